@@ -23,6 +23,12 @@ endif
 
 CFG_LPAE_ADDR_SPACE_BITS ?= 32
 
+ifeq ($(CFG_TA_CNTPCT_SYS_TIME),y)
+ifneq ($(CFG_SECURE_TIME_SOURCE_CNTPCT),y)
+$(error Error: CFG_TA_CNTPCT_SYS_TIME requires CFG_SECURE_TIME_SOURCE_CNTPCT)
+endif
+endif
+
 CFG_MMAP_REGIONS ?= 13
 CFG_RESERVED_VASPACE_SIZE ?= (1024 * 1024 * 10)
 
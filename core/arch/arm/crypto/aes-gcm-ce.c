@@ -94,42 +94,48 @@ void internal_aes_gcm_ghash_update(struct internal_aes_gcm_state *state,
 	put_be_block(state->hash_state, dg);
 }
 
+/*
+ * The CTR and GHASH assembly routines interleave several blocks per
+ * invocation and keep the round keys and hash keys loaded in SIMD
+ * registers while looping. Feed them whole block runs instead of
+ * alternating between single block CTR and GHASH calls, which defeats
+ * both the pipelining and the register reuse.
+ */
 static void encrypt_pl(struct internal_aes_gcm_state *state,
 		       const struct internal_aes_gcm_key *ek, uint64_t dg[2],
 		       const uint8_t *src, size_t num_blocks, uint8_t *dst)
 {
-	void *buf_cryp = state->buf_cryp;
-
-	while (num_blocks) {
-		ce_aes_xor_block(buf_cryp, buf_cryp, src);
-
-		pmull_ghash_update(1, dg, buf_cryp, &state->ghash_key, NULL);
-		memcpy(dst, buf_cryp, TEE_AES_BLOCK_SIZE);
+	/*
+	 * The first block is encrypted with the keystream block already
+	 * prepared in buf_cryp, state->ctr holds the counter of the
+	 * second block.
+	 */
+	ce_aes_xor_block(dst, (const uint8_t *)state->buf_cryp, src);
 
-		ce_aes_ecb_encrypt(buf_cryp, (const uint8_t *)state->ctr,
+	if (num_blocks > 1)
+		ce_aes_ctr_encrypt(dst + TEE_AES_BLOCK_SIZE,
+				   src + TEE_AES_BLOCK_SIZE,
 				   (const uint8_t *)ek->data, ek->rounds,
-				   1, 1);
-		internal_aes_gcm_inc_ctr(state);
+				   num_blocks - 1, (uint8_t *)state->ctr, 1);
 
-		src += TEE_AES_BLOCK_SIZE;
-		dst += TEE_AES_BLOCK_SIZE;
-		num_blocks--;
-	}
+	pmull_ghash_update(num_blocks, dg, dst, &state->ghash_key, NULL);
+
+	/* Prepare the keystream block for the next payload block */
+	ce_aes_ecb_encrypt((uint8_t *)state->buf_cryp,
+			   (const uint8_t *)state->ctr,
+			   (const uint8_t *)ek->data, ek->rounds, 1, 1);
+	internal_aes_gcm_inc_ctr(state);
 }
 
 static void decrypt_pl(struct internal_aes_gcm_state *state,
 		       const struct internal_aes_gcm_key *ek, uint64_t dg[2],
 		       const uint8_t *src, size_t num_blocks, uint8_t *dst)
 {
-	while (num_blocks) {
-		ce_aes_ctr_encrypt(dst, src, (const uint8_t *)ek->data,
-				   ek->rounds, 1, (uint8_t *)state->ctr, 1);
-		pmull_ghash_update(1, dg, src, &state->ghash_key, NULL);
-
-		src += TEE_AES_BLOCK_SIZE;
-		dst += TEE_AES_BLOCK_SIZE;
-		num_blocks--;
-	}
+	/* GHASH is computed over the ciphertext, i.e., the source */
+	pmull_ghash_update(num_blocks, dg, src, &state->ghash_key, NULL);
+
+	ce_aes_ctr_encrypt(dst, src, (const uint8_t *)ek->data, ek->rounds,
+			   num_blocks, (uint8_t *)state->ctr, 1);
 }
 
 #ifdef ARM64
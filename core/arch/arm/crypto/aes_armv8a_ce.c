@@ -43,9 +43,13 @@
  * AES cipher for ARMv8 with Crypto Extensions
  */
 
+#include <arm.h>
 #include <crypto/crypto_accel.h>
+#include <initcall.h>
+#include <kernel/panic.h>
 #include <kernel/thread.h>
 #include <string.h>
+#include <tee_api_types.h>
 #include <types_ext.h>
 #include <utee_defines.h>
 #include <util.h>
@@ -247,3 +251,26 @@ void crypto_accel_aes_xts_dec(void *out, const void *in, const void *key1,
 			   tweak);
 	thread_kernel_disable_vfp(vfp_state);
 }
+
+/*
+ * The descriptor with the accelerated routines above replaces the
+ * table-based AES at build time, so make sure the CPU this image ended
+ * up on actually implements the AES instructions instead of taking an
+ * undefined instruction trap in the middle of the first crypto
+ * operation.
+ */
+static TEE_Result check_aes_ce(void)
+{
+#ifdef ARM64
+	if (!((read_id_aa64isar0_el1() >> ID_AA64ISAR0_AES_SHIFT) &
+	      ID_AA64ISAR0_AES_MASK))
+		panic("CPU does not implement the AES instructions");
+#else
+	if (!(read_id_isar5() & IDISAR5_AES_MASK))
+		panic("CPU does not implement the AES instructions");
+#endif
+
+	return TEE_SUCCESS;
+}
+
+early_init(check_aes_ce);
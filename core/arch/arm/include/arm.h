@@ -95,6 +95,12 @@
 #define CNTKCTL_PL0PCTEN	BIT(0) /* physical counter el0 access enable */
 #define CNTKCTL_PL0VCTEN	BIT(1) /* virtual counter el0 access enable */
 
+/* ARM Performance Monitors definitions */
+#define PMCR_EN			BIT(0) /* enable all counters */
+#define PMCR_EVCNT_RESET	BIT(1) /* reset all event counters */
+#define PMCR_CCNT_RESET		BIT(2) /* reset the cycle counter */
+#define PMCNTEN_CCNT		BIT(31) /* cycle counter enable bit */
+
 #ifdef ARM32
 #include <arm32.h>
 #endif
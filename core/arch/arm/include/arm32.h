@@ -163,6 +163,10 @@
 #define IDPFR1_GENTIMER_SHIFT        16
 #define IDPFR1_GENTIMER_MASK         (0xF << IDPFR1_GENTIMER_SHIFT)
 
+/* ID_ISAR5 bit fields */
+#define IDISAR5_AES_SHIFT            4
+#define IDISAR5_AES_MASK             (0xF << IDISAR5_AES_SHIFT)
+
 #ifndef __ASSEMBLER__
 #include <generated/arm32_sysreg.h>
 #ifdef CFG_ARM_GICV3
@@ -27,6 +27,10 @@
 
 #define CSSELR_LEVEL_SHIFT	1
 
+/* ID_AA64ISAR0_EL1 bit fields */
+#define ID_AA64ISAR0_AES_SHIFT	4
+#define ID_AA64ISAR0_AES_MASK	0xf
+
 #define DAIFBIT_FIQ			BIT32(0)
 #define DAIFBIT_IRQ			BIT32(1)
 #define DAIFBIT_ABT			BIT32(2)
@@ -317,6 +321,9 @@ DEFINE_U32_REG_READWRITE_FUNCS(fpcr)
 DEFINE_U32_REG_READWRITE_FUNCS(fpsr)
 
 DEFINE_U32_REG_READ_FUNC(ctr_el0)
+DEFINE_REG_READ_FUNC_(ccsidr, uint32_t, ccsidr_el1)
+DEFINE_REG_READ_FUNC_(clidr, uint32_t, clidr_el1)
+DEFINE_REG_WRITE_FUNC_(csselr, uint32_t, csselr_el1)
 DEFINE_U32_REG_READ_FUNC(contextidr_el1)
 DEFINE_U32_REG_READ_FUNC(sctlr_el1)
 
@@ -331,6 +338,13 @@ DEFINE_REG_READ_FUNC_(cntps_tval, uint32_t, cntps_tval_el1)
 DEFINE_REG_WRITE_FUNC_(cntps_tval, uint32_t, cntps_tval_el1)
 
 DEFINE_REG_READ_FUNC_(pmccntr, uint64_t, pmccntr_el0)
+DEFINE_REG_READ_FUNC_(pmcr, uint32_t, pmcr_el0)
+DEFINE_REG_WRITE_FUNC_(pmcr, uint32_t, pmcr_el0)
+DEFINE_REG_WRITE_FUNC_(pmcntenset, uint32_t, pmcntenset_el0)
+DEFINE_REG_WRITE_FUNC_(pmcntenclr, uint32_t, pmcntenclr_el0)
+DEFINE_REG_WRITE_FUNC_(pmselr, uint32_t, pmselr_el0)
+DEFINE_REG_WRITE_FUNC_(pmxevtyper, uint32_t, pmxevtyper_el0)
+DEFINE_REG_READ_FUNC_(pmxevcntr, uint32_t, pmxevcntr_el0)
 
 DEFINE_U64_REG_READWRITE_FUNCS(ttbr0_el1)
 DEFINE_U64_REG_READWRITE_FUNCS(ttbr1_el1)
@@ -344,6 +358,7 @@ DEFINE_U64_REG_READ_FUNC(mpidr_el1)
 DEFINE_U64_REG_READ_FUNC(midr_el1)
 /* Alias for reading this register to avoid ifdefs in code */
 #define read_midr() read_midr_el1()
+DEFINE_U64_REG_READ_FUNC(id_aa64isar0_el1)
 DEFINE_U64_REG_READ_FUNC(par_el1)
 
 DEFINE_U64_REG_WRITE_FUNC(mair_el1)
@@ -28,6 +28,14 @@ void icache_inv_user_range(void *addr, size_t size);
 void dcache_op_louis(unsigned long op_type);
 void dcache_op_all(unsigned long op_type);
 
+/*
+ * Performs a DCACHE_OP_* operation on the given range, switching to a
+ * set/way walk of all data caches when the range exceeds the total data
+ * cache size so large flushes are bounded by the cache size rather than
+ * the range size.
+ */
+void dcache_op_range(void *va, size_t len, unsigned long op_type);
+
 void dcache_op_level1(unsigned long op_type);
 void dcache_op_level2(unsigned long op_type);
 void dcache_op_level3(unsigned long op_type);
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_PMU_H
+#define __KERNEL_PMU_H
+
+#include <compiler.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Performance monitor (PMU) profiling of secure world execution, enabled
+ * with CFG_CORE_PMU_PROFILING and driven from the perf pseudo TA. While
+ * profiling is running, the cycle counter and PMU_NUM_COUNTERS event
+ * counters count secure side execution only: the counters are collected
+ * and stopped when a thread leaves for normal world and restarted when
+ * execution comes back.
+ */
+
+/* Number of programmable event counters used */
+#define PMU_NUM_COUNTERS	4
+
+/* Accumulated counter values, the event counts map to pmu_start() events */
+struct pmu_counts {
+	uint64_t cycles;
+	uint64_t events[PMU_NUM_COUNTERS];
+};
+
+#ifdef CFG_CORE_PMU_PROFILING
+/*
+ * pmu_start() - Start PMU profiling
+ * @events:	Architectural PMU event numbers to count
+ *
+ * Resets the accumulated counts and starts counting on the current core,
+ * other cores start counting when they next enter secure world.
+ */
+TEE_Result pmu_start(const uint32_t events[PMU_NUM_COUNTERS]);
+
+/* Stops profiling, accumulated counts remain readable */
+void pmu_stop(void);
+
+/*
+ * pmu_read_counts() - Read the counts accumulated since pmu_start()
+ * @counts:	Filled in with the accumulated counts
+ * @reset:	Restart accumulation from zero
+ *
+ * Counts from cores currently executing in normal world are included up
+ * to the point where they last left secure world.
+ */
+TEE_Result pmu_read_counts(struct pmu_counts *counts, bool reset);
+
+/* World switch hooks called from thread.c */
+void pmu_thread_suspend(void);
+void pmu_thread_resume(void);
+#else
+static inline TEE_Result
+pmu_start(const uint32_t events[PMU_NUM_COUNTERS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void pmu_stop(void)
+{
+}
+
+static inline TEE_Result pmu_read_counts(struct pmu_counts *counts __unused,
+					 bool reset __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void pmu_thread_suspend(void)
+{
+}
+
+static inline void pmu_thread_resume(void)
+{
+}
+#endif
+
+#endif /*__KERNEL_PMU_H*/
@@ -7,7 +7,12 @@
 #ifndef KERNEL_SPINLOCK_H
 #define KERNEL_SPINLOCK_H
 
-#define SPINLOCK_LOCK       1
+/*
+ * Spinlocks are implemented as ticket locks: the lock word holds the
+ * currently served ticket in bits [15:0] and the next free ticket in
+ * bits [31:16]. The two halves are equal when the lock is free, so
+ * SPINLOCK_UNLOCK remains a valid static initializer.
+ */
 #define SPINLOCK_UNLOCK     0
 
 #ifndef __ASSEMBLER__
@@ -265,6 +265,21 @@ unsigned long thread_system_reset_handler(unsigned long a0, unsigned long a1);
 void thread_init_primary(void);
 void thread_init_per_cpu(void);
 
+#ifdef CFG_CORE_STACK_USAGE
+/* Stack classes for thread_get_stack_usage() */
+#define THREAD_STACK_TMP	0
+#define THREAD_STACK_ABT	1
+#define THREAD_STACK_THREAD	2
+
+/*
+ * Reports the usable size and the high-water mark usage in bytes of stack
+ * @n of class @which. Returns false when the stack does not exist or
+ * cannot be scanned in this configuration.
+ */
+bool thread_get_stack_usage(unsigned int which, size_t n, size_t *size,
+			    size_t *max_usage);
+#endif
+
 struct thread_core_local *thread_get_core_local(void);
 
 /*
@@ -738,6 +753,7 @@ enum thread_shm_type {
  * @THREAD_SHM_CACHE_USER_SOCKET - socket communication
  * @THREAD_SHM_CACHE_USER_FS - filesystem access
  * @THREAD_SHM_CACHE_USER_I2C - I2C communication
+ * @THREAD_SHM_CACHE_USER_RPMB - RPMB communication
  *
  * To ensure that each user of the shared memory cache doesn't interfere
  * with each other a unique ID per user is used.
@@ -746,6 +762,7 @@ enum thread_shm_cache_user {
 	THREAD_SHM_CACHE_USER_SOCKET,
 	THREAD_SHM_CACHE_USER_FS,
 	THREAD_SHM_CACHE_USER_I2C,
+	THREAD_SHM_CACHE_USER_RPMB,
 };
 
 /*
@@ -25,11 +25,10 @@ static inline void tlbi_mva_allasid_nosync(vaddr_t va)
 #endif
 }
 
-static inline void tlbi_mva_asid(vaddr_t va, uint32_t asid)
+static inline void tlbi_mva_asid_nosync(vaddr_t va, uint32_t asid)
 {
 	uint32_t a = asid & TLBI_ASID_MASK;
 
-	dsb_ishst();
 #ifdef ARM64
 	tlbi_vale1is((va >> TLBI_MVA_SHIFT) | SHIFT_U64(a, TLBI_ASID_SHIFT));
 	tlbi_vale1is((va >> TLBI_MVA_SHIFT) |
@@ -38,9 +37,32 @@ static inline void tlbi_mva_asid(vaddr_t va, uint32_t asid)
 	write_tlbimvais((va & ~(BIT32(TLBI_MVA_SHIFT) - 1)) | a);
 	write_tlbimvais((va & ~(BIT32(TLBI_MVA_SHIFT) - 1)) | a | 1);
 #endif
+}
+
+/*
+ * Batched TLB invalidation: write all the page table entry updates
+ * first, call tlbi_batch_begin() to order them before the
+ * invalidations, issue one _nosync invalidation per entry and complete
+ * with a single tlbi_batch_end(). This pays for the expensive barriers
+ * once per batch instead of once per entry.
+ */
+static inline void tlbi_batch_begin(void)
+{
+	dsb_ishst();
+}
+
+static inline void tlbi_batch_end(void)
+{
 	dsb_ish();
 	isb();
 }
+
+static inline void tlbi_mva_asid(vaddr_t va, uint32_t asid)
+{
+	tlbi_batch_begin();
+	tlbi_mva_asid_nosync(va, asid);
+	tlbi_batch_end();
+}
 #endif /*!__ASSEMBLER__*/
 
 #endif /* TLB_HELPERS_H */
@@ -33,6 +33,8 @@ SLIST_HEAD(load_seg_head, load_seg);
  * @is_initializing:	True if TA is not fully loaded
  * @open_sessions:	List of sessions opened by this TA
  * @cryp_states:	List of cryp states created by this TA
+ * @cryp_pool:		List of freed cryp states kept for reuse
+ * @cryp_pool_count:	Number of cryp states in @cryp_pool
  * @objects:		List of storage objects opened by this TA
  * @storage_enums:	List of storage enumerators opened by this TA
  * @stack_ptr:		Stack pointer
@@ -54,6 +56,8 @@ struct user_ta_ctx {
 	bool is_initializing;
 	struct tee_ta_session_head open_sessions;
 	struct tee_cryp_state_head cryp_states;
+	struct tee_cryp_state_head cryp_pool;
+	size_t cryp_pool_count;
 	struct tee_obj_head objects;
 	struct tee_storage_enum_head storage_enums;
 	vaddr_t stack_ptr;
@@ -13,9 +13,17 @@ SLIST_HEAD(wait_queue, wait_queue_elem);
 
 #define WAIT_QUEUE_INITIALIZER { .slh_first = NULL }
 
+/*
+ * Wait queue priority classes. Waiters of a higher class are woken
+ * before waiters of a lower class, order within a class stays FIFO.
+ */
+#define WQ_PRIO_NORMAL	0
+#define WQ_PRIO_HIGH	1
+
 struct condvar;
 struct wait_queue_elem {
 	short handle;
+	uint8_t prio;
 	bool done;
 	bool wait_read;
 	struct condvar *cv;
@@ -63,5 +71,13 @@ bool wq_have_condvar(struct wait_queue *wq, struct condvar *cv);
 void __wq_rpc(uint32_t func, int id, const void *sync_obj, const char *fname,
 	      int lineno);
 
+/*
+ * Returns the number of sleep and wakeup RPCs issued on behalf of a
+ * thread since boot. Both counters are returned as 0 for an invalid
+ * thread ID.
+ */
+void wq_get_thread_stats(size_t thread_id, uint32_t *sleeps,
+			 uint32_t *wakeups);
+
 #endif /*KERNEL_WAIT_QUEUE_H*/
 
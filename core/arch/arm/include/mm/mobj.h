@@ -27,6 +27,7 @@ struct mobj_ops {
 	TEE_Result (*get_pa)(struct mobj *mobj, size_t offs, size_t granule,
 			     paddr_t *pa);
 	size_t (*get_phys_offs)(struct mobj *mobj, size_t granule);
+	size_t (*get_contig_run)(struct mobj *mobj, size_t offs);
 	TEE_Result (*get_cattr)(struct mobj *mobj, uint32_t *cattr);
 	bool (*matches)(struct mobj *mobj, enum buf_is_attr attr);
 	void (*free)(struct mobj *mobj);
@@ -198,6 +199,28 @@ static inline size_t mobj_get_phys_granule(struct mobj *mobj)
 	return mobj->size;
 }
 
+/**
+ * mobj_get_contig_run() - physically contiguous bytes from an offset
+ * @mobj:	pointer to a MOBJ
+ * @offs:	offset into the MOBJ
+ *
+ * Returns how many bytes starting at @offs are physically contiguous.
+ * MOBJs which don't implement the operation are contiguous per physical
+ * granule, so the remainder of the granule @offs is in is returned.
+ */
+static inline size_t mobj_get_contig_run(struct mobj *mobj, size_t offs)
+{
+	size_t granule = 0;
+
+	if (mobj->ops && mobj->ops->get_contig_run)
+		return mobj->ops->get_contig_run(mobj, offs);
+
+	granule = mobj->phys_granule;
+	if (!granule)
+		return mobj->size - offs;
+	return granule - (offs & (granule - 1));
+}
+
 struct mobj *mobj_mm_alloc(struct mobj *mobj_parent, size_t size,
 			   tee_mm_pool_t *pool);
 
@@ -240,6 +263,15 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie);
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie);
 
+/**
+ * mobj_reg_shm_release_count() - registered shared memory releases so far
+ *
+ * Incremented each time a registered shared memory object is freed. Used
+ * by the parameter mapping cache (CFG_TA_SHM_MAP_CACHE) to tell whether a
+ * cookie sampled earlier can still refer to the same registration.
+ */
+uint32_t mobj_reg_shm_release_count(void);
+
 /**
  * mobj_reg_shm_unguard() - unguards a reg_shm
  * @mobj:	pointer to a registered shared memory mobj
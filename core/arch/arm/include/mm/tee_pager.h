@@ -267,9 +267,30 @@ struct tee_pager_stats {
 	size_t npages_all;	/* number of pages */
 };
 
+/*
+ * Record of one pager fault, logged when CFG_PAGER_FAULT_TRACE=y so the
+ * faulting code paths can be reconstructed offline
+ */
+struct tee_pager_fault_rec {
+	uint64_t pc;
+	uint64_t va;
+};
+
+/* Number of struct tee_pager_fault_rec kept in the trace ring */
+#define TEE_PAGER_FAULT_TRACE_SIZE	256
+
 #ifdef CFG_WITH_PAGER
 void tee_pager_get_stats(struct tee_pager_stats *stats);
 bool tee_pager_handle_fault(struct abort_info *ai);
+
+/*
+ * Copy up to @num_recs fault records into @recs and return the total
+ * number of faults recorded, the oldest available record is found at
+ * index count % TEE_PAGER_FAULT_TRACE_SIZE. Requires
+ * CFG_PAGER_FAULT_TRACE=y.
+ */
+size_t tee_pager_get_fault_trace(struct tee_pager_fault_rec *recs,
+				 size_t num_recs);
 #else /*CFG_WITH_PAGER*/
 static inline bool tee_pager_handle_fault(struct abort_info *ai __unused)
 {
@@ -81,10 +81,16 @@
  * w4:    Bit[1:0]:  Number of 4kB pages of shared memory to register with
  *                   OPTEE_FFA_REGISTER_RPC_SHM to support RPC
  *        Bit[31:2]: Reserved (MBZ)
- * w5-w7: Note used (MBZ)
+ * w5:    Bit[0]:    Set if OPTEE_FFA_YIELDING_CALL_WITH_ARG_LIST is
+ *                   supported
+ *        Bit[31:1]: Reserved (MBZ)
+ * w6-w7: Note used (MBZ)
  */
 #define OPTEE_FFA_EXCHANGE_CAPABILITIES OPTEE_FFA_BLOCKING_CALL(2)
 
+/* Secure world supports OPTEE_FFA_YIELDING_CALL_WITH_ARG_LIST */
+#define OPTEE_FFA_SEC_CAP_ARG_LIST	BIT32(0)
+
 /*
  * Call with struct optee_msg_arg as argument in the supplied shared memory
  * with a zero internal offset and normal cached memory attributes.
@@ -95,6 +101,19 @@
  * w6:    Offset into shared memory pointing to a struct optee_msg_arg
  * w7:    Not used (MBZ)
  *
+ * Call with a list of struct optee_msg_arg as argument in the supplied
+ * shared memory with normal cached memory attributes. The memory starts
+ * with a struct optee_ffa_arg_list giving the offset of each struct
+ * optee_msg_arg within the memory. The requests are processed in order by
+ * a single secure world thread, amortizing the cost of the FF-A exchange
+ * over several requests. The result of each request is found in its
+ * struct optee_msg_arg.
+ * Register usage:
+ * w3:    Service ID, OPTEE_FFA_YIELDING_CALL_WITH_ARG_LIST
+ * w4:    Lower 32 bits of a 64-bit Shared memory handle
+ * w5:    Upper 32 bits of a 64-bit Shared memory handle
+ * w6-w7: Not used (MBZ)
+ *
  * Call to register shared memory. The data is supplied in shared
  * memory with a zero internal offset and normal cached memory attributes.
  * The data is formatted as described in FF-A 1.0 EAC Table 44
@@ -186,6 +205,22 @@
 #define OPTEE_FFA_YIELDING_CALL_REGISTER_SHM	OPTEE_FFA_YIELDING_CALL(1)
 #define OPTEE_FFA_YIELDING_CALL_UNREGISTER_SHM	OPTEE_FFA_YIELDING_CALL(2)
 #define OPTEE_FFA_YIELDING_CALL_RESUME		OPTEE_FFA_YIELDING_CALL(3)
+#define OPTEE_FFA_YIELDING_CALL_WITH_ARG_LIST	OPTEE_FFA_YIELDING_CALL(4)
+
+/*
+ * Header of the shared memory supplied with
+ * OPTEE_FFA_YIELDING_CALL_WITH_ARG_LIST, placed at offset 0 and followed
+ * by the struct optee_msg_arg of each request at the given offsets.
+ *
+ * @num_args:	number of entries in @offs
+ * @reserved:	MBZ
+ * @offs:	offset of each struct optee_msg_arg within the shared memory
+ */
+struct optee_ffa_arg_list {
+	uint32_t num_args;
+	uint32_t reserved;
+	uint64_t offs[];
+};
 
 #define OPTEE_FFA_YIELDING_CALL_RETURN_DONE		0
 #define OPTEE_FFA_YIELDING_CALL_RETURN_ALLOC_KERN_SHM	1
@@ -387,6 +387,7 @@ static void init_runtime(unsigned long pageable_part)
 	size_t pageable_start = (size_t)__pageable_start;
 	size_t pageable_end = (size_t)__pageable_end;
 	size_t pageable_size = pageable_end - pageable_start;
+	size_t eager_check_size = pageable_size;
 	size_t tzsram_end = TZSRAM_BASE + TZSRAM_SIZE;
 	size_t hash_size = (pageable_size / SMALL_PAGE_SIZE) *
 			   TEE_SHA256_HASH_SIZE;
@@ -449,9 +450,18 @@ static void init_runtime(unsigned long pageable_part)
 	 */
 	undo_init_relocation(paged_store);
 
-	/* Check that hashes of what's in pageable area is OK */
+	/*
+	 * Check that hashes of what's in pageable area is OK. The init
+	 * part runs mapped without going through the pager so it must be
+	 * verified here. The remaining pages are verified against the
+	 * same hashes when they are first paged in, so with
+	 * CFG_PAGER_LAZY_HASH_VERIFY boot leaves them to the pager.
+	 */
+	if (IS_ENABLED(CFG_PAGER_LAZY_HASH_VERIFY))
+		eager_check_size = init_size;
+
 	DMSG("Checking hashes of pageable area");
-	for (n = 0; (n * SMALL_PAGE_SIZE) < pageable_size; n++) {
+	for (n = 0; (n * SMALL_PAGE_SIZE) < eager_check_size; n++) {
 		const uint8_t *hash = hashes + n * TEE_SHA256_HASH_SIZE;
 		const uint8_t *page = paged_store + n * SMALL_PAGE_SIZE;
 		TEE_Result res;
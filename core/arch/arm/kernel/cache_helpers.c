@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/cache_helpers.h>
+#include <kernel/panic.h>
+
+/* CLIDR cache type fields, 3 bits per level */
+#define CLIDR_CTYPE(clidr, level) \
+	(((clidr) >> ((level) * U(3))) & U(0x7))
+#define CLIDR_CTYPE_NO_CACHE		U(0)
+#define CLIDR_CTYPE_ICACHE_ONLY		U(1)
+#define CLIDR_MAX_LEVELS		U(7)
+
+/* CCSIDR cache geometry fields */
+#define CCSIDR_LINE_SIZE(ccsidr)	(((ccsidr) & U(0x7)) + U(4))
+#define CCSIDR_ASSOC(ccsidr)		((((ccsidr) >> U(3)) & U(0x3ff)) + 1)
+#define CCSIDR_NUM_SETS(ccsidr)		((((ccsidr) >> U(13)) & \
+					  U(0x7fff)) + 1)
+
+/*
+ * Returns the total size of the data and unified caches, computed once
+ * by walking the cache levels in CLIDR and reading the geometry of each
+ * from CCSIDR.
+ */
+static size_t dcache_total_size(void)
+{
+	static size_t size;
+	uint32_t clidr = 0;
+	uint32_t ccsidr = 0;
+	unsigned int level = 0;
+	unsigned int ctype = 0;
+
+	if (size)
+		return size;
+
+	clidr = read_clidr();
+	for (level = 0; level < CLIDR_MAX_LEVELS; level++) {
+		ctype = CLIDR_CTYPE(clidr, level);
+		if (ctype == CLIDR_CTYPE_NO_CACHE)
+			break;
+		if (ctype == CLIDR_CTYPE_ICACHE_ONLY)
+			continue;
+
+		write_csselr(level << CSSELR_LEVEL_SHIFT);
+		isb();
+		ccsidr = read_ccsidr();
+		size += (size_t)CCSIDR_NUM_SETS(ccsidr) *
+			CCSIDR_ASSOC(ccsidr) *
+			BIT(CCSIDR_LINE_SIZE(ccsidr));
+	}
+
+	return size;
+}
+
+void dcache_op_range(void *va, size_t len, unsigned long op_type)
+{
+	/*
+	 * Beyond the total data cache size a line by line walk of the
+	 * range touches more lines than the caches hold, walking every
+	 * set and way instead bounds the cost by the cache size. The
+	 * set/way ops have the same local-core-only semantics as the
+	 * full-cache commands already accepted by cache_op_inner().
+	 *
+	 * A full-cache invalidate would discard dirty lines outside the
+	 * range, so invalidate falls back to clean+invalidate which is
+	 * safe for any range.
+	 */
+	if (len >= dcache_total_size()) {
+		if (op_type == DCACHE_OP_INV)
+			op_type = DCACHE_OP_CLEAN_INV;
+		dcache_op_all(op_type);
+		return;
+	}
+
+	switch (op_type) {
+	case DCACHE_OP_CLEAN:
+		dcache_clean_range(va, len);
+		break;
+	case DCACHE_OP_INV:
+		dcache_inv_range(va, len);
+		break;
+	case DCACHE_OP_CLEAN_INV:
+		dcache_cleaninv_range(va, len);
+		break;
+	default:
+		panic();
+	}
+}
@@ -5,10 +5,13 @@
 #include <crypto/crypto.h>
 #include <initcall.h>
 #include <kernel/early_ta.h>
+#include <kernel/mutex.h>
 #include <kernel/user_ta.h>
 #include <kernel/user_ta_store.h>
+#include <mm/core_mmu.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <trace.h>
 #include <utee_defines.h>
 #include <util.h>
@@ -101,33 +104,79 @@ static TEE_Result early_ta_get_size(const struct user_ta_store_handle *h,
 	return TEE_SUCCESS;
 }
 
-static TEE_Result early_ta_get_tag(const struct user_ta_store_handle *h,
-				   uint8_t *tag, unsigned int *tag_len)
+/*
+ * Early TAs are immutable so their tags are computed once and then kept
+ * here, the hash over a large TA is otherwise redone for each ELF opened
+ * from the store.
+ */
+struct cached_tag {
+	const struct early_ta *early_ta;
+	uint8_t tag[TEE_SHA256_HASH_SIZE];
+	SLIST_ENTRY(cached_tag) link;
+};
+
+static SLIST_HEAD(, cached_tag) tag_cache = SLIST_HEAD_INITIALIZER(tag_cache);
+static struct mutex tag_cache_mutex = MUTEX_INITIALIZER;
+
+static TEE_Result compute_tag(const struct early_ta *ta,
+			      uint8_t tag[TEE_SHA256_HASH_SIZE])
 {
 	TEE_Result res = TEE_SUCCESS;
 	void *ctx = NULL;
 
-	if (!tag || *tag_len < TEE_SHA256_HASH_SIZE) {
-		*tag_len = TEE_SHA256_HASH_SIZE;
-		return TEE_ERROR_SHORT_BUFFER;
-	}
-	*tag_len = TEE_SHA256_HASH_SIZE;
-
 	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
 	if (res)
 		return res;
 	res = crypto_hash_init(ctx);
 	if (res)
 		goto out;
-	res = crypto_hash_update(ctx, h->early_ta->ta, h->early_ta->size);
+	res = crypto_hash_update(ctx, ta->ta, ta->size);
 	if (res)
 		goto out;
-	res = crypto_hash_final(ctx, tag, *tag_len);
+	res = crypto_hash_final(ctx, tag, TEE_SHA256_HASH_SIZE);
 out:
 	crypto_hash_free_ctx(ctx);
 	return res;
 }
 
+static TEE_Result early_ta_get_tag(const struct user_ta_store_handle *h,
+				   uint8_t *tag, unsigned int *tag_len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct cached_tag *ct = NULL;
+
+	if (!tag || *tag_len < TEE_SHA256_HASH_SIZE) {
+		*tag_len = TEE_SHA256_HASH_SIZE;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	*tag_len = TEE_SHA256_HASH_SIZE;
+
+	mutex_lock(&tag_cache_mutex);
+	SLIST_FOREACH(ct, &tag_cache, link)
+		if (ct->early_ta == h->early_ta)
+			break;
+	if (!ct) {
+		ct = malloc(sizeof(*ct));
+		if (!ct) {
+			mutex_unlock(&tag_cache_mutex);
+			/* Not fatal, compute without caching */
+			return compute_tag(h->early_ta, tag);
+		}
+		res = compute_tag(h->early_ta, ct->tag);
+		if (res) {
+			mutex_unlock(&tag_cache_mutex);
+			free(ct);
+			return res;
+		}
+		ct->early_ta = h->early_ta;
+		SLIST_INSERT_HEAD(&tag_cache, ct, link);
+	}
+	memcpy(tag, ct->tag, TEE_SHA256_HASH_SIZE);
+	mutex_unlock(&tag_cache_mutex);
+
+	return res;
+}
+
 static TEE_Result read_uncompressed(struct user_ta_store_handle *h, void *data,
 				    size_t len)
 {
@@ -160,10 +209,12 @@ static TEE_Result read_compressed(struct user_ta_store_handle *h, void *data,
 	} else {
 		/*
 		 * inflate() does not support a NULL strm->next_out. So, to
-		 * discard data, we have to allocate a temporary buffer. 1K
-		 * seems reasonable.
+		 * discard data, we have to allocate a temporary buffer. A
+		 * page per inflate() call keeps the loop count low when
+		 * skipping over large segments without straining the core
+		 * heap.
 		 */
-		strm->avail_out = MIN(len, 1024U);
+		strm->avail_out = MIN(len, (size_t)SMALL_PAGE_SIZE);
 		tmpbuf = malloc(strm->avail_out);
 		if (!tmpbuf) {
 			EMSG("Out of memory");
@@ -193,7 +244,8 @@ static TEE_Result read_compressed(struct user_ta_store_handle *h, void *data,
 			 * and read again as much as possible.
 			 */
 			strm->next_out = tmpbuf;
-			strm->avail_out = MIN(len - total, 1024U);
+			strm->avail_out = MIN(len - total,
+					      (size_t)SMALL_PAGE_SIZE);
 		}
 	} while ((st == Z_OK || st == Z_BUF_ERROR) && (total != len));
 	if (st != Z_OK && st != Z_STREAM_END) {
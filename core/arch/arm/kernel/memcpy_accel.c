@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <kernel/memcpy_accel.h>
+#include <kernel/thread.h>
+#include <string.h>
+#include <types_ext.h>
+
+/*
+ * Wide loads and stores only pay off once the buffer is large enough to
+ * amortize saving and restoring the VFP state, smaller buffers go through
+ * plain memcpy()/memset().
+ */
+#define MEMCPY_ACCEL_THRESHOLD	512
+
+/* The assembly functions process the buffer in blocks of this size */
+#define MEMCPY_ACCEL_BLOCK_SIZE	64
+
+/* Prototypes for assembly functions */
+void memcpy_accel_blocks(void *dst, const void *src, size_t blocks);
+void memset_accel_blocks(void *dst, uint8_t val, size_t blocks);
+
+static bool can_use_vfp(size_t n)
+{
+	/*
+	 * thread_kernel_enable_vfp() may only be called from an active
+	 * thread context, boot, abort and interrupt context fall back to
+	 * the plain string routines.
+	 */
+	return n >= MEMCPY_ACCEL_THRESHOLD &&
+	       thread_get_id_may_fail() != THREAD_ID_INVALID;
+}
+
+void *memcpy_accel(void *dst, const void *src, size_t n)
+{
+	size_t blocks = n / MEMCPY_ACCEL_BLOCK_SIZE;
+	size_t tail = n % MEMCPY_ACCEL_BLOCK_SIZE;
+	uint32_t vfp_state = 0;
+
+	if (!can_use_vfp(n))
+		return memcpy(dst, src, n);
+
+	vfp_state = thread_kernel_enable_vfp();
+	memcpy_accel_blocks(dst, src, blocks);
+	thread_kernel_disable_vfp(vfp_state);
+
+	if (tail)
+		memcpy((uint8_t *)dst + n - tail,
+		       (const uint8_t *)src + n - tail, tail);
+
+	return dst;
+}
+
+void *memset_accel(void *b, int c, size_t n)
+{
+	size_t blocks = n / MEMCPY_ACCEL_BLOCK_SIZE;
+	size_t tail = n % MEMCPY_ACCEL_BLOCK_SIZE;
+	uint32_t vfp_state = 0;
+
+	if (!can_use_vfp(n))
+		return memset(b, c, n);
+
+	vfp_state = thread_kernel_enable_vfp();
+	memset_accel_blocks(b, c, blocks);
+	thread_kernel_disable_vfp(vfp_state);
+
+	if (tail)
+		memset((uint8_t *)b + n - tail, c, tail);
+
+	return b;
+}
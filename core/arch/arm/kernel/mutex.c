@@ -3,15 +3,60 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <atomic.h>
+#include <kernel/lockprof.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <trace.h>
+#include <util.h>
 
 #include "mutex_lockdep.h"
 
+/*
+ * Going to sleep on a contended mutex means suspending the thread and
+ * returning to normal world until the owner wakes us through an RPC,
+ * which costs orders of magnitude more than a typical critical
+ * section. Spin a bounded number of iterations hoping the owner
+ * releases the mutex first and only fall back to the wait queue when
+ * that fails. Pointless on a single core since the owner can't run
+ * concurrently.
+ */
+#ifndef CFG_MUTEX_SPIN_COUNT
+#define CFG_MUTEX_SPIN_COUNT	U(128)
+#endif
+
+static bool mutex_spin_try_lock(struct mutex *m)
+{
+	size_t n = 0;
+
+	if (CFG_TEE_CORE_NB_CORE == 1)
+		return false;
+
+	for (n = 0; n < CFG_MUTEX_SPIN_COUNT; n++) {
+		uint32_t old_itr_status = 0;
+		bool can_lock = false;
+
+		if (atomic_load_short(&m->state))
+			continue;
+
+		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
+		can_lock = !m->state;
+
+		if (can_lock)
+			m->state = -1; /* write locked */
+
+		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
+
+		if (can_lock)
+			return true;
+	}
+
+	return false;
+}
+
 void mutex_init(struct mutex *m)
 {
 	*m = (struct mutex)MUTEX_INITIALIZER;
@@ -24,12 +69,19 @@ void mutex_init_recursive(struct recursive_mutex *m)
 
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool contended = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
 
 	mutex_lock_check(m);
 
+	if (mutex_spin_try_lock(m)) {
+		lockprof_acquired((uintptr_t)m, false);
+		return;
+	}
+
 	while (true) {
 		uint32_t old_itr_status;
 		bool can_lock;
@@ -60,9 +112,12 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			contended = true;
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
+		} else {
+			lockprof_acquired((uintptr_t)m, contended);
 			return;
+		}
 	}
 }
 
@@ -105,6 +160,7 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
+	lockprof_released((uintptr_t)m);
 	wq_wake_next(&m->wq, m, fname, lineno);
 }
 
@@ -141,8 +197,10 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-	if (can_lock_write)
+	if (can_lock_write) {
 		mutex_trylock_check(m);
+		lockprof_acquired((uintptr_t)m, false);
+	}
 
 	return can_lock_write;
 }
@@ -165,12 +223,16 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
 	/* Wake eventual waiters if the mutex was unlocked */
-	if (!new_state)
+	if (!new_state) {
+		lockprof_released((uintptr_t)m);
 		wq_wake_next(&m->wq, m, fname, lineno);
+	}
 }
 
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool contended = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -205,9 +267,12 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			contended = true;
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
+		} else {
+			lockprof_acquired((uintptr_t)m, contended);
 			return;
+		}
 	}
 }
 
@@ -229,6 +294,9 @@ static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
+	if (can_lock)
+		lockprof_acquired((uintptr_t)m, false);
+
 	return can_lock;
 }
 
@@ -431,8 +499,10 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
 	/* Wake eventual waiters if the mutex was unlocked */
-	if (!new_state)
+	if (!new_state) {
+		lockprof_released((uintptr_t)m);
 		wq_wake_next(&m->wq, m, fname, lineno);
+	}
 
 	wq_wait_final(&m->wq, &wqe, m, fname, lineno);
 
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/misc.h>
+#include <kernel/pmu.h>
+#include <kernel/spinlock.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * The PMU is a per-core resource, so every core programs its own counters
+ * when it enters secure world with profiling enabled and folds its counts
+ * into the global totals when it leaves again. pmu_core_armed[] tracks
+ * which cores currently have their counters running, pmu_lock protects
+ * the totals and the enable state.
+ *
+ * Note that counting in the secure state may additionally have to be
+ * permitted by the EL3 firmware (MDCR_EL3.SPME, or SDER on Armv7), if it
+ * isn't the counters simply read as zero.
+ */
+
+static unsigned int pmu_lock = SPINLOCK_UNLOCK;
+static bool pmu_enabled;
+static uint32_t pmu_events[PMU_NUM_COUNTERS];
+static struct pmu_counts pmu_totals;
+static bool pmu_core_armed[CFG_TEE_CORE_NB_CORE];
+
+static void pmu_program_this_core(void)
+{
+	uint32_t n = 0;
+
+	for (n = 0; n < PMU_NUM_COUNTERS; n++) {
+		write_pmselr(n);
+		isb();
+		write_pmxevtyper(pmu_events[n]);
+	}
+	write_pmcntenset(PMCNTEN_CCNT | GENMASK_32(PMU_NUM_COUNTERS - 1, 0));
+	write_pmcr(read_pmcr() | PMCR_EVCNT_RESET | PMCR_CCNT_RESET | PMCR_EN);
+	isb();
+}
+
+static void pmu_disable_this_core(void)
+{
+	write_pmcr(read_pmcr() & ~PMCR_EN);
+	isb();
+}
+
+/* Called with pmu_lock held, leaves the counters stopped and reset */
+static void pmu_collect_this_core(void)
+{
+	uint32_t n = 0;
+
+	pmu_disable_this_core();
+	pmu_totals.cycles += read_pmccntr();
+	for (n = 0; n < PMU_NUM_COUNTERS; n++) {
+		write_pmselr(n);
+		isb();
+		pmu_totals.events[n] += read_pmxevcntr();
+	}
+	write_pmcr(read_pmcr() | PMCR_EVCNT_RESET | PMCR_CCNT_RESET);
+	isb();
+}
+
+TEE_Result pmu_start(const uint32_t events[PMU_NUM_COUNTERS])
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&pmu_lock);
+
+	memcpy(pmu_events, events, sizeof(pmu_events));
+	memset(&pmu_totals, 0, sizeof(pmu_totals));
+	pmu_enabled = true;
+	pmu_core_armed[get_core_pos()] = true;
+	pmu_program_this_core();
+
+	cpu_spin_unlock_xrestore(&pmu_lock, exceptions);
+
+	return TEE_SUCCESS;
+}
+
+void pmu_stop(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&pmu_lock);
+	size_t pos = get_core_pos();
+
+	if (pmu_enabled) {
+		if (pmu_core_armed[pos]) {
+			pmu_collect_this_core();
+			pmu_core_armed[pos] = false;
+		}
+		/*
+		 * Other cores disarm at their next world switch, their
+		 * counts since the last switch are dropped.
+		 */
+		pmu_enabled = false;
+	}
+
+	cpu_spin_unlock_xrestore(&pmu_lock, exceptions);
+}
+
+TEE_Result pmu_read_counts(struct pmu_counts *counts, bool reset)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&pmu_lock);
+	size_t pos = get_core_pos();
+
+	/*
+	 * Fold in what this core has counted so far so the caller sees
+	 * its own activity up to this point, then let it keep counting.
+	 */
+	if (pmu_enabled && pmu_core_armed[pos]) {
+		pmu_collect_this_core();
+		write_pmcr(read_pmcr() | PMCR_EN);
+		isb();
+	}
+
+	*counts = pmu_totals;
+	if (reset)
+		memset(&pmu_totals, 0, sizeof(pmu_totals));
+
+	cpu_spin_unlock_xrestore(&pmu_lock, exceptions);
+
+	return TEE_SUCCESS;
+}
+
+void pmu_thread_suspend(void)
+{
+	size_t pos = get_core_pos();
+	uint32_t exceptions = 0;
+
+	if (!pmu_core_armed[pos])
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&pmu_lock);
+	if (pmu_core_armed[pos]) {
+		if (pmu_enabled)
+			pmu_collect_this_core();
+		else
+			pmu_disable_this_core();
+		pmu_core_armed[pos] = false;
+	}
+	cpu_spin_unlock_xrestore(&pmu_lock, exceptions);
+}
+
+void pmu_thread_resume(void)
+{
+	size_t pos = get_core_pos();
+	uint32_t exceptions = 0;
+
+	if (!pmu_enabled)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&pmu_lock);
+	if (pmu_enabled && !pmu_core_armed[pos]) {
+		pmu_program_this_core();
+		pmu_core_armed[pos] = true;
+	}
+	cpu_spin_unlock_xrestore(&pmu_lock, exceptions);
+}
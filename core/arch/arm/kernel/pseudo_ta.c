@@ -252,6 +252,85 @@ bool is_pseudo_ta_ctx(struct ts_ctx *ctx)
 	return ctx->ops == &pseudo_ta_ops;
 }
 
+/*
+ * PTA heads sit in a read-only scattered array in link order. pta_index
+ * sorts pointers to them by UUID once at boot so each session open finds
+ * its PTA with a binary search instead of a linear scan. pta_mru
+ * remembers the last match since clients tend to open the same few PTAs
+ * over and over. When the index is missing (no heap at fault, or no PTA
+ * at all) lookups fall back to scanning the scattered array.
+ */
+static const struct pseudo_ta_head **pta_index;
+static size_t pta_index_count;
+static const struct pseudo_ta_head *pta_mru;
+
+static int pta_index_cmp(const void *a, const void *b)
+{
+	const struct pseudo_ta_head *const *ta = a;
+	const struct pseudo_ta_head *const *tb = b;
+
+	return memcmp(&(*ta)->uuid, &(*tb)->uuid, sizeof(TEE_UUID));
+}
+
+static const struct pseudo_ta_head *pta_find(const TEE_UUID *uuid)
+{
+	const struct pseudo_ta_head *pta = pta_mru;
+	size_t lo = 0;
+	size_t hi = pta_index_count;
+	size_t mid = 0;
+	int cmp = 0;
+
+	if (pta && !memcmp(&pta->uuid, uuid, sizeof(TEE_UUID)))
+		return pta;
+
+	if (!pta_index) {
+		for (pta = SCATTERED_ARRAY_BEGIN(pseudo_tas,
+						 struct pseudo_ta_head);
+		     pta < SCATTERED_ARRAY_END(pseudo_tas,
+					       struct pseudo_ta_head); pta++)
+			if (!memcmp(&pta->uuid, uuid, sizeof(TEE_UUID)))
+				return pta;
+
+		return NULL;
+	}
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		cmp = memcmp(uuid, &pta_index[mid]->uuid, sizeof(TEE_UUID));
+		if (!cmp) {
+			pta_mru = pta_index[mid];
+			return pta_index[mid];
+		}
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return NULL;
+}
+
+static void build_pta_index(const struct pseudo_ta_head *start,
+			    const struct pseudo_ta_head *end)
+{
+	const struct pseudo_ta_head *pta = NULL;
+	size_t count = end - start;
+	size_t n = 0;
+
+	if (!count)
+		return;
+
+	pta_index = malloc(count * sizeof(*pta_index));
+	if (!pta_index)
+		return;
+
+	for (pta = start; pta < end; pta++)
+		pta_index[n++] = pta;
+
+	qsort(pta_index, count, sizeof(*pta_index), pta_index_cmp);
+	pta_index_count = count;
+}
+
 /* Insures declared pseudo TAs conforms with core expectations */
 static TEE_Result verify_pseudo_tas_conformance(void)
 {
@@ -276,6 +355,7 @@ static TEE_Result verify_pseudo_tas_conformance(void)
 		    !pta->invoke_command_entry_point)
 			goto err;
 	}
+	build_pta_index(start, end);
 	return TEE_SUCCESS;
 err:
 	DMSG("pseudo TA error at %p", (void *)pta);
@@ -297,15 +377,9 @@ TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 
 	DMSG("Lookup pseudo TA %pUl", (void *)uuid);
 
-	ta = SCATTERED_ARRAY_BEGIN(pseudo_tas, struct pseudo_ta_head);
-	while (true) {
-		if (ta >= SCATTERED_ARRAY_END(pseudo_tas,
-					      struct pseudo_ta_head))
-			return TEE_ERROR_ITEM_NOT_FOUND;
-		if (memcmp(&ta->uuid, uuid, sizeof(TEE_UUID)) == 0)
-			break;
-		ta++;
-	}
+	ta = pta_find(uuid);
+	if (!ta)
+		return TEE_ERROR_ITEM_NOT_FOUND;
 
 	/* Load a new TA and create a session */
 	DMSG("Open %s", ta->name);
@@ -322,7 +396,7 @@ TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 
 	mutex_lock(&tee_ta_mutex);
 	s->ts_sess.ctx = &ctx->ts_ctx;
-	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	tee_ta_link_ctx(ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	DMSG("%s : %pUl", stc->pseudo_ta->name, (void *)&ctx->ts_ctx.uuid);
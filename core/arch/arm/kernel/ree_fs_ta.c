@@ -74,6 +74,88 @@ struct ta_ver_db_hdr {
 static const char ta_ver_db_obj_id[] = "ta_ver.db";
 static struct mutex ta_ver_db_mutex = MUTEX_INITIALIZER;
 
+#ifdef CFG_REE_FS_TA_SHDR_CACHE
+/*
+ * Cache of recently verified signed headers. A header matching an entry
+ * byte for byte has already had its signature verified against an image
+ * with the recorded hash, so the asymmetric operation can be skipped when
+ * the same TA is loaded again. The image is still hashed and compared
+ * against the header on every load, and the anti-rollback version check
+ * still runs, so a stale or substituted binary is rejected as before.
+ */
+#define SHDR_CACHE_NB_ENTRIES	8
+
+struct shdr_cache_entry {
+	bool valid;
+	struct shdr shdr;
+	uint8_t hash[TEE_SHA512_HASH_SIZE];
+};
+
+static struct shdr_cache_entry shdr_cache[SHDR_CACHE_NB_ENTRIES];
+static unsigned int shdr_cache_next;
+static struct mutex shdr_cache_mutex = MUTEX_INITIALIZER;
+
+static bool shdr_cache_match(const struct shdr_cache_entry *e,
+			     const struct shdr *shdr)
+{
+	return e->valid && !memcmp(&e->shdr, shdr, sizeof(*shdr)) &&
+	       !memcmp(e->hash, SHDR_GET_HASH(shdr), shdr->hash_size);
+}
+
+static bool shdr_is_cached(const struct shdr *shdr)
+{
+	bool found = false;
+	unsigned int n = 0;
+
+	if (shdr->hash_size > sizeof(shdr_cache[0].hash))
+		return false;
+
+	mutex_lock(&shdr_cache_mutex);
+	for (n = 0; n < SHDR_CACHE_NB_ENTRIES; n++) {
+		if (shdr_cache_match(shdr_cache + n, shdr)) {
+			found = true;
+			break;
+		}
+	}
+	mutex_unlock(&shdr_cache_mutex);
+
+	return found;
+}
+
+/* Called when @shdr and the image it covers have been fully verified */
+static void shdr_cache_insert(const struct shdr *shdr)
+{
+	struct shdr_cache_entry *e = NULL;
+	unsigned int n = 0;
+
+	if (shdr->hash_size > sizeof(shdr_cache[0].hash))
+		return;
+
+	mutex_lock(&shdr_cache_mutex);
+	for (n = 0; n < SHDR_CACHE_NB_ENTRIES; n++)
+		if (shdr_cache_match(shdr_cache + n, shdr))
+			goto out;
+
+	/* Replace entries in round robin order */
+	e = shdr_cache + shdr_cache_next;
+	shdr_cache_next = (shdr_cache_next + 1) % SHDR_CACHE_NB_ENTRIES;
+	e->shdr = *shdr;
+	memcpy(e->hash, SHDR_GET_HASH(shdr), shdr->hash_size);
+	e->valid = true;
+out:
+	mutex_unlock(&shdr_cache_mutex);
+}
+#else
+static bool shdr_is_cached(const struct shdr *shdr __unused)
+{
+	return false;
+}
+
+static void shdr_cache_insert(const struct shdr *shdr __unused)
+{
+}
+#endif /*CFG_REE_FS_TA_SHDR_CACHE*/
+
 /*
  * Load a TA via RPC with UUID defined by input param @uuid. The virtual
  * address of the raw TA binary is received in out parameter @ta.
@@ -154,10 +236,12 @@ static TEE_Result ree_fs_ta_open(const TEE_UUID *uuid,
 		goto error_free_payload;
 	}
 
-	/* Validate header signature */
-	res = shdr_verify_signature(shdr);
-	if (res != TEE_SUCCESS)
-		goto error_free_payload;
+	/* Validate header signature, unless this header was verified lately */
+	if (!shdr_is_cached(shdr)) {
+		res = shdr_verify_signature(shdr);
+		if (res != TEE_SUCCESS)
+			goto error_free_payload;
+	}
 	if (shdr->img_type != SHDR_TA && shdr->img_type != SHDR_BOOTSTRAP_TA &&
 	    shdr->img_type != SHDR_ENCRYPTED_TA) {
 		res = TEE_ERROR_SECURITY;
@@ -435,7 +519,7 @@ static TEE_Result ree_fs_ta_read(struct user_ta_store_handle *h, void *data,
 				return TEE_ERROR_SECURITY;
 		} else {
 			size_t num_bytes = 0;
-			size_t b_size = MIN(1024U, len);
+			size_t b_size = MIN((size_t)SMALL_PAGE_SIZE, len);
 			uint8_t *b = malloc(b_size);
 
 			if (!b)
@@ -462,8 +546,27 @@ static TEE_Result ree_fs_ta_read(struct user_ta_store_handle *h, void *data,
 				return TEE_ERROR_SECURITY;
 		}
 	} else if (data) {
-		dst = data; /* Hash secure buffer (shm might be modified) */
-		memcpy(dst, src, len);
+		size_t num_bytes = 0;
+		uint8_t *d = data; /* Hash secure buffer (shm might be modified) */
+
+		/*
+		 * Copy and hash in page sized chunks so that each chunk is
+		 * hashed while it is still hot in the data cache. Copying a
+		 * large segment first and hashing it afterwards would read
+		 * every byte from memory twice.
+		 */
+		while (num_bytes < len) {
+			size_t n = MIN((size_t)SMALL_PAGE_SIZE,
+				       len - num_bytes);
+
+			memcpy(d + num_bytes, src + num_bytes, n);
+			res = crypto_hash_update(handle->hash_ctx,
+						 d + num_bytes, n);
+			if (res != TEE_SUCCESS)
+				return TEE_ERROR_SECURITY;
+			num_bytes += n;
+		}
+		dst = NULL; /* Already hashed */
 	}
 
 	if (dst) {
@@ -494,6 +597,9 @@ static TEE_Result ree_fs_ta_read(struct user_ta_store_handle *h, void *data,
 
 		if (handle->bs_hdr)
 			res = check_update_version(handle->bs_hdr);
+
+		if (res == TEE_SUCCESS)
+			shdr_cache_insert(handle->shdr);
 	}
 	return res;
 }
@@ -512,7 +618,7 @@ static void ree_fs_ta_close(struct user_ta_store_handle *h)
 	free(handle);
 }
 
-#ifndef CFG_REE_FS_TA_BUFFERED
+#if !defined(CFG_REE_FS_TA_BUFFERED) && !defined(CFG_REE_FS_TA_RESIDENT)
 TEE_TA_REGISTER_TA_STORE(9) = {
 	.description = "REE",
 	.open = ree_fs_ta_open,
@@ -523,7 +629,7 @@ TEE_TA_REGISTER_TA_STORE(9) = {
 };
 #endif
 
-#ifdef CFG_REE_FS_TA_BUFFERED
+#if defined(CFG_REE_FS_TA_BUFFERED) || defined(CFG_REE_FS_TA_RESIDENT)
 
 /*
  * This is a wrapper around the "REE FS" TA store.
@@ -540,8 +646,132 @@ struct buf_ree_fs_ta_handle {
 	size_t offs;
 	uint8_t *tag;
 	unsigned int tag_len;
+#ifdef CFG_REE_FS_TA_RESIDENT
+	struct ta_img_cache_entry *ce;
+#endif
 };
 
+#ifdef CFG_REE_FS_TA_RESIDENT
+/*
+ * Cache of verified TA binaries. The buffer holding the authenticated
+ * plaintext image is kept resident after the last session has closed so
+ * that reopening the TA skips the load from tee-supplicant and the
+ * authentication. The TA instance itself is still torn down and recreated
+ * from the image, so it starts each open with a clean state. The price is
+ * that the cached copies occupy TA RAM and that an updated TA binary is
+ * not picked up until its entry has been evicted.
+ */
+#define TA_IMG_CACHE_NB_ENTRIES	4
+
+struct ta_img_cache_entry {
+	TEE_UUID uuid;
+	size_t size;
+	tee_mm_entry_t *mm;
+	uint8_t *buf;
+	uint8_t *tag;
+	unsigned int tag_len;
+	unsigned int ref_count;
+	bool cached;
+};
+
+static struct ta_img_cache_entry *ta_img_cache[TA_IMG_CACHE_NB_ENTRIES];
+static unsigned int ta_img_cache_next;
+static struct mutex ta_img_cache_mutex = MUTEX_INITIALIZER;
+
+static void ta_img_free(struct ta_img_cache_entry *ce)
+{
+	tee_mm_free(ce->mm);
+	free(ce->tag);
+	free(ce);
+}
+
+static struct ta_img_cache_entry *ta_img_cache_get(const TEE_UUID *uuid)
+{
+	struct ta_img_cache_entry *ce = NULL;
+	unsigned int n = 0;
+
+	mutex_lock(&ta_img_cache_mutex);
+	for (n = 0; n < TA_IMG_CACHE_NB_ENTRIES; n++) {
+		if (ta_img_cache[n] &&
+		    !memcmp(&ta_img_cache[n]->uuid, uuid, sizeof(*uuid))) {
+			ce = ta_img_cache[n];
+			ce->ref_count++;
+			break;
+		}
+	}
+	mutex_unlock(&ta_img_cache_mutex);
+
+	return ce;
+}
+
+static void ta_img_cache_put(struct ta_img_cache_entry *ce)
+{
+	bool do_free = false;
+
+	mutex_lock(&ta_img_cache_mutex);
+	assert(ce->ref_count);
+	ce->ref_count--;
+	do_free = !ce->ref_count && !ce->cached;
+	mutex_unlock(&ta_img_cache_mutex);
+
+	if (do_free)
+		ta_img_free(ce);
+}
+
+/* Takes ownership of the buffer and tag of @h on success */
+static struct ta_img_cache_entry *
+ta_img_cache_add(const TEE_UUID *uuid, struct buf_ree_fs_ta_handle *h)
+{
+	struct ta_img_cache_entry *ce = NULL;
+	struct ta_img_cache_entry *evicted = NULL;
+	unsigned int n = 0;
+
+	/* Failure isn't fatal, the handle then keeps its buffer */
+	ce = calloc(1, sizeof(*ce));
+	if (!ce)
+		return NULL;
+
+	ce->uuid = *uuid;
+	ce->size = h->ta_size;
+	ce->mm = h->mm;
+	ce->buf = h->buf;
+	ce->tag = h->tag;
+	ce->tag_len = h->tag_len;
+	ce->ref_count = 1;
+	ce->cached = true;
+
+	mutex_lock(&ta_img_cache_mutex);
+	for (n = 0; n < TA_IMG_CACHE_NB_ENTRIES; n++) {
+		if (ta_img_cache[n] &&
+		    !memcmp(&ta_img_cache[n]->uuid, uuid, sizeof(*uuid))) {
+			/* Raced with another open of the same TA */
+			mutex_unlock(&ta_img_cache_mutex);
+			free(ce);
+			return NULL;
+		}
+	}
+	for (n = 0; n < TA_IMG_CACHE_NB_ENTRIES; n++)
+		if (!ta_img_cache[n])
+			break;
+	if (n == TA_IMG_CACHE_NB_ENTRIES) {
+		/* Evict in round robin order */
+		n = ta_img_cache_next;
+		ta_img_cache_next = (n + 1) % TA_IMG_CACHE_NB_ENTRIES;
+		evicted = ta_img_cache[n];
+		evicted->cached = false;
+		if (evicted->ref_count)
+			evicted = NULL; /* Freed by the last user */
+	}
+	ta_img_cache[n] = ce;
+	mutex_unlock(&ta_img_cache_mutex);
+
+	if (evicted)
+		ta_img_free(evicted);
+
+	return ce;
+}
+#endif /*CFG_REE_FS_TA_RESIDENT*/
+
 static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 			      struct user_ta_store_handle **h)
 {
@@ -551,6 +781,17 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 	handle = calloc(1, sizeof(*handle));
 	if (!handle)
 		return TEE_ERROR_OUT_OF_MEMORY;
+#ifdef CFG_REE_FS_TA_RESIDENT
+	handle->ce = ta_img_cache_get(uuid);
+	if (handle->ce) {
+		handle->ta_size = handle->ce->size;
+		handle->buf = handle->ce->buf;
+		handle->tag = handle->ce->tag;
+		handle->tag_len = handle->ce->tag_len;
+		*h = (struct user_ta_store_handle *)handle;
+		return TEE_SUCCESS;
+	}
+#endif
 	res = ree_fs_ta_open(uuid, &handle->h);
 	if (res)
 		goto err2;
@@ -586,6 +827,13 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 	res = ree_fs_ta_read(handle->h, handle->buf, handle->ta_size);
 	if (res)
 		goto err;
+#ifdef CFG_REE_FS_TA_RESIDENT
+	handle->ce = ta_img_cache_add(uuid, handle);
+	if (handle->ce) {
+		/* Buffer and tag are now owned by the cache entry */
+		handle->mm = NULL;
+	}
+#endif
 	*h = (struct user_ta_store_handle *)handle;
 err:
 	ree_fs_ta_close(handle->h);
@@ -644,6 +892,13 @@ static void buf_ta_close(struct user_ta_store_handle *h)
 
 	if (!handle)
 		return;
+#ifdef CFG_REE_FS_TA_RESIDENT
+	if (handle->ce) {
+		ta_img_cache_put(handle->ce);
+		free(handle);
+		return;
+	}
+#endif
 	tee_mm_free(handle->mm);
 	free(handle->tag);
 	free(handle);
@@ -658,4 +913,4 @@ TEE_TA_REGISTER_TA_STORE(9) = {
 	.close = buf_ta_close,
 };
 
-#endif /* CFG_REE_FS_TA_BUFFERED */
+#endif /* CFG_REE_FS_TA_BUFFERED || CFG_REE_FS_TA_RESIDENT */
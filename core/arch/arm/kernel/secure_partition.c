@@ -294,7 +294,7 @@ TEE_Result sec_part_init_session(const TEE_UUID *uuid,
 
 	mutex_lock(&tee_ta_mutex);
 	spc->is_initializing = false;
-	TAILQ_INSERT_TAIL(&tee_ctxes, &spc->ta_ctx, link);
+	tee_ta_link_ctx(&spc->ta_ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	return TEE_SUCCESS;
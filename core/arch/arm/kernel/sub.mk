@@ -21,6 +21,18 @@ srcs-$(CFG_ARM32_core) += tlb_helpers_a32.S
 srcs-$(CFG_ARM64_core) += tlb_helpers_a64.S
 srcs-$(CFG_ARM64_core) += cache_helpers_a64.S
 srcs-$(CFG_ARM32_core) += cache_helpers_a32.S
+srcs-y += cache_helpers.c
+
+ifeq ($(CFG_CORE_NEON_MEMCPY),y)
+ifneq ($(CFG_WITH_VFP),y)
+$(error CFG_CORE_NEON_MEMCPY requires CFG_WITH_VFP)
+endif
+srcs-y += memcpy_accel.c
+srcs-$(CFG_ARM64_core) += memcpy_accel_a64.S
+srcs-$(CFG_ARM32_core) += memcpy_accel_a32.S
+endif
+
+srcs-$(CFG_CORE_PMU_PROFILING) += pmu.c
 srcs-$(CFG_PL310) += tz_ssvce_pl310_a32.S
 srcs-$(CFG_PL310) += tee_l2cc_mutex.c
 
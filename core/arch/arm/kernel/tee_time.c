@@ -4,8 +4,10 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <arm.h>
 #include <compiler.h>
 #include <initcall.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
 #include <kernel/thread.h>
 #include <kernel/time_source.h>
@@ -13,6 +15,7 @@
 #include <optee_rpc_cmd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <utee_defines.h>
 
 struct time_source _time_source;
 
@@ -42,6 +45,68 @@ void tee_time_wait(uint32_t milliseconds_delay)
 	thread_rpc_cmd(OPTEE_RPC_CMD_SUSPEND, 1, &params);
 }
 
+#if CFG_REE_TIME_CACHE_MS
+/*
+ * Last REE time obtained over RPC and the generic timer count it was
+ * taken at, used to serve readings without a world switch until the
+ * base is CFG_REE_TIME_CACHE_MS old.
+ */
+static unsigned int ree_time_cache_lock = SPINLOCK_UNLOCK;
+static TEE_Time ree_time_base;
+static uint64_t ree_time_base_cnt;
+static bool ree_time_base_valid;
+
+static bool get_cached_ree_time(TEE_Time *time)
+{
+	TEE_Time base = { };
+	uint64_t base_cnt = 0;
+	uint64_t ms = 0;
+	uint32_t exceptions = 0;
+	bool valid = false;
+
+	exceptions = cpu_spin_lock_xsave(&ree_time_cache_lock);
+	valid = ree_time_base_valid;
+	base = ree_time_base;
+	base_cnt = ree_time_base_cnt;
+	cpu_spin_unlock_xrestore(&ree_time_cache_lock, exceptions);
+
+	if (!valid)
+		return false;
+
+	ms = ((read_cntpct() - base_cnt) * TEE_TIME_MILLIS_BASE) /
+	     read_cntfrq();
+	if (ms >= CFG_REE_TIME_CACHE_MS)
+		return false;
+
+	ms += base.millis;
+	time->seconds = base.seconds + ms / TEE_TIME_MILLIS_BASE;
+	time->millis = ms % TEE_TIME_MILLIS_BASE;
+
+	return true;
+}
+
+static void set_cached_ree_time(const TEE_Time *time, uint64_t cnt)
+{
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&ree_time_cache_lock);
+	ree_time_base = *time;
+	ree_time_base_cnt = cnt;
+	ree_time_base_valid = true;
+	cpu_spin_unlock_xrestore(&ree_time_cache_lock, exceptions);
+}
+#else
+static bool get_cached_ree_time(TEE_Time *time __unused)
+{
+	return false;
+}
+
+static void set_cached_ree_time(const TEE_Time *time __unused,
+				uint64_t cnt __unused)
+{
+}
+#endif /*CFG_REE_TIME_CACHE_MS*/
+
 /*
  * tee_time_get_ree_time(): this function implements the GP Internal API
  * function TEE_GetREETime()
@@ -55,12 +120,21 @@ TEE_Result tee_time_get_ree_time(TEE_Time *time)
 	if (!time)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (get_cached_ree_time(time))
+		return TEE_SUCCESS;
+
 	struct thread_param params = THREAD_PARAM_VALUE(OUT, 0, 0, 0);
 
 	res = thread_rpc_cmd(OPTEE_RPC_CMD_GET_TIME, 1, &params);
 	if (res == TEE_SUCCESS) {
 		time->seconds = params.u.value.a;
 		time->millis = params.u.value.b / 1000000;
+		/*
+		 * The reading is slightly older than the counter sampled
+		 * here, extrapolated times err on the low side which
+		 * keeps them behind the next RPC refresh.
+		 */
+		set_cached_ree_time(time, read_cntpct());
 	}
 
 	return res;
@@ -8,6 +8,7 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <config.h>
 #include <io.h>
 #include <keep.h>
@@ -17,6 +18,7 @@
 #include <kernel/lockdep.h>
 #include <kernel/misc.h>
 #include <kernel/panic.h>
+#include <kernel/pmu.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread_defs.h>
@@ -36,6 +38,18 @@
 
 struct thread_ctx threads[CFG_NUM_THREADS];
 
+/*
+ * Bitmap of free entries in threads[], one bit per thread context. A set
+ * bit means that the corresponding entry is in state THREAD_STATE_FREE
+ * and may be claimed with a CAS without holding thread_global_lock. The
+ * bitmap only serves the allocation fast path in thread_alloc_and_run(),
+ * the states in threads[] remain authoritative and are still only
+ * changed while holding thread_global_lock or after having claimed the
+ * entry through the bitmap.
+ */
+#define THREAD_FREE_BITS_WORDS	((CFG_NUM_THREADS + 31) / 32)
+static uint32_t thread_free_bits[THREAD_FREE_BITS_WORDS];
+
 struct thread_core_local thread_core_local[CFG_TEE_CORE_NB_CORE] __nex_bss;
 
 /*
@@ -236,6 +250,106 @@ void thread_check_canaries(void)
 #endif/*CFG_WITH_STACK_CANARIES*/
 }
 
+#ifdef CFG_CORE_STACK_USAGE
+/*
+ * Value used to fill the stacks at boot. The high-water mark reported by
+ * thread_get_stack_usage() is the distance from the stack bottom to the
+ * first word which no longer holds this value.
+ */
+#define STACK_FILL_PATTERN	0x5a5a5a5a
+
+static void fill_stack(vaddr_t top, vaddr_t bottom)
+{
+	uint32_t *p = NULL;
+
+	for (p = (uint32_t *)top; (vaddr_t)(p + 1) <= bottom; p++)
+		*p = STACK_FILL_PATTERN;
+}
+
+static void init_stack_usage(void)
+{
+	/* Any value in the current stack frame will do */
+	vaddr_t current_sp = (vaddr_t)&current_sp;
+	vaddr_t bottom = 0;
+	vaddr_t top = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(stack_tmp); n++) {
+		top = GET_STACK_TOP_HARD(stack_tmp, n);
+		bottom = GET_STACK_BOTTOM(stack_tmp, n);
+		/*
+		 * The boot core is currently running on its temporary
+		 * stack, stop filling well below the live frames. The
+		 * skipped part only makes the reported usage of this stack
+		 * slightly pessimistic.
+		 */
+		if (current_sp >= top && current_sp <= bottom)
+			bottom = current_sp - 256;
+		if (bottom > top)
+			fill_stack(top, bottom);
+	}
+	for (n = 0; n < ARRAY_SIZE(stack_abt); n++)
+		fill_stack(GET_STACK_TOP_HARD(stack_abt, n),
+			   GET_STACK_BOTTOM(stack_abt, n));
+#if !defined(CFG_WITH_PAGER) && !defined(CFG_VIRTUALIZATION)
+	for (n = 0; n < ARRAY_SIZE(stack_thread); n++)
+		fill_stack(GET_STACK_TOP_HARD(stack_thread, n),
+			   GET_STACK_BOTTOM(stack_thread, n));
+#endif
+}
+
+bool thread_get_stack_usage(unsigned int which, size_t n, size_t *size,
+			    size_t *max_usage)
+{
+	vaddr_t bottom = 0;
+	vaddr_t top = 0;
+	uint32_t *p = NULL;
+
+	switch (which) {
+	case THREAD_STACK_TMP:
+		if (n >= ARRAY_SIZE(stack_tmp))
+			return false;
+		top = GET_STACK_TOP_HARD(stack_tmp, n);
+		bottom = GET_STACK_BOTTOM(stack_tmp, n);
+		break;
+	case THREAD_STACK_ABT:
+		if (n >= ARRAY_SIZE(stack_abt))
+			return false;
+		top = GET_STACK_TOP_HARD(stack_abt, n);
+		bottom = GET_STACK_BOTTOM(stack_abt, n);
+		break;
+#if !defined(CFG_WITH_PAGER) && !defined(CFG_VIRTUALIZATION)
+	case THREAD_STACK_THREAD:
+		if (n >= ARRAY_SIZE(stack_thread))
+			return false;
+		top = GET_STACK_TOP_HARD(stack_thread, n);
+		bottom = GET_STACK_BOTTOM(stack_thread, n);
+		break;
+#endif
+	default:
+		return false;
+	}
+
+	/*
+	 * Scanning a stack which is concurrently in use is fine, only the
+	 * part above the high-water mark is read and the mark can only
+	 * grow.
+	 */
+	for (p = (uint32_t *)top; (vaddr_t)p < bottom; p++)
+		if (*p != STACK_FILL_PATTERN)
+			break;
+
+	*size = bottom - top;
+	*max_usage = bottom - (vaddr_t)p;
+
+	return true;
+}
+#else
+static void init_stack_usage(void)
+{
+}
+#endif /*CFG_CORE_STACK_USAGE*/
+
 void thread_lock_global(void)
 {
 	cpu_spin_lock(&thread_global_lock);
@@ -508,6 +622,60 @@ static void init_regs(struct thread_ctx *thread, uint32_t a0, uint32_t a1,
 }
 #endif /*ARM64*/
 
+static void thread_free_bit_set(size_t n)
+{
+	uint32_t *w = thread_free_bits + n / 32;
+	uint32_t oval = atomic_load_u32(w);
+
+	while (!atomic_cas_u32(w, &oval, oval | BIT32(n % 32)))
+		;
+}
+
+static bool thread_free_bit_try_clear(size_t n)
+{
+	uint32_t *w = thread_free_bits + n / 32;
+	uint32_t oval = atomic_load_u32(w);
+
+	while (oval & BIT32(n % 32)) {
+		if (atomic_cas_u32(w, &oval, oval & ~BIT32(n % 32)))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Tries to claim a free entry in threads[] without taking
+ * thread_global_lock, returns the index of the claimed entry or -1 on
+ * failure. A successful CAS clearing a bit in thread_free_bits transfers
+ * exclusive ownership of the entry to this core, so the state can be
+ * updated without further synchronization.
+ *
+ * Entries that last ran on this core are preferred since their stacks
+ * and context data may still be warm in the local caches, entries last
+ * used by other cores are only claimed when no such entry is free.
+ */
+static ssize_t thread_claim_free_slot(void)
+{
+	unsigned int pos = get_core_pos();
+	size_t pass = 0;
+	size_t n = 0;
+
+	for (pass = 0; pass < 2; pass++) {
+		for (n = 0; n < CFG_NUM_THREADS; n++) {
+			if (!pass && threads[n].last_core != pos)
+				continue;
+			if (thread_free_bit_try_clear(n)) {
+				threads[n].state = THREAD_STATE_ACTIVE;
+				threads[n].last_core = pos;
+				return n;
+			}
+		}
+	}
+
+	return -1;
+}
+
 void thread_init_boot_thread(void)
 {
 	struct thread_core_local *l = thread_get_core_local();
@@ -516,6 +684,7 @@ void thread_init_boot_thread(void)
 
 	l->curr_thread = 0;
 	threads[0].state = THREAD_STATE_ACTIVE;
+	thread_free_bit_try_clear(0);
 }
 
 void __nostackcheck thread_clr_boot_thread(void)
@@ -525,6 +694,7 @@ void __nostackcheck thread_clr_boot_thread(void)
 	assert(l->curr_thread >= 0 && l->curr_thread < CFG_NUM_THREADS);
 	assert(threads[l->curr_thread].state == THREAD_STATE_ACTIVE);
 	threads[l->curr_thread].state = THREAD_STATE_FREE;
+	thread_free_bit_set(l->curr_thread);
 	l->curr_thread = -1;
 }
 
@@ -533,20 +703,35 @@ void thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
 	size_t n;
 	struct thread_core_local *l = thread_get_core_local();
 	bool found_thread = false;
+	ssize_t cn = -1;
 
 	assert(l->curr_thread == -1);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
+	cn = thread_claim_free_slot();
+	if (cn >= 0) {
+		n = cn;
+		found_thread = true;
+	} else {
+		/*
+		 * The lock-free fast path failed, fall back to scanning
+		 * the states under the global lock. An entry claimed here
+		 * may still have its free bit set if we raced with
+		 * thread_state_free(), so make sure to clear it.
+		 */
+		thread_lock_global();
+
+		for (n = 0; n < CFG_NUM_THREADS; n++) {
+			if (threads[n].state == THREAD_STATE_FREE &&
+			    thread_free_bit_try_clear(n)) {
+				threads[n].state = THREAD_STATE_ACTIVE;
+				threads[n].last_core = get_core_pos();
+				found_thread = true;
+				break;
+			}
 		}
-	}
 
-	thread_unlock_global();
+		thread_unlock_global();
+	}
 
 	if (!found_thread)
 		return;
@@ -557,6 +742,7 @@ void thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
 	init_regs(threads + n, a0, a1, a2, a3);
 
 	thread_lazy_save_ns_vfp();
+	pmu_thread_resume();
 
 	l->flags &= ~THREAD_CLF_TMP;
 	thread_resume(&threads[n].regs);
@@ -657,6 +843,7 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 
 	if (n < CFG_NUM_THREADS && threads[n].state == THREAD_STATE_SUSPENDED) {
 		threads[n].state = THREAD_STATE_ACTIVE;
+		threads[n].last_core = get_core_pos();
 		found_thread = true;
 	}
 
@@ -686,6 +873,7 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 	}
 
 	thread_lazy_save_ns_vfp();
+	pmu_thread_resume();
 
 	if (threads[n].have_user_map)
 		ftrace_resume();
@@ -813,6 +1001,7 @@ void thread_state_free(void)
 
 	assert(ct != -1);
 
+	pmu_thread_suspend();
 	thread_lazy_restore_ns_vfp();
 	tee_pager_release_phys(
 		(void *)(threads[ct].stack_va_end - STACK_THREAD_SIZE),
@@ -823,6 +1012,7 @@ void thread_state_free(void)
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
+	thread_free_bit_set(ct);
 	l->curr_thread = -1;
 
 #ifdef CFG_VIRTUALIZATION
@@ -869,8 +1059,18 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 		ftrace_suspend();
 
 	thread_check_canaries();
+	pmu_thread_suspend();
 
-	release_unused_kernel_stack(threads + ct, cpsr);
+	/*
+	 * A suspend caused by a foreign interrupt only leaves secure
+	 * world for as long as it takes normal world to service the
+	 * interrupt and is expected to resume shortly. Releasing the
+	 * unused part of the kernel stack back to the pager would only
+	 * force the pages to be faulted in again on resume, so keep the
+	 * stack intact for such exits.
+	 */
+	if (!(flags & THREAD_FLAGS_EXIT_ON_FOREIGN_INTR))
+		release_unused_kernel_stack(threads + ct, cpsr);
 
 	if (is_from_user(cpsr)) {
 		thread_user_save_vfp();
@@ -1059,6 +1259,7 @@ void thread_init_threads(void)
 	for (n = 0; n < CFG_NUM_THREADS; n++) {
 		TAILQ_INIT(&threads[n].tsd.sess_stack);
 		SLIST_INIT(&threads[n].tsd.pgt_cache);
+		thread_free_bit_set(n);
 	}
 }
 
@@ -1079,6 +1280,8 @@ void thread_init_primary(void)
 {
 	/* Initialize canaries around the stacks */
 	init_canaries();
+	/* Fill the stacks for the high-water mark tracking */
+	init_stack_usage();
 
 	init_user_kcode();
 }
@@ -1182,11 +1385,11 @@ void thread_init_per_cpu(void)
 
 	thread_init_vbar(get_excp_vect());
 
-#ifdef CFG_FTRACE_SUPPORT
+#if defined(CFG_FTRACE_SUPPORT) || defined(CFG_TA_CNTPCT_SYS_TIME)
 	/*
 	 * Enable accesses to frequency register and physical counter
 	 * register in EL0/PL0 required for timestamping during
-	 * function tracing.
+	 * function tracing and for the TEE_GetSystemTime() fast path.
 	 */
 	write_cntkctl(read_cntkctl() | CNTKCTL_PL0PCTEN);
 #endif
@@ -1687,6 +1890,24 @@ void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache)
 	}
 }
 
+void thread_rpc_shm_cache_drop(struct thread_shm_cache *cache)
+{
+	/*
+	 * Called when normal world tears down the RPC caches from a fast
+	 * call where no RPC can be done. Only the core side references
+	 * are released, the owner of the buffers is going away anyway.
+	 */
+	while (true) {
+		struct thread_shm_cache_entry *ce = SLIST_FIRST(cache);
+
+		if (!ce)
+			break;
+		SLIST_REMOVE_HEAD(cache, link);
+		mobj_put(ce->mobj);
+		free(ce);
+	}
+}
+
 #ifdef CFG_WITH_ARM_TRUSTED_FW
 /*
  * These five functions are __weak to allow platforms to override them if
@@ -3,12 +3,16 @@
  * Copyright (c) 2019, Linaro Limited
  */
 
+#include <arm.h>
 #include <assert.h>
 #include <compiler.h>
+#include <config.h>
 #include <io.h>
+#include <kernel/evtrace.h>
 #include <kernel/misc.h>
 #include <kernel/msg_param.h>
 #include <kernel/thread.h>
+#include <kernel/ts_manager.h>
 #include <kernel/virtualization.h>
 #include <mm/core_mmu.h>
 #include <optee_msg.h>
@@ -207,6 +211,7 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 {
 	uint32_t rv = 0;
 
+	evtrace_add(EVTRACE_STD_SMC_ENTRY);
 #ifdef CFG_VIRTUALIZATION
 	virt_on_stdcall();
 #endif
@@ -215,7 +220,17 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 	if (rv == OPTEE_SMC_RETURN_OK) {
 		struct thread_ctx *thr = threads + thread_get_id();
 
-		thread_rpc_shm_cache_clear(&thr->shm_cache);
+		/*
+		 * With CFG_RPC_PAYLOAD_CACHE the RPC payload buffers stay
+		 * cached in the thread across calls for as long as normal
+		 * world keeps the RPC argument cache enabled, so the
+		 * first RPC of a call doesn't need an allocation round
+		 * trip. They are dropped when the cache is disabled in
+		 * thread_disable_prealloc_rpc_cache().
+		 */
+		if (!IS_ENABLED(CFG_RPC_PAYLOAD_CACHE) ||
+		    !thread_prealloc_rpc_cache)
+			thread_rpc_shm_cache_clear(&thr->shm_cache);
 		if (!thread_prealloc_rpc_cache) {
 			thread_rpc_free_arg(mobj_get_cookie(thr->rpc_mobj));
 			mobj_put(thr->rpc_mobj);
@@ -224,6 +239,8 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 		}
 	}
 
+	evtrace_add(EVTRACE_STD_SMC_RETURN);
+
 	return rv;
 }
 
@@ -253,6 +270,9 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 	}
 
 	*cookie = 0;
+	if (IS_ENABLED(CFG_RPC_PAYLOAD_CACHE))
+		for (n = 0; n < CFG_NUM_THREADS; n++)
+			thread_rpc_shm_cache_drop(&threads[n].shm_cache);
 	thread_prealloc_rpc_cache = false;
 out:
 	thread_unlock_global();
@@ -476,6 +496,7 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = { OPTEE_SMC_RETURN_RPC_CMD };
 	void *arg = NULL;
 	uint64_t carg = 0;
+	uint64_t tref = 0;
 	uint32_t ret = 0;
 
 	/* The source CRYPTO_RNG_SRC_JITTER_RPC is safe to use here */
@@ -487,7 +508,13 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		return ret;
 
 	reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
+	evtrace_add(EVTRACE_RPC_CMD_SEND);
+	if (IS_ENABLED(CFG_TS_LATENCY_STATS))
+		tref = read_cntpct();
 	thread_rpc(rpc_args);
+	if (IS_ENABLED(CFG_TS_LATENCY_STATS))
+		ts_latency_add_rpc(read_cntpct() - tref);
+	evtrace_add(EVTRACE_RPC_CMD_DONE);
 
 	return get_rpc_arg_res(arg, num_params, params);
 }
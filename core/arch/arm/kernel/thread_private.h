@@ -58,6 +58,7 @@ struct thread_ctx {
 	enum thread_state state;
 	vaddr_t stack_va_end;
 	uint32_t flags;
+	unsigned int last_core;	/* Core the context last ran on */
 	struct core_mmu_user_map user_map;
 	bool have_user_map;
 #ifdef ARM64
@@ -240,5 +241,11 @@ void thread_svc_handler(struct thread_svc_regs *regs);
 
 /* Frees the cache of allocated FS RPC memory */
 void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache);
+
+/*
+ * Drops the cache of allocated FS RPC memory without telling normal
+ * world, for use in fast call context where no RPC can be done.
+ */
+void thread_rpc_shm_cache_drop(struct thread_shm_cache *cache);
 #endif /*__ASSEMBLER__*/
 #endif /*THREAD_PRIVATE_H*/
@@ -4,7 +4,9 @@
  * Copyright (c) 2019, Arm Limited. All rights reserved.
  */
 
+#include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <ffa.h>
 #include <io.h>
 #include <kernel/interrupt.h>
@@ -12,6 +14,7 @@
 #include <kernel/spinlock.h>
 #include <kernel/tee_misc.h>
 #include <kernel/thread.h>
+#include <kernel/ts_manager.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <optee_ffa.h>
@@ -399,7 +402,8 @@ static void handle_blocking_call(struct thread_smc_args *args)
 		break;
 	case OPTEE_FFA_EXCHANGE_CAPABILITIES:
 		set_args(args, FFA_MSG_SEND_DIRECT_RESP_32,
-			 swap_src_dst(args->a1), 0, 0, 0, 0);
+			 swap_src_dst(args->a1), 0, 0, 0,
+			 OPTEE_FFA_SEC_CAP_ARG_LIST);
 		break;
 	default:
 		EMSG("Unhandled blocking service ID %#"PRIx32,
@@ -866,12 +870,35 @@ void thread_spmc_msg_recv(struct thread_smc_args *args)
 	}
 }
 
+static uint32_t process_msg_arg(struct mobj *mobj, size_t offs)
+{
+	struct optee_msg_arg *arg = NULL;
+	uint32_t num_params = 0;
+	size_t end_offs = 0;
+
+	arg = mobj_get_va(mobj, offs);
+	if (!arg || !ALIGNMENT_IS_OK(arg, struct optee_msg_arg))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (ADD_OVERFLOW(offs, sizeof(*arg), &end_offs) ||
+	    !mobj_get_va(mobj, end_offs))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	num_params = READ_ONCE(arg->num_params);
+	if (num_params > OPTEE_MSG_MAX_NUM_PARAMS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (ADD_OVERFLOW(offs, OPTEE_MSG_GET_ARG_SIZE(num_params),
+			 &end_offs) || !mobj_get_va(mobj, end_offs))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return tee_entry_std(arg, num_params);
+}
+
 static uint32_t yielding_call_with_arg(uint64_t cookie)
 {
 	uint32_t rv = TEE_ERROR_BAD_PARAMETERS;
-	struct optee_msg_arg *arg = NULL;
 	struct mobj *mobj = NULL;
-	uint32_t num_params = 0;
 
 	mobj = mobj_ffa_get_by_cookie(cookie, 0);
 	if (!mobj) {
@@ -883,22 +910,62 @@ static uint32_t yielding_call_with_arg(uint64_t cookie)
 	if (rv)
 		goto out_put_mobj;
 
-	rv = TEE_ERROR_BAD_PARAMETERS;
-	arg = mobj_get_va(mobj, 0);
-	if (!arg)
-		goto out_dec_map;
+	rv = process_msg_arg(mobj, 0);
 
-	if (!mobj_get_va(mobj, sizeof(*arg)))
-		goto out_dec_map;
+	thread_rpc_shm_cache_clear(&threads[thread_get_id()].shm_cache);
 
-	num_params = READ_ONCE(arg->num_params);
-	if (num_params > OPTEE_MSG_MAX_NUM_PARAMS)
+	mobj_dec_map(mobj);
+out_put_mobj:
+	mobj_put(mobj);
+	return rv;
+}
+
+static uint32_t yielding_call_with_arg_list(uint64_t cookie)
+{
+	uint32_t rv = TEE_ERROR_BAD_PARAMETERS;
+	struct optee_ffa_arg_list *arg_list = NULL;
+	struct mobj *mobj = NULL;
+	uint32_t num_args = 0;
+	uint64_t offs = 0;
+	size_t sz = 0;
+	uint32_t n = 0;
+
+	mobj = mobj_ffa_get_by_cookie(cookie, 0);
+	if (!mobj) {
+		EMSG("Can't find cookie %#"PRIx64, cookie);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	rv = mobj_inc_map(mobj);
+	if (rv)
+		goto out_put_mobj;
+
+	rv = TEE_ERROR_BAD_PARAMETERS;
+	arg_list = mobj_get_va(mobj, 0);
+	if (!arg_list)
 		goto out_dec_map;
 
-	if (!mobj_get_va(mobj, OPTEE_MSG_GET_ARG_SIZE(num_params)))
+	num_args = READ_ONCE(arg_list->num_args);
+	if (MUL_OVERFLOW(sizeof(*arg_list->offs), num_args, &sz) ||
+	    ADD_OVERFLOW(sizeof(*arg_list), sz, &sz) ||
+	    !mobj_get_va(mobj, sz))
 		goto out_dec_map;
 
-	rv = tee_entry_std(arg, num_params);
+	/*
+	 * Process the requests in order on this thread, results are
+	 * written into each struct optee_msg_arg. Stop at the first
+	 * malformed message, leaving the remaining requests untouched.
+	 */
+	for (n = 0; n < num_args; n++) {
+		offs = READ_ONCE(arg_list->offs[n]);
+		if (offs != (size_t)offs) {
+			rv = TEE_ERROR_BAD_PARAMETERS;
+			break;
+		}
+		rv = process_msg_arg(mobj, offs);
+		if (rv)
+			break;
+	}
 
 	thread_rpc_shm_cache_clear(&threads[thread_get_id()].shm_cache);
 
@@ -946,6 +1013,8 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1,
 	switch (a1) {
 	case OPTEE_FFA_YIELDING_CALL_WITH_ARG:
 		return yielding_call_with_arg(reg_pair_to_64(a3, a2));
+	case OPTEE_FFA_YIELDING_CALL_WITH_ARG_LIST:
+		return yielding_call_with_arg_list(reg_pair_to_64(a3, a2));
 	case OPTEE_FFA_YIELDING_CALL_REGISTER_SHM:
 		return FFA_NOT_SUPPORTED;
 	case OPTEE_FFA_YIELDING_CALL_UNREGISTER_SHM:
@@ -1158,6 +1227,7 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 	};
 	uint64_t carg = 0;
 	struct optee_msg_arg *arg = NULL;
+	uint64_t tref = 0;
 	uint32_t ret = 0;
 
 	ret = get_rpc_arg(cmd, num_params, params, &arg, &carg);
@@ -1165,7 +1235,11 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		return ret;
 
 	reg_pair_from_64(carg, &rpc_arg.call.w6, &rpc_arg.call.w5);
+	if (IS_ENABLED(CFG_TS_LATENCY_STATS))
+		tref = read_cntpct();
 	thread_rpc(&rpc_arg);
+	if (IS_ENABLED(CFG_TS_LATENCY_STATS))
+		ts_latency_add_rpc(read_cntpct() - tref);
 
 	return get_rpc_arg_res(arg, num_params, params);
 }
@@ -2,12 +2,21 @@
 /*
  * Copyright (c) 2014, Linaro Limited
  */
-#include <stdbool.h>
-#include <trace.h>
-#include <console.h>
+#include <arm.h>
+#include <assert.h>
+#include <atomic.h>
+#include <config.h>
+#include <inttypes.h>
+#include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <mm/core_mmu.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <trace.h>
+#include <console.h>
+#include <util.h>
 
 const char trace_ext_prefix[] = "TC";
 int trace_level __nex_data = TRACE_LEVEL;
@@ -17,6 +26,111 @@ void __weak plat_trace_ext_puts(const char *str __unused)
 {
 }
 
+#ifdef CFG_CORE_TRACE_DEFERRED
+#define TRACE_RING_SIZE	U(CFG_CORE_TRACE_DEFERRED_BUF_SIZE)
+
+/*
+ * Per-core rings of pending trace output. trace_ext_puts() runs with
+ * all exceptions masked so each ring has a single producer, its owning
+ * core. trace_ext_drain() consumes all rings under @puts_lock. @head
+ * and @tail are free-running byte counters, hence TRACE_RING_SIZE must
+ * be a power of two. When a message doesn't fit the remainder is
+ * dropped and accounted in @dropped rather than stalling the producer.
+ */
+struct trace_ring {
+	uint32_t head;		/* Next byte to write, producer owned */
+	uint32_t tail;		/* Next byte to drain, under @puts_lock */
+	uint32_t dropped;	/* Bytes lost to a full ring */
+	uint32_t reported;	/* @dropped already reported, drainer owned */
+	char buf[TRACE_RING_SIZE];
+};
+
+static struct trace_ring trace_rings[CFG_TEE_CORE_NB_CORE] __nex_bss;
+
+static void trace_ring_puts(const char *str)
+{
+	struct trace_ring *r = trace_rings + get_core_pos();
+	uint32_t tail = atomic_load_u32(&r->tail);
+	uint32_t head = r->head;
+	uint32_t dropped = 0;
+	const char *p = NULL;
+
+	COMPILE_TIME_ASSERT(IS_POWER_OF_TWO(TRACE_RING_SIZE));
+
+	for (p = str; *p; p++) {
+		if (head - tail == TRACE_RING_SIZE) {
+			dropped = strlen(p);
+			break;
+		}
+		r->buf[head % TRACE_RING_SIZE] = *p;
+		head++;
+	}
+
+	/* Make the bytes observable before the new head position */
+	dsb();
+	atomic_store_u32(&r->head, head);
+	if (dropped)
+		atomic_store_u32(&r->dropped, r->dropped + dropped);
+}
+
+void trace_ext_drain(void)
+{
+	char msg[44] = { };
+	uint32_t itr_status = 0;
+	struct trace_ring *r = NULL;
+	uint32_t head = 0;
+	uint32_t dropped = 0;
+	size_t n = 0;
+	bool output = false;
+	const char *p = NULL;
+
+	if (!cpu_mmu_enabled())
+		return;
+
+	itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
+	cpu_spin_lock(&puts_lock);
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++) {
+		r = trace_rings + n;
+		head = atomic_load_u32(&r->head);
+		if (head != r->tail) {
+			/* Pair with the producer barrier before @head */
+			dsb();
+			output = true;
+		}
+		while (r->tail != head) {
+			console_putc(r->buf[r->tail % TRACE_RING_SIZE]);
+			atomic_store_u32(&r->tail, r->tail + 1);
+		}
+
+		dropped = atomic_load_u32(&r->dropped);
+		if (dropped != r->reported) {
+			snprintf(msg, sizeof(msg),
+				 "*** %" PRIu32 " trace bytes dropped\n",
+				 dropped - r->reported);
+			for (p = msg; *p; p++)
+				console_putc(*p);
+			r->reported = dropped;
+			output = true;
+		}
+	}
+
+	if (output)
+		console_flush();
+
+	cpu_spin_unlock(&puts_lock);
+	thread_unmask_exceptions(itr_status);
+}
+#else
+static void trace_ring_puts(const char *str __unused)
+{
+}
+
+void trace_ext_drain(void)
+{
+}
+#endif /*CFG_CORE_TRACE_DEFERRED*/
+
 void trace_ext_puts(const char *str)
 {
 	uint32_t itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
@@ -24,6 +138,12 @@ void trace_ext_puts(const char *str)
 	bool was_contended = false;
 	const char *p;
 
+	if (IS_ENABLED(CFG_CORE_TRACE_DEFERRED) && mmu_enabled) {
+		trace_ring_puts(str);
+		thread_unmask_exceptions(itr_status);
+		return;
+	}
+
 	if (mmu_enabled && !cpu_spin_trylock(&puts_lock)) {
 		was_contended = true;
 		cpu_spin_lock_no_dldetect(&puts_lock);
@@ -6,11 +6,13 @@
 
 #include <assert.h>
 #include <compiler.h>
+#include <config.h>
 #include <crypto/crypto.h>
 #include <ctype.h>
 #include <initcall.h>
 #include <keep.h>
 #include <kernel/linker.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
 #include <kernel/tee_ta_manager.h>
@@ -144,6 +146,38 @@ static void dec_recursion(void)
 	tsd->syscall_recursion--;
 }
 
+#ifdef CFG_FTRACE_SUPPORT
+/*
+ * Streams the ftrace buffer to normal world once it has filled beyond
+ * the watermark, while the returning entry point already pays for a
+ * world switch. The buffer is then restarted so long-running sessions
+ * deliver a continuous trace in chunks instead of invoking the
+ * CFG_FTRACE_BUF_WHEN_FULL policy and losing data.
+ */
+static void ftrace_flush_watermark(struct ts_session *s)
+{
+	struct ftrace_buf *fbuf = s->fbuf;
+
+	if (!IS_ENABLED(CFG_FTRACE_INCREMENTAL_DUMP) || !fbuf)
+		return;
+
+	if (fbuf->curr_size < fbuf->max_size / 4 * 3)
+		return;
+
+	/* Keep the dump itself out of the trace */
+	s->fbuf = NULL;
+	s->ctx->ops->dump_ftrace(s->ctx);
+	s->fbuf = fbuf;
+
+	/*
+	 * Restart the buffer. Functions still open keep their return
+	 * stack and begin times, their closing braces land in the next
+	 * chunk just as after a 'wrap' when the buffer fills.
+	 */
+	fbuf->curr_size = 0;
+}
+#endif /*CFG_FTRACE_SUPPORT*/
+
 static TEE_Result user_ta_enter(struct ts_session *session,
 				enum utee_entry_func func, uint32_t cmd)
 {
@@ -211,6 +245,10 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 		vm_clean_param(&utc->uctx);
 	}
 
+#ifdef CFG_FTRACE_SUPPORT
+	if (!utc->ta_ctx.panicked)
+		ftrace_flush_watermark(session);
+#endif
 
 	ts_sess = ts_pop_current_session();
 	assert(ts_sess == session);
@@ -672,6 +710,66 @@ static TEE_Result alloc_and_map_ldelf_fobj(struct user_ta_ctx *utc, size_t sz,
 	return res;
 }
 
+/*
+ * The ldelf code pages are the same in every context: ldelf runs without
+ * load time relocation so the bytes don't depend on the load address.
+ * Populate a fobj the first time ldelf is loaded and map it read-execute
+ * into each new context instead of copying the code again.
+ */
+static struct fobj *ldelf_code_fobj;
+static struct mutex ldelf_code_mutex = MUTEX_INITIALIZER;
+
+static TEE_Result map_ldelf_code(struct user_ta_ctx *utc, vaddr_t *code_addr)
+{
+	size_t num_pgs = ROUNDUP(ldelf_code_size, SMALL_PAGE_SIZE) /
+			 SMALL_PAGE_SIZE;
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	bool populate = false;
+
+	mutex_lock(&ldelf_code_mutex);
+	if (!ldelf_code_fobj) {
+		ldelf_code_fobj = fobj_ta_mem_alloc(num_pgs);
+		if (!ldelf_code_fobj) {
+			mutex_unlock(&ldelf_code_mutex);
+			return TEE_ERROR_OUT_OF_MEMORY;
+		}
+		populate = true;
+	}
+
+	mobj = mobj_with_fobj_alloc(ldelf_code_fobj, NULL);
+	if (!mobj) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err;
+	}
+	res = vm_map(&utc->uctx, code_addr, num_pgs * SMALL_PAGE_SIZE,
+		     populate ? TEE_MATTR_PRW : TEE_MATTR_URX,
+		     VM_FLAG_LDELF, mobj, 0);
+	mobj_put(mobj);
+	if (res)
+		goto err;
+
+	if (populate) {
+		vm_set_ctx(&utc->ta_ctx.ts_ctx);
+		memcpy((void *)*code_addr, ldelf_data, ldelf_code_size);
+		res = vm_set_prot(&utc->uctx, *code_addr,
+				  num_pgs * SMALL_PAGE_SIZE, TEE_MATTR_URX);
+		if (res)
+			goto err;
+	}
+	mutex_unlock(&ldelf_code_mutex);
+
+	return TEE_SUCCESS;
+err:
+	if (populate) {
+		fobj_put(ldelf_code_fobj);
+		ldelf_code_fobj = NULL;
+	}
+	mutex_unlock(&ldelf_code_mutex);
+
+	return res;
+}
+
 /*
  * This function may leave a few mappings behind on error, but that's taken
  * care of by tee_ta_init_user_ta_session() since the entire context is
@@ -693,8 +791,7 @@ static TEE_Result load_ldelf(struct user_ta_ctx *utc)
 		return res;
 	utc->ldelf_stack_ptr = stack_addr + LDELF_STACK_SIZE;
 
-	res = alloc_and_map_ldelf_fobj(utc, ldelf_code_size, TEE_MATTR_PRW,
-				       &code_addr);
+	res = map_ldelf_code(utc, &code_addr);
 	if (res)
 		return res;
 	utc->entry_func = code_addr + ldelf_entry;
@@ -707,15 +804,8 @@ static TEE_Result load_ldelf(struct user_ta_ctx *utc)
 
 	vm_set_ctx(&utc->ta_ctx.ts_ctx);
 
-	memcpy((void *)code_addr, ldelf_data, ldelf_code_size);
 	memcpy((void *)rw_addr, ldelf_data + ldelf_code_size, ldelf_data_size);
 
-	res = vm_set_prot(&utc->uctx, code_addr,
-			  ROUNDUP(ldelf_code_size, SMALL_PAGE_SIZE),
-			  TEE_MATTR_URX);
-	if (res)
-		return res;
-
 	DMSG("ldelf load address %#"PRIxVA, code_addr);
 
 	return TEE_SUCCESS;
@@ -735,6 +825,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	utc->is_initializing = true;
 	TAILQ_INIT(&utc->open_sessions);
 	TAILQ_INIT(&utc->cryp_states);
+	TAILQ_INIT(&utc->cryp_pool);
 	TAILQ_INIT(&utc->objects);
 	TAILQ_INIT(&utc->storage_enums);
 	condvar_init(&utc->ta_ctx.busy_cv);
@@ -760,7 +851,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	 * until this context is fully initialized. This is needed to
 	 * handle single instance TAs.
 	 */
-	TAILQ_INSERT_TAIL(&tee_ctxes, &utc->ta_ctx, link);
+	tee_ta_link_ctx(&utc->ta_ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	/*
@@ -781,7 +872,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 		utc->is_initializing = false;
 	} else {
 		s->ts_sess.ctx = NULL;
-		TAILQ_REMOVE(&tee_ctxes, &utc->ta_ctx, link);
+		tee_ta_unlink_ctx(&utc->ta_ctx);
 	}
 
 	/* The state has changed for the context, notify eventual waiters. */
@@ -29,7 +29,9 @@ void vfp_lazy_save_state_init(struct vfp_state *state)
 	uint32_t fpexc = vfp_read_fpexc();
 
 	state->fpexc = fpexc;
-	vfp_write_fpexc(fpexc & ~FPEXC_EN);
+	/* Skip the register write when VFP already is disabled */
+	if (fpexc & FPEXC_EN)
+		vfp_write_fpexc(fpexc & ~FPEXC_EN);
 }
 
 void vfp_lazy_save_state_final(struct vfp_state *state, bool force_save)
@@ -59,8 +61,16 @@ void vfp_lazy_restore_state(struct vfp_state *state, bool full_state)
 
 		vfp_write_fpscr(state->fpscr);
 		vfp_restore_extension_regs(state->reg);
+		vfp_write_fpexc(state->fpexc);
+	} else if (state->fpexc & FPEXC_EN) {
+		/*
+		 * The registers are intact and FPEXC is unchanged since
+		 * vfp_lazy_save_state_init() unless VFP was enabled and
+		 * had to be trapped, so only the enable bit needs to be
+		 * brought back.
+		 */
+		vfp_write_fpexc(state->fpexc);
 	}
-	vfp_write_fpexc(state->fpexc);
 }
 #endif /* ARM32 */
 
@@ -91,7 +101,9 @@ void vfp_disable(void)
 void vfp_lazy_save_state_init(struct vfp_state *state)
 {
 	state->cpacr_el1 = read_cpacr_el1();
-	vfp_disable();
+	/* Skip the register write and isb when FP/SIMD already traps */
+	if (CPACR_EL1_FPEN(state->cpacr_el1) & CPACR_EL1_FPEN_EL0EL1)
+		vfp_disable();
 }
 
 void vfp_lazy_save_state_final(struct vfp_state *state, bool force_save)
@@ -120,8 +132,17 @@ void vfp_lazy_restore_state(struct vfp_state *state, bool full_state)
 		write_fpcr(state->fpcr);
 		write_fpsr(state->fpsr);
 		vfp_restore_extension_regs(state->reg);
+		write_cpacr_el1(state->cpacr_el1);
+		isb();
+	} else if (CPACR_EL1_FPEN(state->cpacr_el1) & CPACR_EL1_FPEN_EL0EL1) {
+		/*
+		 * The registers are intact and CPACR_EL1 is unchanged
+		 * since vfp_lazy_save_state_init() unless FP/SIMD was
+		 * enabled and had to be trapped, so only the enable
+		 * field needs to be brought back.
+		 */
+		write_cpacr_el1(state->cpacr_el1);
+		isb();
 	}
-	write_cpacr_el1(state->cpacr_el1);
-	isb();
 }
 #endif /* ARM64 */
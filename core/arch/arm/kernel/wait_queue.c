@@ -2,18 +2,64 @@
 /*
  * Copyright (c) 2015-2016, Linaro Limited
  */
+#include <assert.h>
 #include <compiler.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/ts_manager.h>
 #include <kernel/wait_queue.h>
 #include <optee_rpc_cmd.h>
 #include <string.h>
 #include <tee_api_defines.h>
 #include <trace.h>
 #include <types_ext.h>
+#include <util.h>
 
 static unsigned wq_spin_lock;
 
+/*
+ * Each sleep or wakeup request is a full RPC round trip to normal
+ * world, so they are counted per thread to let the stats PTA expose
+ * where threads block and how often convoys form.
+ */
+static struct wq_cnt {
+	uint32_t sleeps;
+	uint32_t wakeups;
+} wq_cnt[CFG_NUM_THREADS];
+
+void wq_get_thread_stats(size_t thread_id, uint32_t *sleeps, uint32_t *wakeups)
+{
+	uint32_t old_itr_status = 0;
+
+	*sleeps = 0;
+	*wakeups = 0;
+	if (thread_id >= CFG_NUM_THREADS)
+		return;
+
+	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+
+	*sleeps = wq_cnt[thread_id].sleeps;
+	*wakeups = wq_cnt[thread_id].wakeups;
+
+	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+}
+
+static void wq_count_rpc(uint32_t func, int id)
+{
+	uint32_t old_itr_status = 0;
+
+	if (id < 0 || id >= CFG_NUM_THREADS)
+		return;
+
+	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+
+	if (func == OPTEE_RPC_WAIT_QUEUE_SLEEP)
+		wq_cnt[id].sleeps++;
+	else
+		wq_cnt[id].wakeups++;
+
+	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+}
 
 void wq_init(struct wait_queue *wq)
 {
@@ -39,38 +85,59 @@ void __weak __wq_rpc(uint32_t func, int id, const void *sync_obj __maybe_unused,
 
 	struct thread_param params = THREAD_PARAM_VALUE(IN, func, id, 0);
 
+	wq_count_rpc(func, id);
+
 	ret = thread_rpc_cmd(OPTEE_RPC_CMD_WAIT_QUEUE, 1, &params);
 	if (ret != TEE_SUCCESS)
 		DMSG("%s thread %u ret 0x%x", cmd_str, id, ret);
 }
 
-static void slist_add_tail(struct wait_queue *wq, struct wait_queue_elem *wqe)
+static void slist_add_prio(struct wait_queue *wq, struct wait_queue_elem *wqe)
 {
-	struct wait_queue_elem *wqe_iter;
-
-	/* Add elem to end of wait queue */
-	wqe_iter = SLIST_FIRST(wq);
-	if (wqe_iter) {
-		while (SLIST_NEXT(wqe_iter, link))
-			wqe_iter = SLIST_NEXT(wqe_iter, link);
-		SLIST_INSERT_AFTER(wqe_iter, wqe, link);
-	} else
+	struct wait_queue_elem *wqe_iter = NULL;
+	struct wait_queue_elem *wqe_prev = NULL;
+
+	/*
+	 * Add elem after the last element of the same or a higher
+	 * priority class so that higher classes are woken first while
+	 * order within a class stays FIFO.
+	 */
+	SLIST_FOREACH(wqe_iter, wq, link) {
+		if (wqe_iter->prio < wqe->prio)
+			break;
+		wqe_prev = wqe_iter;
+	}
+
+	if (wqe_prev)
+		SLIST_INSERT_AFTER(wqe_prev, wqe, link);
+	else
 		SLIST_INSERT_HEAD(wq, wqe, link);
 }
 
+static uint8_t wq_current_prio(void)
+{
+	struct ts_session *s = ts_get_current_session_may_fail();
+
+	if (s)
+		return s->wq_prio;
+
+	return WQ_PRIO_NORMAL;
+}
+
 void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
 		struct condvar *cv, bool wait_read)
 {
 	uint32_t old_itr_status;
 
 	wqe->handle = thread_get_id();
+	wqe->prio = wq_current_prio();
 	wqe->done = false;
 	wqe->wait_read = wait_read;
 	wqe->cv = cv;
 
 	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
 
-	slist_add_tail(wq, wqe);
+	slist_add_prio(wq, wqe);
 
 	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
 }
@@ -100,8 +167,9 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 {
 	uint32_t old_itr_status;
 	struct wait_queue_elem *wqe;
-	int handle = -1;
-	bool do_wakeup = false;
+	short handles[CFG_NUM_THREADS];
+	size_t num_handles = 0;
+	size_t n = 0;
 	bool wake_type_assigned = false;
 	bool wake_read = false; /* avoid gcc warning */
 
@@ -109,40 +177,42 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	 * If next type is wait_read wakeup all wqe with wait_read true.
 	 * If next type isn't wait_read wakeup only the first wqe which isn't
 	 * done.
+	 *
+	 * All eligible waiters are marked done in a single pass under the
+	 * spinlock and the wakeup RPCs are issued once it has been
+	 * released, so waking many readers takes the lock once instead of
+	 * once per waiter.
 	 */
 
-	while (true) {
-		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
 
-		SLIST_FOREACH(wqe, wq, link) {
-			if (wqe->cv)
-				continue;
-			if (wqe->done)
-				continue;
-			if (!wake_type_assigned) {
-				wake_read = wqe->wait_read;
-				wake_type_assigned = true;
-			}
-
-			if (wqe->wait_read != wake_read)
-				continue;
-
-			wqe->done = true;
-			handle = wqe->handle;
-			do_wakeup = true;
-			break;
+	SLIST_FOREACH(wqe, wq, link) {
+		if (wqe->cv)
+			continue;
+		if (wqe->done)
+			continue;
+		if (!wake_type_assigned) {
+			wake_read = wqe->wait_read;
+			wake_type_assigned = true;
 		}
 
-		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+		if (wqe->wait_read != wake_read)
+			continue;
 
-		if (do_wakeup)
-			__wq_rpc(OPTEE_RPC_WAIT_QUEUE_WAKEUP, handle,
-				 sync_obj, fname, lineno);
+		wqe->done = true;
+		assert(num_handles < ARRAY_SIZE(handles));
+		handles[num_handles] = wqe->handle;
+		num_handles++;
 
-		if (!do_wakeup || !wake_read)
+		if (!wake_read)
 			break;
-		do_wakeup = false;
 	}
+
+	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+
+	for (n = 0; n < num_handles; n++)
+		__wq_rpc(OPTEE_RPC_WAIT_QUEUE_WAKEUP, handles[n],
+			 sync_obj, fname, lineno);
 }
 
 void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
@@ -637,6 +637,7 @@ uint32_t core_mmu_type_to_attr(enum teecore_memtypes t)
 	case MEM_AREA_TEE_COHERENT:
 		return attr | TEE_MATTR_SECURE | TEE_MATTR_PRWX | noncache;
 	case MEM_AREA_TA_RAM:
+	case MEM_AREA_SEC_FAST_RAM:
 		return attr | TEE_MATTR_SECURE | TEE_MATTR_PRW | cached;
 	case MEM_AREA_NSEC_SHM:
 		return attr | TEE_MATTR_PRW | cached;
@@ -1131,6 +1132,7 @@ static void check_mem_map(struct tee_mmap_region *map)
 				panic("TEE_RAM can't fit in secure_only");
 			break;
 		case MEM_AREA_TA_RAM:
+		case MEM_AREA_SEC_FAST_RAM:
 			if (!pbuf_is_inside(secure_only, m->pa, m->size))
 				panic("TA_RAM can't fit in secure_only");
 			break;
@@ -1383,7 +1385,7 @@ void tlbi_mva_range(vaddr_t va, size_t size, size_t granule)
 
 	assert(granule == CORE_MMU_PGDIR_SIZE || granule == SMALL_PAGE_SIZE);
 
-	dsb_ishst();
+	tlbi_batch_begin();
 	while (sz) {
 		tlbi_mva_allasid_nosync(va);
 		if (sz < granule)
@@ -1391,8 +1393,7 @@ void tlbi_mva_range(vaddr_t va, size_t size, size_t granule)
 		sz -= granule;
 		va += granule;
 	}
-	dsb_ish();
-	isb();
+	tlbi_batch_end();
 }
 
 TEE_Result cache_op_inner(enum cache_op op, void *va, size_t len)
@@ -1402,13 +1403,13 @@ TEE_Result cache_op_inner(enum cache_op op, void *va, size_t len)
 		dcache_op_all(DCACHE_OP_CLEAN);
 		break;
 	case DCACHE_AREA_CLEAN:
-		dcache_clean_range(va, len);
+		dcache_op_range(va, len, DCACHE_OP_CLEAN);
 		break;
 	case DCACHE_INVALIDATE:
 		dcache_op_all(DCACHE_OP_INV);
 		break;
 	case DCACHE_AREA_INVALIDATE:
-		dcache_inv_range(va, len);
+		dcache_op_range(va, len, DCACHE_OP_INV);
 		break;
 	case ICACHE_INVALIDATE:
 		icache_inv_all();
@@ -1420,7 +1421,7 @@ TEE_Result cache_op_inner(enum cache_op op, void *va, size_t len)
 		dcache_op_all(DCACHE_OP_CLEAN_INV);
 		break;
 	case DCACHE_AREA_CLEAN_INV:
-		dcache_cleaninv_range(va, len);
+		dcache_op_range(va, len, DCACHE_OP_CLEAN_INV);
 		break;
 	default:
 		return TEE_ERROR_NOT_IMPLEMENTED;
@@ -1519,6 +1520,40 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 	uint32_t pgt_attr = (r.attr & TEE_MATTR_SECURE) | TEE_MATTR_TABLE;
 
 	while (r.va < end) {
+		size_t offset = r.va - region->va + region->offset;
+
+		/*
+		 * Map a whole CORE_MMU_PGDIR_SIZE aligned chunk with a
+		 * block entry in the directory when the mobj is physically
+		 * contiguous and the alignment allows it. The text and
+		 * data segments of large TAs are then covered with one
+		 * TLB entry per chunk instead of one per small page.
+		 */
+		if (!mobj_is_paged(region->mobj) &&
+		    !(r.va & CORE_MMU_PGDIR_MASK) &&
+		    end - r.va >= CORE_MMU_PGDIR_SIZE &&
+		    mobj_get_contig_run(region->mobj, offset) >=
+		    CORE_MMU_PGDIR_SIZE &&
+		    !mobj_get_pa(region->mobj, offset, 0, &r.pa) &&
+		    !(r.pa & CORE_MMU_PGDIR_MASK)) {
+			r.size = CORE_MMU_PGDIR_SIZE;
+			set_region(dir_info, &r);
+
+			/*
+			 * Keep the bookkeeping in step so the next chunk
+			 * assigns a fresh translation table.
+			 */
+			pg_info->va_base = r.va;
+			pg_info->table = NULL;
+#ifndef CFG_PAGED_USER_TA
+			/* Consume the table allocated for this chunk */
+			assert(*pgt);
+			*pgt = SLIST_NEXT(*pgt, link);
+#endif
+			r.va += r.size;
+			continue;
+		}
+
 		if (!pg_info->table ||
 		     r.va >= (pg_info->va_base + CORE_MMU_PGDIR_SIZE)) {
 			/*
@@ -1561,10 +1596,17 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 
 		if (!mobj_is_paged(region->mobj)) {
 			size_t granule = BIT(pg_info->shift);
-			size_t offset = r.va - region->va + region->offset;
 
+			/*
+			 * One physical address lookup covers a whole
+			 * physically contiguous run, not just one granule.
+			 * A contiguous buffer (e.g. registered CMA memory)
+			 * is then mapped with one lookup per translation
+			 * table instead of one per small page.
+			 */
 			r.size = MIN(r.size,
-				     mobj_get_phys_granule(region->mobj));
+				     mobj_get_contig_run(region->mobj,
+							 offset));
 			r.size = ROUNDUP(r.size, SMALL_PAGE_SIZE);
 
 			if (mobj_get_pa(region->mobj, offset, granule,
@@ -1855,8 +1897,16 @@ void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 
 	core_mmu_set_info_table(&pg_info, dir_info->level + 1, 0, NULL);
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link)
+	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
+		/*
+		 * Parked parameter mappings (CFG_TA_SHM_MAP_CACHE) only
+		 * reserve the virtual address range, there's nothing to
+		 * map until they are reused.
+		 */
+		if (!r->mobj)
+			continue;
 		set_pg_region(dir_info, r, &pgt, &pg_info);
+	}
 }
 
 bool core_mmu_add_mapping(enum teecore_memtypes type, paddr_t addr, size_t len)
@@ -2352,4 +2402,20 @@ void core_mmu_init_ta_ram(void)
 	tee_mm_final(&tee_mm_sec_ddr);
 	tee_mm_init(&tee_mm_sec_ddr, ps, pe, CORE_MMU_USER_CODE_SHIFT,
 		    TEE_MM_POOL_NO_FLAGS);
+
+	/*
+	 * If the platform has registered a fast secure RAM bank, make it
+	 * available as a separate pool so allocations on hot paths can be
+	 * steered to it.
+	 */
+	core_mmu_get_mem_by_type(MEM_AREA_SEC_FAST_RAM, &s, &e);
+	if (s < e) {
+		ps = virt_to_phys((void *)s);
+		pe = virt_to_phys((void *)(e - 1)) + 1;
+		if (!tee_pbuf_is_sec(ps, pe - ps))
+			panic("Fast secure RAM bank is not secure");
+		tee_mm_final(&tee_mm_sec_fast);
+		tee_mm_init(&tee_mm_sec_fast, ps, pe, SMALL_PAGE_SHIFT,
+			    TEE_MM_POOL_NO_FLAGS);
+	}
 }
@@ -833,12 +833,14 @@ void core_mmu_get_user_map(struct core_mmu_user_map *map)
 void core_mmu_set_user_map(struct core_mmu_user_map *map)
 {
 	uint64_t ttbr;
+	uint64_t asid = 0;
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
 	struct mmu_partition *prtn = get_prtn();
 
 	assert(user_va_idx != -1);
 
 	ttbr = read_ttbr0_64bit();
+	asid = (ttbr >> TTBR_ASID_SHIFT) & TTBR_ASID_MASK;
 	/* Clear ASID */
 	ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
 	write_ttbr0_64bit(ttbr);
@@ -864,7 +866,15 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		dsb();	/* Make sure the write above is visible */
 	}
 
-	tlbi_all();
+	/*
+	 * User mappings are tagged with their ASID, so entries of the
+	 * outgoing context can be invalidated selectively, leaving global
+	 * kernel entries and entries of other contexts intact. An ASID is
+	 * always invalidated when switched out, so no stale entries can
+	 * exist for the incoming context.
+	 */
+	if (asid)
+		tlbi_asid(asid);
 	icache_inv_all();
 
 	thread_unmask_exceptions(exceptions);
@@ -919,10 +929,12 @@ void core_mmu_get_user_map(struct core_mmu_user_map *map)
 void core_mmu_set_user_map(struct core_mmu_user_map *map)
 {
 	uint64_t ttbr;
+	uint64_t asid = 0;
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
 	struct mmu_partition *prtn = get_prtn();
 
 	ttbr = read_ttbr0_el1();
+	asid = (ttbr >> TTBR_ASID_SHIFT) & TTBR_ASID_MASK;
 	/* Clear ASID */
 	ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
 	write_ttbr0_el1(ttbr);
@@ -948,7 +960,15 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		dsb();	/* Make sure the write above is visible */
 	}
 
-	tlbi_all();
+	/*
+	 * User mappings are tagged with their ASID, so entries of the
+	 * outgoing context can be invalidated selectively, leaving global
+	 * kernel entries and entries of other contexts intact. An ASID is
+	 * always invalidated when switched out, so no stale entries can
+	 * exist for the incoming context.
+	 */
+	if (asid)
+		tlbi_asid(asid);
 	icache_inv_all();
 
 	thread_unmask_exceptions(exceptions);
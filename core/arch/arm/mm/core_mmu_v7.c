@@ -643,6 +643,7 @@ void core_mmu_get_user_map(struct core_mmu_user_map *map)
 void core_mmu_set_user_map(struct core_mmu_user_map *map)
 {
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	uint32_t asid = read_contextidr() & 0xff;
 
 	/*
 	 * Update the reserved Context ID and TTBR0
@@ -662,7 +663,15 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		isb();
 	}
 
-	tlbi_all();
+	/*
+	 * User mappings are tagged with their ASID, so entries of the
+	 * outgoing context can be invalidated selectively, leaving global
+	 * kernel entries and entries of other contexts intact. An ASID is
+	 * always invalidated when switched out, so no stale entries can
+	 * exist for the incoming context.
+	 */
+	if (asid)
+		tlbi_asid(asid);
 	icache_inv_all();
 
 	/* Restore interrupts */
@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <initcall.h>
 #include <keep.h>
 #include <kernel/linker.h>
@@ -55,12 +56,34 @@ static size_t mobj_reg_shm_size(size_t nr_pages)
 	return s;
 }
 
-static SLIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_list =
-	SLIST_HEAD_INITIALIZER(reg_shm_head);
+/*
+ * Registrations are kept in a hash table keyed by cookie, with one list
+ * and one spinlock per bucket. Cookie lookup is done for every RPC and
+ * parameter resolution, sharding keeps the searched list short and
+ * avoids serializing unrelated lookups on one global lock.
+ */
+#define REG_SHM_NUM_BUCKETS	64
+
+SLIST_HEAD(reg_shm_head, mobj_reg_shm);
+
+static struct reg_shm_bucket {
+	struct reg_shm_head list;
+	unsigned int lock;
+} reg_shm_buckets[REG_SHM_NUM_BUCKETS];
 
-static unsigned int reg_shm_slist_lock = SPINLOCK_UNLOCK;
 static unsigned int reg_shm_map_lock = SPINLOCK_UNLOCK;
 
+static struct reg_shm_bucket *reg_shm_bucket(uint64_t cookie)
+{
+	/*
+	 * Cookies are often normal world addresses with the low bits
+	 * zero, spread the bits before selecting a bucket.
+	 */
+	uint64_t h = cookie * UINT64_C(0x9e3779b97f4a7c15);
+
+	return reg_shm_buckets + (h >> 58) % REG_SHM_NUM_BUCKETS;
+}
+
 static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
 
 static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
@@ -101,6 +124,26 @@ static size_t mobj_reg_shm_get_phys_offs(struct mobj *mobj,
 	return to_mobj_reg_shm(mobj)->page_offset;
 }
 
+static size_t mobj_reg_shm_get_contig_run(struct mobj *mobj, size_t offs)
+{
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	size_t full_offset = 0;
+	size_t last = 0;
+	size_t n = 0;
+
+	if (offs >= mobj->size)
+		return 0;
+
+	full_offset = offs + r->page_offset;
+	n = full_offset / SMALL_PAGE_SIZE;
+	last = (r->page_offset + mobj->size - 1) / SMALL_PAGE_SIZE;
+	while (n < last && r->pages[n + 1] == r->pages[n] + SMALL_PAGE_SIZE)
+		n++;
+
+	return MIN((n + 1) * SMALL_PAGE_SIZE - full_offset,
+		   mobj->size - offs);
+}
+
 static void *mobj_reg_shm_get_va(struct mobj *mobj, size_t offst)
 {
 	struct mobj_reg_shm *mrs = to_mobj_reg_shm(mobj);
@@ -120,6 +163,15 @@ static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
 	r->mm = NULL;
 }
 
+/*
+ * Incremented each time a registration is freed. Frees in different
+ * buckets run under different locks so the counter is updated
+ * atomically. Readers only compare two samples of the counter so the
+ * plain read in mobj_reg_shm_release_count() is fine.
+ */
+static uint32_t reg_shm_releases;
+
+/* Call with the bucket lock of @mobj_reg_shm->cookie held */
 static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 {
 	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
@@ -129,13 +181,21 @@ static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
-	SLIST_REMOVE(&reg_shm_list, mobj_reg_shm, mobj_reg_shm, next);
+	SLIST_REMOVE(&reg_shm_bucket(mobj_reg_shm->cookie)->list,
+		     mobj_reg_shm, mobj_reg_shm, next);
+	atomic_inc32(&reg_shm_releases);
 	free(mobj_reg_shm);
 }
 
+uint32_t mobj_reg_shm_release_count(void)
+{
+	return reg_shm_releases;
+}
+
 static void mobj_reg_shm_free(struct mobj *mobj)
 {
 	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	struct reg_shm_bucket *bucket = reg_shm_bucket(r->cookie);
 	uint32_t exceptions = 0;
 
 	if (r->guarded && !r->releasing) {
@@ -146,17 +206,17 @@ static void mobj_reg_shm_free(struct mobj *mobj)
 		 * unless mobj_reg_shm_release_by_cookie() is waiting for
 		 * the mobj to be released.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&bucket->lock);
 		reg_shm_free_helper(r);
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 	} else {
 		/*
 		 * We've reached the point where an unguarded reg shm can
 		 * be released by cookie. Notify eventual waiters.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&bucket->lock);
 		r->release_frees = true;
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 		mutex_lock(&shm_mu);
 		if (shm_release_waiters)
@@ -240,6 +300,7 @@ static uint64_t mobj_reg_shm_get_cookie(struct mobj *mobj)
 static const struct mobj_ops mobj_reg_shm_ops __rodata_unpaged = {
 	.get_pa = mobj_reg_shm_get_pa,
 	.get_phys_offs = mobj_reg_shm_get_phys_offs,
+	.get_contig_run = mobj_reg_shm_get_contig_run,
 	.get_va = mobj_reg_shm_get_va,
 	.get_cattr = mobj_reg_shm_get_cattr,
 	.matches = mobj_reg_shm_matches,
@@ -267,6 +328,7 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 				paddr_t page_offset, uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
+	struct reg_shm_bucket *bucket = NULL;
 	size_t i = 0;
 	uint32_t exceptions = 0;
 	size_t s = 0;
@@ -291,19 +353,33 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 	memcpy(mobj_reg_shm->pages, pages, sizeof(*pages) * num_pages);
 
 	/* Ensure loaded references match format and security constraints */
-	for (i = 0; i < num_pages; i++) {
+	for (i = 0; i < num_pages; i++)
 		if (mobj_reg_shm->pages[i] & SMALL_PAGE_MASK)
 			goto err;
 
-		/* Only Non-secure memory can be mapped there */
+	/*
+	 * Only non-secure memory can be mapped there. Normal world often
+	 * supplies physically contiguous buffers (CMA allocations), check
+	 * each contiguous run with one query instead of page by page.
+	 */
+	for (i = 0; i < num_pages;) {
+		size_t n = i + 1;
+
+		while (n < num_pages &&
+		       mobj_reg_shm->pages[n] ==
+		       mobj_reg_shm->pages[n - 1] + SMALL_PAGE_SIZE)
+			n++;
+
 		if (!core_pbuf_is(CORE_MEM_NON_SEC, mobj_reg_shm->pages[i],
-				  SMALL_PAGE_SIZE))
+				  (n - i) * SMALL_PAGE_SIZE))
 			goto err;
+		i = n;
 	}
 
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	SLIST_INSERT_HEAD(&reg_shm_list, mobj_reg_shm, next);
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	bucket = reg_shm_bucket(cookie);
+	exceptions = cpu_spin_lock_xsave(&bucket->lock);
+	SLIST_INSERT_HEAD(&bucket->list, mobj_reg_shm, next);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 	return &mobj_reg_shm->mobj;
 err:
@@ -313,17 +389,20 @@ err:
 
 void mobj_reg_shm_unguard(struct mobj *mobj)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct reg_shm_bucket *bucket =
+		reg_shm_bucket(to_mobj_reg_shm(mobj)->cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&bucket->lock);
 
 	to_mobj_reg_shm(mobj)->guarded = false;
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 }
 
+/* Call with the bucket lock of @cookie held */
 static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
 
-	SLIST_FOREACH(mobj_reg_shm, &reg_shm_list, next)
+	SLIST_FOREACH(mobj_reg_shm, &reg_shm_bucket(cookie)->list, next)
 		if (mobj_reg_shm->cookie == cookie)
 			return mobj_reg_shm;
 
@@ -332,10 +411,11 @@ static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 
 struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct reg_shm_bucket *bucket = reg_shm_bucket(cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&bucket->lock);
 	struct mobj_reg_shm *r = reg_shm_find_unlocked(cookie);
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 	if (!r)
 		return NULL;
 
@@ -344,6 +424,7 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 {
+	struct reg_shm_bucket *bucket = reg_shm_bucket(cookie);
 	uint32_t exceptions = 0;
 	struct mobj_reg_shm *r = NULL;
 
@@ -353,14 +434,14 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	 * wrong cookie and perhaps a second time, regardless return
 	 * TEE_ERROR_BAD_PARAMETERS.
 	 */
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	exceptions = cpu_spin_lock_xsave(&bucket->lock);
 	r = reg_shm_find_unlocked(cookie);
 	if (!r || r->guarded || r->releasing)
 		r = NULL;
 	else
 		r->releasing = true;
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 	if (!r)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -381,12 +462,12 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	assert(shm_release_waiters);
 
 	while (true) {
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&bucket->lock);
 		if (r->release_frees) {
 			reg_shm_free_helper(r);
 			r = NULL;
 		}
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 		if (!r)
 			break;
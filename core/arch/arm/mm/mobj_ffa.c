@@ -10,6 +10,7 @@
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <mm/mobj.h>
+#include <string.h>
 #include <sys/queue.h>
 
 struct mobj_ffa {
@@ -37,6 +38,15 @@ static struct mobj_ffa_head shm_inactive_head =
 
 static unsigned int shm_lock = SPINLOCK_UNLOCK;
 
+/*
+ * The most recently freed object is kept around since normal world often
+ * re-registers a buffer of the same size shortly after it has been
+ * reclaimed and the pages[] array of a large buffer is an expensive
+ * allocation on the core heap.
+ */
+static struct mobj_ffa *shm_spare;
+static size_t shm_spare_size;
+
 static const struct mobj_ops mobj_ffa_ops __rodata_unpaged;
 
 static struct mobj_ffa *to_mobj_ffa(struct mobj *mobj)
@@ -56,9 +66,15 @@ static size_t shm_size(size_t num_pages)
 	return s;
 }
 
+static size_t get_page_count(struct mobj_ffa *mf)
+{
+	return ROUNDUP(mf->mobj.size, SMALL_PAGE_SIZE) / SMALL_PAGE_SIZE;
+}
+
 static struct mobj_ffa *ffa_new(unsigned int num_pages)
 {
 	struct mobj_ffa *mf = NULL;
+	uint32_t exceptions = 0;
 	size_t s = 0;
 
 	if (!num_pages)
@@ -67,7 +83,18 @@ static struct mobj_ffa *ffa_new(unsigned int num_pages)
 	s = shm_size(num_pages);
 	if (!s)
 		return NULL;
-	mf = calloc(1, s);
+
+	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	if (shm_spare && shm_spare_size == s) {
+		mf = shm_spare;
+		shm_spare = NULL;
+	}
+	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+
+	if (mf)
+		memset(mf, 0, s);
+	else
+		mf = calloc(1, s);
 	if (!mf)
 		return NULL;
 
@@ -79,6 +106,21 @@ static struct mobj_ffa *ffa_new(unsigned int num_pages)
 	return mf;
 }
 
+static void ffa_free(struct mobj_ffa *mf)
+{
+	size_t s = shm_size(get_page_count(mf));
+	struct mobj_ffa *old = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	old = shm_spare;
+	shm_spare = mf;
+	shm_spare_size = s;
+	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+
+	free(old);
+}
+
 #ifdef CFG_CORE_SEL1_SPMC
 struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages)
 {
@@ -103,7 +145,7 @@ struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages)
 	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
 
 	if (i == -1) {
-		free(mf);
+		ffa_free(mf);
 		return NULL;
 	}
 
@@ -111,11 +153,6 @@ struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages)
 }
 #endif /*CFG_CORE_SEL1_SPMC*/
 
-static size_t get_page_count(struct mobj_ffa *mf)
-{
-	return ROUNDUP(mf->mobj.size, SMALL_PAGE_SIZE) / SMALL_PAGE_SIZE;
-}
-
 static bool cmp_cookie(struct mobj_ffa *mf, uint64_t cookie)
 {
 	return mf->cookie == cookie;
@@ -182,7 +219,7 @@ void mobj_ffa_sel1_spmc_delete(struct mobj_ffa *mf)
 	assert(!mf->mm);
 	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
 
-	free(mf);
+	ffa_free(mf);
 }
 #endif /*CFG_CORE_SEL1_SPMC*/
 
@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <kernel/memcpy_accel.h>
 #include <kernel/mutex.h>
 #include <kernel/tee_misc.h>
 #include <mm/core_mmu.h>
@@ -32,6 +33,10 @@
  * be freed. A threads allocated tables are freed each time a TA is
  * unmapped so each thread should be able to allocate the needed tables in
  * turn if needed.
+ *
+ * Note that with CFG_VIRTUALIZATION the state below lives in the banked
+ * data/bss sections so each guest partition has its own pool, there's no
+ * sharing or lock contention between partitions.
  */
 
 #if defined(CFG_WITH_PAGER) && !defined(CFG_WITH_LPAE)
@@ -60,6 +65,8 @@ static struct pgt pgt_entries[PGT_CACHE_SIZE];
 
 static struct mutex pgt_mu = MUTEX_INITIALIZER;
 static struct condvar pgt_cv = CONDVAR_INITIALIZER;
+/* Number of threads blocked in pgt_alloc() waiting for tables to be freed */
+static size_t pgt_waiters;
 
 #if defined(CFG_WITH_PAGER) && defined(CFG_WITH_LPAE)
 void pgt_init(void)
@@ -124,7 +131,7 @@ static struct pgt *pop_from_free_list(void)
 
 	if (p) {
 		SLIST_REMOVE_HEAD(&pgt_free_list, link);
-		memset(p->tbl, 0, PGT_SIZE);
+		memset_accel(p->tbl, 0, PGT_SIZE);
 	}
 	return p;
 }
@@ -147,7 +154,7 @@ static struct pgt *pop_from_free_list(void)
 		if (p) {
 			SLIST_REMOVE_HEAD(&pgt_parents[n].pgt_cache, link);
 			pgt_parents[n].num_used++;
-			memset(p->tbl, 0, PGT_SIZE);
+			memset_accel(p->tbl, 0, PGT_SIZE);
 			return p;
 		}
 	}
@@ -269,7 +276,7 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 		if (!p)
 			return NULL;
 		tee_pager_pgt_save_and_release_entries(p);
-		memset(p->tbl, 0, PGT_SIZE);
+		memset_accel(p->tbl, 0, PGT_SIZE);
 	}
 	assert(!p->num_used_entries);
 	p->ctx = ctx;
@@ -396,7 +403,8 @@ void pgt_flush_ctx_range(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 		flush_ctx_range_from_list(pgt_cache, ctx, begin, last);
 	flush_ctx_range_from_list(&pgt_cache_list, ctx, begin, last);
 
-	condvar_broadcast(&pgt_cv);
+	if (pgt_waiters)
+		condvar_broadcast(&pgt_cv);
 	mutex_unlock(&pgt_mu);
 }
 
@@ -458,8 +466,10 @@ void pgt_alloc(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 	pgt_free_unlocked(pgt_cache, ctx);
 	while (!pgt_alloc_unlocked(pgt_cache, ctx, begin, last)) {
 		DMSG("Waiting for page tables");
+		pgt_waiters++;
 		condvar_broadcast(&pgt_cv);
 		condvar_wait(&pgt_cv, &pgt_mu);
+		pgt_waiters--;
 	}
 
 	mutex_unlock(&pgt_mu);
@@ -474,6 +484,7 @@ void pgt_free(struct pgt_cache *pgt_cache, bool save_ctx)
 
 	pgt_free_unlocked(pgt_cache, save_ctx);
 
-	condvar_broadcast(&pgt_cv);
+	if (pgt_waiters)
+		condvar_broadcast(&pgt_cv);
 	mutex_unlock(&pgt_mu);
 }
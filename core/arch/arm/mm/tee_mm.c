@@ -11,6 +11,13 @@
 #include <trace.h>
 #include <util.h>
 
+/*
+ * Largest pool, in granules, that gets a bitmap. A bitmap at this limit
+ * is 4KiB, covering for instance 128MiB of 4KiB pages. Larger pools
+ * fall back to the entry list walk.
+ */
+#define TEE_MM_BITMAP_MAX_BITS	(32 * 1024)
+
 static void *pmalloc(tee_mm_pool_t *pool, size_t size)
 {
 	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
@@ -50,13 +57,28 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_t hi, uint8_t shift,
 	pool->hi = hi;
 	pool->shift = shift;
 	pool->flags = flags;
+	pool->bitmap = NULL;
+	pool->nbits = 0;
+	pool->hint = 0;
 	pool->entry = pcalloc(pool, 1, sizeof(tee_mm_entry_t));
 
 	if (pool->entry == NULL)
 		return false;
 
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
 		pool->entry->offset = ((hi - lo - 1) >> shift) + 1;
+	} else {
+		size_t nbits = (hi - lo) >> shift;
+
+		/*
+		 * Failing to allocate the bitmap isn't fatal, the pool
+		 * then allocates by walking the entry list as before.
+		 */
+		if (nbits && nbits <= TEE_MM_BITMAP_MAX_BITS)
+			pool->bitmap = pcalloc(pool, 1, bitstr_size(nbits));
+		if (pool->bitmap)
+			pool->nbits = nbits;
+	}
 	pool->entry->pool = pool;
 	pool->lock = SPINLOCK_UNLOCK;
 
@@ -72,15 +94,68 @@ void tee_mm_final(tee_mm_pool_t *pool)
 		tee_mm_free(pool->entry->next);
 	pfree(pool, pool->entry);
 	pool->entry = NULL;
+	pfree(pool, pool->bitmap);
+	pool->bitmap = NULL;
+	pool->nbits = 0;
+	pool->hint = 0;
 }
 
 static void tee_mm_add(tee_mm_entry_t *p, tee_mm_entry_t *nn)
 {
 	/* add to list */
 	nn->next = p->next;
+	nn->prev = p;
+	if (nn->next)
+		nn->next->prev = nn;
 	p->next = nn;
 }
 
+/*
+ * Find a run of @psize clear bits in [@from, @to). Returns the first
+ * granule of the run in @offs.
+ */
+static bool bitmap_find_run(tee_mm_pool_t *pool, uint32_t from, uint32_t to,
+			    uint32_t psize, uint32_t *offs)
+{
+	uint32_t run = 0;
+	uint32_t n = 0;
+
+	for (n = from; n < to; n++) {
+		if (bit_test(pool->bitmap, n)) {
+			run = 0;
+			continue;
+		}
+		run++;
+		if (run == psize) {
+			*offs = n + 1 - psize;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Allocate @psize granules from the bitmap, false if no room */
+static bool bitmap_alloc(tee_mm_pool_t *pool, uint32_t psize, uint32_t *offs)
+{
+	if (!psize) {
+		*offs = 0;
+		return true;
+	}
+
+	if (psize > pool->nbits)
+		return false;
+
+	if (!bitmap_find_run(pool, pool->hint, pool->nbits, psize, offs) &&
+	    !bitmap_find_run(pool, 0, pool->nbits, psize, offs))
+		return false;
+
+	bit_nset(pool->bitmap, *offs, *offs + psize - 1);
+	pool->hint = (*offs + psize) % pool->nbits;
+
+	return true;
+}
+
 #ifdef CFG_WITH_STATS
 static size_t tee_mm_stats_allocated(tee_mm_pool_t *pool)
 {
@@ -157,6 +232,22 @@ tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size)
 	else
 		psize = ((size - 1) >> pool->shift) + 1;
 
+	if (pool->bitmap) {
+		uint32_t offs = 0;
+
+		if (!bitmap_alloc(pool, psize, &offs))
+			goto err;
+
+		tee_mm_add(pool->entry, nn);
+		nn->offset = offs;
+		nn->size = psize;
+		nn->pool = pool;
+
+		update_max_allocated(pool);
+		cpu_spin_unlock_xrestore(&pool->lock, exceptions);
+		return nn;
+	}
+
 	/* find free slot */
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
 		while (entry->next != NULL && psize >
@@ -266,6 +357,27 @@ tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 	offslo = (base - pool->lo) >> pool->shift;
 	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
 
+	if (pool->bitmap) {
+		paddr_t n = 0;
+
+		if (offshi > pool->nbits)
+			goto err;
+		for (n = offslo; n < offshi; n++)
+			if (bit_test(pool->bitmap, n))
+				goto err;
+		bit_nset(pool->bitmap, offslo, offshi - 1);
+
+		tee_mm_add(pool->entry, mm);
+
+		mm->offset = offslo;
+		mm->size = offshi - offslo;
+		mm->pool = pool;
+
+		update_max_allocated(pool);
+		cpu_spin_unlock_xrestore(&pool->lock, exceptions);
+		return mm;
+	}
+
 	/* find slot */
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
 		while (entry->next != NULL &&
@@ -297,23 +409,24 @@ err:
 
 void tee_mm_free(tee_mm_entry_t *p)
 {
-	tee_mm_entry_t *entry;
 	uint32_t exceptions;
 
 	if (!p || !p->pool)
 		return;
 
 	exceptions = cpu_spin_lock_xsave(&p->pool->lock);
-	entry = p->pool->entry;
-
-	/* remove entry from list */
-	while (entry->next != NULL && entry->next != p)
-		entry = entry->next;
 
-	if (!entry->next)
+	if (!p->prev || p->prev->next != p)
 		panic("invalid mm_entry");
 
-	entry->next = entry->next->next;
+	if (p->pool->bitmap && p->size)
+		bit_nclear(p->pool->bitmap, p->offset,
+			   p->offset + p->size - 1);
+
+	/* remove entry from list */
+	p->prev->next = p->next;
+	if (p->next)
+		p->next->prev = p->prev;
 	cpu_spin_unlock_xrestore(&p->pool->lock, exceptions);
 
 	pfree(p->pool, p);
@@ -350,6 +463,9 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool)
 /* Physical Secure DDR pool */
 tee_mm_pool_t tee_mm_sec_ddr;
 
+/* Physical fast secure RAM bank, empty unless the platform has one */
+tee_mm_pool_t tee_mm_sec_fast;
+
 /* Virtual eSRAM pool */
 tee_mm_pool_t tee_mm_vcore;
 
@@ -382,6 +498,30 @@ tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr)
 	return NULL;
 }
 
+tee_mm_entry_t *tee_mm_sec_alloc(size_t size)
+{
+	tee_mm_entry_t *mm = NULL;
+
+	if (tee_mm_sec_fast.entry)
+		mm = tee_mm_alloc(&tee_mm_sec_fast, size);
+	if (!mm)
+		mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+
+	return mm;
+}
+
+tee_mm_entry_t *tee_mm_sec_find(paddr_t addr)
+{
+	tee_mm_entry_t *mm = NULL;
+
+	if (tee_mm_sec_fast.entry)
+		mm = tee_mm_find(&tee_mm_sec_fast, addr);
+	if (!mm)
+		mm = tee_mm_find(&tee_mm_sec_ddr, addr);
+
+	return mm;
+}
+
 uintptr_t tee_mm_get_smem(const tee_mm_entry_t *mm)
 {
 	return (mm->offset << mm->pool->shift) + mm->pool->lo;
@@ -11,6 +11,7 @@
 #include <kernel/abort.h>
 #include <kernel/asan.h>
 #include <kernel/cache_helpers.h>
+#include <kernel/evtrace.h>
 #include <kernel/linker.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
@@ -95,6 +96,33 @@ static inline void incr_zi_released(void)
 	pager_stats.zi_released++;
 }
 
+/*
+ * Global page in/eviction counts, sampled around a fault to attribute
+ * the work done while handling it to the faulting user mode context.
+ */
+static size_t pager_pages_loaded;
+static size_t pager_evictions;
+
+static inline void incr_pages_loaded(void)
+{
+	pager_pages_loaded++;
+}
+
+static inline void incr_evictions(void)
+{
+	pager_evictions++;
+}
+
+static inline size_t stat_pages_loaded(void)
+{
+	return pager_pages_loaded;
+}
+
+static inline size_t stat_evictions(void)
+{
+	return pager_evictions;
+}
+
 static inline void incr_npages_all(void)
 {
 	pager_stats.npages_all++;
@@ -120,6 +148,10 @@ static inline void incr_ro_hits(void) { }
 static inline void incr_rw_hits(void) { }
 static inline void incr_hidden_hits(void) { }
 static inline void incr_zi_released(void) { }
+static inline void incr_pages_loaded(void) { }
+static inline void incr_evictions(void) { }
+static inline size_t stat_pages_loaded(void) { return 0; }
+static inline size_t stat_evictions(void) { return 0; }
 static inline void incr_npages_all(void) { }
 static inline void set_npages(void) { }
 
@@ -416,7 +448,7 @@ static vaddr_t area_idx2va(struct tee_pager_area *area, size_t idx)
 	return (idx << SMALL_PAGE_SHIFT) + (area->base & ~CORE_MMU_PGDIR_MASK);
 }
 
-static void area_tlbi_entry(struct tee_pager_area *area, size_t idx)
+static void area_tlbi_entry_nosync(struct tee_pager_area *area, size_t idx)
 {
 	vaddr_t va = area_idx2va(area, idx);
 
@@ -425,16 +457,24 @@ static void area_tlbi_entry(struct tee_pager_area *area, size_t idx)
 	if (area->pgt->ctx) {
 		uint32_t asid = to_user_mode_ctx(area->pgt->ctx)->vm_info.asid;
 
-		tlbi_mva_asid(va, asid);
+		tlbi_mva_asid_nosync(va, asid);
 		return;
 	}
 #endif
-	tlbi_mva_allasid(va);
+	tlbi_mva_allasid_nosync(va);
+}
+
+static void area_tlbi_entry(struct tee_pager_area *area, size_t idx)
+{
+	tlbi_batch_begin();
+	area_tlbi_entry_nosync(area, idx);
+	tlbi_batch_end();
 }
 
 static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
 {
 	struct tee_pager_area *area = NULL;
+	bool invalidated = false;
 	size_t tblidx = 0;
 	uint32_t a = 0;
 
@@ -452,9 +492,28 @@ static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
 		if (a & TEE_MATTR_VALID_BLOCK) {
 			area_set_entry(area, tblidx, 0, 0);
 			pgt_dec_used_entries(area->pgt);
-			area_tlbi_entry(area, tblidx);
+			invalidated = true;
 		}
 	}
+
+	if (!invalidated)
+		return;
+
+	/*
+	 * All entries are now written, one combined invalidation with a
+	 * single set of barriers covers them. Entries which already were
+	 * invalid are invalidated again rather than tracked, that is
+	 * harmless.
+	 */
+	tlbi_batch_begin();
+	TAILQ_FOREACH(area, &pmem->fobj->areas, fobj_link) {
+		if (only_this_pgt && area->pgt != only_this_pgt)
+			continue;
+		if (!area->pgt || !pmem_is_covered_by_area(pmem, area))
+			continue;
+		area_tlbi_entry_nosync(area, pmem_get_area_tblidx(pmem, area));
+	}
+	tlbi_batch_end();
 }
 
 void tee_pager_early_init(void)
@@ -943,6 +1002,7 @@ static void rem_area(struct tee_pager_area_head *area_head,
 	struct tee_pager_pmem *pmem;
 	size_t last_pgoffs = area->fobj_pgoffs +
 			     (area->size >> SMALL_PAGE_SHIFT) - 1;
+	bool invalidated = false;
 	uint32_t exceptions;
 	size_t idx = 0;
 	uint32_t a = 0;
@@ -964,8 +1024,26 @@ static void rem_area(struct tee_pager_area_head *area_head,
 			continue;
 
 		area_set_entry(area, idx, 0, 0);
-		area_tlbi_entry(area, idx);
 		pgt_dec_used_entries(area->pgt);
+		invalidated = true;
+	}
+
+	/*
+	 * One combined invalidation with a single set of barriers for all
+	 * the entries written above, including any already invalid ones
+	 * as invalidating those again is harmless.
+	 */
+	if (invalidated) {
+		tlbi_batch_begin();
+		TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
+			if (pmem->fobj != area->fobj ||
+			    pmem->fobj_pgidx < area->fobj_pgoffs ||
+			    pmem->fobj_pgidx > last_pgoffs)
+				continue;
+			area_tlbi_entry_nosync(area,
+					       pmem_get_area_tblidx(pmem, area));
+		}
+		tlbi_batch_end();
 	}
 
 	pager_unlock(exceptions);
@@ -1235,6 +1313,38 @@ static void tee_pager_hide_pages(void)
 	}
 }
 
+/*
+ * Number of dirty pages written back ahead of time per fault. Cleaning
+ * hidden pages while the lock is held anyway means the next evictions
+ * find clean victims and skip the encryption in the fault path.
+ */
+#define TEE_PAGER_NCLEAN	2
+
+static void tee_pager_clean_hidden_pages(void)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	size_t n = 0;
+
+	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
+		if (n >= TEE_PAGER_NCLEAN)
+			break;
+
+		if (!pmem->fobj || !pmem_is_hidden(pmem) ||
+		    !pmem_is_dirty(pmem))
+			continue;
+
+		/*
+		 * The page is unmapped so the content is stable while
+		 * the backing store is updated. If it's written again
+		 * after being unhidden it faults read-only, is tagged
+		 * dirty again and saved anew at eviction.
+		 */
+		tee_pager_save_page(pmem);
+		pmem->flags &= ~PMEM_FLAG_DIRTY;
+		n++;
+	}
+}
+
 static unsigned int __maybe_unused
 num_areas_with_pmem(struct tee_pager_pmem *pmem)
 {
@@ -1287,10 +1397,36 @@ static bool tee_pager_release_one_phys(struct tee_pager_area *area,
 	return false;
 }
 
-/* Finds the oldest page and unmaps it from all tables */
+/*
+ * Bounds the second-chance scan in tee_pager_get_page() to keep fault
+ * latency predictable when all pages near the head are recently used.
+ */
+#define PAGER_VICTIM_SCAN_MAX	4
+
+/*
+ * Finds a victim page in clock-like fashion and unmaps it from all
+ * tables. Pages are kept in age order and the hidden flag doubles as an
+ * inverted referenced bit since any access to a hidden page faults and
+ * unhides it. A page at the head that's still mapped has been
+ * referenced since it was hidden and is given a second chance at the
+ * tail, while a page that's still hidden is evicted.
+ */
 static struct tee_pager_pmem *tee_pager_get_page(enum tee_pager_area_type at)
 {
 	struct tee_pager_pmem *pmem;
+	size_t n;
+
+	for (n = 0; n < PAGER_VICTIM_SCAN_MAX; n++) {
+		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+		if (!pmem || !pmem->fobj || pmem_is_hidden(pmem))
+			break;
+
+		/* Referenced since the last scan, hide and reinsert */
+		pmem->flags |= PMEM_FLAG_HIDDEN;
+		pmem_unmap(pmem, NULL);
+		TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
+		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
+	}
 
 	pmem = TAILQ_FIRST(&tee_pager_pmem_head);
 	if (!pmem) {
@@ -1301,6 +1437,7 @@ static struct tee_pager_pmem *tee_pager_get_page(enum tee_pager_area_type at)
 	if (pmem->fobj) {
 		pmem_unmap(pmem, NULL);
 		tee_pager_save_page(pmem);
+		incr_evictions();
 	}
 
 	TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
@@ -1434,6 +1571,222 @@ static void stat_handle_fault(void)
 }
 #endif
 
+/* Returns true if the abort is a data abort caused by a write access */
+static bool abort_is_write_fault(struct abort_info *ai)
+{
+	if (ai->abort_type == ABORT_TYPE_PREFETCH)
+		return false;
+
+#ifdef ARM32
+	return ai->fault_descr & FSR_WNR;
+#else
+	return ai->fault_descr & ESR_ABT_WNR;
+#endif
+}
+
+#if defined(CFG_PAGED_USER_TA) && defined(CFG_WITH_STATS)
+/*
+ * Attributes a handled fault to the user mode context owning @area,
+ * @loaded0 and @evicted0 are the global counts sampled when the fault
+ * handling started. Called with the pager lock held.
+ */
+static void stat_um_fault(struct tee_pager_area *area, struct abort_info *ai,
+			  size_t loaded0, size_t evicted0)
+{
+	struct tee_pager_um_stats *stats = NULL;
+
+	if (!is_user_mode_ctx(area->pgt->ctx))
+		return;
+	stats = &to_user_mode_ctx(area->pgt->ctx)->pager_stats;
+
+	stats->faults++;
+	if (ai->abort_type == ABORT_TYPE_PREFETCH)
+		stats->exec_faults++;
+	else if (abort_is_write_fault(ai))
+		stats->write_faults++;
+	else
+		stats->read_faults++;
+	stats->pages_loaded += stat_pages_loaded() - loaded0;
+	stats->evictions += stat_evictions() - evicted0;
+}
+#else
+static void stat_um_fault(struct tee_pager_area *area __unused,
+			  struct abort_info *ai __unused,
+			  size_t loaded0 __unused, size_t evicted0 __unused)
+{
+}
+#endif
+
+#ifdef CFG_PAGER_FAULT_TRACE
+/*
+ * Ring of (PC, fault VA) pairs updated with the pager lock held, used
+ * to reconstruct which code paths thrash the pager.
+ */
+static struct tee_pager_fault_rec fault_trace[TEE_PAGER_FAULT_TRACE_SIZE];
+static size_t fault_trace_head;
+
+static void trace_fault(struct abort_info *ai)
+{
+	struct tee_pager_fault_rec *rec = fault_trace +
+		fault_trace_head % TEE_PAGER_FAULT_TRACE_SIZE;
+
+	rec->pc = ai->pc;
+	rec->va = ai->va;
+	fault_trace_head++;
+}
+
+size_t tee_pager_get_fault_trace(struct tee_pager_fault_rec *recs,
+				 size_t num_recs)
+{
+	uint32_t exceptions = 0;
+	size_t count = 0;
+
+	exceptions = pager_lock(NULL);
+	memcpy(recs, fault_trace,
+	       MIN(num_recs, (size_t)TEE_PAGER_FAULT_TRACE_SIZE) *
+	       sizeof(*recs));
+	count = fault_trace_head;
+	pager_unlock(exceptions);
+
+	return count;
+}
+#else
+static void trace_fault(struct abort_info *ai __unused)
+{
+}
+#endif
+
+/*
+ * Pages in and maps one page of an area at page_va. Called with the
+ * pager lock held both for the faulting page and for read-ahead of the
+ * pages that follow it. With dirty set the page is known to be written
+ * right away and is mapped writable and tagged dirty at once.
+ */
+static void pager_map_page_at(struct tee_pager_area *area, vaddr_t page_va,
+			      bool clean_user_cache, bool dirty)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	uint32_t attr = 0;
+	paddr_t pa = 0;
+	size_t tblidx = 0;
+
+	pmem = tee_pager_get_page(area->type);
+	if (!pmem)
+		panic();
+
+	/* load page code & data */
+	tee_pager_load_page(area, page_va, pmem->va_alias);
+	incr_pages_loaded();
+
+
+	pmem->fobj = area->fobj;
+	pmem->fobj_pgidx = area_va2idx(area, page_va) +
+			   area->fobj_pgoffs -
+			   ((area->base & CORE_MMU_PGDIR_MASK) >>
+				SMALL_PAGE_SHIFT);
+	tblidx = pmem_get_area_tblidx(pmem, area);
+	attr = get_area_mattr(area->flags);
+	/*
+	 * Pages from PAGER_AREA_TYPE_RW start read-only to be able to
+	 * tell when they are updated and should be tagged as dirty,
+	 * except when the faulting access itself is a write in which
+	 * case the extra permission fault is folded into this one.
+	 */
+	if (area->type == PAGER_AREA_TYPE_RW) {
+		if (dirty)
+			pmem->flags |= PMEM_FLAG_DIRTY;
+		else
+			attr &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
+	}
+	pa = get_pmem_pa(pmem);
+
+	/*
+	 * We've updated the page using the aliased mapping and
+	 * some cache maintenence is now needed if it's an
+	 * executable page.
+	 *
+	 * Since the d-cache is a Physically-indexed,
+	 * physically-tagged (PIPT) cache we can clean either the
+	 * aliased address or the real virtual address. In this
+	 * case we choose the real virtual address.
+	 *
+	 * The i-cache can also be PIPT, but may be something else
+	 * too like VIPT. The current code requires the caches to
+	 * implement the IVIPT extension, that is:
+	 * "instruction cache maintenance is required only after
+	 * writing new data to a physical address that holds an
+	 * instruction."
+	 *
+	 * To portably invalidate the icache the page has to
+	 * be mapped at the final virtual address but not
+	 * executable.
+	 */
+	if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
+		uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
+				TEE_MATTR_PW | TEE_MATTR_UW;
+		void *va = (void *)page_va;
+
+		/* Set a temporary read-only mapping */
+		area_set_entry(area, tblidx, pa, attr & ~mask);
+		area_tlbi_entry(area, tblidx);
+
+		dcache_clean_range_pou(va, SMALL_PAGE_SIZE);
+		if (clean_user_cache)
+			icache_inv_user_range(va, SMALL_PAGE_SIZE);
+		else
+			icache_inv_range(va, SMALL_PAGE_SIZE);
+
+		/* Set the final mapping */
+		area_set_entry(area, tblidx, pa, attr);
+		area_tlbi_entry(area, tblidx);
+	} else {
+		area_set_entry(area, tblidx, pa, attr);
+		/*
+		 * No need to flush TLB for this entry, it was
+		 * invalid. We should use a barrier though, to make
+		 * sure that the change is visible.
+		 */
+		dsb_ishst();
+	}
+	pgt_inc_used_entries(area->pgt);
+
+	FMSG("Mapped 0x%" PRIxVA " -> 0x%" PRIxPA, page_va, pa);
+}
+
+/*
+ * Number of extra pages paged in ahead of a faulting access. Faults
+ * cluster spatially both for code and for data that's streamed, so
+ * mapping the next pages of the same area while the pager lock is
+ * already held saves one full abort round trip per page.
+ */
+#define PAGER_READ_AHEAD	2
+
+static void tee_pager_read_ahead(struct tee_pager_area *area, vaddr_t page_va,
+				 bool clean_user_cache)
+{
+	vaddr_t va = page_va;
+	size_t n = 0;
+
+	for (n = 0; n < PAGER_READ_AHEAD; n++) {
+		uint32_t attr = 0;
+
+		va += SMALL_PAGE_SIZE;
+		if (va < page_va || va >= area->base + area->size)
+			break;
+
+		/* Skip pages that already are mapped */
+		area_get_entry(area, area_va2idx(area, va), NULL, &attr);
+		if (attr & TEE_MATTR_VALID_BLOCK)
+			continue;
+
+		/* Hidden pages keep going through the unhide path */
+		if (pmem_find(area, area_va2idx(area, va)))
+			continue;
+
+		pager_map_page_at(area, va, clean_user_cache, false);
+	}
+}
+
 bool tee_pager_handle_fault(struct abort_info *ai)
 {
 	struct tee_pager_area *area;
@@ -1441,6 +1794,8 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	uint32_t exceptions;
 	bool ret;
 	bool clean_user_cache = false;
+	size_t loaded0 = 0;
+	size_t evicted0 = 0;
 
 #ifdef TEE_PAGER_DEBUG_PRINT
 	if (!abort_is_user_exception(ai))
@@ -1458,9 +1813,14 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	 * page, instead we use the aliased mapping to populate the page
 	 * and once everything is ready we map it.
 	 */
+	evtrace_add(EVTRACE_PAGER_FAULT_ENTRY);
+
 	exceptions = pager_lock(ai);
 
 	stat_handle_fault();
+	trace_fault(ai);
+	loaded0 = stat_pages_loaded();
+	evicted0 = stat_evictions();
 
 	/* check if the access is valid */
 	if (abort_is_user_exception(ai)) {
@@ -1479,11 +1839,6 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	}
 
 	if (!tee_pager_unhide_page(area, area_va2idx(area, page_va))) {
-		struct tee_pager_pmem *pmem = NULL;
-		uint32_t attr = 0;
-		paddr_t pa = 0;
-		size_t tblidx = 0;
-
 		/*
 		 * The page wasn't hidden, but some other core may have
 		 * updated the table entry before we got here or we need
@@ -1498,90 +1853,22 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 			goto out;
 		}
 
-		pmem = tee_pager_get_page(area->type);
-		if (!pmem) {
-			abort_print(ai);
-			panic();
-		}
-
-		/* load page code & data */
-		tee_pager_load_page(area, page_va, pmem->va_alias);
-
-
-		pmem->fobj = area->fobj;
-		pmem->fobj_pgidx = area_va2idx(area, page_va) +
-				   area->fobj_pgoffs -
-				   ((area->base & CORE_MMU_PGDIR_MASK) >>
-					SMALL_PAGE_SHIFT);
-		tblidx = pmem_get_area_tblidx(pmem, area);
-		attr = get_area_mattr(area->flags);
-		/*
-		 * Pages from PAGER_AREA_TYPE_RW starts read-only to be
-		 * able to tell when they are updated and should be tagged
-		 * as dirty.
-		 */
-		if (area->type == PAGER_AREA_TYPE_RW)
-			attr &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
-		pa = get_pmem_pa(pmem);
-
-		/*
-		 * We've updated the page using the aliased mapping and
-		 * some cache maintenence is now needed if it's an
-		 * executable page.
-		 *
-		 * Since the d-cache is a Physically-indexed,
-		 * physically-tagged (PIPT) cache we can clean either the
-		 * aliased address or the real virtual address. In this
-		 * case we choose the real virtual address.
-		 *
-		 * The i-cache can also be PIPT, but may be something else
-		 * too like VIPT. The current code requires the caches to
-		 * implement the IVIPT extension, that is:
-		 * "instruction cache maintenance is required only after
-		 * writing new data to a physical address that holds an
-		 * instruction."
-		 *
-		 * To portably invalidate the icache the page has to
-		 * be mapped at the final virtual address but not
-		 * executable.
-		 */
-		if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
-			uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
-					TEE_MATTR_PW | TEE_MATTR_UW;
-			void *va = (void *)page_va;
-
-			/* Set a temporary read-only mapping */
-			area_set_entry(area, tblidx, pa, attr & ~mask);
-			area_tlbi_entry(area, tblidx);
-
-			dcache_clean_range_pou(va, SMALL_PAGE_SIZE);
-			if (clean_user_cache)
-				icache_inv_user_range(va, SMALL_PAGE_SIZE);
-			else
-				icache_inv_range(va, SMALL_PAGE_SIZE);
-
-			/* Set the final mapping */
-			area_set_entry(area, tblidx, pa, attr);
-			area_tlbi_entry(area, tblidx);
-		} else {
-			area_set_entry(area, tblidx, pa, attr);
-			/*
-			 * No need to flush TLB for this entry, it was
-			 * invalid. We should use a barrier though, to make
-			 * sure that the change is visible.
-			 */
-			dsb_ishst();
-		}
-		pgt_inc_used_entries(area->pgt);
-
-		FMSG("Mapped 0x%" PRIxVA " -> 0x%" PRIxPA, page_va, pa);
-
+		pager_map_page_at(area, page_va, clean_user_cache,
+				  abort_is_write_fault(ai) &&
+				  (area->flags &
+				   (TEE_MATTR_PW | TEE_MATTR_UW)));
 	}
 
+	tee_pager_read_ahead(area, page_va, clean_user_cache);
+
 	tee_pager_hide_pages();
+	tee_pager_clean_hidden_pages();
 	ret = true;
 out:
+	if (ret)
+		stat_um_fault(area, ai, loaded0, evicted0);
 	pager_unlock(exceptions);
+	evtrace_add(EVTRACE_PAGER_FAULT_RETURN);
 	return ret;
 }
 
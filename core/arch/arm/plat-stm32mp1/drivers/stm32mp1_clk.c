@@ -12,10 +12,12 @@
 #include <kernel/dt.h>
 #include <kernel/boot.h>
 #include <kernel/panic.h>
+#include <kernel/pm.h>
 #include <kernel/spinlock.h>
 #include <libfdt.h>
 #include <platform_config.h>
 #include <stdio.h>
+#include <string.h>
 #include <stm32_util.h>
 #include <trace.h>
 #include <util.h>
@@ -701,7 +703,7 @@ static unsigned long stm32mp1_read_pll_freq(enum stm32mp1_pll_id pll_id,
 	return dfout;
 }
 
-static unsigned long get_clock_rate(int p)
+static unsigned long compute_clock_rate(int p)
 {
 	uint32_t reg = 0;
 	unsigned long clock = 0;
@@ -901,6 +903,43 @@ static unsigned long get_clock_rate(int p)
 	return clock;
 }
 
+/*
+ * Computed rates, lazily filled in. OP-TEE core never reconfigures the
+ * clock tree (see stm32mp1_clk_early_init()) so a computed rate stays
+ * valid until the platform suspends, after which an earlier boot stage
+ * may have reconfigured the tree and the cache is reset.
+ */
+static unsigned long clock_rate_cache[_PARENT_NB];
+
+static unsigned long get_clock_rate(int p)
+{
+	unsigned long rate = 0;
+
+	if (p >= 0 && p < _PARENT_NB) {
+		rate = clock_rate_cache[p];
+		if (rate)
+			return rate;
+	}
+
+	rate = compute_clock_rate(p);
+
+	if (p >= 0 && p < _PARENT_NB)
+		clock_rate_cache[p] = rate;
+
+	return rate;
+}
+
+static TEE_Result clock_rate_cache_pm(enum pm_op op, uint32_t pm_hint __unused,
+				      const struct pm_callback_handle
+					      *hdl __unused)
+{
+	if (op == PM_OP_RESUME)
+		memset(clock_rate_cache, 0, sizeof(clock_rate_cache));
+
+	return TEE_SUCCESS;
+}
+DECLARE_KEEP_PAGER(clock_rate_cache_pm);
+
 static void __clk_enable(struct stm32mp1_clk_gate const *gate)
 {
 	vaddr_t base = stm32_rcc_base();
@@ -1308,7 +1347,7 @@ static TEE_Result stm32mp1_clk_early_init(void)
 	int ignored = 0;
 
 	fdt = get_embedded_dt();
-	node = fdt_node_offset_by_compatible(fdt, -1, DT_RCC_CLK_COMPAT);
+	node = dt_node_offset_by_compatible(fdt, -1, DT_RCC_CLK_COMPAT);
 
 	if (node < 0 || _fdt_reg_base_address(fdt, node) != RCC_BASE)
 		panic();
@@ -1363,6 +1402,8 @@ static TEE_Result stm32mp1_clk_early_init(void)
 
 	enable_static_secure_clocks();
 
+	register_pm_core_service_cb(clock_rate_cache_pm, NULL);
+
 	return TEE_SUCCESS;
 }
 
@@ -47,7 +47,7 @@ static int dt_get_pmic_node(void *fdt)
 	static int node = -FDT_ERR_BADOFFSET;
 
 	if (node == -FDT_ERR_BADOFFSET)
-		node = fdt_node_offset_by_compatible(fdt, -1, "st,stpmic1");
+		node = dt_node_offset_by_compatible(fdt, -1, "st,stpmic1");
 
 	return node;
 }
@@ -354,7 +354,7 @@ static int save_cpu_supply_name(void)
 	if (!cuint)
 		return -FDT_ERR_NOTFOUND;
 
-	node = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*cuint));
+	node = dt_node_offset_by_phandle(fdt, fdt32_to_cpu(*cuint));
 	if (node < 0)
 		return -FDT_ERR_NOTFOUND;
 
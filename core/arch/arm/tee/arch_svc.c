@@ -118,6 +118,10 @@ static const struct syscall_entry tee_svc_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_hash_update_iov),
+	SYSCALL_ENTRY(syscall_cipher_update_iov),
+	SYSCALL_ENTRY(syscall_authenc_update_payload_iov),
+	SYSCALL_ENTRY(syscall_asymm_verify_batch),
 };
 
 #ifdef TRACE_SYSCALLS
@@ -208,6 +212,71 @@ static void set_svc_retval(struct thread_svc_regs *regs, uint64_t ret_val)
 }
 #endif /*ARM64*/
 
+/*
+ * The syscalls dominating in profiles are called directly from here,
+ * skipping the argument marshalling frame set up by tee_svc_do_call().
+ * Only calls passing all their arguments in registers can be dispatched
+ * this way, and syscall_sys_return()/syscall_panic() never as they chase
+ * the stack record of tee_svc_do_call() to unwind.
+ */
+static bool scn_is_fast_path(size_t scn)
+{
+	switch (scn) {
+	case TEE_SCN_LOG:
+	case TEE_SCN_INVOKE_TA_COMMAND:
+	case TEE_SCN_HASH_UPDATE:
+	case TEE_SCN_CIPHER_UPDATE:
+	case TEE_SCN_AUTHENC_UPDATE_PAYLOAD:
+		return true;
+	default:
+		return false;
+	}
+}
+
+#ifdef ARM32
+typedef uint32_t (*syscall_reg_args_t)(unsigned long a0, unsigned long a1,
+				       unsigned long a2, unsigned long a3);
+
+static bool try_fast_call(struct thread_svc_regs *regs, size_t scn,
+			  size_t max_args, syscall_t scf)
+{
+	syscall_reg_args_t f = (syscall_reg_args_t)scf;
+
+	if (max_args || !scn_is_fast_path(scn))
+		return false;
+
+	set_svc_retval(regs, f(regs->r0, regs->r1, regs->r2, regs->r3));
+	return true;
+}
+#endif /*ARM32*/
+
+#ifdef ARM64
+typedef uint32_t (*syscall_reg_args_t)(unsigned long a0, unsigned long a1,
+				       unsigned long a2, unsigned long a3,
+				       unsigned long a4, unsigned long a5,
+				       unsigned long a6, unsigned long a7);
+
+static bool try_fast_call(struct thread_svc_regs *regs, size_t scn,
+			  size_t max_args, syscall_t scf)
+{
+	syscall_reg_args_t f = (syscall_reg_args_t)scf;
+
+	if (max_args || !scn_is_fast_path(scn))
+		return false;
+
+	if (((regs->spsr >> SPSR_MODE_RW_SHIFT) & SPSR_MODE_RW_MASK) ==
+	    SPSR_MODE_RW_32)
+		set_svc_retval(regs, f((uint32_t)regs->x0, (uint32_t)regs->x1,
+				       (uint32_t)regs->x2, (uint32_t)regs->x3,
+				       0, 0, 0, 0));
+	else
+		set_svc_retval(regs, f(regs->x0, regs->x1, regs->x2, regs->x3,
+				       regs->x4, regs->x5, regs->x6,
+				       regs->x7));
+	return true;
+}
+#endif /*ARM64*/
+
 static syscall_t get_syscall_func(size_t num)
 {
 	/* Cast away const */
@@ -243,7 +312,8 @@ bool user_ta_handle_svc(struct thread_svc_regs *regs)
 
 	ftrace_syscall_enter(scn);
 
-	set_svc_retval(regs, tee_svc_do_call(regs, scf));
+	if (!try_fast_call(regs, scn, max_args, scf))
+		set_svc_retval(regs, tee_svc_do_call(regs, scf));
 
 	ftrace_syscall_leave();
 
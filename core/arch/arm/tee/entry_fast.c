@@ -12,6 +12,7 @@
 #include <kernel/virtualization.h>
 #include <kernel/misc.h>
 #include <mm/core_mmu.h>
+#include <trace.h>
 
 #ifdef CFG_CORE_RESERVED_SHM
 static void tee_entry_get_shm_config(struct thread_smc_args *args)
@@ -187,6 +188,9 @@ void __weak tee_entry_fast(struct thread_smc_args *args)
  */
 void __tee_entry_fast(struct thread_smc_args *args)
 {
+	/* Push trace output deferred by CFG_CORE_TRACE_DEFERRED */
+	trace_ext_drain();
+
 	switch (args->a0) {
 
 	/* Generic functions */
@@ -452,6 +452,66 @@ out:
 	arg->ret_origin = err_orig;
 }
 
+/*
+ * Invokes a sequence of commands on the same session to amortize the
+ * SMC world switch over many small invocations. Each command is
+ * described by one meta value parameter followed by the parameters of
+ * the command, see OPTEE_MSG_CMD_INVOKE_BATCH in optee_msg.h.
+ */
+static void entry_invoke_batch(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	TEE_Result res = TEE_SUCCESS;
+	TEE_ErrorOrigin err_orig = TEE_ORIGIN_TEE;
+	struct tee_ta_session *s = NULL;
+	size_t n = 0;
+
+	s = tee_ta_get_session(arg->session, true, &tee_open_sessions);
+	if (!s) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	while (n < num_params) {
+		struct tee_ta_param param = { 0 };
+		uint64_t saved_attr[TEE_NUM_PARAMS] = { 0 };
+		uint64_t attr = READ_ONCE(arg->params[n].attr);
+		uint32_t func = READ_ONCE(arg->params[n].u.value.a);
+		uint32_t cnt = READ_ONCE(arg->params[n].u.value.b);
+
+		if (attr != (OPTEE_MSG_ATTR_META |
+			     OPTEE_MSG_ATTR_TYPE_VALUE_INOUT) ||
+		    cnt > TEE_NUM_PARAMS || cnt > num_params - n - 1) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			err_orig = TEE_ORIGIN_TEE;
+			break;
+		}
+
+		res = copy_in_params(arg->params + n + 1, cnt, &param,
+				     saved_attr);
+		if (res == TEE_SUCCESS) {
+			err_orig = TEE_ORIGIN_TEE;
+			res = tee_ta_invoke_command(&err_orig, s,
+						    NSAPP_IDENTITY,
+						    TEE_TIMEOUT_INFINITE,
+						    func, &param);
+			copy_out_param(&param, cnt, arg->params + n + 1,
+				       saved_attr);
+		}
+		cleanup_shm_refs(saved_attr, &param, cnt);
+
+		arg->params[n].u.value.c = res;
+		if (res != TEE_SUCCESS)
+			break;
+
+		n += cnt + 1;
+	}
+
+	tee_ta_put_session(s);
+out:
+	arg->ret = res;
+	arg->ret_origin = err_orig;
+}
+
 static void entry_cancel(struct optee_msg_arg *arg, uint32_t num_params)
 {
 	TEE_Result res;
@@ -548,6 +608,9 @@ uint32_t __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 	case OPTEE_MSG_CMD_INVOKE_COMMAND:
 		entry_invoke_command(arg, num_params);
 		break;
+	case OPTEE_MSG_CMD_INVOKE_BATCH:
+		entry_invoke_batch(arg, num_params);
+		break;
 	case OPTEE_MSG_CMD_CANCEL:
 		entry_cancel(arg, num_params);
 		break;
@@ -40,6 +40,21 @@ CFG_CRYPTO_DH ?= y
 # ECC includes ECDSA and ECDH
 CFG_CRYPTO_ECC ?= y
 ifeq ($(CFG_CRYPTOLIB_NAME),tomcrypt)
+# Cache fixed point lookup tables for ECC point multiplication. Repeated
+# point multiplications on the same base point, as when signing over and
+# over with a key on the same curve, skip the expensive double-and-add
+# loop once the table for that base point is built. Costs heap memory
+# per cached base point, tuned with the _ENTRIES (number of cached base
+# points) and _LUT (log2 of the table size per point) values below. The
+# table lookups are indexed by secret scalar bits, so leave this
+# disabled where cache timing attacks on the scalar are a concern.
+CFG_CRYPTO_ECC_FP_MULMOD ?= n
+CFG_CRYPTO_ECC_FP_MULMOD_ENTRIES ?= 4
+CFG_CRYPTO_ECC_FP_MULMOD_LUT ?= 6
+# Specialized constant-time NIST P-256 point multiplication with fixed
+# width machine-word field arithmetic instead of generic heap allocated
+# bignums. Other curves transparently fall back to the generic code.
+CFG_CRYPTO_ECC_P256_MULMOD ?= y
 CFG_CRYPTO_SM2_PKE ?= y
 CFG_CRYPTO_SM2_DSA ?= y
 CFG_CRYPTO_SM2_KEP ?= y
@@ -62,6 +77,13 @@ CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB ?= n
 
 endif
 
+# When a crypto driver (CFG_CRYPTO_DRIVER) provides hash algorithms, hash
+# operations whose first update chunk is smaller than this size in bytes are
+# processed with the software implementation instead: small operations are
+# typically faster in software than through the accelerator job interface.
+# 0 always selects the driver.
+CFG_CRYPTO_DRV_HASH_MIN_SIZE ?= 0
+
 ifeq ($(CFG_WITH_PAGER),y)
 ifneq ($(CFG_CRYPTO_SHA256),y)
 $(warning Warning: Enabling CFG_CRYPTO_SHA256 [required by CFG_WITH_PAGER])
@@ -165,6 +187,8 @@ ifeq ($(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB),y)
 core-ltc-vars += GCM
 endif
 core-ltc-vars += RSA DSA DH ECC
+core-ltc-vars += ECC_FP_MULMOD
+core-ltc-vars += ECC_P256_MULMOD
 core-ltc-vars += SIZE_OPTIMIZATION
 core-ltc-vars += SM2_PKE
 core-ltc-vars += SM2_DSA
@@ -172,6 +196,8 @@ core-ltc-vars += SM2_KEP
 # Assigned selected CFG_CRYPTO_xxx as _CFG_CORE_LTC_xxx
 $(foreach v, $(core-ltc-vars), $(eval _CFG_CORE_LTC_$(v) := $(CFG_CRYPTO_$(v))))
 _CFG_CORE_LTC_MPI := $(CFG_CORE_MBEDTLS_MPI)
+_CFG_CORE_LTC_ECC_FP_ENTRIES := $(CFG_CRYPTO_ECC_FP_MULMOD_ENTRIES)
+_CFG_CORE_LTC_ECC_FP_LUT := $(CFG_CRYPTO_ECC_FP_MULMOD_LUT)
 _CFG_CORE_LTC_AES_ACCEL := $(CFG_CORE_CRYPTO_AES_ACCEL)
 _CFG_CORE_LTC_SHA1_ACCEL := $(CFG_CORE_CRYPTO_SHA1_ACCEL)
 _CFG_CORE_LTC_SHA256_ACCEL := $(CFG_CORE_CRYPTO_SHA256_ACCEL)
@@ -68,18 +68,34 @@ static void ghash_update_lengths(struct internal_aes_gcm_state *state,
 
 static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
 			     const struct internal_aes_gcm_key *ek,
-			     TEE_OperationMode mode, const void *nonce,
-			     size_t nonce_len, size_t tag_len)
+			     bool new_key, TEE_OperationMode mode,
+			     const void *nonce, size_t nonce_len,
+			     size_t tag_len)
 {
 	COMPILE_TIME_ASSERT(sizeof(state->ctr) == TEE_AES_BLOCK_SIZE);
 
 	if (tag_len > sizeof(state->buf_tag))
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	memset(state, 0, sizeof(*state));
+	if (new_key) {
+		memset(state, 0, sizeof(*state));
+		internal_aes_gcm_set_key(state, ek);
+	} else {
+		/*
+		 * Same key as last time, keep the derived ghash key and
+		 * reset the rest of the state.
+		 */
+		memset(state->ctr, 0, sizeof(state->ctr));
+		memset(state->hash_state, 0, sizeof(state->hash_state));
+		memset(state->buf_tag, 0, sizeof(state->buf_tag));
+		memset(state->buf_hash, 0, sizeof(state->buf_hash));
+		memset(state->buf_cryp, 0, sizeof(state->buf_cryp));
+		state->aad_bytes = 0;
+		state->payload_bytes = 0;
+		state->buf_pos = 0;
+	}
 
 	state->tag_len = tag_len;
-	internal_aes_gcm_set_key(state, ek);
 
 	if (nonce_len == (96 / 8)) {
 		memcpy(state->ctr, nonce, nonce_len);
@@ -128,13 +144,28 @@ TEE_Result internal_aes_gcm_init(struct internal_aes_gcm_ctx *ctx,
 {
 	TEE_Result res = TEE_SUCCESS;
 	struct internal_aes_gcm_key *ek = &ctx->key;
+	bool new_key = key_len > sizeof(ctx->enc_key) ||
+		       key_len != ctx->enc_key_len ||
+		       memcmp(ctx->enc_key, key, key_len);
+
+	/*
+	 * Sequential operations on the same context often use the same
+	 * key, for instance when reading or writing a file with one
+	 * AES-GCM operation per block. Skip the AES key expansion and the
+	 * ghash key derivation when the key is unchanged.
+	 */
+	if (new_key) {
+		ctx->enc_key_len = 0;
+		res = crypto_aes_expand_enc_key(key, key_len, ek->data,
+						sizeof(ek->data), &ek->rounds);
+		if (res)
+			return res;
+		memcpy(ctx->enc_key, key, key_len);
+		ctx->enc_key_len = key_len;
+	}
 
-	res = crypto_aes_expand_enc_key(key, key_len, ek->data,
-					sizeof(ek->data), &ek->rounds);
-	if (res)
-		return res;
-
-	return __gcm_init(&ctx->state, ek, mode, nonce, nonce_len, tag_len);
+	return __gcm_init(&ctx->state, ek, new_key, mode, nonce, nonce_len,
+			  tag_len);
 }
 
 static TEE_Result __gcm_update_aad(struct internal_aes_gcm_state *state,
@@ -376,8 +407,8 @@ TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
 	TEE_Result res;
 	struct internal_aes_gcm_state state;
 
-	res = __gcm_init(&state, enc_key, TEE_MODE_ENCRYPT, nonce, nonce_len,
-			 *tag_len);
+	res = __gcm_init(&state, enc_key, true /*new_key*/, TEE_MODE_ENCRYPT,
+			 nonce, nonce_len, *tag_len);
 	if (res)
 		return res;
 
@@ -399,8 +430,8 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 	TEE_Result res;
 	struct internal_aes_gcm_state state;
 
-	res = __gcm_init(&state, enc_key, TEE_MODE_DECRYPT, nonce, nonce_len,
-			 tag_len);
+	res = __gcm_init(&state, enc_key, true /*new_key*/, TEE_MODE_DECRYPT,
+			 nonce, nonce_len, tag_len);
 	if (res)
 		return res;
 
@@ -12,6 +12,220 @@
 #include <stdlib.h>
 #include <string.h>
 #include <utee_defines.h>
+#include <util.h>
+
+static TEE_Result sw_hash_alloc_ctx(struct crypto_hash_ctx **c, uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+	case TEE_ALG_MD5:
+		res = crypto_md5_alloc_ctx(c);
+		break;
+	case TEE_ALG_SHA1:
+		res = crypto_sha1_alloc_ctx(c);
+		break;
+	case TEE_ALG_SHA224:
+		res = crypto_sha224_alloc_ctx(c);
+		break;
+	case TEE_ALG_SHA256:
+		res = crypto_sha256_alloc_ctx(c);
+		break;
+	case TEE_ALG_SHA384:
+		res = crypto_sha384_alloc_ctx(c);
+		break;
+	case TEE_ALG_SHA512:
+		res = crypto_sha512_alloc_ctx(c);
+		break;
+	case TEE_ALG_SM3:
+		res = crypto_sm3_alloc_ctx(c);
+		break;
+	default:
+		break;
+	}
+
+	return res;
+}
+
+#if defined(CFG_CRYPTO_DRIVER) && CFG_CRYPTO_DRV_HASH_MIN_SIZE > 0
+/*
+ * Hash provider dispatch context
+ *
+ * Small operations are typically faster with the software implementation
+ * than through an accelerator job interface while large ones benefit from
+ * the hardware. Allocation of the provider context is deferred until the
+ * first update so that the size of that chunk selects the provider:
+ * software below CFG_CRYPTO_DRV_HASH_MIN_SIZE bytes, the crypto driver
+ * otherwise. The choice is kept for the lifetime of the context.
+ */
+struct hash_dispatch_ctx {
+	struct crypto_hash_ctx head;
+	struct crypto_hash_ctx *real;	/* Selected provider context */
+	uint32_t algo;
+	bool hw;			/* Real context is from drvcrypt */
+};
+
+static const struct crypto_hash_ops hash_dispatch_ops;
+
+static struct hash_dispatch_ctx *to_hash_dispatch_ctx(struct crypto_hash_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &hash_dispatch_ops);
+
+	return container_of(ctx, struct hash_dispatch_ctx, head);
+}
+
+static TEE_Result hash_dispatch_select(struct hash_dispatch_ctx *c, size_t len)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	if (len >= CFG_CRYPTO_DRV_HASH_MIN_SIZE) {
+		res = drvcrypt_hash_alloc_ctx(&c->real, c->algo);
+		c->hw = !res;
+	}
+	if (res)
+		res = sw_hash_alloc_ctx(&c->real, c->algo);
+	if (res) {
+		res = drvcrypt_hash_alloc_ctx(&c->real, c->algo);
+		c->hw = !res;
+	}
+	if (res)
+		return res;
+
+	return c->real->ops->init(c->real);
+}
+
+static TEE_Result hash_dispatch_init(struct crypto_hash_ctx *ctx)
+{
+	struct hash_dispatch_ctx *c = to_hash_dispatch_ctx(ctx);
+
+	/* Defer provider selection until the first chunk size is known */
+	if (!c->real)
+		return TEE_SUCCESS;
+
+	return c->real->ops->init(c->real);
+}
+
+static TEE_Result hash_dispatch_update(struct crypto_hash_ctx *ctx,
+				       const uint8_t *data, size_t len)
+{
+	struct hash_dispatch_ctx *c = to_hash_dispatch_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!c->real) {
+		res = hash_dispatch_select(c, len);
+		if (res)
+			return res;
+	}
+
+	return c->real->ops->update(c->real, data, len);
+}
+
+static TEE_Result hash_dispatch_final(struct crypto_hash_ctx *ctx,
+				      uint8_t *digest, size_t len)
+{
+	struct hash_dispatch_ctx *c = to_hash_dispatch_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	/* Empty message, any provider will do */
+	if (!c->real) {
+		res = hash_dispatch_select(c, 0);
+		if (res)
+			return res;
+	}
+
+	return c->real->ops->final(c->real, digest, len);
+}
+
+static void hash_dispatch_free_ctx(struct crypto_hash_ctx *ctx)
+{
+	struct hash_dispatch_ctx *c = to_hash_dispatch_ctx(ctx);
+
+	if (c->real)
+		c->real->ops->free_ctx(c->real);
+	free(c);
+}
+
+static void hash_dispatch_copy_state(struct crypto_hash_ctx *dst_ctx,
+				     struct crypto_hash_ctx *src_ctx)
+{
+	struct hash_dispatch_ctx *dst = to_hash_dispatch_ctx(dst_ctx);
+	struct hash_dispatch_ctx *src = to_hash_dispatch_ctx(src_ctx);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (!src->real) {
+		/* Source still unselected, reset the destination too */
+		if (dst->real) {
+			dst->real->ops->free_ctx(dst->real);
+			dst->real = NULL;
+		}
+		return;
+	}
+
+	/* The provider state can only be copied into the same provider */
+	if (dst->real && dst->hw != src->hw) {
+		dst->real->ops->free_ctx(dst->real);
+		dst->real = NULL;
+	}
+	if (!dst->real) {
+		if (src->hw)
+			res = drvcrypt_hash_alloc_ctx(&dst->real, dst->algo);
+		else
+			res = sw_hash_alloc_ctx(&dst->real, dst->algo);
+		if (res)
+			panic();
+		dst->hw = src->hw;
+	}
+
+	dst->real->ops->copy_state(dst->real, src->real);
+}
+
+static const struct crypto_hash_ops hash_dispatch_ops = {
+	.init = hash_dispatch_init,
+	.update = hash_dispatch_update,
+	.final = hash_dispatch_final,
+	.free_ctx = hash_dispatch_free_ctx,
+	.copy_state = hash_dispatch_copy_state,
+};
+
+static TEE_Result hash_dispatch_alloc_ctx(struct crypto_hash_ctx **ctx,
+					  uint32_t algo)
+{
+	struct hash_dispatch_ctx *c = calloc(1, sizeof(*c));
+
+	if (!c)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	c->head.ops = &hash_dispatch_ops;
+	c->algo = algo;
+	*ctx = &c->head;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result maybe_dispatch_hash_ctx(struct crypto_hash_ctx **c,
+					  uint32_t algo)
+{
+	struct crypto_hash_ctx *sw = NULL;
+
+	/*
+	 * Only wrap the context when both providers implement the
+	 * algorithm, otherwise keep the driver context as is.
+	 */
+	if (sw_hash_alloc_ctx(&sw, algo))
+		return TEE_SUCCESS;
+	sw->ops->free_ctx(sw);
+	(*c)->ops->free_ctx(*c);
+	*c = NULL;
+
+	return hash_dispatch_alloc_ctx(c, algo);
+}
+#else
+static TEE_Result maybe_dispatch_hash_ctx(struct crypto_hash_ctx **c __unused,
+					  uint32_t algo __unused)
+{
+	return TEE_SUCCESS;
+}
+#endif
 
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 {
@@ -24,33 +238,10 @@ TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_hash_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_MD5:
-			res = crypto_md5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA1:
-			res = crypto_sha1_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA224:
-			res = crypto_sha224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA256:
-			res = crypto_sha256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA384:
-			res = crypto_sha384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA512:
-			res = crypto_sha512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM3:
-			res = crypto_sm3_alloc_ctx(&c);
-			break;
-		default:
-			break;
-		}
-	}
+	if (!res)
+		res = maybe_dispatch_hash_ctx(&c, algo);
+	else if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = sw_hash_alloc_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -9,6 +9,7 @@
 
 #include <assert.h>
 #include <crypto/crypto.h>
+#include <kernel/misc.h>
 #include <kernel/mutex.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
@@ -58,18 +59,24 @@ static struct fortuna_state {
 
 static struct mutex state_mu = MUTEX_INITIALIZER;
 
-static struct {
+/*
+ * Quick events are staged per core before being mixed into the pools in
+ * batches when the state mutex is taken anyway. Interrupt driven
+ * entropy sources can fire thousands of events per second, a private
+ * buffer per core keeps them from contending on one lock and from
+ * paying for a hash update each.
+ */
+static struct ring_buffer {
 	struct {
 		uint8_t snum;
 		uint8_t pnum;
 		uint8_t dlen;
 		uint8_t data[RING_BUF_DATA_SIZE];
-	} elem[8];
+	} elem[16];
 	unsigned int begin;
 	unsigned int end;
-} ring_buffer;
-
-unsigned int ring_buffer_spin_lock;
+	unsigned int spin_lock;
+} ring_buffer[CFG_TEE_CORE_NB_CORE];
 
 static void inc_counter(uint64_t counter[2])
 {
@@ -175,46 +182,47 @@ err:
 static void push_ring_buffer(uint8_t snum, uint8_t pnum, const void *data,
 			     size_t dlen)
 {
+	struct ring_buffer *rb = ring_buffer + get_core_pos();
 	uint8_t dl = MIN(RING_BUF_DATA_SIZE, dlen);
 	unsigned int next_begin;
 	uint32_t old_itr_status;
 
-	/* Spinlock to serialize writers */
-	old_itr_status = cpu_spin_lock_xsave(&ring_buffer_spin_lock);
+	/* Spinlock to serialize writers on this core */
+	old_itr_status = cpu_spin_lock_xsave(&rb->spin_lock);
 
-	next_begin = (ring_buffer.begin + 1) % ARRAY_SIZE(ring_buffer.elem);
-	if (next_begin == atomic_load_uint(&ring_buffer.end))
+	next_begin = (rb->begin + 1) % ARRAY_SIZE(rb->elem);
+	if (next_begin == atomic_load_uint(&rb->end))
 		goto out; /* buffer is full */
 
-	ring_buffer.elem[next_begin].snum = snum;
-	ring_buffer.elem[next_begin].pnum = pnum;
-	ring_buffer.elem[next_begin].dlen = dl;
-	memcpy(ring_buffer.elem[next_begin].data, data, dl);
+	rb->elem[next_begin].snum = snum;
+	rb->elem[next_begin].pnum = pnum;
+	rb->elem[next_begin].dlen = dl;
+	memcpy(rb->elem[next_begin].data, data, dl);
 
-	atomic_store_uint(&ring_buffer.begin, next_begin);
+	atomic_store_uint(&rb->begin, next_begin);
 
 out:
-	cpu_spin_unlock_xrestore(&ring_buffer_spin_lock, old_itr_status);
+	cpu_spin_unlock_xrestore(&rb->spin_lock, old_itr_status);
 }
 
-static size_t pop_ring_buffer(uint8_t *snum, uint8_t *pnum,
-			      uint8_t data[RING_BUF_DATA_SIZE])
+static size_t pop_ring_buffer(struct ring_buffer *rb, uint8_t *snum,
+			      uint8_t *pnum, uint8_t data[RING_BUF_DATA_SIZE])
 {
 	unsigned int next_end;
 	size_t dlen;
 
-	if (atomic_load_uint(&ring_buffer.begin) == ring_buffer.end)
+	if (atomic_load_uint(&rb->begin) == rb->end)
 		return 0;
 
-	next_end = (ring_buffer.end + 1) % ARRAY_SIZE(ring_buffer.elem);
+	next_end = (rb->end + 1) % ARRAY_SIZE(rb->elem);
 
-	*snum = ring_buffer.elem[ring_buffer.end].snum;
-	*pnum = ring_buffer.elem[ring_buffer.end].pnum;
-	dlen = MIN(ring_buffer.elem[ring_buffer.end].dlen, RING_BUF_DATA_SIZE);
-	assert(ring_buffer.elem[ring_buffer.end].dlen == dlen);
-	memcpy(data, ring_buffer.elem[ring_buffer.end].data, dlen);
+	*snum = rb->elem[rb->end].snum;
+	*pnum = rb->elem[rb->end].pnum;
+	dlen = MIN(rb->elem[rb->end].dlen, RING_BUF_DATA_SIZE);
+	assert(rb->elem[rb->end].dlen == dlen);
+	memcpy(data, rb->elem[rb->end].data, dlen);
 
-	atomic_store_uint(&ring_buffer.end, next_end);
+	atomic_store_uint(&rb->end, next_end);
 
 	return dlen;
 }
@@ -247,21 +255,28 @@ static TEE_Result add_event(uint8_t snum, uint8_t pnum,
 
 static TEE_Result drain_ring_buffer(void)
 {
-	while (true) {
-		TEE_Result res;
-		uint8_t snum;
-		uint8_t pnum;
-		uint8_t data[RING_BUF_DATA_SIZE];
-		size_t dlen;
-
-		dlen = pop_ring_buffer(&snum, &pnum, data);
-		if (!dlen)
-			return TEE_SUCCESS;
+	size_t n;
 
-		res = add_event(snum, pnum, data, dlen);
-		if (res)
-			return res;
+	for (n = 0; n < ARRAY_SIZE(ring_buffer); n++) {
+		while (true) {
+			TEE_Result res;
+			uint8_t snum;
+			uint8_t pnum;
+			uint8_t data[RING_BUF_DATA_SIZE];
+			size_t dlen;
+
+			dlen = pop_ring_buffer(ring_buffer + n, &snum, &pnum,
+					       data);
+			if (!dlen)
+				break;
+
+			res = add_event(snum, pnum, data, dlen);
+			if (res)
+				return res;
+		}
 	}
+
+	return TEE_SUCCESS;
 }
 
 static unsigned int get_next_pnum(unsigned int *pnum)
@@ -3,9 +3,13 @@
 
 #include <compiler.h>
 #include <crypto/crypto.h>
+#include <kernel/spinlock.h>
 #include <rng_support.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee/tee_cryp_utl.h>
 #include <types_ext.h>
+#include <util.h>
 
 TEE_Result __weak crypto_rng_init(const void *data __unused,
 				  size_t dlen __unused)
@@ -20,6 +24,75 @@ void __weak crypto_rng_add_event(enum crypto_rng_src sid __unused,
 {
 }
 
+#if CFG_HW_RNG_POOL_SIZE
+
+/*
+ * Pool of pre-generated random bytes kept in front of the TRNG. Requests
+ * are served with a memcpy and the caller draining the pool below a
+ * quarter refills it in one bulk read, so a slow TRNG stalls one request
+ * per pool cycle instead of every request. The lock is only held while
+ * copying bytes in or out, never while reading the TRNG.
+ */
+static uint8_t rng_pool[CFG_HW_RNG_POOL_SIZE];
+static size_t rng_pool_num;	/* Valid bytes left in rng_pool */
+static unsigned int rng_pool_lock = SPINLOCK_UNLOCK;
+
+static size_t rng_pool_take(uint8_t *b, size_t blen)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+	size_t n = MIN(blen, rng_pool_num);
+
+	/* Serve from the tail so the remaining bytes stay in place */
+	memcpy(b, rng_pool + rng_pool_num - n, n);
+	rng_pool_num -= n;
+	cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+
+	return n;
+}
+
+static void rng_pool_refill(void)
+{
+	uint32_t exceptions = 0;
+	uint8_t tmp[64] = { 0 };
+	bool full = false;
+	size_t n = 0;
+
+	while (!full) {
+		for (n = 0; n < sizeof(tmp); n++)
+			tmp[n] = hw_get_random_byte();
+
+		exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+		n = MIN(sizeof(tmp), sizeof(rng_pool) - rng_pool_num);
+		memcpy(rng_pool + rng_pool_num, tmp, n);
+		rng_pool_num += n;
+		full = rng_pool_num == sizeof(rng_pool);
+		cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+	}
+
+	memzero_explicit(tmp, sizeof(tmp));
+}
+
+TEE_Result __weak crypto_rng_read(void *buf, size_t blen)
+{
+	uint8_t *b = buf;
+	size_t n = 0;
+
+	if (!b)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	n = rng_pool_take(b, blen);
+	for (; n < blen; n++)
+		b[n] = hw_get_random_byte();
+
+	/* Unlocked read, at worst an extra or a missed refill */
+	if (rng_pool_num < sizeof(rng_pool) / 4)
+		rng_pool_refill();
+
+	return TEE_SUCCESS;
+}
+
+#else /* CFG_HW_RNG_POOL_SIZE */
+
 TEE_Result __weak crypto_rng_read(void *buf, size_t blen)
 {
 	uint8_t *b = buf;
@@ -34,3 +107,4 @@ TEE_Result __weak crypto_rng_read(void *buf, size_t blen)
 	return TEE_SUCCESS;
 }
 
+#endif /* CFG_HW_RNG_POOL_SIZE */
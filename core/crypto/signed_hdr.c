@@ -4,6 +4,7 @@
  */
 
 #include <crypto/crypto.h>
+#include <initcall.h>
 #include <signed_hdr.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +14,41 @@
 #include <utee_defines.h>
 #include <util.h>
 
+/*
+ * The TA signing key is fixed at build time, parse it into bignum form
+ * once at boot instead of on every TA load. The key is only read after
+ * the initcall so it can be shared by concurrent loads.
+ */
+static struct rsa_public_key shdr_pub_key;
+static bool shdr_pub_key_ready;
+
+static TEE_Result shdr_load_pub_key(void)
+{
+	uint32_t e = TEE_U32_TO_BIG_ENDIAN(ta_pub_key_exponent);
+	TEE_Result res;
+
+	res = crypto_acipher_alloc_rsa_public_key(&shdr_pub_key,
+						  ta_pub_key_modulus_size);
+	if (res)
+		return res;
+
+	res = crypto_bignum_bin2bn((uint8_t *)&e, sizeof(e), shdr_pub_key.e);
+	if (res)
+		goto err;
+	res = crypto_bignum_bin2bn(ta_pub_key_modulus, ta_pub_key_modulus_size,
+				   shdr_pub_key.n);
+	if (res)
+		goto err;
+
+	shdr_pub_key_ready = true;
+
+	return TEE_SUCCESS;
+err:
+	crypto_acipher_free_rsa_public_key(&shdr_pub_key);
+	return res;
+}
+service_init(shdr_load_pub_key);
+
 struct shdr *shdr_alloc_and_copy(const struct shdr *img, size_t img_size)
 {
 	size_t shdr_size;
@@ -46,11 +82,12 @@ struct shdr *shdr_alloc_and_copy(const struct shdr *img, size_t img_size)
 
 TEE_Result shdr_verify_signature(const struct shdr *shdr)
 {
-	struct rsa_public_key key;
 	TEE_Result res;
-	uint32_t e = TEE_U32_TO_BIG_ENDIAN(ta_pub_key_exponent);
 	size_t hash_size;
 
+	if (!shdr_pub_key_ready)
+		return TEE_ERROR_SECURITY;
+
 	if (shdr->magic != SHDR_MAGIC)
 		return TEE_ERROR_SECURITY;
 
@@ -64,23 +101,10 @@ TEE_Result shdr_verify_signature(const struct shdr *shdr)
 	if (hash_size != shdr->hash_size)
 		return TEE_ERROR_SECURITY;
 
-	res = crypto_acipher_alloc_rsa_public_key(&key, shdr->sig_size);
-	if (res)
-		return TEE_ERROR_SECURITY;
-
-	res = crypto_bignum_bin2bn((uint8_t *)&e, sizeof(e), key.e);
-	if (res)
-		goto out;
-	res = crypto_bignum_bin2bn(ta_pub_key_modulus, ta_pub_key_modulus_size,
-				   key.n);
-	if (res)
-		goto out;
-
-	res = crypto_acipher_rsassa_verify(shdr->algo, &key, shdr->hash_size,
+	res = crypto_acipher_rsassa_verify(shdr->algo, &shdr_pub_key,
+					   shdr->hash_size,
 					   SHDR_GET_HASH(shdr), shdr->hash_size,
 					   SHDR_GET_SIG(shdr), shdr->sig_size);
-out:
-	crypto_acipher_free_rsa_public_key(&key);
 	if (res)
 		return TEE_ERROR_SECURITY;
 	return TEE_SUCCESS;
@@ -17,6 +17,7 @@
 #include <kernel/panic.h>
 #include <kernel/pm.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <tee/cache.h>
 
@@ -62,6 +63,7 @@ struct jr_privdata {
 	unsigned int callers_lock;      /* Job Ring Caller spin lock */
 
 	struct itr_handler it_handler;  /* Interrupt handler */
+	bool it_registered;             /* Interrupt handler registered */
 };
 
 /*
@@ -296,30 +298,19 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	uint8_t idx_jr = 0;
 	bool found = false;
 
-	exceptions = cpu_spin_lock_xsave(&jr_privdata->inlock);
-
 	/*
-	 * Stay locked until a job is available
-	 * Check if there is an available JR index in the HW
-	 */
-	while (caam_hal_jr_read_nbslot_available(jr_privdata->baseaddr) == 0) {
-		/*
-		 * WFE will return thanks to a SEV generated by the
-		 * interrupt handler or by a spin_unlock
-		 */
-		wfe();
-	};
-
-	/*
-	 * There is a space free in the input ring but it doesn't mean
-	 * that the job pushed is completed.
+	 * A free space in the input ring doesn't mean that the job pushed
+	 * is completed.
 	 * Completion is out of order. Look for a free space in the
-	 * caller data to push them and get a job ID for the completion
+	 * caller data to push them and get a job ID for the completion.
+	 * Only the caller information array lock is needed here, keep it
+	 * out of the input ring critical section so that concurrent
+	 * enqueues serialize on the ring itself only.
 	 *
 	 * Lock the caller information array because dequeue is
 	 * also touching it
 	 */
-	cpu_spin_lock(&jr_privdata->callers_lock);
+	exceptions = cpu_spin_lock_xsave(&jr_privdata->callers_lock);
 	for (idx_jr = 0; idx_jr < jr_privdata->nb_jobs; idx_jr++) {
 		if (jr_privdata->callers[idx_jr].job_id == JR_JOB_FREE) {
 			JR_TRACE("Found a space #%" PRId8
@@ -337,13 +328,35 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 			break;
 		}
 	}
-	cpu_spin_unlock(&jr_privdata->callers_lock);
+	cpu_spin_unlock_xrestore(&jr_privdata->callers_lock, exceptions);
 
 	if (!found) {
 		JR_TRACE("Error didn't find a free space in the callers array");
-		goto end_enqueue;
+		return retstatus;
 	}
 
+	/*
+	 * Ensure that the input descriptor is pushed in physical memory
+	 * before taking the input ring lock, the descriptor can be large
+	 * and its maintenance doesn't need the lock.
+	 */
+	cache_operation(TEE_CACHECLEAN, jobctx->desc,
+			DESC_SZBYTES(caam_desc_get_len(jobctx->desc)));
+
+	exceptions = cpu_spin_lock_xsave(&jr_privdata->inlock);
+
+	/*
+	 * Stay locked until a job is available
+	 * Check if there is an available JR index in the HW
+	 */
+	while (caam_hal_jr_read_nbslot_available(jr_privdata->baseaddr) == 0) {
+		/*
+		 * WFE will return thanks to a SEV generated by the
+		 * interrupt handler or by a spin_unlock
+		 */
+		wfe();
+	};
+
 	JR_TRACE("Push id=%" PRId16 ", job (0x%08" PRIx32
 		 ") context @0x%08" PRIxVA,
 		 jr_privdata->inwrite_index, job_mask, (vaddr_t)jobctx);
@@ -364,20 +377,14 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	jr_privdata->inwrite_index++;
 	jr_privdata->inwrite_index %= jr_privdata->nb_jobs;
 
-	/* Ensure that input descriptor is pushed in physical memory */
-	cache_operation(TEE_CACHECLEAN, jobctx->desc,
-			DESC_SZBYTES(caam_desc_get_len(jobctx->desc)));
-
 	/* Inform HW that a new JR is available */
 	caam_hal_jr_add_newjob(jr_privdata->baseaddr);
 
-	*job_id = job_mask;
-	retstatus = CAAM_NO_ERROR;
-
-end_enqueue:
 	cpu_spin_unlock_xrestore(&jr_privdata->inlock, exceptions);
 
-	return retstatus;
+	*job_id = job_mask;
+
+	return CAAM_NO_ERROR;
 }
 
 /*
@@ -427,9 +434,25 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
 		if (job_complete & job_ids)
 			return CAAM_NO_ERROR;
 
-		/* Check if JR interrupt otherwise wait a bit */
-		if (!caam_hal_jr_check_ack_itr(jr_privdata->baseaddr))
-			caam_udelay(10);
+		/* Check if JR interrupt otherwise wait for it or a bit */
+		if (!caam_hal_jr_check_ack_itr(jr_privdata->baseaddr)) {
+			if (jr_privdata->it_registered &&
+			    thread_get_id_may_fail() >= 0) {
+				/*
+				 * Re-enable the JR interrupt disabled by its
+				 * handler and doze in WFE until the SEV sent
+				 * by the handler (or by a spin unlock)
+				 * signals a possible job completion, instead
+				 * of burning the core polling the output
+				 * ring. Not done at boot time when the
+				 * interrupt may not be dispatched.
+				 */
+				itr_enable(jr_privdata->it_handler.it);
+				wfe();
+			} else {
+				caam_udelay(10);
+			}
+		}
 	} while (infinite || (nb_loop--));
 
 	return CAAM_TIMEOUT;
@@ -575,6 +598,7 @@ enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 
 #ifdef CFG_NXP_CAAM_RUNTIME_JR
 	itr_add(&jr_privdata->it_handler);
+	jr_privdata->it_registered = true;
 #endif
 	caam_hal_jr_enable_itr(jr_privdata->baseaddr);
 
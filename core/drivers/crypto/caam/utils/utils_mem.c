@@ -463,21 +463,17 @@ int caam_mem_get_pa_area(struct caambuf *buf, struct caambuf **out_pabufs)
 		/*
 		 * Caller asked for the extracted contiguous
 		 * physical areas.
-		 * Allocate maximum possible small pages
+		 * Count them first to allocate the exact number of entries,
+		 * the worst case of one area per small page can represent a
+		 * significant part of the heap for a large input buffer.
 		 */
-		if (buf->length > SMALL_PAGE_SIZE) {
-			nb_pa_area = buf->length / SMALL_PAGE_SIZE + 1;
-			if (buf->length % SMALL_PAGE_SIZE)
-				nb_pa_area++;
-		} else {
-			nb_pa_area = 2;
-		}
+		nb_pa_area = caam_mem_get_pa_area(buf, NULL);
 
 		pabufs = caam_calloc(nb_pa_area * sizeof(*pabufs));
 		if (!pabufs)
 			return -1;
 
-		MEM_TRACE("Allocate max %d Physical Areas", nb_pa_area);
+		MEM_TRACE("Allocate %d Physical Areas", nb_pa_area);
 	}
 
 	/*
@@ -70,6 +70,10 @@
 static void gic_op_add(struct itr_chip *chip, size_t it, uint32_t flags);
 static void gic_op_enable(struct itr_chip *chip, size_t it);
 static void gic_op_disable(struct itr_chip *chip, size_t it);
+static void gic_op_enable_mask(struct itr_chip *chip, size_t base_it,
+			       uint32_t mask);
+static void gic_op_disable_mask(struct itr_chip *chip, size_t base_it,
+				uint32_t mask);
 static void gic_op_raise_pi(struct itr_chip *chip, size_t it);
 static void gic_op_raise_sgi(struct itr_chip *chip, size_t it,
 			uint8_t cpu_mask);
@@ -80,6 +84,8 @@ static const struct itr_ops gic_ops = {
 	.add = gic_op_add,
 	.enable = gic_op_enable,
 	.disable = gic_op_disable,
+	.enable_mask = gic_op_enable_mask,
+	.disable_mask = gic_op_disable_mask,
 	.raise_pi = gic_op_raise_pi,
 	.raise_sgi = gic_op_raise_sgi,
 	.set_affinity = gic_op_set_affinity,
@@ -299,6 +305,32 @@ static void gic_it_disable(struct gic_data *gd, size_t it)
 	io_write32(gd->gicd_base + GICD_ICENABLER(idx), mask);
 }
 
+static void gic_it_enable_mask(struct gic_data *gd, size_t idx, uint32_t mask)
+{
+	uint32_t sgi_mask __maybe_unused = idx ? 0 : GENMASK_32(NUM_SGI - 1, 0);
+	vaddr_t base = gd->gicd_base;
+
+	/* Assigned to group0 */
+	assert(!(io_read32(base + GICD_IGROUPR(idx)) & mask));
+	/*
+	 * Not enabled yet, except Software Generated Interrupts which are
+	 * implementation defined
+	 */
+	assert(!(io_read32(base + GICD_ISENABLER(idx)) & mask & ~sgi_mask));
+
+	/* Enable the interrupts, GICD_ISENABLER is write one to set */
+	io_write32(base + GICD_ISENABLER(idx), mask);
+}
+
+static void gic_it_disable_mask(struct gic_data *gd, size_t idx, uint32_t mask)
+{
+	/* Assigned to group0 */
+	assert(!(io_read32(gd->gicd_base + GICD_IGROUPR(idx)) & mask));
+
+	/* Disable the interrupts, GICD_ICENABLER is write one to clear */
+	io_write32(gd->gicd_base + GICD_ICENABLER(idx), mask);
+}
+
 static void gic_it_set_pending(struct gic_data *gd, size_t it)
 {
 	size_t idx = it / NUM_INTS_PER_REG;
@@ -439,6 +471,36 @@ static void gic_op_disable(struct itr_chip *chip, size_t it)
 	gic_it_disable(gd, it);
 }
 
+static void gic_op_enable_mask(struct itr_chip *chip, size_t base_it,
+			       uint32_t mask)
+{
+	struct gic_data *gd = container_of(chip, struct gic_data, chip);
+
+	assert(!(base_it % NUM_INTS_PER_REG));
+	if (!mask)
+		return;
+	if (base_it + NUM_INTS_PER_REG - 1 - __builtin_clz(mask) >=
+	    gd->max_it)
+		panic();
+
+	gic_it_enable_mask(gd, base_it / NUM_INTS_PER_REG, mask);
+}
+
+static void gic_op_disable_mask(struct itr_chip *chip, size_t base_it,
+				uint32_t mask)
+{
+	struct gic_data *gd = container_of(chip, struct gic_data, chip);
+
+	assert(!(base_it % NUM_INTS_PER_REG));
+	if (!mask)
+		return;
+	if (base_it + NUM_INTS_PER_REG - 1 - __builtin_clz(mask) >=
+	    gd->max_it)
+		panic();
+
+	gic_it_disable_mask(gd, base_it / NUM_INTS_PER_REG, mask);
+}
+
 static void gic_op_raise_pi(struct itr_chip *chip, size_t it)
 {
 	struct gic_data *gd = container_of(chip, struct gic_data, chip);
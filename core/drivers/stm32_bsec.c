@@ -631,7 +631,7 @@ static void initialize_bsec_from_dt(void)
 	struct dt_node_info bsec_info = { };
 
 	fdt = get_embedded_dt();
-	node = fdt_node_offset_by_compatible(fdt, 0, "st,stm32mp15-bsec");
+	node = dt_node_offset_by_compatible(fdt, 0, "st,stm32mp15-bsec");
 	if (node < 0)
 		panic();
 
@@ -264,7 +264,8 @@ static void init_pm(struct etzpc_instance *dev)
 			dev->tzma_cfg[n] |= TZMA_PM_LOCK_BIT;
 	}
 
-	register_pm_core_service_cb(etzpc_pm, dev);
+	/* Device state only needs restoring when the context was lost */
+	register_pm_core_service_cb_mask(etzpc_pm, dev, PM_HINT_CONTEXT_STATE);
 }
 
 struct etzpc_hwcfg {
@@ -319,7 +320,7 @@ void stm32_etzpc_init(paddr_t base)
 static TEE_Result init_etzpc_from_dt(void)
 {
 	void *fdt = get_embedded_dt();
-	int node = fdt_node_offset_by_compatible(fdt, -1, ETZPC_COMPAT);
+	int node = dt_node_offset_by_compatible(fdt, -1, ETZPC_COMPAT);
 	int status = 0;
 	paddr_t pbase = 0;
 
@@ -327,7 +328,7 @@ static TEE_Result init_etzpc_from_dt(void)
 
 	if (node < 0)
 		panic();
-	assert(fdt_node_offset_by_compatible(fdt, node, ETZPC_COMPAT) < 0);
+	assert(dt_node_offset_by_compatible(fdt, node, ETZPC_COMPAT) < 0);
 
 	status = _fdt_get_status(fdt, node);
 	if (!(status & DT_STATUS_OK_SEC))
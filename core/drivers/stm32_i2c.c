@@ -16,6 +16,8 @@
 #include <kernel/dt.h>
 #include <kernel/boot.h>
 #include <kernel/panic.h>
+#include <kernel/tee_time.h>
+#include <kernel/thread.h>
 #include <libfdt.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -157,6 +159,15 @@
 #define I2C_TIMEOUT_BUSY_MS		25
 #define I2C_TIMEOUT_BUSY_US		(I2C_TIMEOUT_BUSY_MS * 1000)
 
+/*
+ * Time spent spinning on a status flag before yielding the core, and the
+ * duration of each yield. A flag is expected within a byte time (~90us at
+ * 100kHz) so short waits stay on the fast spinning path while the long
+ * ones (end of a reloaded transfer, bus busy, timeout) release the core.
+ */
+#define I2C_SPIN_BEFORE_YIELD_US	200
+#define I2C_YIELD_SLICE_MS		1
+
 #define CR2_RESET_MASK			(I2C_CR2_SADD | I2C_CR2_HEAD10R | \
 					 I2C_CR2_NBYTES | I2C_CR2_RELOAD | \
 					 I2C_CR2_RD_WRN)
@@ -841,6 +852,25 @@ static void i2c_flush_txdr(struct i2c_handle_s *hi2c)
 		io_setbits32(base + I2C_ISR, I2C_ISR_TXE);
 }
 
+/*
+ * Relax a status flag polling loop. Once @spin_ref has expired each call
+ * releases the core for I2C_YIELD_SLICE_MS instead of spinning, provided
+ * the caller runs in a thread context that may be suspended. The I2C
+ * event interrupt cannot wake a suspended thread so the flag is simply
+ * polled again after each slice.
+ */
+static void i2c_relax_poll(uint64_t spin_ref)
+{
+	if (!timeout_elapsed(spin_ref))
+		return;
+
+	if (thread_get_id_may_fail() == THREAD_ID_INVALID ||
+	    thread_get_exceptions() & THREAD_EXCP_ALL)
+		return;
+
+	tee_time_wait(I2C_YIELD_SLICE_MS);
+}
+
 /*
  * Wait for a single target I2C_ISR bit to reach an awaited value (0 or 1)
  *
@@ -854,13 +884,16 @@ static int wait_isr_event(struct i2c_handle_s *hi2c, uint32_t bit_mask,
 			  unsigned int awaited_value, uint64_t timeout_ref)
 {
 	vaddr_t isr = get_base(hi2c) + I2C_ISR;
+	uint64_t spin_ref = timeout_init_us(I2C_SPIN_BEFORE_YIELD_US);
 
 	assert(IS_POWER_OF_TWO(bit_mask) && !(awaited_value & ~1U));
 
 	/* May timeout while TEE thread is suspended */
-	while (!timeout_elapsed(timeout_ref))
+	while (!timeout_elapsed(timeout_ref)) {
 		if (!!(io_read32(isr) & bit_mask) == awaited_value)
 			break;
+		i2c_relax_poll(spin_ref);
+	}
 
 	if (!!(io_read32(isr) & bit_mask) == awaited_value)
 		return 0;
@@ -873,6 +906,7 @@ static int wait_isr_event(struct i2c_handle_s *hi2c, uint32_t bit_mask,
 static int i2c_ack_failed(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 {
 	vaddr_t base = get_base(hi2c);
+	uint64_t spin_ref = 0;
 
 	if ((io_read32(base + I2C_ISR) & I2C_ISR_NACKF) == 0U)
 		return 0;
@@ -882,9 +916,12 @@ static int i2c_ack_failed(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 	 * AutoEnd should be initiate after AF.
 	 * Timeout may elpased while TEE thread is suspended.
 	 */
-	while (!timeout_elapsed(timeout_ref))
+	spin_ref = timeout_init_us(I2C_SPIN_BEFORE_YIELD_US);
+	while (!timeout_elapsed(timeout_ref)) {
 		if (io_read32(base + I2C_ISR) & I2C_ISR_STOPF)
 			break;
+		i2c_relax_poll(spin_ref);
+	}
 
 	if ((io_read32(base + I2C_ISR) & I2C_ISR_STOPF) == 0) {
 		notif_i2c_timeout(hi2c);
@@ -908,11 +945,14 @@ static int i2c_ack_failed(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 /* Wait TXIS bit is 1 in I2C_ISR register */
 static int i2c_wait_txis(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 {
+	uint64_t spin_ref = timeout_init_us(I2C_SPIN_BEFORE_YIELD_US);
+
 	while (!timeout_elapsed(timeout_ref)) {
 		if (io_read32(get_base(hi2c) + I2C_ISR) & I2C_ISR_TXIS)
 			break;
 		if (i2c_ack_failed(hi2c, timeout_ref))
 			return -1;
+		i2c_relax_poll(spin_ref);
 	}
 
 	if (io_read32(get_base(hi2c) + I2C_ISR) & I2C_ISR_TXIS)
@@ -928,12 +968,15 @@ static int i2c_wait_txis(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 /* Wait STOPF bit is 1 in I2C_ISR register */
 static int i2c_wait_stop(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 {
+	uint64_t spin_ref = timeout_init_us(I2C_SPIN_BEFORE_YIELD_US);
+
 	while (!timeout_elapsed(timeout_ref)) {
 		if (io_read32(get_base(hi2c) + I2C_ISR) & I2C_ISR_STOPF)
 			break;
 
 		if (i2c_ack_failed(hi2c, timeout_ref))
 			return -1;
+		i2c_relax_poll(spin_ref);
 	}
 
 	if (io_read32(get_base(hi2c) + I2C_ISR) & I2C_ISR_STOPF)
@@ -1427,6 +1470,7 @@ bool stm32_i2c_is_device_ready(struct i2c_handle_s *hi2c, uint32_t dev_addr,
 
 	do {
 		uint64_t timeout_ref = 0;
+		uint64_t spin_ref = 0;
 		vaddr_t isr = base + I2C_ISR;
 
 		/* Generate Start */
@@ -1447,9 +1491,12 @@ bool stm32_i2c_is_device_ready(struct i2c_handle_s *hi2c, uint32_t dev_addr,
 		 * Wait until STOPF flag is set or a NACK flag is set.
 		 */
 		timeout_ref = timeout_init_us(timeout_ms * 1000);
-		while (!timeout_elapsed(timeout_ref))
+		spin_ref = timeout_init_us(I2C_SPIN_BEFORE_YIELD_US);
+		while (!timeout_elapsed(timeout_ref)) {
 			if (io_read32(isr) & (I2C_ISR_STOPF | I2C_ISR_NACKF))
 				break;
+			i2c_relax_poll(spin_ref);
+		}
 
 		if ((io_read32(isr) & (I2C_ISR_STOPF | I2C_ISR_NACKF)) == 0) {
 			notif_i2c_timeout(hi2c);
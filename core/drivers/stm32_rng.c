@@ -199,7 +199,7 @@ static TEE_Result stm32_rng_init(void)
 		panic();
 
 	while (true) {
-		node = fdt_node_offset_by_compatible(fdt, node, DT_RNG_COMPAT);
+		node = dt_node_offset_by_compatible(fdt, node, DT_RNG_COMPAT);
 		if (node < 0)
 			break;
 
@@ -237,5 +237,6 @@ static TEE_Result stm32_rng_init(void)
 	return TEE_SUCCESS;
 }
 
-driver_init(stm32_rng_init);
+/* stm32_rng_read() is only reachable once TAs run, init can wait */
+driver_init_lazy(stm32_rng_init);
 #endif /*CFG_EMBED_DTB*/
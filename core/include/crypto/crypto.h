@@ -283,6 +283,13 @@ TEE_Result crypto_acipher_sm2_kep_derive(struct ecc_keypair *my_key,
 TEE_Result hash_sha256_check(const uint8_t *hash, const uint8_t *data,
 		size_t data_size);
 
+/*
+ * Computes a SHA-256 hash, same dependency free implementation as
+ * hash_sha256_check() for use by pager and early initialization code.
+ */
+TEE_Result hash_sha256_compute(uint8_t *digest, const uint8_t *data,
+		size_t data_size);
+
 /*
  * Computes a SHA-512/256 hash, vetted conditioner as per NIST.SP.800-90B.
  * It doesn't require crypto_init() to be called in advance and has as few
@@ -366,4 +373,27 @@ TEE_Result crypto_aes_expand_enc_key(const void *key, size_t key_len,
 void crypto_aes_enc_block(const void *enc_key, size_t enc_keylen,
 			  unsigned int rounds, const void *src, void *dst);
 
+/*
+ * crypto_aes_expand_dec_key() - Expand an AES key for decryption
+ * @key:	AES key buffer
+ * @key_len:	Size of the @key buffer in bytes
+ * @dec_key:	Expanded AES decryption key buffer
+ * @dec_keylen: Size of the @dec_key buffer in bytes
+ * @rounds:	Number of rounds to be used during decryption
+ */
+TEE_Result crypto_aes_expand_dec_key(const void *key, size_t key_len,
+				     void *dec_key, size_t dec_keylen,
+				     unsigned int *rounds);
+
+/*
+ * crypto_aes_dec_block() - Decrypt an AES block
+ * @dec_key:	Expanded AES decryption key
+ * @dec_keylen:	Size of @dec_key in bytes
+ * @rounds:	Number of rounds
+ * @src:	Source buffer of one AES block (16 bytes)
+ * @dst:	Destination buffer of one AES block (16 bytes)
+ */
+void crypto_aes_dec_block(const void *dec_key, size_t dec_keylen,
+			  unsigned int rounds, const void *src, void *dst);
+
 #endif /* __CRYPTO_CRYPTO_H */
@@ -50,6 +50,13 @@ struct internal_aes_gcm_state {
 struct internal_aes_gcm_ctx {
 	struct internal_aes_gcm_state state;
 	struct internal_aes_gcm_key key;
+	/*
+	 * Raw key from the last internal_aes_gcm_init() to detect when the
+	 * expanded key and derived ghash key can be reused, enc_key_len is
+	 * 0 when no valid key is expanded.
+	 */
+	uint8_t enc_key[TEE_AES_MAX_KEY_SIZE];
+	size_t enc_key_len;
 };
 
 TEE_Result internal_aes_gcm_init(struct internal_aes_gcm_ctx *ctx,
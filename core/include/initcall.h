@@ -36,6 +36,9 @@ struct initcall {
 #define finalcall_begin	SCATTERED_ARRAY_BEGIN(finalcall, struct initcall)
 #define finalcall_end	SCATTERED_ARRAY_END(finalcall, struct initcall)
 
+#define lazycall_begin	SCATTERED_ARRAY_BEGIN(lazycall, struct initcall)
+#define lazycall_end	SCATTERED_ARRAY_END(lazycall, struct initcall)
+
 #define early_init(fn)			__define_initcall(init, 1, fn)
 #define early_init_late(fn)		__define_initcall(init, 2, fn)
 #define service_init(fn)		__define_initcall(init, 3, fn)
@@ -43,9 +46,23 @@ struct initcall {
 #define driver_init(fn)			__define_initcall(init, 5, fn)
 #define driver_init_late(fn)		__define_initcall(init, 6, fn)
 
+/*
+ * Drivers whose services can only be requested once TAs run may register
+ * with driver_init_lazy() instead of driver_init(): with
+ * CFG_DRIVERS_LAZY_INIT their init is deferred from boot to right before
+ * the first TA session is opened, otherwise it runs at the driver_init()
+ * level as usual.
+ */
+#ifdef CFG_DRIVERS_LAZY_INIT
+#define driver_init_lazy(fn)		__define_initcall(lazy, 5, fn)
+#else
+#define driver_init_lazy(fn)		__define_initcall(init, 5, fn)
+#endif
+
 #define boot_final(fn)			__define_initcall(final, 1, fn)
 
 void call_initcalls(void);
 void call_finalcalls(void);
+void call_lazy_initcalls(void);
 
 #endif
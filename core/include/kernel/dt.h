@@ -128,6 +128,22 @@ int dt_disable_status(void *fdt, int node);
  */
 int dt_enable_secure_status(void *fdt, int node);
 
+/*
+ * Indexed variant of fdt_node_offset_by_compatible(). With
+ * CFG_DT_CACHED_NODE_INDEX a one-pass index over @fdt is built on first
+ * use and the lookup costs a binary search instead of a scan of the
+ * whole structure block, otherwise this simply wraps the libfdt
+ * function. Return values are those of fdt_node_offset_by_compatible().
+ */
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible);
+
+/*
+ * Indexed variant of fdt_node_offset_by_phandle(), with the same return
+ * values. See dt_node_offset_by_compatible().
+ */
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+
 /*
  * FDT manipulation functions, not provided by <libfdt.h>
  */
@@ -186,6 +202,19 @@ static inline int dt_map_dev(const void *fdt __unused, int offs __unused,
 	return -1;
 }
 
+static inline int dt_node_offset_by_compatible(const void *fdt __unused,
+					       int startoffset __unused,
+					       const char *compatible __unused)
+{
+	return -1;
+}
+
+static inline int dt_node_offset_by_phandle(const void *fdt __unused,
+					    uint32_t phandle __unused)
+{
+	return -1;
+}
+
 static inline paddr_t _fdt_reg_base_address(const void *fdt __unused,
 					    int offs __unused)
 {
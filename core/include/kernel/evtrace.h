@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_EVTRACE_H
+#define __KERNEL_EVTRACE_H
+
+#include <compiler.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Lightweight event trace for the core hot paths, enabled with
+ * CFG_CORE_EVENT_TRACE. Events are recorded in small fixed-size per-core
+ * ring buffers as (event, CNTPCT timestamp) pairs, cheap enough to stay
+ * enabled in production, and are retrieved with the stats pseudo TA for
+ * off-line tail latency analysis.
+ */
+
+enum evtrace_event {
+	EVTRACE_STD_SMC_ENTRY = 1,
+	EVTRACE_STD_SMC_RETURN,
+	EVTRACE_RPC_CMD_SEND,
+	EVTRACE_RPC_CMD_DONE,
+	EVTRACE_PAGER_FAULT_ENTRY,
+	EVTRACE_PAGER_FAULT_RETURN,
+};
+
+/* One record of the trace, the timestamp is a raw CNTPCT value */
+struct evtrace_rec {
+	uint64_t timestamp;
+	uint32_t event;
+	uint32_t pad;
+};
+
+#define EVTRACE_RING_SIZE	256
+
+#ifdef CFG_CORE_EVENT_TRACE
+/* Records @event with the current timestamp on the executing core */
+void evtrace_add(enum evtrace_event event);
+
+/*
+ * evtrace_snapshot() - Copy out the trace ring of one core
+ * @core:	Core to snapshot
+ * @recs:	Destination buffer
+ * @num_recs:	In: room in @recs in records, out: records copied
+ * @head:	Total number of records written on @core so far, the oldest
+ *		record in the ring is at index @head % EVTRACE_RING_SIZE
+ *
+ * Tracing on the other cores continues while the snapshot is taken, the
+ * records closest to @head may be overwritten concurrently.
+ */
+TEE_Result evtrace_snapshot(size_t core, struct evtrace_rec *recs,
+			    size_t *num_recs, uint32_t *head);
+#else
+static inline void evtrace_add(enum evtrace_event event __unused)
+{
+}
+
+static inline TEE_Result evtrace_snapshot(size_t core __unused,
+					  struct evtrace_rec *recs __unused,
+					  size_t *num_recs __unused,
+					  uint32_t *head __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#endif /*__KERNEL_EVTRACE_H*/
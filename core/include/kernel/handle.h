@@ -10,9 +10,10 @@
 struct handle_db {
 	void **ptrs;
 	size_t max_ptrs;
+	size_t min_free;	/* No free slot below this index */
 };
 
-#define HANDLE_DB_INITIALIZER { NULL, 0 }
+#define HANDLE_DB_INITIALIZER { NULL, 0, 0 }
 
 /*
  * Frees all internal data structures of the database, but does not free
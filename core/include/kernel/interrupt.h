@@ -5,6 +5,7 @@
 #ifndef __KERNEL_INTERRUPT_H
 #define __KERNEL_INTERRUPT_H
 
+#include <tee_api_types.h>
 #include <types_ext.h>
 #include <sys/queue.h>
 #include <util.h>
@@ -20,6 +21,17 @@ struct itr_ops {
 	void (*add)(struct itr_chip *chip, size_t it, uint32_t flags);
 	void (*enable)(struct itr_chip *chip, size_t it);
 	void (*disable)(struct itr_chip *chip, size_t it);
+	/*
+	 * Optional word based versions of enable/disable operating on the
+	 * 32 interrupts starting at the 32 aligned @base_it, used by
+	 * itr_enable_many()/itr_disable_many() to batch device register
+	 * accesses. May be NULL in which case one operation per interrupt
+	 * is used instead.
+	 */
+	void (*enable_mask)(struct itr_chip *chip, size_t base_it,
+		uint32_t mask);
+	void (*disable_mask)(struct itr_chip *chip, size_t base_it,
+		uint32_t mask);
 	void (*raise_pi)(struct itr_chip *chip, size_t it);
 	void (*raise_sgi)(struct itr_chip *chip, size_t it,
 		uint8_t cpu_mask);
@@ -37,15 +49,33 @@ struct itr_handler {
 	uint32_t flags;
 	enum itr_return (*handler)(struct itr_handler *h);
 	void *data;
+#ifdef CFG_WITH_STATS
+	uint64_t count;		/* Number of invocations */
+	uint64_t max_ticks;	/* Longest invocation in CNTPCT ticks */
+#endif
 	SLIST_ENTRY(itr_handler) link;
 };
 
+/* Per handler statistics returned by itr_get_stats() */
+struct itr_stat {
+	uint64_t it;
+	uint64_t count;
+	uint64_t max_ticks;
+};
+
 void itr_init(struct itr_chip *data);
 void itr_handle(size_t it);
 
 void itr_add(struct itr_handler *handler);
 void itr_enable(size_t it);
 void itr_disable(size_t it);
+/*
+ * Enable or disable the @count interrupts in @its in one call. Chips
+ * implementing the mask based callbacks get one callback per used 32
+ * interrupt word, other chips fall back to one operation per interrupt.
+ */
+void itr_enable_many(const size_t *its, size_t count);
+void itr_disable_many(const size_t *its, size_t count);
 /* raise the Peripheral Interrupt corresponding to the interrupt ID */
 void itr_raise_pi(size_t it);
 /*
@@ -59,6 +89,18 @@ void itr_raise_sgi(size_t it, uint8_t cpu_mask);
  */
 void itr_set_affinity(size_t it, uint8_t cpu_mask);
 
+#ifdef CFG_WITH_STATS
+/*
+ * Copy per handler invocation counts and max durations into @stats. On
+ * entry *@num_stats is the number of elements @stats has room for, on
+ * return the number of registered handlers. Returns
+ * TEE_ERROR_SHORT_BUFFER if @stats is too small, if @reset the counters
+ * are cleared after a successful copy.
+ */
+TEE_Result itr_get_stats(struct itr_stat *stats, size_t *num_stats,
+			 bool reset);
+#endif
+
 /*
  * __weak overridable function which is called when a secure interrupt is
  * received. The default function calls panic() immediately, platforms which
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef __KERNEL_LOCKPROF_H
+#define __KERNEL_LOCKPROF_H
+
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Lock contention profiler (CFG_LOCK_PROFILER=y). Unlike lockdep this is
+ * meant for production-like builds: it records per lock how often the
+ * lock was taken, how often the acquirer had to wait and the longest
+ * observed hold time, so that the locks worth splitting can be
+ * identified. Locks are keyed by the same identity as lockdep uses, the
+ * address of the lock object.
+ *
+ * Hold times are measured with the generic counter (CNTPCT). For
+ * read/write locks with several concurrent readers only the most recent
+ * acquisition is tracked, so hold times of read-mostly locks are
+ * approximate.
+ */
+
+struct lockprof_stat {
+	uint64_t lock_id;	/* Address of the lock object */
+	uint64_t acquired;	/* Number of acquisitions */
+	uint64_t contended;	/* Acquisitions that had to wait */
+	uint64_t max_hold;	/* Longest hold time in CNTPCT ticks */
+};
+
+#ifdef CFG_LOCK_PROFILER
+/* Record that lock @lock_id was acquired, after waiting if @contended */
+void lockprof_acquired(uintptr_t lock_id, bool contended);
+
+/* Record that lock @lock_id was released */
+void lockprof_released(uintptr_t lock_id);
+
+/*
+ * Copy the recorded statistics into @stats. On entry *@num_stats is the
+ * number of elements @stats has room for, on return the number of locks
+ * recorded. Returns TEE_ERROR_SHORT_BUFFER if @stats is too small, if
+ * @reset the counters are cleared after a successful copy.
+ */
+TEE_Result lockprof_get_stats(struct lockprof_stat *stats, size_t *num_stats,
+			      bool reset);
+#else
+static inline void lockprof_acquired(uintptr_t lock_id __unused,
+				     bool contended __unused)
+{
+}
+
+static inline void lockprof_released(uintptr_t lock_id __unused)
+{
+}
+
+static inline TEE_Result lockprof_get_stats(struct lockprof_stat *s __unused,
+					    size_t *num_stats __unused,
+					    bool reset __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#endif /* __KERNEL_LOCKPROF_H */
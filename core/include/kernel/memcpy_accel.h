@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_MEMCPY_ACCEL_H
+#define __KERNEL_MEMCPY_ACCEL_H
+
+#include <string.h>
+#include <types_ext.h>
+
+/*
+ * SIMD accelerated alternatives to memcpy() and memset() for bulk data,
+ * for instance when marshalling large memref parameters. Small buffers,
+ * and calls from abort or interrupt context where the VFP state can't be
+ * touched, are served with the plain string routines so the functions
+ * are always safe to call where memcpy()/memset() is.
+ */
+#ifdef CFG_CORE_NEON_MEMCPY
+void *memcpy_accel(void *dst, const void *src, size_t n);
+void *memset_accel(void *b, int c, size_t n);
+#else
+static inline void *memcpy_accel(void *dst, const void *src, size_t n)
+{
+	return memcpy(dst, src, n);
+}
+
+static inline void *memset_accel(void *b, int c, size_t n)
+{
+	return memset(b, c, n);
+}
+#endif
+
+#endif /*__KERNEL_MEMCPY_ACCEL_H*/
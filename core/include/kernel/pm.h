@@ -30,6 +30,9 @@
 #define PM_HINT_PLATFORM_STATE_MASK	GENMASK_32(31, 16)
 #define PM_HINT_PLATFORM_STATE_SHIFT	16
 
+/* All state bits, for callbacks that shall run on every transition */
+#define PM_HINT_STATE_ALL		UINT32_C(0xffffffff)
+
 /*
  * PM_OP_SUSPEND: platform is suspending to a target low power state
  * PM_OP_RESUME: platform is resuming from low power state
@@ -99,12 +102,15 @@ typedef TEE_Result (*pm_callback)(enum pm_op op, uint32_t pm_hint,
  * @callback - Registered callback function
  * @handle - Registered private handler for the callback
  * @order - Registered callback call order priority (PM_CB_ORDER_*)
+ * @hint_mask - PM_HINT_* state bits the callback has state to handle for,
+ *		0 defaults to PM_HINT_STATE_ALL at registration
  */
 struct pm_callback_handle {
 	/* Set by the caller when registering a callback */
 	pm_callback callback;
 	void *handle;
 	uint8_t order;
+	uint32_t hint_mask;
 	/* Set by the system according to execution context */
 	uint8_t flags;
 };
@@ -147,6 +153,37 @@ static inline void register_pm_core_service_cb(pm_callback callback,
 						PM_CB_ORDER_CORE_SERVICE));
 }
 
+/*
+ * Variants for callbacks that only have state to save or restore for
+ * some power states. @hint_mask selects the PM_HINT_* state bits the
+ * callback cares about: pm_change_state() skips the callback entirely on
+ * suspend when the targeted state doesn't intersect the mask, so state
+ * untouched by shallow power states isn't saved and restored on every
+ * transition.
+ */
+static inline void register_pm_driver_cb_mask(pm_callback callback,
+					      void *handle, uint32_t hint_mask)
+{
+	struct pm_callback_handle pm_hdl = PM_CALLBACK_HANDLE_INITIALIZER(
+						callback, handle,
+						PM_CB_ORDER_DRIVER);
+
+	pm_hdl.hint_mask = hint_mask;
+	register_pm_cb(&pm_hdl);
+}
+
+static inline void register_pm_core_service_cb_mask(pm_callback callback,
+						    void *handle,
+						    uint32_t hint_mask)
+{
+	struct pm_callback_handle pm_hdl = PM_CALLBACK_HANDLE_INITIALIZER(
+						callback, handle,
+						PM_CB_ORDER_CORE_SERVICE);
+
+	pm_hdl.hint_mask = hint_mask;
+	register_pm_cb(&pm_hdl);
+}
+
 /*
  * Request call to registered PM callbacks
  *
@@ -56,7 +56,10 @@ struct sample_buf {
 	uint32_t scale;		/* Passed from user mode */
 	uint32_t count;		/* Number of samples taken */
 	bool enabled;		/* Sampling enabled? */
-	uint16_t *samples;
+	uint16_t *samples;	/* Core private histogram, no access checks
+				   needed in the sampling interrupt path */
+	uint16_t *usamples;	/* User buffer the histogram is copied to
+				   when sampling stops */
 	uint64_t usr;		/* Total user CPU time for this session */
 	uint64_t usr_entered;	/* When this session last entered user mode */
 	uint32_t freq;		/* @usr divided by @freq is in seconds */
@@ -67,6 +70,7 @@ struct sample_buf {
 struct tee_ta_ctx {
 	uint32_t flags;		/* TA_FLAGS from TA header */
 	TAILQ_ENTRY(tee_ta_ctx) link;
+	SLIST_ENTRY(tee_ta_ctx) uuid_hash_link;
 	struct ts_ctx ts_ctx;
 	uint32_t panicked;	/* True if TA has panicked, written from asm */
 	uint32_t panic_code;	/* Code supplied for panic */
@@ -78,6 +82,8 @@ struct tee_ta_ctx {
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
+	SLIST_ENTRY(tee_ta_session) hash_link;
+	struct tee_ta_session_head *owner; /* List the session is linked in */
 	struct ts_session ts_sess;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -87,6 +93,8 @@ struct tee_ta_session {
 	bool cancel_mask;	/* True if cancel is masked */
 	TEE_Time cancel_time;	/* Time when to cancel the TA invocation */
 	void *user_ctx;		/* Opaque session handle assigned by PTA */
+	struct mobj *param_mobj; /* Cached bounce buffer for TA-to-TA params */
+	size_t param_mobj_size;	/* Size @param_mobj was allocated for */
 	uint32_t ref_count;	/* reference counter */
 	struct condvar refc_cv;	/* CV used to wait for ref_count to be 0 */
 	struct condvar lock_cv;	/* CV used to wait for lock */
@@ -141,6 +149,13 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 
 void tee_ta_put_session(struct tee_ta_session *sess);
 
+/*
+ * Links/unlinks a TA context in the registered contexts and the per-UUID
+ * lookup index. Must be called with tee_ta_mutex held.
+ */
+void tee_ta_link_ctx(struct tee_ta_ctx *ctx);
+void tee_ta_unlink_ctx(struct tee_ta_ctx *ctx);
+
 #if defined(CFG_TA_GPROF_SUPPORT)
 void tee_ta_update_session_utime_suspend(void);
 void tee_ta_update_session_utime_resume(void);
@@ -7,6 +7,7 @@
 #ifndef __KERNEL_TS_MANAGER_H
 #define __KERNEL_TS_MANAGER_H
 
+#include <compiler.h>
 #include <sys/queue.h>
 #include <tee_api_types.h>
 
@@ -18,6 +19,11 @@ struct ts_ctx {
 struct ts_session {
 	TAILQ_ENTRY(ts_session) link_tsd;
 	struct ts_ctx *ctx;	/* Generic TS context */
+	uint8_t wq_prio;	/* Wait queue priority class, WQ_PRIO_* */
+#if defined(CFG_TS_LATENCY_STATS)
+	uint64_t lat_enter;	/* CNTPCT when the session was entered */
+	uint64_t lat_rpc;	/* Ticks spent blocked on RPC this entry */
+#endif
 #if defined(CFG_TA_GPROF_SUPPORT)
 	struct sample_buf *sbuf; /* Profiling data (PC sampling) */
 #endif
@@ -53,4 +59,46 @@ void ts_push_current_session(struct ts_session *sess);
 struct ts_session *ts_pop_current_session(void);
 struct ts_session *ts_get_calling_session(void);
 
+/*
+ * Per TS latency distribution, CFG_TS_LATENCY_STATS. Durations are
+ * measured from ts_push_current_session() to ts_pop_current_session()
+ * with CNTPCT and split into time blocked on RPC and the remaining
+ * secure side compute time. Bucket n counts entries whose duration d
+ * satisfies 2^n us <= d < 2^(n + 1) us, except that bucket 0 also
+ * holds sub-microsecond entries and the last bucket everything above
+ * the range.
+ */
+#define TS_LATENCY_NB_BUCKETS	16
+
+struct ts_latency_stats {
+	bool used;		/* True once a TS claimed this slot */
+	TEE_UUID uuid;
+	uint64_t count;		/* Number of entries recorded */
+	uint32_t compute[TS_LATENCY_NB_BUCKETS]; /* Wall time minus RPC wait */
+	uint32_t rpc[TS_LATENCY_NB_BUCKETS];	 /* Time blocked on RPC */
+};
+
+#if defined(CFG_TS_LATENCY_STATS)
+/* Charge @ticks of RPC wait to the sessions on the current stack */
+void ts_latency_add_rpc(uint64_t ticks);
+/*
+ * Copy out slot @idx of the latency table, optionally resetting its
+ * counters. Returns TEE_ERROR_ITEM_NOT_FOUND past the last used slot.
+ */
+TEE_Result ts_latency_get_stats(size_t idx, struct ts_latency_stats *stats,
+				bool reset);
+#else
+static inline void ts_latency_add_rpc(uint64_t ticks __unused)
+{
+}
+
+static inline TEE_Result
+ts_latency_get_stats(size_t idx __unused,
+		     struct ts_latency_stats *stats __unused,
+		     bool reset __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 #endif /*__KERNEL_TS_MANAGER_H*/
@@ -10,9 +10,30 @@
 #include <tee_api_types.h>
 #include <types_ext.h>
 
+/*
+ * Element of a batched user space copy, see copy_from_user_batch()
+ */
+struct user_access_elem {
+	void *kaddr;
+	const void *uaddr;
+	size_t len;
+};
+
 #ifdef CFG_WITH_USER_TA
 TEE_Result copy_from_user_private(void *kaddr, const void *uaddr, size_t len);
 TEE_Result copy_from_user(void *kaddr, const void *uaddr, size_t len);
+
+/*
+ * copy_from_user_batch() - Copy several user space buffers in one operation
+ * @elems:	Array of buffers to copy
+ * @num_elems:	Number of elements in @elems
+ *
+ * All ranges are validated before anything is copied so a failure can't
+ * leave a partially filled destination, and the current session is only
+ * looked up once for the whole batch.
+ */
+TEE_Result copy_from_user_batch(struct user_access_elem *elems,
+				size_t num_elems);
 #else
 static inline TEE_Result copy_from_user_private(void *kaddr __unused,
 						const void *uaddr __unused,
@@ -28,6 +49,13 @@ static inline TEE_Result copy_from_user(void *kaddr __unused,
 	return TEE_ERROR_NOT_SUPPORTED;
 }
 
+static inline TEE_Result
+copy_from_user_batch(struct user_access_elem *elems __unused,
+		     size_t num_elems __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
 #endif
 
 TEE_Result copy_to_user_private(void *uaddr, const void *kaddr, size_t len);
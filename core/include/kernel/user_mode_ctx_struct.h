@@ -10,11 +10,28 @@
 #include <kernel/thread.h>
 #include <mm/tee_mmu_types.h>
 
+/*
+ * Per context pager fault statistics, updated by the pager with the
+ * pager lock held. Defined here rather than in <mm/tee_pager.h> which
+ * indirectly includes this header.
+ */
+struct tee_pager_um_stats {
+	size_t faults;
+	size_t read_faults;
+	size_t write_faults;
+	size_t exec_faults;
+	size_t pages_loaded;	/* Pages paged in on behalf of the context */
+	size_t evictions;	/* Evictions the faults above forced */
+};
+
 struct user_mode_ctx {
 	struct vm_info vm_info;
 	struct tee_pager_area_head *areas;
 #if defined(CFG_WITH_VFP)
 	struct thread_user_vfp_state vfp;
+#endif
+#if defined(CFG_PAGED_USER_TA) && defined(CFG_WITH_STATS)
+	struct tee_pager_um_stats pager_stats;
 #endif
 	struct ts_ctx *ts_ctx;
 };
@@ -160,6 +160,19 @@ static inline TEE_Result fobj_save_page(struct fobj *fobj,
  */
 struct fobj *fobj_sec_mem_alloc(unsigned int num_pages);
 
+/*
+ * fobj_sec_mem_alloc_uninit() - Allocates uninitialized storage directly in
+ * secure memory
+ * @num_pages:	Number of pages
+ *
+ * As fobj_sec_mem_alloc() except that the memory isn't cleared. The caller
+ * must write every covered byte before the fobj is made accessible to less
+ * trusted code.
+ *
+ * Returns a valid pointer on success or NULL on failure.
+ */
+struct fobj *fobj_sec_mem_alloc_uninit(unsigned int num_pages);
+
 #define fobj_ta_mem_alloc(num_pages)	fobj_sec_mem_alloc(num_pages)
 #endif
 
@@ -6,6 +6,7 @@
 #ifndef TEE_MM_H
 #define TEE_MM_H
 
+#include <bitstring.h>
 #include <malloc.h>
 #include <types_ext.h>
 
@@ -19,6 +20,7 @@
 struct _tee_mm_entry_t {
 	struct _tee_mm_pool_t *pool;
 	struct _tee_mm_entry_t *next;
+	struct _tee_mm_entry_t *prev;
 	uint32_t offset;	/* offset in pages/sections */
 	uint32_t size;		/* size in pages/sections */
 };
@@ -26,6 +28,15 @@ typedef struct _tee_mm_entry_t tee_mm_entry_t;
 
 struct _tee_mm_pool_t {
 	tee_mm_entry_t *entry;
+	/*
+	 * Bitmap over the granules of the pool, or NULL when the pool is
+	 * too large or allocates from high addresses. With a bitmap
+	 * allocations search for a run of clear bits from a rolling hint
+	 * instead of walking the entry list, and the list is unsorted.
+	 */
+	bitstr_t *bitmap;
+	uint32_t nbits;		/* number of granules covered by bitmap */
+	uint32_t hint;		/* granule where next bitmap search starts */
 	paddr_t lo;		/* low boundary of the pool */
 	paddr_t hi;		/* high boundary of the pool */
 	uint32_t flags;		/* Config flags for the pool */
@@ -40,6 +51,12 @@ typedef struct _tee_mm_pool_t tee_mm_pool_t;
 /* Physical Secure DDR pool */
 extern tee_mm_pool_t tee_mm_sec_ddr;
 
+/*
+ * Physical fast (on-chip) secure RAM bank, only initialized on platforms
+ * registering a MEM_AREA_SEC_FAST_RAM area.
+ */
+extern tee_mm_pool_t tee_mm_sec_fast;
+
 /* Virtual eSRAM pool */
 extern tee_mm_pool_t tee_mm_vcore;
 
@@ -52,6 +69,18 @@ extern tee_mm_pool_t tee_mm_shm;
  */
 tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr);
 
+/*
+ * Allocates secure physical memory, preferring the fast bank when one
+ * is configured and has room, falling back to the secure DDR pool.
+ */
+tee_mm_entry_t *tee_mm_sec_alloc(size_t size);
+
+/*
+ * Returns the mm entry covering the supplied address in either of the
+ * secure physical pools, NULL if none covers it.
+ */
+tee_mm_entry_t *tee_mm_sec_find(paddr_t addr);
+
 /*
  * Validates that an address (addr) is part of the secure virtual memory
  * Returns false if not valid, true if valid
@@ -53,6 +53,12 @@
  * functions.
  */
 #define VM_FLAG_READONLY		BIT(4)
+/*
+ * Tags a parked parameter mapping kept between invocations by the
+ * mapping cache (CFG_TA_SHM_MAP_CACHE). The region only reserves the
+ * virtual address range, the mobj reference is dropped while parked.
+ */
+#define VM_FLAG_SHM_CACHED		BIT(5)
 
 /*
  * Set of flags used by tee_mmu_is_vbuf_inside_ta_private() and
@@ -61,7 +67,8 @@
  */
 #define VM_FLAGS_NONPRIV		(VM_FLAG_EPHEMERAL | \
 					 VM_FLAG_PERMANENT | \
-					 VM_FLAG_SHAREABLE)
+					 VM_FLAG_SHAREABLE | \
+					 VM_FLAG_SHM_CACHED)
 
 struct tee_mmap_region {
 	unsigned int type; /* enum teecore_memtypes */
@@ -77,6 +84,10 @@ struct vm_region {
 	size_t offset;
 	vaddr_t va;
 	size_t size;
+#ifdef CFG_TA_SHM_MAP_CACHE
+	uint64_t shm_cookie;	/* Cookie of a parked parameter mapping */
+	uint32_t shm_releases;	/* mobj_reg_shm_release_count() when parked */
+#endif
 	uint16_t attr; /* TEE_MATTR_* above */
 	uint16_t flags; /* VM_FLAGS_* above */
 	TAILQ_ENTRY(vm_region) link;
@@ -86,6 +97,13 @@ TAILQ_HEAD(vm_region_head, vm_region);
 
 struct vm_info {
 	struct vm_region_head regions;
+	/*
+	 * Sorted-by-va array over the regions above, rebuilt on each map
+	 * change and used for fast lookups. NULL when out of memory in
+	 * which case lookups walk the list instead.
+	 */
+	struct vm_region **idx;
+	size_t idx_count;
 	unsigned int asid;
 };
 
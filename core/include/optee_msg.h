@@ -322,6 +322,18 @@ struct optee_msg_arg {
  * [in] param[0].u.rmem.shm_ref		holds shared memory reference
  * [in] param[0].u.rmem.offs		0
  * [in] param[0].u.rmem.size		0
+ *
+ * OPTEE_MSG_CMD_INVOKE_BATCH invokes a sequence of commands on a
+ * previously opened session using a single call. Each command starts
+ * with one meta value parameter:
+ * [in]  param[n].attr			OPTEE_MSG_ATTR_TYPE_VALUE_INOUT |
+ *					OPTEE_MSG_ATTR_META
+ * [in]  param[n].u.value.a		function to invoke
+ * [in]  param[n].u.value.b		number of parameters following the
+ *					meta parameter
+ * [out] param[n].u.value.c		return code of the command
+ * followed by the parameters of the command. Processing stops at the
+ * first command not returning TEE_SUCCESS.
  */
 #define OPTEE_MSG_CMD_OPEN_SESSION	0
 #define OPTEE_MSG_CMD_INVOKE_COMMAND	1
@@ -329,6 +341,7 @@ struct optee_msg_arg {
 #define OPTEE_MSG_CMD_CANCEL		3
 #define OPTEE_MSG_CMD_REGISTER_SHM	4
 #define OPTEE_MSG_CMD_UNREGISTER_SHM	5
+#define OPTEE_MSG_CMD_INVOKE_BATCH	6
 #define OPTEE_MSG_FUNCID_CALL_WITH_ARG	0x0004
 
 #endif /* _OPTEE_MSG_H */
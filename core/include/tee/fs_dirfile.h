@@ -136,6 +136,21 @@ TEE_Result tee_fs_dirfile_remove(struct tee_fs_dirfile_dirh *dirh,
 TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 				      const struct tee_fs_dirfile_fileh *dfh);
 
+/**
+ * tee_fs_dirfile_snapshot() - get all object ids of a TA in one sweep
+ * @dirh:	dirfile handle
+ * @uuid:	uuid of requesting TA
+ * @ents:	returned allocated array of object ids, or NULL if none,
+ *		to be freed by the caller
+ * @nents:	returned number of entries in @ents
+ *
+ * Sweeps the dirfile with batched reads, several entries per read,
+ * instead of the one entry per read of tee_fs_dirfile_get_next().
+ */
+TEE_Result tee_fs_dirfile_snapshot(struct tee_fs_dirfile_dirh *dirh,
+				   const TEE_UUID *uuid,
+				   struct tee_fs_dirent **ents, size_t *nents);
+
 /**
  * tee_fs_dirfile_get_next() - get object id of next file
  * @dirh:	dirfile handle
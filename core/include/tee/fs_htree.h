@@ -78,10 +78,23 @@ struct tee_fs_rpc_operation;
  *			operation
  * @rpc_write_init:	initialize a struct tee_fs_rpc_operation for an RPC
  *			write operation
+ * @nodes_per_block:	number of node image pairs per physical storage
+ *			block, 0 if whole-block node access isn't supported
+ * @rpc_node_blk_read_init: initialize an RPC read of the physical block
+ *			holding the node image pairs starting at index
+ *			@bnum * @nodes_per_block, may be NULL
+ * @rpc_node_blk_write_init: initialize an RPC write of the same block,
+ *			may be NULL
  *
  * The @idx arguments starts counting from 0. The @vers arguments are either
  * 0 or 1. The @data arguments is a pointer to a buffer in non-secure shared
  * memory where the encrypted data is stored.
+ *
+ * A physical node block accessed through the whole-block callbacks holds
+ * the two versions of each node image back to back, that is, node idx
+ * version vers is found at offset
+ * ((idx % nodes_per_block) * 2 + vers) * sizeof(struct
+ * tee_fs_htree_node_image) within the block.
  */
 struct tee_fs_htree_storage {
 	size_t block_size;
@@ -94,6 +107,13 @@ struct tee_fs_htree_storage {
 				     enum tee_fs_htree_type type, size_t idx,
 				     uint8_t vers, void **data);
 	TEE_Result (*rpc_write_final)(struct tee_fs_rpc_operation *op);
+	size_t nodes_per_block;
+	TEE_Result (*rpc_node_blk_read_init)(void *aux,
+					     struct tee_fs_rpc_operation *op,
+					     size_t bnum, void **data);
+	TEE_Result (*rpc_node_blk_write_init)(void *aux,
+					      struct tee_fs_rpc_operation *op,
+					      size_t bnum, void **data);
 };
 
 struct tee_fs_htree;
@@ -170,4 +190,30 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht, size_t block_num,
 TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht, size_t block_num,
 				   void *block);
 
+/**
+ * tee_fs_htree_get_block_vers() - get committed version of a data block
+ * @ht:		hash tree
+ * @block_num:	block number
+ * @vers:	committed version (0 or 1) of the block on return
+ *
+ * Lets the storage layer compute the physical location of a block and
+ * fetch several blocks with a single RPC before decrypting them with
+ * tee_fs_htree_dec_block(). Does not free the hash tree on failure.
+ */
+TEE_Result tee_fs_htree_get_block_vers(struct tee_fs_htree **ht,
+				       size_t block_num, uint8_t *vers);
+
+/**
+ * tee_fs_htree_dec_block() - decrypt an already read data block
+ * @ht:		hash tree
+ * @block_num:	block number
+ * @enc_block:	encrypted block of stor->block_size size, read from the
+ *		location matching tee_fs_htree_get_block_vers()
+ * @block:	pointer to a block of stor->block_size size
+ *
+ * Frees the hash tree and sets *ht to NULL on failure and returns an error code
+ */
+TEE_Result tee_fs_htree_dec_block(struct tee_fs_htree **ht, size_t block_num,
+				  const void *enc_block, void *block);
+
 #endif /*__TEE_FS_HTREE_H*/
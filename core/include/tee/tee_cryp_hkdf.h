@@ -7,10 +7,30 @@
 #define TEE_CRYP_HKDF_H
 
 #include <tee_api_types.h>
+#include <utee_defines.h>
+
+/*
+ * Cached result of the HKDF extract phase. A derivation with the same
+ * hash, IKM and salt as the cached entry reuses the PRK and skips the
+ * extract HMAC, which pays off when many subkeys are derived from one
+ * master secret with different info strings. @in holds a copy of
+ * IKM | salt to compare the inputs against.
+ */
+struct tee_cryp_hkdf_cache {
+	uint32_t hash_id;
+	size_t prk_len;
+	uint8_t prk[TEE_MAX_HASH_SIZE];
+	uint8_t *in;
+	size_t ikm_len;
+	size_t salt_len;
+};
 
 TEE_Result tee_cryp_hkdf(uint32_t hash_id, const uint8_t *ikm, size_t ikm_len,
 			 const uint8_t *salt, size_t salt_len,
-			 const uint8_t *info, size_t info_len, uint8_t *okm,
+			 const uint8_t *info, size_t info_len,
+			 struct tee_cryp_hkdf_cache *cache, uint8_t *okm,
 			 size_t okm_len);
 
+void tee_cryp_hkdf_cache_clear(struct tee_cryp_hkdf_cache *cache);
+
 #endif /* TEE_CRYP_HKDF_H */
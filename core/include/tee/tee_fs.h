@@ -48,6 +48,18 @@ struct tee_file_operations {
 	TEE_Result (*opendir)(const TEE_UUID *uuid, struct tee_fs_dir **d);
 	TEE_Result (*readdir)(struct tee_fs_dir *d, struct tee_fs_dirent **ent);
 	void (*closedir)(struct tee_fs_dir *d);
+
+	/*
+	 * Optional group commit support. Operations issued between
+	 * begin_transaction() and end_transaction() defer their shared
+	 * metadata commit and are made persistent together by
+	 * end_transaction(). On a crash before end_transaction() all
+	 * operations of the batch roll back as a group. Useful when
+	 * writing many objects in a burst, for instance during
+	 * provisioning.
+	 */
+	TEE_Result (*begin_transaction)(void);
+	TEE_Result (*end_transaction)(void);
 };
 
 #ifdef CFG_REE_FS
@@ -65,6 +77,35 @@ TEE_Result tee_rpmb_fs_raw_open(const char *fname, bool create,
  * prevent a RPMB key write in the wrong state.
  */
 bool plat_rpmb_key_is_ready(void);
+
+/* Number of power-of-two latency buckets in struct tee_rpmb_fs_stats */
+#define TEE_RPMB_FS_STATS_LAT_BUCKETS	8
+
+/*
+ * struct tee_rpmb_fs_stats - health counters for the RPMB path
+ * @read_cnt:	number of data read requests to the device
+ * @write_cnt:	number of data write requests to the device
+ * @frames_sent: number of data frames sent to the device
+ * @hmac_errs:	number of response frames failing HMAC verification
+ * @op_errs:	number of failed operations not counted by @hmac_errs
+ * @wr_cnt_resyncs: number of times the cached write counter was
+ *	invalidated by a failed write and had to be re-read
+ * @read_lat:	read request latency histogram, bucket n counts requests
+ *	that took less than 2^n ms, the last bucket counts the rest
+ * @write_lat:	write request latency histogram, same bucket layout
+ */
+struct tee_rpmb_fs_stats {
+	uint32_t read_cnt;
+	uint32_t write_cnt;
+	uint32_t frames_sent;
+	uint32_t hmac_errs;
+	uint32_t op_errs;
+	uint32_t wr_cnt_resyncs;
+	uint32_t read_lat[TEE_RPMB_FS_STATS_LAT_BUCKETS];
+	uint32_t write_lat[TEE_RPMB_FS_STATS_LAT_BUCKETS];
+};
+
+void tee_rpmb_fs_get_stats(struct tee_rpmb_fs_stats *stats, bool reset);
 #endif
 
 #endif /*TEE_FS_H*/
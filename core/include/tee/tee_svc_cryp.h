@@ -41,6 +41,8 @@ TEE_Result syscall_hash_init(unsigned long state, const void *iv,
 			size_t iv_len);
 TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 			size_t chunk_size);
+TEE_Result syscall_hash_update_iov(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_count);
 TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
 			size_t chunk_size, void *hash, uint64_t *hash_len);
 
@@ -48,6 +50,9 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 			size_t iv_len);
 TEE_Result syscall_cipher_update(unsigned long state, const void *src,
 			size_t src_len, void *dest, uint64_t *dest_len);
+TEE_Result syscall_cipher_update_iov(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_count,
+			void *dest, uint64_t *dest_len);
 TEE_Result syscall_cipher_final(unsigned long state, const void *src,
 			size_t src_len, void *dest, uint64_t *dest_len);
 
@@ -65,6 +70,9 @@ TEE_Result syscall_authenc_update_aad(unsigned long state,
 TEE_Result syscall_authenc_update_payload(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len);
+TEE_Result syscall_authenc_update_payload_iov(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_count,
+			void *dest_data, uint64_t *dest_len);
 TEE_Result syscall_authenc_enc_final(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len, void *tag, uint64_t *tag_len);
@@ -80,6 +88,11 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 			const struct utee_attribute *usr_params,
 			size_t num_params, const void *data, size_t data_len,
 			const void *sig, size_t sig_len);
+TEE_Result syscall_asymm_verify_batch(unsigned long state,
+			const struct utee_attribute *usr_params,
+			size_t num_params, const struct utee_iovec *data_iov,
+			const struct utee_iovec *sig_iov, size_t count,
+			uint64_t *failed_idx);
 
 TEE_Result tee_obj_set_type(struct tee_obj *o, uint32_t obj_type,
 			    size_t max_key_size);
@@ -9,6 +9,7 @@
 #include <libfdt.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <stdlib.h>
 #include <string.h>
 #include <trace.h>
 
@@ -282,6 +283,229 @@ int _fdt_get_status(const void *fdt, int offs)
 	return st;
 }
 
+#ifdef CFG_DT_CACHED_NODE_INDEX
+/*
+ * Indexed node lookup
+ *
+ * fdt_node_offset_by_compatible() and fdt_node_offset_by_phandle() scan
+ * the whole FDT structure block on each query and boot issues many of
+ * them. The index below is built in a single pass over the tree the
+ * first time an indexed lookup is made: one sorted (hash, offset) array
+ * for the compatible strings and one sorted (phandle, offset) array for
+ * the phandles. Lookups then cost a binary search.
+ *
+ * The index targets one FDT at a time, in practice the embedded or the
+ * external DT. The structure block size is recorded when the index is
+ * built: appending properties or nodes grows the block and shifts node
+ * offsets, in which case the index is silently rebuilt. In-place
+ * property updates keep offsets stable and need no rebuild.
+ */
+struct dt_index_entry {
+	uint32_t key;		/* Compatible string hash or phandle */
+	int offset;		/* Node offset in the indexed FDT */
+};
+
+static const void *dt_index_fdt;
+static uint32_t dt_index_struct_size;
+static struct dt_index_entry *dt_compat_index;
+static size_t dt_compat_count;
+static struct dt_index_entry *dt_phandle_index;
+static size_t dt_phandle_count;
+
+static uint32_t dt_index_hash(const char *str)
+{
+	uint32_t hash = 5381;
+
+	while (*str)
+		hash = hash * 33 + *str++;
+
+	return hash;
+}
+
+static int dt_index_entry_cmp(const void *a, const void *b)
+{
+	const struct dt_index_entry *ea = a;
+	const struct dt_index_entry *eb = b;
+
+	if (ea->key != eb->key)
+		return CMP_TRILEAN(ea->key, eb->key);
+
+	return CMP_TRILEAN(ea->offset, eb->offset);
+}
+
+static void dt_index_add_node(const void *fdt, int offs,
+			      size_t *ncompat, size_t *nphandle)
+{
+	int count = fdt_stringlist_count(fdt, offs, "compatible");
+	const char *compat = NULL;
+	int n = 0;
+
+	for (n = 0; n < count; n++) {
+		compat = fdt_stringlist_get(fdt, offs, "compatible", n, NULL);
+		if (!compat)
+			break;
+		if (dt_compat_index) {
+			dt_compat_index[*ncompat].key = dt_index_hash(compat);
+			dt_compat_index[*ncompat].offset = offs;
+		}
+		(*ncompat)++;
+	}
+
+	if (fdt_get_phandle(fdt, offs)) {
+		if (dt_phandle_index) {
+			dt_phandle_index[*nphandle].key = fdt_get_phandle(fdt,
+									  offs);
+			dt_phandle_index[*nphandle].offset = offs;
+		}
+		(*nphandle)++;
+	}
+}
+
+static void dt_index_build(const void *fdt)
+{
+	size_t ncompat = 0;
+	size_t nphandle = 0;
+	int offs = -1;
+
+	free(dt_compat_index);
+	free(dt_phandle_index);
+	dt_compat_index = NULL;
+	dt_phandle_index = NULL;
+	dt_compat_count = 0;
+	dt_phandle_count = 0;
+	dt_index_fdt = NULL;
+
+	/* First pass counts the entries, second pass fills them in */
+	while (true) {
+		offs = fdt_next_node(fdt, offs, NULL);
+		if (offs < 0)
+			break;
+		dt_index_add_node(fdt, offs, &ncompat, &nphandle);
+	}
+
+	if (ncompat) {
+		dt_compat_index = malloc(ncompat * sizeof(*dt_compat_index));
+		if (!dt_compat_index)
+			return;
+	}
+	if (nphandle) {
+		dt_phandle_index = malloc(nphandle *
+					  sizeof(*dt_phandle_index));
+		if (!dt_phandle_index) {
+			free(dt_compat_index);
+			dt_compat_index = NULL;
+			return;
+		}
+	}
+
+	dt_compat_count = ncompat;
+	dt_phandle_count = nphandle;
+	ncompat = 0;
+	nphandle = 0;
+	offs = -1;
+	while (true) {
+		offs = fdt_next_node(fdt, offs, NULL);
+		if (offs < 0)
+			break;
+		dt_index_add_node(fdt, offs, &ncompat, &nphandle);
+	}
+
+	qsort(dt_compat_index, dt_compat_count, sizeof(*dt_compat_index),
+	      dt_index_entry_cmp);
+	qsort(dt_phandle_index, dt_phandle_count, sizeof(*dt_phandle_index),
+	      dt_index_entry_cmp);
+
+	dt_index_struct_size = fdt_size_dt_struct(fdt);
+	dt_index_fdt = fdt;
+}
+
+static bool dt_index_is_valid(const void *fdt)
+{
+	return fdt == dt_index_fdt &&
+	       fdt_size_dt_struct(fdt) == dt_index_struct_size;
+}
+
+static struct dt_index_entry *dt_index_find(struct dt_index_entry *index,
+					    size_t count, uint32_t key)
+{
+	size_t lo = 0;
+	size_t hi = count;
+	size_t mid = 0;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (index[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == count || index[lo].key != key)
+		return NULL;
+
+	return index + lo;
+}
+
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible)
+{
+	struct dt_index_entry *e = NULL;
+	uint32_t hash = 0;
+
+	if (!dt_index_is_valid(fdt))
+		dt_index_build(fdt);
+	if (!dt_index_is_valid(fdt))
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+
+	hash = dt_index_hash(compatible);
+	e = dt_index_find(dt_compat_index, dt_compat_count, hash);
+	if (!e)
+		return -FDT_ERR_NOTFOUND;
+
+	/*
+	 * Entries with an equal hash sort next to each other by increasing
+	 * node offset, fdt_node_check_compatible() filters out collisions.
+	 */
+	for (; e < dt_compat_index + dt_compat_count && e->key == hash; e++)
+		if (e->offset > startoffset &&
+		    !fdt_node_check_compatible(fdt, e->offset, compatible))
+			return e->offset;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	struct dt_index_entry *e = NULL;
+
+	if (!phandle || phandle == (uint32_t)-1)
+		return -FDT_ERR_BADPHANDLE;
+
+	if (!dt_index_is_valid(fdt))
+		dt_index_build(fdt);
+	if (!dt_index_is_valid(fdt))
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	e = dt_index_find(dt_phandle_index, dt_phandle_count, phandle);
+	if (!e)
+		return -FDT_ERR_NOTFOUND;
+
+	return e->offset;
+}
+#else
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible)
+{
+	return fdt_node_offset_by_compatible(fdt, startoffset, compatible);
+}
+
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+#endif /*CFG_DT_CACHED_NODE_INDEX*/
+
 void _fdt_fill_device_info(void *fdt, struct dt_node_info *info, int offs)
 {
 	struct dt_node_info dinfo = {
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <atomic.h>
+#include <keep.h>
+#include <kernel/evtrace.h>
+#include <kernel/misc.h>
+#include <string.h>
+#include <util.h>
+
+struct evtrace_ring {
+	uint32_t head;
+	struct evtrace_rec recs[EVTRACE_RING_SIZE];
+};
+
+static struct evtrace_ring evtrace_rings[CFG_TEE_CORE_NB_CORE];
+
+void evtrace_add(enum evtrace_event event)
+{
+	struct evtrace_ring *r = evtrace_rings + get_core_pos();
+	struct evtrace_rec *rec = NULL;
+
+	/*
+	 * The ring is only written from the owning core but an abort (for
+	 * instance a pager fault) can hit in the middle of recording an
+	 * event, so slots are reserved with an atomic increment to keep
+	 * the nested record from overwriting the interrupted one.
+	 */
+	rec = r->recs + (atomic_inc32(&r->head) - 1) % EVTRACE_RING_SIZE;
+	rec->event = event;
+	rec->pad = 0;
+	rec->timestamp = read_cntpct();
+}
+/* Called from the pager fault handler */
+DECLARE_KEEP_PAGER(evtrace_add);
+
+TEE_Result evtrace_snapshot(size_t core, struct evtrace_rec *recs,
+			    size_t *num_recs, uint32_t *head)
+{
+	struct evtrace_ring *r = NULL;
+	size_t n = 0;
+
+	if (core >= CFG_TEE_CORE_NB_CORE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	r = evtrace_rings + core;
+	n = MIN(*num_recs, (size_t)EVTRACE_RING_SIZE);
+	memcpy(recs, r->recs, n * sizeof(*recs));
+	*num_recs = n;
+	*head = atomic_load_u32(&r->head);
+
+	return TEE_SUCCESS;
+}
@@ -27,6 +27,7 @@ void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 		free(db->ptrs);
 		db->ptrs = NULL;
 		db->max_ptrs = 0;
+		db->min_free = 0;
 	}
 }
 
@@ -39,10 +40,15 @@ int handle_get(struct handle_db *db, void *ptr)
 	if (!db || !ptr)
 		return -1;
 
-	/* Try to find an empty location */
-	for (n = 0; n < db->max_ptrs; n++) {
+	/*
+	 * Try to find an empty location, starting from the free slot hint
+	 * so a mostly full database isn't rescanned from index 0 on every
+	 * allocation.
+	 */
+	for (n = db->min_free; n < db->max_ptrs; n++) {
 		if (!db->ptrs[n]) {
 			db->ptrs[n] = ptr;
+			db->min_free = n + 1;
 			return n;
 		}
 	}
@@ -62,6 +68,7 @@ int handle_get(struct handle_db *db, void *ptr)
 
 	/* Since n stopped at db->max_ptrs there is an empty location there */
 	db->ptrs[n] = ptr;
+	db->min_free = n + 1;
 	return n;
 }
 
@@ -74,6 +81,8 @@ void *handle_put(struct handle_db *db, int handle)
 
 	p = db->ptrs[handle];
 	db->ptrs[handle] = NULL;
+	if ((size_t)handle < db->min_free)
+		db->min_free = handle;
 	return p;
 }
 
@@ -5,6 +5,7 @@
  */
 
 #include <initcall.h>
+#include <kernel/mutex.h>
 #include <trace.h>
 #include <kernel/linker.h>
 
@@ -27,6 +28,40 @@ void __weak call_initcalls(void)
 	}
 }
 
+static bool lazy_initcalls_done;
+static struct mutex lazy_initcalls_mutex = MUTEX_INITIALIZER;
+
+/*
+ * Runs the driver_init_lazy() registered initcalls. With
+ * CFG_DRIVERS_LAZY_INIT they are deferred from boot to the first TA
+ * session opening, the first point where their services can be
+ * requested, so boot doesn't stall on initializing drivers the product
+ * never uses. Without the option those calls run at the driver_init()
+ * level and the lazy array is empty.
+ */
+void call_lazy_initcalls(void)
+{
+	const struct initcall *call = NULL;
+	TEE_Result ret = TEE_SUCCESS;
+
+	if (lazy_initcalls_done)
+		return;
+
+	mutex_lock(&lazy_initcalls_mutex);
+	if (!lazy_initcalls_done) {
+		for (call = lazycall_begin; call < lazycall_end; call++) {
+			DMSG("level %d %s()", call->level, call->func_name);
+			ret = call->func();
+			if (ret != TEE_SUCCESS) {
+				EMSG("Lazy initcall __text_start + 0x%08" PRIxVA
+				     " failed", (vaddr_t)call - VCORE_START_VA);
+			}
+		}
+		lazy_initcalls_done = true;
+	}
+	mutex_unlock(&lazy_initcalls_mutex);
+}
+
 /*
  * Note: this function is weak just to make it possible to exclude it from
  * the unpaged area.
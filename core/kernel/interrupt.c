@@ -3,10 +3,12 @@
  * Copyright (c) 2016-2019, Linaro Limited
  */
 
+#include <arm.h>
 #include <kernel/interrupt.h>
 #include <kernel/panic.h>
 #include <trace.h>
 #include <assert.h>
+#include <util.h>
 
 /*
  * NOTE!
@@ -16,23 +18,88 @@
  * we begin to modify settings after boot initialization.
  */
 
+/*
+ * Handlers are kept in small per interrupt number buckets so delivery
+ * only walks the handlers sharing a bucket instead of every registered
+ * handler, keeping dispatch close to O(1) in the handler count.
+ */
+#define ITR_HANDLER_BUCKETS	U(32)
+
 static struct itr_chip *itr_chip __nex_bss;
-static SLIST_HEAD(, itr_handler) handlers __nex_data =
-	SLIST_HEAD_INITIALIZER(handlers);
+static SLIST_HEAD(itr_handler_head, itr_handler)
+	handlers[ITR_HANDLER_BUCKETS] __nex_bss;
+
+static struct itr_handler_head *itr_bucket(size_t it)
+{
+	return handlers + it % ITR_HANDLER_BUCKETS;
+}
 
 void itr_init(struct itr_chip *chip)
 {
 	itr_chip = chip;
 }
 
+#ifdef CFG_WITH_STATS
+static enum itr_return itr_call_handler(struct itr_handler *h)
+{
+	uint64_t t0 = read_cntpct();
+	enum itr_return ret = h->handler(h);
+	uint64_t ticks = read_cntpct() - t0;
+
+	h->count++;
+	h->max_ticks = MAX(h->max_ticks, ticks);
+
+	return ret;
+}
+
+TEE_Result itr_get_stats(struct itr_stat *stats, size_t *num_stats,
+			 bool reset)
+{
+	struct itr_handler *h = NULL;
+	size_t used = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ITR_HANDLER_BUCKETS; n++)
+		SLIST_FOREACH(h, handlers + n, link)
+			used++;
+
+	if (*num_stats < used) {
+		*num_stats = used;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	used = 0;
+	for (n = 0; n < ITR_HANDLER_BUCKETS; n++) {
+		SLIST_FOREACH(h, handlers + n, link) {
+			stats[used].it = h->it;
+			stats[used].count = h->count;
+			stats[used].max_ticks = h->max_ticks;
+			used++;
+			if (reset) {
+				h->count = 0;
+				h->max_ticks = 0;
+			}
+		}
+	}
+	*num_stats = used;
+
+	return TEE_SUCCESS;
+}
+#else
+static enum itr_return itr_call_handler(struct itr_handler *h)
+{
+	return h->handler(h);
+}
+#endif
+
 void itr_handle(size_t it)
 {
 	struct itr_handler *h = NULL;
 	bool was_handled = false;
 
-	SLIST_FOREACH(h, &handlers, link) {
+	SLIST_FOREACH(h, itr_bucket(it), link) {
 		if (h->it == it) {
-			if (h->handler(h) == ITRR_HANDLED)
+			if (itr_call_handler(h) == ITRR_HANDLED)
 				was_handled = true;
 			else if (!(h->flags & ITRF_SHARED))
 				break;
@@ -49,13 +116,13 @@ void itr_add(struct itr_handler *h)
 {
 	struct itr_handler __maybe_unused *hdl = NULL;
 
-	SLIST_FOREACH(hdl, &handlers, link)
+	SLIST_FOREACH(hdl, itr_bucket(h->it), link)
 		if (hdl->it == h->it)
 			assert((hdl->flags & ITRF_SHARED) &&
 			       (h->flags & ITRF_SHARED));
 
 	itr_chip->ops->add(itr_chip, h->it, h->flags);
-	SLIST_INSERT_HEAD(&handlers, h, link);
+	SLIST_INSERT_HEAD(itr_bucket(h->it), h, link);
 }
 
 void itr_enable(size_t it)
@@ -68,6 +135,59 @@ void itr_disable(size_t it)
 	itr_chip->ops->disable(itr_chip, it);
 }
 
+/* Number of interrupts covered by one mask based chip callback */
+#define ITR_MASK_BITS	U(32)
+
+static void itr_apply_many(const size_t *its, size_t count, bool enable)
+{
+	const struct itr_ops *ops = itr_chip->ops;
+	uint32_t mask = 0;
+	size_t base = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	if (!ops->enable_mask || !ops->disable_mask) {
+		for (n = 0; n < count; n++) {
+			if (enable)
+				ops->enable(itr_chip, its[n]);
+			else
+				ops->disable(itr_chip, its[n]);
+		}
+		return;
+	}
+
+	/* Each used 32 interrupt word is emitted at its first member */
+	for (n = 0; n < count; n++) {
+		base = ROUNDDOWN(its[n], ITR_MASK_BITS);
+
+		for (m = 0; m < n; m++)
+			if (ROUNDDOWN(its[m], ITR_MASK_BITS) == base)
+				break;
+		if (m < n)
+			continue;
+
+		mask = 0;
+		for (m = n; m < count; m++)
+			if (ROUNDDOWN(its[m], ITR_MASK_BITS) == base)
+				mask |= BIT32(its[m] % ITR_MASK_BITS);
+
+		if (enable)
+			ops->enable_mask(itr_chip, base, mask);
+		else
+			ops->disable_mask(itr_chip, base, mask);
+	}
+}
+
+void itr_enable_many(const size_t *its, size_t count)
+{
+	itr_apply_many(its, count, true);
+}
+
+void itr_disable_many(const size_t *its, size_t count)
+{
+	itr_apply_many(its, count, false);
+}
+
 void itr_raise_pi(size_t it)
 {
 	itr_chip->ops->raise_pi(itr_chip, it);
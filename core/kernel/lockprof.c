@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/lockprof.h>
+#include <kernel/spinlock.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * Fixed size open addressed table of profiled locks. The table is small
+ * since only a handful of locks in the core see real traffic, locks that
+ * don't fit once the table is full are silently ignored. The spinlock
+ * protected sections below are a few loads and stores, cheap compared to
+ * the mutex operations being profiled.
+ */
+#define LOCKPROF_NUM_SLOTS	64
+
+struct lockprof_slot {
+	struct lockprof_stat stat;
+	uint64_t hold_start;
+};
+
+static struct lockprof_slot lockprof_slots[LOCKPROF_NUM_SLOTS];
+static unsigned int lockprof_lock = SPINLOCK_UNLOCK;
+
+/* Called with lockprof_lock held */
+static struct lockprof_slot *lockprof_find_slot(uintptr_t lock_id)
+{
+	size_t idx = (lock_id / sizeof(long)) % LOCKPROF_NUM_SLOTS;
+	struct lockprof_slot *slot = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < LOCKPROF_NUM_SLOTS; n++) {
+		slot = lockprof_slots + (idx + n) % LOCKPROF_NUM_SLOTS;
+		if (slot->stat.lock_id == lock_id)
+			return slot;
+		if (!slot->stat.lock_id) {
+			slot->stat.lock_id = lock_id;
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+void lockprof_acquired(uintptr_t lock_id, bool contended)
+{
+	struct lockprof_slot *slot = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&lockprof_lock);
+
+	slot = lockprof_find_slot(lock_id);
+	if (slot) {
+		slot->stat.acquired++;
+		if (contended)
+			slot->stat.contended++;
+		slot->hold_start = read_cntpct();
+	}
+
+	cpu_spin_unlock_xrestore(&lockprof_lock, exceptions);
+}
+
+void lockprof_released(uintptr_t lock_id)
+{
+	struct lockprof_slot *slot = NULL;
+	uint32_t exceptions = 0;
+	uint64_t hold = 0;
+
+	exceptions = cpu_spin_lock_xsave(&lockprof_lock);
+
+	slot = lockprof_find_slot(lock_id);
+	if (slot && slot->hold_start) {
+		hold = read_cntpct() - slot->hold_start;
+		slot->stat.max_hold = MAX(slot->stat.max_hold, hold);
+		slot->hold_start = 0;
+	}
+
+	cpu_spin_unlock_xrestore(&lockprof_lock, exceptions);
+}
+
+TEE_Result lockprof_get_stats(struct lockprof_stat *stats, size_t *num_stats,
+			      bool reset)
+{
+	struct lockprof_slot *slot = NULL;
+	uint32_t exceptions = 0;
+	size_t used = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&lockprof_lock);
+
+	for (n = 0; n < LOCKPROF_NUM_SLOTS; n++)
+		if (lockprof_slots[n].stat.lock_id)
+			used++;
+
+	if (*num_stats < used) {
+		cpu_spin_unlock_xrestore(&lockprof_lock, exceptions);
+		*num_stats = used;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	used = 0;
+	for (n = 0; n < LOCKPROF_NUM_SLOTS; n++) {
+		slot = lockprof_slots + n;
+		if (!slot->stat.lock_id)
+			continue;
+		stats[used++] = slot->stat;
+		if (reset) {
+			slot->stat.acquired = 0;
+			slot->stat.contended = 0;
+			slot->stat.max_hold = 0;
+		}
+	}
+
+	cpu_spin_unlock_xrestore(&lockprof_lock, exceptions);
+	*num_stats = used;
+
+	return TEE_SUCCESS;
+}
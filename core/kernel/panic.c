@@ -29,6 +29,10 @@ void __do_panic(const char *file __maybe_unused,
 			 func ? "<" : "", func ? func : "", func ? ">" : "");
 
 	print_kernel_stack();
+
+	/* Push trace output deferred by CFG_CORE_TRACE_DEFERRED */
+	trace_ext_drain();
+
 	/* abort current execution */
 	while (1)
 		;
@@ -39,6 +39,8 @@ void register_pm_cb(struct pm_callback_handle *pm_hdl)
 
 	ref[count] = *pm_hdl;
 	ref[count].flags = 0;
+	if (!ref[count].hint_mask)
+		ref[count].hint_mask = PM_HINT_STATE_ALL;
 
 	pm_cb_count = count + 1;
 	pm_cb_ref = ref;
@@ -56,6 +58,14 @@ static TEE_Result call_callbacks(enum pm_op op, uint32_t pm_hint,
 		    (hdl->flags & PM_FLAG_SUSPENDED) == (op == PM_OP_SUSPEND))
 			continue;
 
+		/*
+		 * Skip callbacks without state for the targeted power
+		 * state. Suspended callbacks are always resumed no matter
+		 * the resume hint so suspend/resume calls stay balanced.
+		 */
+		if (op == PM_OP_SUSPEND && !(hdl->hint_mask & pm_hint))
+			continue;
+
 		res = hdl->callback(op, pm_hint, hdl);
 		if (res)
 			return res;
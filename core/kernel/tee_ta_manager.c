@@ -5,6 +5,7 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <initcall.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
@@ -16,6 +17,7 @@
 #include <kernel/thread.h>
 #include <kernel/user_mode_ctx.h>
 #include <kernel/user_ta.h>
+#include <kernel/wait_queue.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
@@ -40,6 +42,67 @@ struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
 struct condvar tee_ta_init_cv = CONDVAR_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
+/*
+ * Open sessions are looked up by ID on every syscall entry so they are
+ * also indexed by a small hash table to avoid walking a whole
+ * open-session list for each lookup. The table is protected by
+ * tee_ta_mutex just like the lists. Sessions from all open-session
+ * lists share the table, the owning list is recorded in the session and
+ * matched on lookup.
+ */
+#define TEE_TA_SESS_HASH_SIZE	32
+
+static SLIST_HEAD(tee_ta_sess_hash_head, tee_ta_session)
+	tee_ta_sess_hash[TEE_TA_SESS_HASH_SIZE];
+
+static struct tee_ta_sess_hash_head *sess_hash_bucket(uint32_t id)
+{
+	return tee_ta_sess_hash + id % TEE_TA_SESS_HASH_SIZE;
+}
+
+static void sess_hash_insert(struct tee_ta_session *s,
+			     struct tee_ta_session_head *open_sessions)
+{
+	s->owner = open_sessions;
+	SLIST_INSERT_HEAD(sess_hash_bucket(s->id), s, hash_link);
+}
+
+static void sess_hash_remove(struct tee_ta_session *s)
+{
+	SLIST_REMOVE(sess_hash_bucket(s->id), s, tee_ta_session, hash_link);
+	s->owner = NULL;
+}
+
+/*
+ * Registered contexts are also indexed by UUID so that concurrent
+ * session opens toward different TAs spend as little time as possible
+ * under tee_ta_mutex in tee_ta_context_find(). The buckets are
+ * protected by tee_ta_mutex, like tee_ctxes itself.
+ */
+#define TEE_TA_CTX_HASH_SIZE	16
+
+static SLIST_HEAD(tee_ta_ctx_hash_head, tee_ta_ctx)
+	tee_ta_ctx_hash[TEE_TA_CTX_HASH_SIZE];
+
+static struct tee_ta_ctx_hash_head *ctx_hash_bucket(const TEE_UUID *uuid)
+{
+	return tee_ta_ctx_hash + uuid->timeLow % TEE_TA_CTX_HASH_SIZE;
+}
+
+void tee_ta_link_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	SLIST_INSERT_HEAD(ctx_hash_bucket(&ctx->ts_ctx.uuid), ctx,
+			  uuid_hash_link);
+}
+
+void tee_ta_unlink_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	SLIST_REMOVE(ctx_hash_bucket(&ctx->ts_ctx.uuid), ctx, tee_ta_ctx,
+		     uuid_hash_link);
+}
+
 #ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
 static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
 static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
@@ -184,16 +247,12 @@ static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
 	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
+	SLIST_FOREACH(s, sess_hash_bucket(id), hash_link)
+		if (s->id == id && s->owner == open_sessions)
 			break;
-		}
-	}
 
-	return found;
+	return s;
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
@@ -264,6 +323,7 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 		condvar_wait(&s->refc_cv, &tee_ta_mutex);
 
 	TAILQ_REMOVE(open_sessions, s, link);
+	sess_hash_remove(s);
 
 	mutex_unlock(&tee_ta_mutex);
 }
@@ -284,6 +344,7 @@ static void destroy_session(struct tee_ta_session *s,
 #if defined(CFG_TA_GPROF_SUPPORT)
 	free(s->ts_sess.sbuf);
 #endif
+	mobj_put_wipe(s->param_mobj);
 	free(s);
 }
 
@@ -350,7 +411,7 @@ static void destroy_ta_ctx_from_session(struct tee_ta_session *s)
 	ctx = to_ta_ctx(s->ts_sess.ctx);
 	assert(count == ctx->ref_count);
 
-	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	tee_ta_unlink_ctx(ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	destroy_context(ctx);
@@ -366,7 +427,7 @@ static struct tee_ta_ctx *tee_ta_context_find(const TEE_UUID *uuid)
 {
 	struct tee_ta_ctx *ctx;
 
-	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+	SLIST_FOREACH(ctx, ctx_hash_bucket(uuid), uuid_hash_link) {
 		if (memcmp(&ctx->ts_ctx.uuid, uuid, sizeof(TEE_UUID)) == 0)
 			return ctx;
 	}
@@ -539,7 +600,7 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 	keep_alive = (ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE) &&
 			(ctx->flags & TA_FLAG_SINGLE_INSTANCE);
 	if (!ctx->ref_count && !keep_alive) {
-		TAILQ_REMOVE(&tee_ctxes, ctx, link);
+		tee_ta_unlink_ctx(ctx);
 		mutex_unlock(&tee_ta_mutex);
 
 		destroy_context(ctx);
@@ -646,6 +707,7 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 	}
 
 	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	sess_hash_insert(s, open_sessions);
 
 	/* Look for already loaded TA */
 	res = tee_ta_init_session_with_context(s, uuid);
@@ -674,6 +736,7 @@ out:
 
 	mutex_lock(&tee_ta_mutex);
 	TAILQ_REMOVE(open_sessions, s, link);
+	sess_hash_remove(s);
 err_mutex_unlock:
 	mutex_unlock(&tee_ta_mutex);
 	free(s);
@@ -694,6 +757,9 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	bool panicked = false;
 	bool was_busy = false;
 
+	/* Lazily registered drivers must be ready before a TA can run */
+	call_lazy_initcalls();
+
 	res = tee_ta_init_session(err, open_sessions, uuid, &s);
 	if (res != TEE_SUCCESS) {
 		DMSG("init session failed 0x%x", res);
@@ -717,6 +783,9 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	/* Save identity of the owner of the session */
 	s->clnt_id = *clnt_id;
 
+	if (ctx->flags & TA_FLAG_LATENCY_SENSITIVE)
+		s->ts_sess.wq_prio = WQ_PRIO_HIGH;
+
 	if (tee_ta_try_set_busy(ctx)) {
 		s->param = param;
 		set_invoke_timeout(s, cancel_req_to);
@@ -847,28 +916,21 @@ bool tee_ta_session_is_cancelled(struct tee_ta_session *s, TEE_Time *curr_time)
 void tee_ta_gprof_sample_pc(vaddr_t pc)
 {
 	struct ts_session *s = ts_get_current_session();
-	struct user_ta_ctx *utc = NULL;
 	struct sample_buf *sbuf = NULL;
-	TEE_Result res = 0;
 	size_t idx = 0;
 
 	sbuf = s->sbuf;
 	if (!sbuf || !sbuf->enabled)
 		return; /* PC sampling is not enabled */
 
+	/*
+	 * The histogram is core private memory so no per sample access
+	 * rights check is needed, it's copied to the user buffer when
+	 * sampling stops.
+	 */
 	idx = (((uint64_t)pc - sbuf->offset)/2 * sbuf->scale)/65536;
-	if (idx < sbuf->nsamples) {
-		utc = to_user_ta_ctx(s->ctx);
-		res = vm_check_access_rights(&utc->uctx,
-					     TEE_MEMORY_ACCESS_READ |
-					     TEE_MEMORY_ACCESS_WRITE |
-					     TEE_MEMORY_ACCESS_ANY_OWNER,
-					     (uaddr_t)&sbuf->samples[idx],
-					     sizeof(*sbuf->samples));
-		if (res != TEE_SUCCESS)
-			return;
+	if (idx < sbuf->nsamples)
 		sbuf->samples[idx]++;
-	}
 	sbuf->count++;
 }
 
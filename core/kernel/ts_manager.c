@@ -4,14 +4,121 @@
  * Copyright (c) 2020, Linaro Limited
  */
 
+#include <arm.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <kernel/ts_manager.h>
 #include <kernel/user_mode_ctx.h>
 #include <mm/core_mmu.h>
 #include <mm/vm.h>
+#include <string.h>
+#include <util.h>
+
+#if defined(CFG_TS_LATENCY_STATS)
+/* Bounded table of per UUID histograms, protected by ts_latency_lock */
+#define TS_LATENCY_NB_TS	16
+
+static struct ts_latency_stats ts_latency[TS_LATENCY_NB_TS];
+static unsigned int ts_latency_lock = SPINLOCK_UNLOCK;
+
+static size_t lat_bucket(uint64_t us)
+{
+	size_t n = 0;
+
+	while ((us >>= 1) && n < TS_LATENCY_NB_BUCKETS - 1)
+		n++;
+
+	return n;
+}
+
+static struct ts_latency_stats *lat_find_slot(const TEE_UUID *uuid)
+{
+	struct ts_latency_stats *free_slot = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < TS_LATENCY_NB_TS; n++) {
+		if (!ts_latency[n].used) {
+			if (!free_slot)
+				free_slot = ts_latency + n;
+			continue;
+		}
+		if (!memcmp(&ts_latency[n].uuid, uuid, sizeof(*uuid)))
+			return ts_latency + n;
+	}
+
+	if (free_slot) {
+		free_slot->used = true;
+		free_slot->uuid = *uuid;
+	}
+
+	/* NULL if the table is full, the entry is then dropped */
+	return free_slot;
+}
+
+static void lat_record(struct ts_session *s, uint64_t now)
+{
+	struct ts_latency_stats *st = NULL;
+	uint32_t freq = read_cntfrq();
+	uint64_t wall = now - s->lat_enter;
+	uint64_t rpc = MIN(s->lat_rpc, wall);
+	uint32_t exceptions = 0;
+
+	if (!freq)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&ts_latency_lock);
+	st = lat_find_slot(&s->ctx->uuid);
+	if (st) {
+		st->count++;
+		st->compute[lat_bucket((wall - rpc) * 1000000 / freq)]++;
+		st->rpc[lat_bucket(rpc * 1000000 / freq)]++;
+	}
+	cpu_spin_unlock_xrestore(&ts_latency_lock, exceptions);
+}
+
+void ts_latency_add_rpc(uint64_t ticks)
+{
+	struct thread_specific_data *tsd = thread_get_tsd();
+	struct ts_session *s = NULL;
+
+	/*
+	 * The whole session stack is blocked on the RPC so the wait
+	 * must not be accounted as compute time for any of the
+	 * suspended callers either.
+	 */
+	TAILQ_FOREACH(s, &tsd->sess_stack, link_tsd)
+		s->lat_rpc += ticks;
+}
+
+TEE_Result ts_latency_get_stats(size_t idx, struct ts_latency_stats *stats,
+				bool reset)
+{
+	TEE_Result res = TEE_ERROR_ITEM_NOT_FOUND;
+	uint32_t exceptions = 0;
+
+	if (idx >= TS_LATENCY_NB_TS)
+		return res;
+
+	exceptions = cpu_spin_lock_xsave(&ts_latency_lock);
+	if (ts_latency[idx].used) {
+		*stats = ts_latency[idx];
+		if (reset) {
+			ts_latency[idx].count = 0;
+			memset(ts_latency[idx].compute, 0,
+			       sizeof(ts_latency[idx].compute));
+			memset(ts_latency[idx].rpc, 0,
+			       sizeof(ts_latency[idx].rpc));
+		}
+		res = TEE_SUCCESS;
+	}
+	cpu_spin_unlock_xrestore(&ts_latency_lock, exceptions);
+
+	return res;
+}
+#endif /*CFG_TS_LATENCY_STATS*/
 
 static void update_current_ctx(struct thread_specific_data *tsd)
 {
@@ -39,6 +146,10 @@ void ts_push_current_session(struct ts_session *s)
 {
 	struct thread_specific_data *tsd = thread_get_tsd();
 
+#if defined(CFG_TS_LATENCY_STATS)
+	s->lat_enter = read_cntpct();
+	s->lat_rpc = 0;
+#endif
 	TAILQ_INSERT_HEAD(&tsd->sess_stack, s, link_tsd);
 	update_current_ctx(tsd);
 }
@@ -51,6 +162,9 @@ struct ts_session *ts_pop_current_session(void)
 	if (s) {
 		TAILQ_REMOVE(&tsd->sess_stack, s, link_tsd);
 		update_current_ctx(tsd);
+#if defined(CFG_TS_LATENCY_STATS)
+		lat_record(s, read_cntpct());
+#endif
 	}
 	return s;
 }
@@ -6,6 +6,7 @@
 
 #include <initcall.h>
 #include <kernel/linker.h>
+#include <kernel/memcpy_accel.h>
 #include <kernel/user_access.h>
 #include <mm/vm.h>
 #include <string.h>
@@ -26,7 +27,7 @@ TEE_Result copy_from_user(void *kaddr, const void *uaddr, size_t len)
 	TEE_Result res = check_access(flags, (vaddr_t)uaddr, len);
 
 	if (!res)
-		memcpy(kaddr, uaddr, len);
+		memcpy_accel(kaddr, uaddr, len);
 
 	return res;
 }
@@ -37,11 +38,41 @@ TEE_Result copy_to_user(void *uaddr, const void *kaddr, size_t len)
 	TEE_Result res = check_access(flags, (vaddr_t)uaddr, len);
 
 	if (!res)
-		memcpy(uaddr, kaddr, len);
+		memcpy_accel(uaddr, kaddr, len);
 
 	return res;
 }
 
+TEE_Result copy_from_user_batch(struct user_access_elem *elems,
+				size_t num_elems)
+{
+	uint32_t flags = TEE_MEMORY_ACCESS_READ | TEE_MEMORY_ACCESS_ANY_OWNER;
+	struct ts_session *s = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	/*
+	 * Validate all the ranges before copying anything. Besides keeping
+	 * a failed batch from filling any of the destinations this keeps
+	 * the copy loop free from checks, should user space access ever
+	 * need to be explicitly opened it can be opened once for the whole
+	 * batch.
+	 */
+	for (n = 0; n < num_elems; n++) {
+		res = vm_check_access_rights(&utc->uctx, flags,
+					     (vaddr_t)elems[n].uaddr,
+					     elems[n].len);
+		if (res)
+			return res;
+	}
+
+	for (n = 0; n < num_elems; n++)
+		memcpy_accel(elems[n].kaddr, elems[n].uaddr, elems[n].len);
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result copy_from_user_private(void *kaddr, const void *uaddr, size_t len)
 {
 	uint32_t flags = TEE_MEMORY_ACCESS_READ;
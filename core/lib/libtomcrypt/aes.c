@@ -47,3 +47,43 @@ void crypto_aes_enc_block(const void *enc_key, size_t enc_keylen __maybe_unused,
 		panic();
 #endif
 }
+
+TEE_Result crypto_aes_expand_dec_key(const void *key, size_t key_len,
+				     void *dec_key, size_t dec_keylen,
+				     unsigned int *rounds)
+{
+#ifdef _CFG_CORE_LTC_AES_ACCEL
+	uint8_t enc_key[sizeof(((symmetric_key *)NULL)->rijndael.eK)] = { 0 };
+
+	return crypto_accel_aes_expand_keys(key, key_len, enc_key, dec_key,
+					    dec_keylen, rounds);
+#else
+	symmetric_key skey;
+
+	if (dec_keylen < sizeof(skey.rijndael.dK))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (aes_setup(key, key_len, 0, &skey))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memcpy(dec_key, skey.rijndael.dK, sizeof(skey.rijndael.dK));
+	*rounds = skey.rijndael.Nr;
+	return TEE_SUCCESS;
+#endif
+}
+
+void crypto_aes_dec_block(const void *dec_key, size_t dec_keylen __maybe_unused,
+			  unsigned int rounds, const void *src, void *dst)
+{
+#ifdef _CFG_CORE_LTC_AES_ACCEL
+	crypto_accel_aes_ecb_dec(dst, src, dec_key, rounds, 1);
+#else
+	symmetric_key skey;
+
+	assert(dec_keylen >= sizeof(skey.rijndael.dK));
+	memcpy(skey.rijndael.dK, dec_key, sizeof(skey.rijndael.dK));
+	skey.rijndael.Nr = rounds;
+	if (aes_ecb_decrypt(src, dst, &skey))
+		panic();
+#endif
+}
@@ -7,12 +7,21 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
 
 #include "des2_key.h"
 
+/*
+ * cached_key is a raw copy of the key scheduled in @state (after the
+ * 2-key 3DES expansion when applicable), or size zero when no schedule
+ * is valid. Re-initializing with the same key then only sets the IV
+ * instead of re-running the key schedule. 32 bytes fit the largest
+ * symmetric key (AES-256).
+ */
 struct ltc_cbc_ctx {
 	struct crypto_cipher_ctx ctx;
 	int cipher_idx;
@@ -20,6 +29,8 @@ struct ltc_cbc_ctx {
 	int (*update)(const unsigned char *src, unsigned char *dst,
 		      unsigned long len, symmetric_CBC *cbc);
 	symmetric_CBC state;
+	uint8_t cached_key[32];
+	size_t cached_key_len;
 };
 
 static const struct crypto_cipher_ops ltc_cbc_ops;
@@ -53,10 +64,24 @@ static TEE_Result ltc_cbc_init(struct crypto_cipher_ctx *ctx,
 	if (c->des3)
 		get_des2_key(&k, &kl, tmp);
 
-	if (cbc_start(c->cipher_idx, iv, k, kl, 0, &c->state) == CRYPT_OK)
+	/* The schedule holds both directions, a mode change reuses it */
+	if (kl && kl == c->cached_key_len &&
+	    !consttime_memcmp(k, c->cached_key, kl)) {
+		if (cbc_setiv(iv, iv_len, &c->state) == CRYPT_OK)
+			return TEE_SUCCESS;
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	c->cached_key_len = 0;
+	if (cbc_start(c->cipher_idx, iv, k, kl, 0, &c->state) == CRYPT_OK) {
+		if (kl <= sizeof(c->cached_key)) {
+			memcpy(c->cached_key, k, kl);
+			c->cached_key_len = kl;
+		}
 		return TEE_SUCCESS;
-	else
+	} else {
 		return TEE_ERROR_BAD_STATE;
+	}
 }
 
 static TEE_Result ltc_cbc_update(struct crypto_cipher_ctx *ctx,
@@ -73,7 +98,11 @@ static TEE_Result ltc_cbc_update(struct crypto_cipher_ctx *ctx,
 
 static void ltc_cbc_final(struct crypto_cipher_ctx *ctx)
 {
-	cbc_done(&to_cbc_ctx(ctx)->state);
+	struct ltc_cbc_ctx *c = to_cbc_ctx(ctx);
+
+	/* cbc_done() invalidates the key schedule */
+	c->cached_key_len = 0;
+	cbc_done(&c->state);
 }
 
 static void ltc_cbc_free_ctx(struct crypto_cipher_ctx *ctx)
@@ -90,6 +119,8 @@ static void ltc_cbc_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	assert(src->cipher_idx == dst->cipher_idx);
 	dst->update = src->update;
 	dst->state = src->state;
+	memcpy(dst->cached_key, src->cached_key, sizeof(dst->cached_key));
+	dst->cached_key_len = src->cached_key_len;
 }
 
 static const struct crypto_cipher_ops ltc_cbc_ops = {
@@ -7,16 +7,27 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
 
+/*
+ * cached_key is a raw copy of the key scheduled in @state, or size zero
+ * when no schedule is valid. Re-initializing with the same key then only
+ * sets the counter instead of re-running the key schedule, which is the
+ * dominant cost when an operation is re-initialized per packet. 32 bytes
+ * fit the largest symmetric key (AES-256).
+ */
 struct ltc_ctr_ctx {
 	struct crypto_cipher_ctx ctx;
 	int cipher_idx;
 	int (*update)(const unsigned char *src, unsigned char *dst,
 		      unsigned long len, symmetric_CTR *ctr);
 	symmetric_CTR state;
+	uint8_t cached_key[32];
+	size_t cached_key_len;
 };
 
 static const struct crypto_cipher_ops ltc_ctr_ops;
@@ -45,11 +56,25 @@ static TEE_Result ltc_ctr_init(struct crypto_cipher_ctx *ctx,
 	else
 		c->update = ctr_decrypt;
 
+	/* The schedule holds both directions, a mode change reuses it */
+	if (key1_len && key1_len == c->cached_key_len &&
+	    !consttime_memcmp(key1, c->cached_key, key1_len)) {
+		if (ctr_setiv(iv, iv_len, &c->state) == CRYPT_OK)
+			return TEE_SUCCESS;
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	c->cached_key_len = 0;
 	if (ctr_start(c->cipher_idx, iv, key1, key1_len, 0,
-		      CTR_COUNTER_BIG_ENDIAN, &c->state) == CRYPT_OK)
+		      CTR_COUNTER_BIG_ENDIAN, &c->state) == CRYPT_OK) {
+		if (key1_len <= sizeof(c->cached_key)) {
+			memcpy(c->cached_key, key1, key1_len);
+			c->cached_key_len = key1_len;
+		}
 		return TEE_SUCCESS;
-	else
+	} else {
 		return TEE_ERROR_BAD_STATE;
+	}
 }
 
 static TEE_Result ltc_ctr_update(struct crypto_cipher_ctx *ctx,
@@ -66,7 +91,11 @@ static TEE_Result ltc_ctr_update(struct crypto_cipher_ctx *ctx,
 
 static void ltc_ctr_final(struct crypto_cipher_ctx *ctx)
 {
-	ctr_done(&to_ctr_ctx(ctx)->state);
+	struct ltc_ctr_ctx *c = to_ctr_ctx(ctx);
+
+	/* ctr_done() invalidates the key schedule */
+	c->cached_key_len = 0;
+	ctr_done(&c->state);
 }
 
 static void ltc_ctr_free_ctx(struct crypto_cipher_ctx *ctx)
@@ -83,6 +112,8 @@ static void ltc_ctr_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	assert(src->cipher_idx == dst->cipher_idx);
 	dst->update = src->update;
 	dst->state = src->state;
+	memcpy(dst->cached_key, src->cached_key, sizeof(dst->cached_key));
+	dst->cached_key_len = src->cached_key_len;
 }
 
 static const struct crypto_cipher_ops ltc_ctr_ops = {
@@ -7,12 +7,20 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
 
 #include "des2_key.h"
 
+/*
+ * cached_key is a raw copy of the key scheduled in @state (after the
+ * 2-key 3DES expansion when applicable), or size zero when no schedule
+ * is valid. ECB has no IV so re-initializing with the same key becomes
+ * a no-op. 32 bytes fit the largest symmetric key (AES-256).
+ */
 struct ltc_ecb_ctx {
 	struct crypto_cipher_ctx ctx;
 	int cipher_idx;
@@ -20,6 +28,8 @@ struct ltc_ecb_ctx {
 	int (*update)(const unsigned char *src, unsigned char *dst,
 		      unsigned long len, symmetric_ECB *ecb);
 	symmetric_ECB state;
+	uint8_t cached_key[32];
+	size_t cached_key_len;
 };
 
 static const struct crypto_cipher_ops ltc_ecb_ops;
@@ -51,10 +61,21 @@ static TEE_Result ltc_ecb_init(struct crypto_cipher_ctx *ctx,
 	if (c->des3)
 		get_des2_key(&k, &kl, tmp);
 
-	if (ecb_start(c->cipher_idx, k, kl, 0, &c->state) == CRYPT_OK)
+	/* The schedule holds both directions, a mode change reuses it */
+	if (kl && kl == c->cached_key_len &&
+	    !consttime_memcmp(k, c->cached_key, kl))
 		return TEE_SUCCESS;
-	else
+
+	c->cached_key_len = 0;
+	if (ecb_start(c->cipher_idx, k, kl, 0, &c->state) == CRYPT_OK) {
+		if (kl <= sizeof(c->cached_key)) {
+			memcpy(c->cached_key, k, kl);
+			c->cached_key_len = kl;
+		}
+		return TEE_SUCCESS;
+	} else {
 		return TEE_ERROR_BAD_STATE;
+	}
 }
 
 static TEE_Result ltc_ecb_update(struct crypto_cipher_ctx *ctx,
@@ -71,7 +92,11 @@ static TEE_Result ltc_ecb_update(struct crypto_cipher_ctx *ctx,
 
 static void ltc_ecb_final(struct crypto_cipher_ctx *ctx)
 {
-	ecb_done(&to_ecb_ctx(ctx)->state);
+	struct ltc_ecb_ctx *c = to_ecb_ctx(ctx);
+
+	/* ecb_done() invalidates the key schedule */
+	c->cached_key_len = 0;
+	ecb_done(&c->state);
 }
 
 static void ltc_ecb_free_ctx(struct crypto_cipher_ctx *ctx)
@@ -88,6 +113,8 @@ static void ltc_ecb_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	assert(src->cipher_idx == dst->cipher_idx);
 	dst->update = src->update;
 	dst->state = src->state;
+	memcpy(dst->cached_key, src->cached_key, sizeof(dst->cached_key));
+	dst->cached_key_len = src->cached_key_len;
 }
 
 static const struct crypto_cipher_ops ltc_ecb_ops = {
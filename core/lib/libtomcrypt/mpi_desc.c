@@ -33,7 +33,7 @@ static struct mempool *get_mp_scratch_memory_pool(void)
 	size_t size;
 	void *data;
 
-	size = ROUNDUP(MPI_MEMPOOL_SIZE, SMALL_PAGE_SIZE);
+	size = ROUNDUP(MPI_MEMPOOL_SIZE * MEMPOOL_NUM_ARENAS, SMALL_PAGE_SIZE);
 	data = tee_pager_alloc(size);
 	if (!data)
 		panic();
@@ -43,7 +43,8 @@ static struct mempool *get_mp_scratch_memory_pool(void)
 #else /* _CFG_CORE_LTC_PAGER */
 static struct mempool *get_mp_scratch_memory_pool(void)
 {
-	static uint8_t data[MPI_MEMPOOL_SIZE] __aligned(MEMPOOL_ALIGN);
+	static uint8_t data[MPI_MEMPOOL_SIZE * MEMPOOL_NUM_ARENAS]
+		__aligned(MEMPOOL_ALIGN);
 
 	return mempool_alloc_pool(data, sizeof(data), NULL);
 }
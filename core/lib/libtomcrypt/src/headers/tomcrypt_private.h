@@ -293,6 +293,13 @@ void ltc_ecc_fp_tablelock(int lock);
 /* R = kG */
 int ltc_ecc_mulmod(void *k, const ecc_point *G, ecc_point *R, void *a, void *modulus, int map);
 
+#ifdef LTC_ECC_MULMOD_P256
+/* R = kG with fixed width constant-time NIST P-256 arithmetic. Returns
+   CRYPT_INVALID_ARG when the arguments don't match the curve, the caller
+   is expected to fall back to the generic implementation. */
+int ltc_ecc_mulmod_p256(void *k, const ecc_point *G, ecc_point *R, void *a, void *modulus, int map);
+#endif
+
 #ifdef LTC_ECC_SHAMIR
 /* kA*A + kB*B = C */
 int ltc_ecc_mul2add(const ecc_point *A, void *kA,
@@ -0,0 +1,572 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* LibTomCrypt, modular cryptographic library -- Tom St Denis
+ *
+ * LibTomCrypt is a library that provides various cryptographic
+ * algorithms in a highly modular and flexible manner.
+ *
+ * The library is free for all purposes without any express
+ * guarantee it works.
+ */
+
+#include "tomcrypt_private.h"
+
+/**
+  @file ltc_ecc_mulmod_p256.c
+  Specialized constant-time point multiplication for NIST P-256
+
+  The generic point multiplication runs Jacobian arithmetic over heap
+  allocated bignums with a reduction chosen at run time. P-256 dominates
+  real workloads, so this file implements the curve with fixed width
+  256-bit field elements held in machine-word arrays: eight 32-bit
+  limbs, Montgomery multiplication (the Montgomery constant -p^-1 mod
+  2^32 is 1 for this prime), branch-free field and point operations and
+  masked table lookups. No memory is allocated and no branch or memory
+  access depends on the scalar.
+*/
+
+#if defined(LTC_MECC) && defined(LTC_ECC_MULMOD_P256)
+
+#define P256_NLIMBS	8
+#define P256_NBYTES	32
+
+/* Field elements are little-endian arrays of 32-bit limbs */
+typedef uint32_t p256_felem[P256_NLIMBS];
+
+/* The field prime p = 2^256 - 2^224 + 2^192 + 2^96 - 1 */
+static const p256_felem p256_p = {
+   0xffffffff, 0xffffffff, 0xffffffff, 0x00000000,
+   0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+/* Big-endian byte form of the prime, to recognize the curve */
+static const unsigned char p256_p_bytes[P256_NBYTES] = {
+   0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+/* R^2 mod p where R = 2^256, converts into the Montgomery domain */
+static const p256_felem p256_rr = {
+   0x00000003, 0x00000000, 0xffffffff, 0xfffffffb,
+   0xfffffffe, 0xffffffff, 0xfffffffd, 0x00000004
+};
+
+/* 1 in the Montgomery domain, i.e. R mod p */
+static const p256_felem p256_one_mont = {
+   0x00000001, 0x00000000, 0x00000000, 0xffffffff,
+   0xffffffff, 0xffffffff, 0xfffffffe, 0x00000000
+};
+
+/* 1 as a plain integer, multiplying by it leaves the Montgomery domain */
+static const p256_felem p256_one = {
+   0x00000001, 0x00000000, 0x00000000, 0x00000000,
+   0x00000000, 0x00000000, 0x00000000, 0x00000000
+};
+
+/* All bits set when @x is zero, else all bits clear */
+static uint32_t p256_is_zero_mask(uint32_t x)
+{
+   return (uint32_t)(((uint64_t)x - 1) >> 32);
+}
+
+/* out = mask ? b : a, with @mask either all ones or all zeroes */
+static void p256_felem_select(p256_felem out, const p256_felem a,
+                              const p256_felem b, uint32_t mask)
+{
+   size_t i;
+
+   for (i = 0; i < P256_NLIMBS; i++)
+      out[i] = (a[i] & ~mask) | (b[i] & mask);
+}
+
+static uint32_t p256_felem_is_zero_mask(const p256_felem a)
+{
+   uint32_t x = 0;
+   size_t i;
+
+   for (i = 0; i < P256_NLIMBS; i++)
+      x |= a[i];
+
+   return p256_is_zero_mask(x);
+}
+
+/* out = (a + b) mod p */
+static void p256_felem_add(p256_felem out, const p256_felem a,
+                           const p256_felem b)
+{
+   uint32_t t[P256_NLIMBS], u[P256_NLIMBS];
+   uint32_t carry = 0, borrow = 0, keep_t;
+   size_t i;
+
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t c = (uint64_t)a[i] + b[i] + carry;
+
+      t[i] = (uint32_t)c;
+      carry = (uint32_t)(c >> 32);
+   }
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t d = (uint64_t)t[i] - p256_p[i] - borrow;
+
+      u[i] = (uint32_t)d;
+      borrow = (uint32_t)((d >> 63) & 1);
+   }
+   /* The sum was already reduced iff it borrowed and had no carry out */
+   keep_t = (uint32_t)0 - (borrow & (carry ^ 1));
+   p256_felem_select(out, u, t, keep_t);
+}
+
+/* out = (a - b) mod p */
+static void p256_felem_sub(p256_felem out, const p256_felem a,
+                           const p256_felem b)
+{
+   uint32_t t[P256_NLIMBS], u[P256_NLIMBS];
+   uint32_t carry = 0, borrow = 0, keep_u;
+   size_t i;
+
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t d = (uint64_t)a[i] - b[i] - borrow;
+
+      t[i] = (uint32_t)d;
+      borrow = (uint32_t)((d >> 63) & 1);
+   }
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t c = (uint64_t)t[i] + p256_p[i] + carry;
+
+      u[i] = (uint32_t)c;
+      carry = (uint32_t)(c >> 32);
+   }
+   keep_u = (uint32_t)0 - borrow;
+   p256_felem_select(out, t, u, keep_u);
+}
+
+/*
+ * out = a * b / R mod p, CIOS Montgomery multiplication. With this
+ * prime -p^-1 mod 2^32 == 1 so the reduction factor in each round is
+ * simply the bottom accumulator limb.
+ */
+static void p256_felem_mul(p256_felem out, const p256_felem a,
+                           const p256_felem b)
+{
+   uint32_t t[P256_NLIMBS + 2] = { 0 };
+   uint32_t u[P256_NLIMBS], carry, borrow, keep_t;
+   size_t i, j;
+
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t c;
+      uint32_t m;
+
+      carry = 0;
+      for (j = 0; j < P256_NLIMBS; j++) {
+         c = (uint64_t)t[j] + (uint64_t)a[i] * b[j] + carry;
+         t[j] = (uint32_t)c;
+         carry = (uint32_t)(c >> 32);
+      }
+      c = (uint64_t)t[P256_NLIMBS] + carry;
+      t[P256_NLIMBS] = (uint32_t)c;
+      t[P256_NLIMBS + 1] = (uint32_t)(c >> 32);
+
+      m = t[0];
+      c = (uint64_t)t[0] + (uint64_t)m * p256_p[0];
+      carry = (uint32_t)(c >> 32);
+      for (j = 1; j < P256_NLIMBS; j++) {
+         c = (uint64_t)t[j] + (uint64_t)m * p256_p[j] + carry;
+         t[j - 1] = (uint32_t)c;
+         carry = (uint32_t)(c >> 32);
+      }
+      c = (uint64_t)t[P256_NLIMBS] + carry;
+      t[P256_NLIMBS - 1] = (uint32_t)c;
+      t[P256_NLIMBS] = t[P256_NLIMBS + 1] + (uint32_t)(c >> 32);
+      t[P256_NLIMBS + 1] = 0;
+   }
+
+   borrow = 0;
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t d = (uint64_t)t[i] - p256_p[i] - borrow;
+
+      u[i] = (uint32_t)d;
+      borrow = (uint32_t)((d >> 63) & 1);
+   }
+   keep_t = (uint32_t)0 - (borrow & (t[P256_NLIMBS] ^ 1));
+   p256_felem_select(out, u, t, keep_t);
+}
+
+static void p256_felem_sqr(p256_felem out, const p256_felem a)
+{
+   p256_felem_mul(out, a, a);
+}
+
+/*
+ * out = a^-1 mod p via a^(p - 2). The exponent is a public constant so
+ * plain square-and-multiply over its bits leaks nothing about @a.
+ */
+static void p256_felem_inv(p256_felem out, const p256_felem a)
+{
+   static const p256_felem p_minus_2 = {
+      0xfffffffd, 0xffffffff, 0xffffffff, 0x00000000,
+      0x00000000, 0x00000000, 0x00000001, 0xffffffff
+   };
+   p256_felem r;
+   int i;
+
+   /* The top exponent bit is set, start from @a */
+   XMEMCPY(r, a, sizeof(r));
+   for (i = 254; i >= 0; i--) {
+      p256_felem_sqr(r, r);
+      if ((p_minus_2[i / 32] >> (i % 32)) & 1)
+         p256_felem_mul(r, r, a);
+   }
+   XMEMCPY(out, r, sizeof(r));
+}
+
+/*
+ * Jacobian points in the Montgomery domain. Z == 0 encodes the point
+ * at infinity.
+ */
+struct p256_jacobian {
+   p256_felem x;
+   p256_felem y;
+   p256_felem z;
+};
+
+static void p256_point_select(struct p256_jacobian *out,
+                              const struct p256_jacobian *a,
+                              const struct p256_jacobian *b, uint32_t mask)
+{
+   p256_felem_select(out->x, a->x, b->x, mask);
+   p256_felem_select(out->y, a->y, b->y, mask);
+   p256_felem_select(out->z, a->z, b->z, mask);
+}
+
+/* R = 2P, dbl-2001-b formulas for a == -3 */
+static void p256_point_double(struct p256_jacobian *r,
+                              const struct p256_jacobian *p)
+{
+   p256_felem delta, gamma, beta, alpha, t1, t2, fourbeta;
+
+   p256_felem_sqr(delta, p->z);
+   p256_felem_sqr(gamma, p->y);
+   p256_felem_mul(beta, p->x, gamma);
+
+   /* alpha = 3 * (x - delta) * (x + delta) */
+   p256_felem_sub(t1, p->x, delta);
+   p256_felem_add(t2, p->x, delta);
+   p256_felem_mul(alpha, t1, t2);
+   p256_felem_add(t1, alpha, alpha);
+   p256_felem_add(alpha, t1, alpha);
+
+   /* z' = (y + z)^2 - gamma - delta */
+   p256_felem_add(t1, p->y, p->z);
+   p256_felem_sqr(t1, t1);
+   p256_felem_sub(t1, t1, gamma);
+   p256_felem_sub(r->z, t1, delta);
+
+   /* x' = alpha^2 - 8 * beta */
+   p256_felem_add(fourbeta, beta, beta);
+   p256_felem_add(fourbeta, fourbeta, fourbeta);
+   p256_felem_add(t1, fourbeta, fourbeta);
+   p256_felem_sqr(t2, alpha);
+   p256_felem_sub(r->x, t2, t1);
+
+   /* y' = alpha * (4 * beta - x') - 8 * gamma^2 */
+   p256_felem_sub(t1, fourbeta, r->x);
+   p256_felem_mul(t1, alpha, t1);
+   p256_felem_sqr(t2, gamma);
+   p256_felem_add(t2, t2, t2);
+   p256_felem_add(t2, t2, t2);
+   p256_felem_add(t2, t2, t2);
+   p256_felem_sub(r->y, t1, t2);
+}
+
+/*
+ * R = P + Q, add-2007-bl formulas with branch-free handling of the
+ * special cases: either operand at infinity and P == Q, where the
+ * addition formulas degenerate and the doubling result is selected
+ * instead.
+ */
+static void p256_point_add(struct p256_jacobian *r,
+                           const struct p256_jacobian *p,
+                           const struct p256_jacobian *q)
+{
+   p256_felem z1z1, z2z2, u1, u2, s1, s2, h, rr, i, j, v, t1, t2;
+   struct p256_jacobian add, dbl;
+   uint32_t p_inf, q_inf, x_eq, y_eq, dbl_mask;
+
+   p_inf = p256_felem_is_zero_mask(p->z);
+   q_inf = p256_felem_is_zero_mask(q->z);
+
+   p256_felem_sqr(z1z1, p->z);
+   p256_felem_sqr(z2z2, q->z);
+   p256_felem_mul(u1, p->x, z2z2);
+   p256_felem_mul(u2, q->x, z1z1);
+   p256_felem_mul(t1, q->z, z2z2);
+   p256_felem_mul(s1, p->y, t1);
+   p256_felem_mul(t1, p->z, z1z1);
+   p256_felem_mul(s2, q->y, t1);
+
+   p256_felem_sub(h, u2, u1);
+   x_eq = p256_felem_is_zero_mask(h);
+   p256_felem_sub(t1, s2, s1);
+   y_eq = p256_felem_is_zero_mask(t1);
+   p256_felem_add(rr, t1, t1);
+
+   /* i = (2h)^2, j = h * i, v = u1 * i */
+   p256_felem_add(t1, h, h);
+   p256_felem_sqr(i, t1);
+   p256_felem_mul(j, h, i);
+   p256_felem_mul(v, u1, i);
+
+   /* x3 = rr^2 - j - 2v */
+   p256_felem_sqr(t1, rr);
+   p256_felem_sub(t1, t1, j);
+   p256_felem_sub(t1, t1, v);
+   p256_felem_sub(add.x, t1, v);
+
+   /* y3 = rr * (v - x3) - 2 * s1 * j */
+   p256_felem_sub(t1, v, add.x);
+   p256_felem_mul(t1, rr, t1);
+   p256_felem_mul(t2, s1, j);
+   p256_felem_add(t2, t2, t2);
+   p256_felem_sub(add.y, t1, t2);
+
+   /* z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h */
+   p256_felem_add(t1, p->z, q->z);
+   p256_felem_sqr(t1, t1);
+   p256_felem_sub(t1, t1, z1z1);
+   p256_felem_sub(t1, t1, z2z2);
+   p256_felem_mul(add.z, t1, h);
+
+   /* P == Q (and neither at infinity) must use the doubling formulas */
+   p256_point_double(&dbl, p);
+   dbl_mask = x_eq & y_eq & ~p_inf & ~q_inf;
+   p256_point_select(&add, &add, &dbl, dbl_mask);
+
+   /* Either operand at infinity yields the other one */
+   p256_point_select(&add, &add, q, p_inf);
+   p256_point_select(&add, &add, p, q_inf);
+   *r = add;
+}
+
+/* Constant-time table lookup, scans every entry whatever the index */
+static void p256_table_select(struct p256_jacobian *out,
+                              const struct p256_jacobian table[16],
+                              uint32_t idx)
+{
+   size_t i;
+
+   XMEMSET(out, 0, sizeof(*out));
+   for (i = 0; i < 16; i++)
+      p256_point_select(out, out, table + i,
+                        p256_is_zero_mask(i ^ idx));
+}
+
+/*
+ * R = scalar * G with @scalar as 32 big-endian bytes and @G an affine
+ * point in the Montgomery domain. Fixed 4-bit windows over a 16-entry
+ * table; the sequence of field operations and memory accesses does not
+ * depend on the scalar.
+ */
+static void p256_scalarmul(struct p256_jacobian *r,
+                           const unsigned char scalar[P256_NBYTES],
+                           const p256_felem gx, const p256_felem gy)
+{
+   struct p256_jacobian table[16], t;
+   size_t i;
+
+   XMEMSET(table, 0, sizeof(table));
+   XMEMCPY(table[1].x, gx, sizeof(p256_felem));
+   XMEMCPY(table[1].y, gy, sizeof(p256_felem));
+   XMEMCPY(table[1].z, p256_one_mont, sizeof(p256_felem));
+   for (i = 2; i < 16; i++)
+      p256_point_add(table + i, table + i - 1, table + 1);
+
+   XMEMSET(r, 0, sizeof(*r));
+   for (i = 0; i < 2 * P256_NBYTES; i++) {
+      uint32_t w = scalar[i / 2];
+
+      if (i)  {
+         p256_point_double(r, r);
+         p256_point_double(r, r);
+         p256_point_double(r, r);
+         p256_point_double(r, r);
+      }
+      w = (i & 1) ? (w & 0xf) : (w >> 4);
+      p256_table_select(&t, table, w);
+      p256_point_add(r, r, &t);
+   }
+}
+
+/* Load 32 big-endian bytes as limbs, return CRYPT_OK when below p */
+static int p256_felem_from_bytes(p256_felem out,
+                                 const unsigned char in[P256_NBYTES])
+{
+   uint32_t borrow = 0;
+   size_t i;
+
+   for (i = 0; i < P256_NLIMBS; i++)
+      out[i] = ((uint32_t)in[P256_NBYTES - 4 * i - 4] << 24) |
+               ((uint32_t)in[P256_NBYTES - 4 * i - 3] << 16) |
+               ((uint32_t)in[P256_NBYTES - 4 * i - 2] << 8) |
+               in[P256_NBYTES - 4 * i - 1];
+
+   for (i = 0; i < P256_NLIMBS; i++) {
+      uint64_t d = (uint64_t)out[i] - p256_p[i] - borrow;
+
+      borrow = (uint32_t)((d >> 63) & 1);
+   }
+   if (!borrow)
+      return CRYPT_INVALID_ARG;
+
+   return CRYPT_OK;
+}
+
+static void p256_felem_to_bytes(unsigned char out[P256_NBYTES],
+                                const p256_felem in)
+{
+   size_t i;
+
+   for (i = 0; i < P256_NLIMBS; i++) {
+      out[P256_NBYTES - 4 * i - 4] = in[i] >> 24;
+      out[P256_NBYTES - 4 * i - 3] = in[i] >> 16;
+      out[P256_NBYTES - 4 * i - 2] = in[i] >> 8;
+      out[P256_NBYTES - 4 * i - 1] = in[i];
+   }
+}
+
+/*
+ * Affine point multiplication on byte strings: out = scalar * (x, y).
+ * Returns CRYPT_INVALID_ARG for out of range coordinates or a point at
+ * infinity result, the caller falls back to the generic path.
+ */
+static int p256_pointmul_bytes(unsigned char outx[P256_NBYTES],
+                               unsigned char outy[P256_NBYTES],
+                               const unsigned char scalar[P256_NBYTES],
+                               const unsigned char inx[P256_NBYTES],
+                               const unsigned char iny[P256_NBYTES])
+{
+   struct p256_jacobian r;
+   p256_felem gx, gy, zinv, zinv2, t;
+   int err;
+
+   if ((err = p256_felem_from_bytes(gx, inx)) != CRYPT_OK) return err;
+   if ((err = p256_felem_from_bytes(gy, iny)) != CRYPT_OK) return err;
+
+   p256_felem_mul(gx, gx, p256_rr);
+   p256_felem_mul(gy, gy, p256_rr);
+
+   p256_scalarmul(&r, scalar, gx, gy);
+
+   if (p256_felem_is_zero_mask(r.z))
+      return CRYPT_INVALID_ARG;
+
+   /* Back to affine and out of the Montgomery domain */
+   p256_felem_inv(zinv, r.z);
+   p256_felem_sqr(zinv2, zinv);
+   p256_felem_mul(t, r.x, zinv2);
+   p256_felem_mul(t, t, p256_one);
+   p256_felem_to_bytes(outx, t);
+   p256_felem_mul(zinv2, zinv2, zinv);
+   p256_felem_mul(t, r.y, zinv2);
+   p256_felem_mul(t, t, p256_one);
+   p256_felem_to_bytes(outy, t);
+
+   return CRYPT_OK;
+}
+
+/**
+   Perform a point multiplication with the specialized P-256 code
+   @param k    The scalar to multiply by
+   @param G    The base point, must be affine
+   @param R    [out] Destination for kG
+   @param a    ECC curve parameter a, must be -3 mod p
+   @param modulus  The modulus of the field, must be the P-256 prime
+   @param map      Boolean whether to map back to affine or not
+   @return CRYPT_OK on success, CRYPT_INVALID_ARG when the arguments
+           don't fit this implementation and the caller should use the
+           generic path instead
+*/
+int ltc_ecc_mulmod_p256(void *k, const ecc_point *G, ecc_point *R, void *a,
+                        void *modulus, int map)
+{
+   unsigned char kb[P256_NBYTES] = { 0 };
+   unsigned char xb[P256_NBYTES] = { 0 };
+   unsigned char yb[P256_NBYTES] = { 0 };
+   unsigned char mb[P256_NBYTES] = { 0 };
+   void *a_plus3 = NULL;
+   unsigned long sz;
+   int err;
+
+   LTC_ARGCHK(k       != NULL);
+   LTC_ARGCHK(G       != NULL);
+   LTC_ARGCHK(R       != NULL);
+   LTC_ARGCHK(modulus != NULL);
+
+   /* Only the full computation back to affine coordinates is handled */
+   if (!map || a == NULL)
+      return CRYPT_INVALID_ARG;
+
+   if (mp_unsigned_bin_size(modulus) != P256_NBYTES)
+      return CRYPT_INVALID_ARG;
+   if ((err = mp_to_unsigned_bin(modulus, mb)) != CRYPT_OK)
+      return err;
+   if (XMEMCMP(mb, p256_p_bytes, P256_NBYTES) != 0)
+      return CRYPT_INVALID_ARG;
+
+   /* The doubling formulas rely on a == -3 */
+   if ((err = mp_init(&a_plus3)) != CRYPT_OK)
+      return err;
+   if ((err = mp_add_d(a, 3, a_plus3)) != CRYPT_OK)
+      goto out;
+   if (mp_cmp(a_plus3, modulus) != LTC_MP_EQ) {
+      err = CRYPT_INVALID_ARG;
+      goto out;
+   }
+
+   /* The base point must be affine */
+   if (mp_cmp_d(G->z, 1) != LTC_MP_EQ) {
+      err = CRYPT_INVALID_ARG;
+      goto out;
+   }
+
+   sz = mp_unsigned_bin_size(k);
+   if (sz > P256_NBYTES) {
+      err = CRYPT_INVALID_ARG;
+      goto out;
+   }
+   if ((err = mp_to_unsigned_bin(k, kb + P256_NBYTES - sz)) != CRYPT_OK)
+      goto out;
+
+   sz = mp_unsigned_bin_size(G->x);
+   if (sz > P256_NBYTES) {
+      err = CRYPT_INVALID_ARG;
+      goto out;
+   }
+   if ((err = mp_to_unsigned_bin(G->x, xb + P256_NBYTES - sz)) != CRYPT_OK)
+      goto out;
+
+   sz = mp_unsigned_bin_size(G->y);
+   if (sz > P256_NBYTES) {
+      err = CRYPT_INVALID_ARG;
+      goto out;
+   }
+   if ((err = mp_to_unsigned_bin(G->y, yb + P256_NBYTES - sz)) != CRYPT_OK)
+      goto out;
+
+   if ((err = p256_pointmul_bytes(xb, yb, kb, xb, yb)) != CRYPT_OK)
+      goto out;
+
+   if ((err = mp_read_unsigned_bin(R->x, xb, P256_NBYTES)) != CRYPT_OK)
+      goto out;
+   if ((err = mp_read_unsigned_bin(R->y, yb, P256_NBYTES)) != CRYPT_OK)
+      goto out;
+   if ((err = mp_set(R->z, 1)) != CRYPT_OK)
+      goto out;
+
+   err = CRYPT_OK;
+out:
+   mp_clear(a_plus3);
+   zeromem(kb, sizeof(kb));
+   return err;
+}
+
+#endif
@@ -48,6 +48,11 @@ int ltc_ecc_mulmod(void *k, const ecc_point *G, ecc_point *R, void *a, void *mod
       return ltc_ecc_set_point_xyz(1, 1, 0, R);
    }
 
+#ifdef LTC_ECC_MULMOD_P256
+   /* use the specialized implementation when the curve matches */
+   if (ltc_ecc_mulmod_p256(k, G, R, a, modulus, map) == CRYPT_OK) return CRYPT_OK;
+#endif
+
    /* init montgomery reduction */
    if ((err = mp_montgomery_setup(modulus, &mp)) != CRYPT_OK)        { goto error; }
    if ((err = mp_init(&mu)) != CRYPT_OK)                             { goto error; }
@@ -13,6 +13,7 @@ srcs-y += ltc_ecc_is_point.c
 srcs-y += ltc_ecc_is_point_at_infinity.c
 srcs-y += ltc_ecc_map.c
 srcs-y += ltc_ecc_mulmod.c
+srcs-y += ltc_ecc_mulmod_p256.c
 srcs-y += ltc_ecc_mulmod_timing.c
 srcs-y += ltc_ecc_mul2add.c
 srcs-y += ltc_ecc_points.c
@@ -94,6 +94,19 @@ ifeq ($(_CFG_CORE_LTC_ECC),y)
 
    # ECC 521 bits is the max supported key size
    cppflags-lib-y += -DLTC_MAX_ECC=521
+
+   ifeq ($(_CFG_CORE_LTC_ECC_FP_MULMOD),y)
+      # Accelerate repeated point multiplications on the same base point
+      # (e.g. ECDSA signing) with cached fixed point lookup tables
+      cppflags-lib-y += -DLTC_MECC_FP
+      cppflags-lib-y += -DFP_ENTRIES=$(_CFG_CORE_LTC_ECC_FP_ENTRIES)
+      cppflags-lib-y += -DFP_LUT=$(_CFG_CORE_LTC_ECC_FP_LUT)
+   endif
+
+   ifeq ($(_CFG_CORE_LTC_ECC_P256_MULMOD),y)
+      # Constant-time fixed width point multiplication for NIST P-256
+      cppflags-lib-y += -DLTC_ECC_MULMOD_P256
+   endif
 endif
 ifneq (,$(filter y,$(_CFG_CORE_LTC_SM2_DSA) $(_CFG_CORE_LTC_SM2_PKE)))
    cppflags-lib-y += -DLTC_ECC_SM2
@@ -13,6 +13,7 @@
 #include <mm/fobj.h>
 #include <mm/tee_mm.h>
 #include <stdlib.h>
+#include <string_ext.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <types_ext.h>
@@ -28,6 +29,10 @@ struct rwp_aes_gcm_iv {
 
 #define RWP_AES_GCM_TAG_LEN	16
 
+/*
+ * With CFG_PAGER_XTS @iv is only a page-in-use marker and @tag holds a
+ * truncated SHA-256 of the plaintext page instead of the AES-GCM tag.
+ */
 struct rwp_state {
 	uint64_t iv;
 	uint8_t tag[RWP_AES_GCM_TAG_LEN];
@@ -41,7 +46,18 @@ struct fobj_rwp {
 
 static const struct fobj_ops ops_rw_paged;
 
+#ifdef CFG_PAGER_XTS
+/*
+ * Expanded AES-XTS keys, struct internal_aes_gcm_key is reused as a
+ * plain container of an expanded AES key and a round count. The data
+ * key is expanded for both directions, the tweak key only encrypts.
+ */
+static struct internal_aes_gcm_key rwp_xts_enc_key;
+static struct internal_aes_gcm_key rwp_xts_dec_key;
+static struct internal_aes_gcm_key rwp_xts_tweak_key;
+#else
 static struct internal_aes_gcm_key rwp_ae_key;
+#endif
 
 /*
  * fobj_generate_authenc_key() - Generate authentication key
@@ -53,12 +69,31 @@ static TEE_Result fobj_generate_authenc_key(void)
 {
 	uint8_t key[RWP_AE_KEY_BITS / 8] = { 0 };
 
+#ifdef CFG_PAGER_XTS
+	uint8_t tweak_key[RWP_AE_KEY_BITS / 8] = { 0 };
+
+	if (crypto_rng_read(key, sizeof(key)) != TEE_SUCCESS ||
+	    crypto_rng_read(tweak_key, sizeof(tweak_key)) != TEE_SUCCESS)
+		panic("failed to generate random");
+	if (crypto_aes_expand_enc_key(key, sizeof(key), rwp_xts_enc_key.data,
+				      sizeof(rwp_xts_enc_key.data),
+				      &rwp_xts_enc_key.rounds) ||
+	    crypto_aes_expand_dec_key(key, sizeof(key), rwp_xts_dec_key.data,
+				      sizeof(rwp_xts_dec_key.data),
+				      &rwp_xts_dec_key.rounds) ||
+	    crypto_aes_expand_enc_key(tweak_key, sizeof(tweak_key),
+				      rwp_xts_tweak_key.data,
+				      sizeof(rwp_xts_tweak_key.data),
+				      &rwp_xts_tweak_key.rounds))
+		panic("failed to expand key");
+#else
 	if (crypto_rng_read(key, sizeof(key)) != TEE_SUCCESS)
 		panic("failed to generate random");
 	if (crypto_aes_expand_enc_key(key, sizeof(key), rwp_ae_key.data,
 				      sizeof(rwp_ae_key.data),
 				      &rwp_ae_key.rounds))
 		panic("failed to expand key");
+#endif
 
 	return TEE_SUCCESS;
 }
@@ -98,10 +133,11 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 
 	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
 		goto err;
-	mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	mm = tee_mm_sec_alloc(size);
 	if (!mm)
 		goto err;
-	rwp->store = phys_to_virt(tee_mm_get_smem(mm), MEM_AREA_TA_RAM);
+	rwp->store = phys_to_virt(tee_mm_get_smem(mm),
+				  core_mmu_get_type_by_pa(tee_mm_get_smem(mm)));
 	assert(rwp->store); /* to assist debugging if it would ever happen */
 	if (!rwp->store)
 		goto err;
@@ -130,20 +166,76 @@ static void rwp_free(struct fobj *fobj)
 	struct fobj_rwp *rwp = to_rwp(fobj);
 
 	fobj_uninit(fobj);
-	tee_mm_free(tee_mm_find(&tee_mm_sec_ddr, virt_to_phys(rwp->store)));
+	tee_mm_free(tee_mm_sec_find(virt_to_phys(rwp->store)));
 	free(rwp->state);
 	free(rwp);
 }
 
+#ifdef CFG_PAGER_XTS
+/* Multiply by x in GF(2^128), little-endian byte order as in IEEE 1619 */
+static void rwp_xts_mult_x(uint64_t w[2])
+{
+	uint8_t *t = (uint8_t *)w;
+	uint8_t carry = 0;
+	size_t n = 0;
+
+	for (n = 0; n < TEE_AES_BLOCK_SIZE; n++) {
+		uint8_t c = t[n] >> 7;
+
+		t[n] = (t[n] << 1) | carry;
+		carry = c;
+	}
+	if (carry)
+		t[0] ^= 0x87;
+}
+
+static void rwp_xts_crypt(const struct internal_aes_gcm_key *key, bool decrypt,
+			  struct rwp_state *state, const void *src, void *dst)
+{
+	uint64_t tweak[2] = { (vaddr_t)state, 0 };
+	const uint64_t *s = src;
+	uint64_t *d = dst;
+	size_t n = 0;
+
+	/*
+	 * The tweak only has to be unique per page slot in the store, the
+	 * address of the per page state serves as the data unit number.
+	 */
+	crypto_aes_enc_block(rwp_xts_tweak_key.data,
+			     sizeof(rwp_xts_tweak_key.data),
+			     rwp_xts_tweak_key.rounds, tweak, tweak);
+
+	for (n = 0; n < SMALL_PAGE_SIZE / TEE_AES_BLOCK_SIZE; n++) {
+		uint64_t blk[2] = { s[0] ^ tweak[0], s[1] ^ tweak[1] };
+
+		if (decrypt)
+			crypto_aes_dec_block(key->data, sizeof(key->data),
+					     key->rounds, blk, blk);
+		else
+			crypto_aes_enc_block(key->data, sizeof(key->data),
+					     key->rounds, blk, blk);
+		d[0] = blk[0] ^ tweak[0];
+		d[1] = blk[1] ^ tweak[1];
+		s += 2;
+		d += 2;
+		rwp_xts_mult_x(tweak);
+	}
+}
+#endif /*CFG_PAGER_XTS*/
+
 static TEE_Result rwp_load_page(struct fobj *fobj, unsigned int page_idx,
 				void *va)
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
 	struct rwp_state *state = rwp->state + page_idx;
 	uint8_t *src = rwp->store + page_idx * SMALL_PAGE_SIZE;
+#ifdef CFG_PAGER_XTS
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { 0 };
+#else
 	struct rwp_aes_gcm_iv iv = {
 		.iv = { (vaddr_t)state, state->iv >> 32, state->iv }
 	};
+#endif
 
 	assert(refcount_val(&fobj->refc));
 	assert(page_idx < fobj->num_pages);
@@ -157,22 +249,48 @@ static TEE_Result rwp_load_page(struct fobj *fobj, unsigned int page_idx,
 		return TEE_SUCCESS;
 	}
 
+#ifdef CFG_PAGER_XTS
+	rwp_xts_crypt(&rwp_xts_dec_key, true /*decrypt*/, state, src, va);
+	if (hash_sha256_compute(digest, va, SMALL_PAGE_SIZE))
+		return TEE_ERROR_SECURITY;
+	if (consttime_memcmp(digest, state->tag, sizeof(state->tag)))
+		return TEE_ERROR_SECURITY;
+
+	return TEE_SUCCESS;
+#else
 	return internal_aes_gcm_dec(&rwp_ae_key, &iv, sizeof(iv),
 				    NULL, 0, src, SMALL_PAGE_SIZE, va,
 				    state->tag, sizeof(state->tag));
+#endif
 }
 DECLARE_KEEP_PAGER(rwp_load_page);
 
+static bool rwp_page_is_zero(const void *va)
+{
+	const uint64_t *p = va;
+	size_t n = 0;
+
+	for (n = 0; n < SMALL_PAGE_SIZE / sizeof(*p); n++)
+		if (p[n])
+			return false;
+
+	return true;
+}
+
 static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 				const void *va)
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
 	struct rwp_state *state = rwp->state + page_idx;
-	size_t tag_len = sizeof(state->tag);
 	uint8_t *dst = rwp->store + page_idx * SMALL_PAGE_SIZE;
+#ifdef CFG_PAGER_XTS
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { 0 };
+#else
+	size_t tag_len = sizeof(state->tag);
 	struct rwp_aes_gcm_iv iv;
 
 	memset(&iv, 0, sizeof(iv));
+#endif
 
 	if (!refcount_val(&fobj->refc)) {
 		/*
@@ -186,6 +304,30 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 	assert(page_idx < fobj->num_pages);
 	assert(state->iv + 1 > state->iv);
 
+	/*
+	 * An all-zero page is represented by iv == 0, the same encoding
+	 * as a never used page, so it needs neither encryption nor a
+	 * write-back to the store and is recreated with memset() in
+	 * rwp_load_page(). Typical candidates are freshly grown heap and
+	 * stack pages. Note that skipping the store write reveals to an
+	 * observer of the backing store that the page is zero filled,
+	 * just as for pages that never have been written.
+	 */
+	if (rwp_page_is_zero(va)) {
+		state->iv = 0;
+		return TEE_SUCCESS;
+	}
+
+#ifdef CFG_PAGER_XTS
+	/* Any non-zero value marks the page as present in the store */
+	state->iv = 1;
+	if (hash_sha256_compute(digest, va, SMALL_PAGE_SIZE))
+		return TEE_ERROR_SECURITY;
+	memcpy(state->tag, digest, sizeof(state->tag));
+	rwp_xts_crypt(&rwp_xts_enc_key, false /*encrypt*/, state, va, dst);
+
+	return TEE_SUCCESS;
+#else
 	state->iv++;
 	/*
 	 * IV is constructed as recommended in section "8.2.1 Deterministic
@@ -201,6 +343,7 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 	return internal_aes_gcm_enc(&rwp_ae_key, &iv, sizeof(iv),
 				    NULL, 0, va, SMALL_PAGE_SIZE, dst,
 				    state->tag, &tag_len);
+#endif
 }
 DECLARE_KEEP_PAGER(rwp_save_page);
 
@@ -533,7 +676,7 @@ struct fobj_sec_mem {
 
 static const struct fobj_ops ops_sec_mem;
 
-struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
+static struct fobj *sec_mem_alloc(unsigned int num_pages, bool zeroed)
 {
 	struct fobj_sec_mem *f = calloc(1, sizeof(*f));
 	size_t size = 0;
@@ -553,7 +696,8 @@ struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
 	if (!va)
 		goto err;
 
-	memset(va, 0, size);
+	if (zeroed)
+		memset(va, 0, size);
 	f->fobj.ops = &ops_sec_mem;
 	f->fobj.num_pages = num_pages;
 	refcount_set(&f->fobj.refc, 1);
@@ -566,6 +710,16 @@ err:
 	return NULL;
 }
 
+struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
+{
+	return sec_mem_alloc(num_pages, true /*zeroed*/);
+}
+
+struct fobj *fobj_sec_mem_alloc_uninit(unsigned int num_pages)
+{
+	return sec_mem_alloc(num_pages, false /*!zeroed*/);
+}
+
 static struct fobj_sec_mem *to_sec_mem(struct fobj *fobj)
 {
 	assert(fobj->ops == &ops_sec_mem);
@@ -6,7 +6,9 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <initcall.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_common.h>
@@ -24,6 +26,7 @@
 #include <mm/vm.h>
 #include <sm/optee_smc.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
 #include <trace.h>
@@ -45,6 +48,59 @@
 #define TEE_MMU_UCACHE_DEFAULT_ATTR	(TEE_MATTR_CACHE_CACHED << \
 					 TEE_MATTR_CACHE_SHIFT)
 
+/*
+ * Regions are small fixed-size objects allocated and freed in bursts
+ * during session setup and teardown. A per-core cache of freed regions
+ * serves most allocations without taking the heap lock. The cache is
+ * only touched with exceptions masked so a core cannot race with
+ * itself and no further locking is needed.
+ */
+#define VM_REGION_CACHE_SIZE	U(8)
+
+static struct vm_region *vm_region_cache[CFG_TEE_CORE_NB_CORE]
+					[VM_REGION_CACHE_SIZE];
+static size_t vm_region_cache_count[CFG_TEE_CORE_NB_CORE];
+
+static struct vm_region *alloc_region(void)
+{
+	struct vm_region *reg = NULL;
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	size_t pos = get_core_pos();
+
+	if (vm_region_cache_count[pos]) {
+		vm_region_cache_count[pos]--;
+		reg = vm_region_cache[pos][vm_region_cache_count[pos]];
+	}
+	thread_unmask_exceptions(exceptions);
+
+	if (reg)
+		memset(reg, 0, sizeof(*reg));
+	else
+		reg = calloc(1, sizeof(*reg));
+
+	return reg;
+}
+
+static void free_region(struct vm_region *reg)
+{
+	uint32_t exceptions = 0;
+	size_t pos = 0;
+
+	if (!reg)
+		return;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	pos = get_core_pos();
+	if (vm_region_cache_count[pos] < VM_REGION_CACHE_SIZE) {
+		vm_region_cache[pos][vm_region_cache_count[pos]] = reg;
+		vm_region_cache_count[pos]++;
+		reg = NULL;
+	}
+	thread_unmask_exceptions(exceptions);
+
+	free(reg);
+}
+
 static vaddr_t select_va_in_range(const struct vm_region *prev_reg,
 				  const struct vm_region *next_reg,
 				  const struct vm_region *reg,
@@ -229,6 +285,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 		if (va) {
 			reg->va = va;
 			TAILQ_INSERT_BEFORE(r, reg, link);
+			update_region_index(vmi);
 			return TEE_SUCCESS;
 		}
 		prev_r = r;
@@ -242,6 +299,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	if (va) {
 		reg->va = va;
 		TAILQ_INSERT_TAIL(&vmi->regions, reg, link);
+		update_region_index(vmi);
 		return TEE_SUCCESS;
 	}
 
@@ -260,7 +318,7 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 	if (prot & ~TEE_MATTR_PROT_MASK)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	reg = calloc(1, sizeof(*reg));
+	reg = alloc_region();
 	if (!reg)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -318,23 +376,87 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 
 err_rem_reg:
 	TAILQ_REMOVE(&uctx->vm_info.regions, reg, link);
+	update_region_index(&uctx->vm_info);
 err_free_reg:
 	mobj_put(reg->mobj);
-	free(reg);
+	free_region(reg);
 	return res;
 }
 
-static struct vm_region *find_vm_region(struct vm_info *vm_info, vaddr_t va)
+/*
+ * The regions list is kept sorted by virtual address. An array index
+ * over the list is rebuilt on each map change so the pointer validation
+ * done for every syscall argument can binary search instead of walking
+ * the list. If the index cannot be allocated lookups fall back to the
+ * list walk.
+ */
+static void update_region_index(struct vm_info *vmi)
 {
+	struct vm_region **idx = NULL;
 	struct vm_region *r = NULL;
+	size_t count = 0;
 
-	TAILQ_FOREACH(r, &vm_info->regions, link)
-		if (va >= r->va && va < r->va + r->size)
+	TAILQ_FOREACH(r, &vmi->regions, link)
+		count++;
+
+	if (!count) {
+		free(vmi->idx);
+		vmi->idx = NULL;
+		vmi->idx_count = 0;
+		return;
+	}
+
+	idx = realloc(vmi->idx, count * sizeof(*idx));
+	if (!idx) {
+		free(vmi->idx);
+		vmi->idx = NULL;
+		vmi->idx_count = 0;
+		return;
+	}
+
+	count = 0;
+	TAILQ_FOREACH(r, &vmi->regions, link) {
+		idx[count] = r;
+		count++;
+	}
+
+	vmi->idx = idx;
+	vmi->idx_count = count;
+}
+
+static struct vm_region *lookup_region(const struct vm_info *vmi, vaddr_t va)
+{
+	struct vm_region *r = NULL;
+	size_t lo = 0;
+	size_t hi = vmi->idx_count;
+
+	if (!vmi->idx) {
+		TAILQ_FOREACH(r, &vmi->regions, link)
+			if (va >= r->va && va < r->va + r->size)
+				return r;
+		return NULL;
+	}
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		r = vmi->idx[mid];
+		if (va < r->va)
+			hi = mid;
+		else if (va >= r->va + r->size)
+			lo = mid + 1;
+		else
 			return r;
+	}
 
 	return NULL;
 }
 
+static struct vm_region *find_vm_region(struct vm_info *vm_info, vaddr_t va)
+{
+	return lookup_region(vm_info, va);
+}
+
 static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
 				   size_t len,
 				   bool (*cmp_regs)(const struct vm_region *r0,
@@ -371,7 +493,7 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 
 	assert(diff && diff < r->size);
 
-	r2 = calloc(1, sizeof(*r2));
+	r2 = alloc_region();
 	if (!r2)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -379,7 +501,7 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 		TEE_Result res = tee_pager_split_um_region(uctx, va);
 
 		if (res) {
-			free(r2);
+			free_region(r2);
 			return res;
 		}
 	}
@@ -394,6 +516,7 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 	r->size = diff;
 
 	TAILQ_INSERT_AFTER(&uctx->vm_info.regions, r, r2, link);
+	update_region_index(&uctx->vm_info);
 
 	return TEE_SUCCESS;
 }
@@ -487,9 +610,10 @@ static void merge_vm_range(struct user_mode_ctx *uctx, vaddr_t va, size_t len)
 		TAILQ_REMOVE(&uctx->vm_info.regions, r_next, link);
 		r->size += r_next->size;
 		mobj_put(r_next->mobj);
-		free(r_next);
+		free_region(r_next);
 		r_next = r;
 	}
+	update_region_index(&uctx->vm_info);
 }
 
 static bool cmp_region_for_remap(const struct vm_region *r0,
@@ -545,6 +669,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 		TAILQ_REMOVE(&uctx->vm_info.regions, r, link);
 		TAILQ_INSERT_TAIL(&regs, r, link);
 	}
+	update_region_index(&uctx->vm_info);
 
 	/*
 	 * Synchronize change to translation tables. Even though the pager
@@ -596,6 +721,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 					TAILQ_INSERT_HEAD(&regs, r, link);
 				r_tmp = r;
 			}
+			update_region_index(&uctx->vm_info);
 
 			goto err_restore_map;
 		}
@@ -743,8 +869,9 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 static void umap_remove_region(struct vm_info *vmi, struct vm_region *reg)
 {
 	TAILQ_REMOVE(&vmi->regions, reg, link);
+	update_region_index(vmi);
 	mobj_put(reg->mobj);
-	free(reg);
+	free_region(reg);
 }
 
 TEE_Result vm_unmap(struct user_mode_ctx *uctx, vaddr_t va, size_t len)
@@ -836,6 +963,92 @@ TEE_Result vm_info_init(struct user_mode_ctx *uctx)
 	return res;
 }
 
+#ifdef CFG_TA_SHM_MAP_CACHE
+/*
+ * Parameter mappings backed by registered shared memory are kept in the
+ * vm_info between invocations so that a client passing the same shared
+ * memory over and over doesn't pay for a map/unmap cycle each time. A
+ * parked region only reserves the virtual address range: the mobj
+ * reference is dropped since holding it would prevent
+ * mobj_reg_shm_release_by_cookie() from ever completing. The region
+ * instead records the cookie and the release counter sampled while the
+ * reference still was held. Reuse is only allowed while no registration
+ * has been released since, so the pages backing the range cannot have
+ * changed. With a NULL mobj the region gets no page table entries
+ * either, a parked range is unmapped until it's reused.
+ */
+static bool park_param_region(struct vm_region *r)
+{
+	uint64_t cookie = mobj_get_cookie(r->mobj);
+
+	if (!cookie || mobj_is_paged(r->mobj))
+		return false;
+
+	r->shm_cookie = cookie;
+	r->shm_releases = mobj_reg_shm_release_count();
+	r->flags = (r->flags & ~VM_FLAG_EPHEMERAL) | VM_FLAG_SHM_CACHED;
+	mobj_put(r->mobj);
+	r->mobj = NULL;
+	return true;
+}
+
+static void evict_parked_regions(struct user_mode_ctx *uctx, bool only_stale)
+{
+	uint32_t releases = mobj_reg_shm_release_count();
+	struct vm_region *next_r = NULL;
+	struct vm_region *r = NULL;
+
+	TAILQ_FOREACH_SAFE(r, &uctx->vm_info.regions, link, next_r) {
+		if (!(r->flags & VM_FLAG_SHM_CACHED))
+			continue;
+		if (only_stale && r->shm_releases == releases)
+			continue;
+		maybe_free_pgt(uctx, r);
+		umap_remove_region(&uctx->vm_info, r);
+	}
+}
+
+static bool reuse_parked_region(struct user_mode_ctx *uctx,
+				struct param_mem *mem)
+{
+	uint64_t cookie = mobj_get_cookie(mem->mobj);
+	struct vm_region *r = NULL;
+
+	if (!cookie)
+		return false;
+
+	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
+		if (!(r->flags & VM_FLAG_SHM_CACHED))
+			continue;
+		if (r->shm_cookie != cookie || r->offset != mem->offs ||
+		    r->size != ROUNDUP(mem->size, SMALL_PAGE_SIZE))
+			continue;
+		/* Stale entries were evicted before getting here */
+		r->mobj = mobj_get(mem->mobj);
+		r->flags = VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE;
+		return true;
+	}
+
+	return false;
+}
+#else
+static bool park_param_region(struct vm_region *r __unused)
+{
+	return false;
+}
+
+static void evict_parked_regions(struct user_mode_ctx *uctx __unused,
+				 bool only_stale __unused)
+{
+}
+
+static bool reuse_parked_region(struct user_mode_ctx *uctx __unused,
+				struct param_mem *mem __unused)
+{
+	return false;
+}
+#endif
+
 void vm_clean_param(struct user_mode_ctx *uctx)
 {
 	struct vm_region *next_r;
@@ -843,6 +1056,8 @@ void vm_clean_param(struct user_mode_ctx *uctx)
 
 	TAILQ_FOREACH_SAFE(r, &uctx->vm_info.regions, link, next_r) {
 		if (r->flags & VM_FLAG_EPHEMERAL) {
+			if (park_param_region(r))
+				continue;
 			if (mobj_is_paged(r->mobj))
 				tee_pager_rem_um_region(uctx, r->va, r->size);
 			maybe_free_pgt(uctx, r);
@@ -979,15 +1194,35 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 	if (mem[0].mobj)
 		m++;
 
+	/*
+	 * Parked mappings whose registration may have been released since
+	 * they were parked must go before the TA is entered again.
+	 */
+	evict_parked_regions(uctx, true /* only_stale */);
+
 	check_param_map_empty(uctx);
 
 	for (n = 0; n < m; n++) {
 		vaddr_t va = 0;
 
+		if (reuse_parked_region(uctx, mem + n))
+			continue;
+
 		res = vm_map(uctx, &va, mem[n].size,
 			     TEE_MATTR_PRW | TEE_MATTR_URW,
 			     VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE,
 			     mem[n].mobj, mem[n].offs);
+		if (res && IS_ENABLED(CFG_TA_SHM_MAP_CACHE)) {
+			/*
+			 * Parked mappings may eat the address space,
+			 * retry once without them.
+			 */
+			evict_parked_regions(uctx, false /* only_stale */);
+			res = vm_map(uctx, &va, mem[n].size,
+				     TEE_MATTR_PRW | TEE_MATTR_URW,
+				     VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE,
+				     mem[n].mobj, mem[n].offs);
+		}
 		if (res)
 			goto out;
 	}
@@ -1020,7 +1255,7 @@ TEE_Result vm_add_rwmem(struct user_mode_ctx *uctx, struct mobj *mobj,
 			vaddr_t *va)
 {
 	TEE_Result res;
-	struct vm_region *reg = calloc(1, sizeof(*reg));
+	struct vm_region *reg = alloc_region();
 
 	if (!reg)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -1036,7 +1271,7 @@ TEE_Result vm_add_rwmem(struct user_mode_ctx *uctx, struct mobj *mobj,
 
 	res = umap_add_region(&uctx->vm_info, reg, 0, 0, 0);
 	if (res) {
-		free(reg);
+		free_region(reg);
 		return res;
 	}
 
@@ -1083,16 +1318,12 @@ void vm_info_final(struct user_mode_ctx *uctx)
 bool vm_buf_is_inside_um_private(const struct user_mode_ctx *uctx,
 				 const void *va, size_t size)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = lookup_region(&uctx->vm_info, (vaddr_t)va);
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (r->flags & VM_FLAGS_NONPRIV)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
-			return true;
-	}
+	if (!r || (r->flags & VM_FLAGS_NONPRIV))
+		return false;
 
-	return false;
+	return core_is_buffer_inside((vaddr_t)va, size, r->va, r->size);
 }
 
 /* return true only if buffer intersects TA private memory */
@@ -1115,20 +1346,16 @@ TEE_Result vm_buf_to_mboj_offs(const struct user_mode_ctx *uctx,
 			       const void *va, size_t size,
 			       struct mobj **mobj, size_t *offs)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = lookup_region(&uctx->vm_info, (vaddr_t)va);
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (!r->mobj)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size)) {
-			size_t poffs;
+	if (r && r->mobj &&
+	    core_is_buffer_inside((vaddr_t)va, size, r->va, r->size)) {
+		size_t poffs;
 
-			poffs = mobj_get_phys_offs(r->mobj,
-						   CORE_MMU_USER_PARAM_SIZE);
-			*mobj = r->mobj;
-			*offs = (vaddr_t)va - r->va + r->offset - poffs;
-			return TEE_SUCCESS;
-		}
+		poffs = mobj_get_phys_offs(r->mobj, CORE_MMU_USER_PARAM_SIZE);
+		*mobj = r->mobj;
+		*offs = (vaddr_t)va - r->va + r->offset - poffs;
+		return TEE_SUCCESS;
 	}
 
 	return TEE_ERROR_BAD_PARAMETERS;
@@ -1137,13 +1364,9 @@ TEE_Result vm_buf_to_mboj_offs(const struct user_mode_ctx *uctx,
 static TEE_Result tee_mmu_user_va2pa_attr(const struct user_mode_ctx *uctx,
 					  void *ua, paddr_t *pa, uint32_t *attr)
 {
-	struct vm_region *region = NULL;
-
-	TAILQ_FOREACH(region, &uctx->vm_info.regions, link) {
-		if (!core_is_buffer_inside((vaddr_t)ua, 1, region->va,
-					   region->size))
-			continue;
+	struct vm_region *region = lookup_region(&uctx->vm_info, (vaddr_t)ua);
 
+	if (region && region->mobj) {
 		if (pa) {
 			TEE_Result res;
 			paddr_t p;
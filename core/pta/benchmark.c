@@ -2,6 +2,7 @@
 /*
  * Copyright (c) 2017, Linaro Limited
  */
+#include <arm.h>
 #include <bench.h>
 #include <compiler.h>
 #include <kernel/misc.h>
@@ -159,6 +160,81 @@ static TEE_Result unregister_benchmark(uint32_t type,
 	return res;
 }
 
+static TEE_Result drain_timestamps(uint32_t type,
+				TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_ts_cpu_buf *cpu_buf;
+	struct tee_time_st *out;
+	size_t max_out;
+	size_t nout = 0;
+	uint64_t pending;
+	uint64_t best_cnt;
+	uint64_t cores;
+	uint64_t best;
+	uint64_t n;
+
+	if ((TEE_PARAM_TYPE_GET(type, 0) != TEE_PARAM_TYPE_VALUE_OUTPUT) ||
+		(TEE_PARAM_TYPE_GET(type, 1) != TEE_PARAM_TYPE_MEMREF_OUTPUT) ||
+		(TEE_PARAM_TYPE_GET(type, 2) != TEE_PARAM_TYPE_NONE) ||
+		(TEE_PARAM_TYPE_GET(type, 3) != TEE_PARAM_TYPE_NONE)) {
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	out = p[1].memref.buffer;
+	max_out = p[1].memref.size / sizeof(*out);
+
+	mutex_lock(&bench_reg_mu);
+
+	if (!bench_ts_global) {
+		mutex_unlock(&bench_reg_mu);
+		return TEE_ERROR_BAD_STATE;
+	}
+	cores = bench_ts_global->cores;
+
+	/*
+	 * Repeatedly pick the core whose oldest unconsumed timestamp is the
+	 * earliest so the merged output comes out ordered. Other cores may
+	 * still add timestamps while we drain, such entries are simply left
+	 * for the next drain.
+	 */
+	while (nout < max_out) {
+		best = cores;
+		best_cnt = UINT64_MAX;
+
+		for (n = 0; n < cores; n++) {
+			cpu_buf = &bench_ts_global->cpu_buf[n];
+			pending = cpu_buf->head - cpu_buf->tail;
+			if (!pending)
+				continue;
+			/* Ring has wrapped, the oldest entries are lost */
+			if (pending > TEE_BENCH_MAX_STAMPS)
+				cpu_buf->tail = cpu_buf->head -
+						TEE_BENCH_MAX_STAMPS;
+
+			pending = cpu_buf->stamps[cpu_buf->tail &
+						  TEE_BENCH_MAX_MASK].cnt;
+			if (pending < best_cnt) {
+				best_cnt = pending;
+				best = n;
+			}
+		}
+		if (best == cores)
+			break;
+
+		cpu_buf = &bench_ts_global->cpu_buf[best];
+		out[nout++] = cpu_buf->stamps[cpu_buf->tail &
+					      TEE_BENCH_MAX_MASK];
+		cpu_buf->tail++;
+	}
+
+	mutex_unlock(&bench_reg_mu);
+
+	p[0].value.a = nout;
+	p[1].memref.size = nout * sizeof(*out);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result invoke_command(void *session_ctx __unused,
 		uint32_t cmd_id, uint32_t param_types,
 		TEE_Param params[TEE_NUM_PARAMS])
@@ -170,6 +246,8 @@ static TEE_Result invoke_command(void *session_ctx __unused,
 		return get_benchmark_memref(param_types, params);
 	case BENCHMARK_CMD_UNREGISTER:
 		return unregister_benchmark(param_types, params);
+	case BENCHMARK_CMD_DRAIN:
+		return drain_timestamps(param_types, params);
 	default:
 		break;
 	}
@@ -181,6 +259,19 @@ pseudo_ta_register(.uuid = BENCHMARK_UUID, .name = TA_NAME,
 		   .flags = PTA_DEFAULT_FLAGS,
 		   .invoke_command_entry_point = invoke_command);
 
+static uint64_t bm_get_cycle_count(void)
+{
+	/*
+	 * The PMU cycle counter is only usable when it has been enabled,
+	 * typically by the normal world benchmark driver. Fall back to the
+	 * generic counter so timestamps remain monotonic either way.
+	 */
+	if (read_pmcr() & PMCR_EN)
+		return read_pmccntr() * TEE_BENCH_DIVIDER;
+
+	return read_cntpct();
+}
+
 void bm_timestamp(void)
 {
 	struct tee_ts_cpu_buf *cpu_buf;
@@ -205,7 +296,7 @@ void bm_timestamp(void)
 
 	cpu_buf = &bench_ts_global->cpu_buf[cur_cpu];
 	ts_i = cpu_buf->head++;
-	ts_data.cnt = read_pmccntr() * TEE_BENCH_DIVIDER;
+	ts_data.cnt = bm_get_cycle_count();
 	ts_data.addr = (uintptr_t)ret_addr;
 	ts_data.src = TEE_BENCH_CORE;
 	cpu_buf->stamps[ts_i & TEE_BENCH_MAX_MASK] = ts_data;
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2020, Linaro Limited
+ */
+#include <arm.h>
+#include <crypto/crypto.h>
+#include <kernel/pseudo_ta.h>
+#include <pta_crypto_bench.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee/tee_cryp_utl.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#define TA_NAME		"crypto_bench.ta"
+
+#define BENCH_MAX_KEY_SIZE	32
+#define BENCH_DEFAULT_KEY_SIZE	16
+
+static uint64_t bench_timestamp(void)
+{
+	/* Keep the counter read from drifting into the timed section */
+	isb();
+	return read_cntpct();
+}
+
+static TEE_Result bench_hash(uint32_t algo, size_t size, size_t count,
+			     uint64_t *ticks)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	void *ctx = NULL;
+	uint8_t digest[TEE_MAX_HASH_SIZE] = { };
+	size_t digest_len = 0;
+	uint8_t *buf = NULL;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	res = tee_alg_get_digest_size(algo, &digest_len);
+	if (res)
+		return res;
+
+	buf = malloc(size);
+	if (!buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(buf, 'b', size);
+
+	res = crypto_hash_alloc_ctx(&ctx, algo);
+	if (res)
+		goto out;
+
+	t0 = bench_timestamp();
+	for (n = 0; n < count; n++) {
+		res = crypto_hash_init(ctx);
+		if (!res)
+			res = crypto_hash_update(ctx, buf, size);
+		if (!res)
+			res = crypto_hash_final(ctx, digest, digest_len);
+		if (res)
+			break;
+	}
+	*ticks = bench_timestamp() - t0;
+
+	crypto_hash_free_ctx(ctx);
+out:
+	free(buf);
+
+	return res;
+}
+
+static TEE_Result bench_cipher(uint32_t algo, size_t size, size_t count,
+			       size_t key_len, uint64_t *ticks)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	void *ctx = NULL;
+	uint8_t key[BENCH_MAX_KEY_SIZE] = { };
+	uint8_t iv[TEE_AES_BLOCK_SIZE] = { };
+	const uint8_t *key2 = NULL;
+	size_t key2_len = 0;
+	size_t iv_len = sizeof(iv);
+	uint8_t *src = NULL;
+	uint8_t *dst = NULL;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	res = crypto_rng_read(key, key_len);
+	if (res)
+		return res;
+
+	switch (TEE_ALG_GET_CHAIN_MODE(algo)) {
+	case TEE_CHAIN_MODE_ECB_NOPAD:
+		iv_len = 0;
+		break;
+	case TEE_CHAIN_MODE_XTS:
+		/* XTS needs a second key of the same size */
+		key2 = key;
+		key2_len = key_len;
+		break;
+	default:
+		break;
+	}
+
+	src = malloc(size);
+	dst = malloc(size);
+	if (!src || !dst) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	memset(src, 'b', size);
+
+	res = crypto_cipher_alloc_ctx(&ctx, algo);
+	if (res)
+		goto out;
+
+	res = crypto_cipher_init(ctx, TEE_MODE_ENCRYPT, key, key_len,
+				 key2, key2_len, iv, iv_len);
+	if (res)
+		goto out_ctx;
+
+	t0 = bench_timestamp();
+	for (n = 0; n < count; n++) {
+		res = crypto_cipher_update(ctx, TEE_MODE_ENCRYPT, false,
+					   src, size, dst);
+		if (res)
+			break;
+	}
+	*ticks = bench_timestamp() - t0;
+
+	crypto_cipher_final(ctx);
+out_ctx:
+	crypto_cipher_free_ctx(ctx);
+out:
+	free(src);
+	free(dst);
+
+	return res;
+}
+
+static TEE_Result bench_authenc(uint32_t algo, size_t size, size_t count,
+				size_t key_len, uint64_t *ticks)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	void *ctx = NULL;
+	uint8_t key[BENCH_MAX_KEY_SIZE] = { };
+	uint8_t nonce[12] = { };
+	uint8_t tag[TEE_AES_BLOCK_SIZE] = { };
+	size_t tag_len = sizeof(tag);
+	size_t payload_len = 0;
+	size_t dlen = 0;
+	uint8_t *src = NULL;
+	uint8_t *dst = NULL;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	if (MUL_OVERFLOW(size, count, &payload_len))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = crypto_rng_read(key, key_len);
+	if (res)
+		return res;
+
+	src = malloc(size);
+	dst = malloc(size);
+	if (!src || !dst) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	memset(src, 'b', size);
+
+	res = crypto_authenc_alloc_ctx(&ctx, algo);
+	if (res)
+		goto out;
+
+	res = crypto_authenc_init(ctx, TEE_MODE_ENCRYPT, key, key_len,
+				  nonce, sizeof(nonce), sizeof(tag), 0,
+				  payload_len);
+	if (res)
+		goto out_ctx;
+
+	t0 = bench_timestamp();
+	for (n = 0; n < count; n++) {
+		dlen = size;
+		res = crypto_authenc_update_payload(ctx, TEE_MODE_ENCRYPT,
+						    src, size, dst, &dlen);
+		if (res)
+			break;
+	}
+	*ticks = bench_timestamp() - t0;
+
+	if (!res) {
+		dlen = 0;
+		res = crypto_authenc_enc_final(ctx, NULL, 0, NULL, &dlen,
+					       tag, &tag_len);
+	}
+
+	crypto_authenc_final(ctx);
+out_ctx:
+	crypto_authenc_free_ctx(ctx);
+out:
+	free(src);
+	free(dst);
+
+	return res;
+}
+
+static TEE_Result bench_rsa(size_t key_bits, size_t count, uint64_t *ticks,
+			    size_t *size)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct rsa_keypair key = { };
+	uint8_t *src = NULL;
+	uint8_t *dst = NULL;
+	size_t dlen = 0;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	*size = key_bits / 8;
+	if (!*size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	src = malloc(*size);
+	dst = malloc(*size);
+	if (!src || !dst) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	res = crypto_rng_read(src, *size);
+	if (res)
+		goto out;
+	/* Keep the "ciphertext" below the modulus */
+	src[0] = 0;
+
+	res = crypto_acipher_alloc_rsa_keypair(&key, key_bits);
+	if (res)
+		goto out;
+
+	res = crypto_acipher_gen_rsa_key(&key, key_bits);
+	if (res)
+		goto out_key;
+
+	t0 = bench_timestamp();
+	for (n = 0; n < count; n++) {
+		dlen = *size;
+		res = crypto_acipher_rsanopad_decrypt(&key, src, *size,
+						      dst, &dlen);
+		if (res)
+			break;
+	}
+	*ticks = bench_timestamp() - t0;
+
+out_key:
+	crypto_acipher_free_rsa_keypair(&key);
+out:
+	free(src);
+	free(dst);
+
+	return res;
+}
+
+static TEE_Result invoke_command(void *psess __unused, uint32_t cmd,
+				 uint32_t ptypes,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint32_t algo = 0;
+	size_t size = 0;
+	size_t count = 0;
+	size_t key_len = 0;
+	uint64_t ticks = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT) != ptypes)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	algo = params[0].value.a;
+	size = params[0].value.b;
+	count = params[1].value.a;
+	key_len = params[1].value.b;
+	if (!key_len)
+		key_len = BENCH_DEFAULT_KEY_SIZE;
+
+	if (!size || !count || key_len > BENCH_MAX_KEY_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (cmd) {
+	case PTA_CRYPTO_BENCH_CMD_HASH:
+		res = bench_hash(algo, size, count, &ticks);
+		break;
+	case PTA_CRYPTO_BENCH_CMD_CIPHER:
+		res = bench_cipher(algo, size, count, key_len, &ticks);
+		break;
+	case PTA_CRYPTO_BENCH_CMD_AUTHENC:
+		res = bench_authenc(algo, size, count, key_len, &ticks);
+		break;
+	case PTA_CRYPTO_BENCH_CMD_RSA:
+		res = bench_rsa(size, count, &ticks, &size);
+		break;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (res)
+		return res;
+
+	params[2].value.a = ticks;
+	params[2].value.b = ticks >> 32;
+	params[3].value.a = read_cntfrq();
+	params[3].value.b = size;
+
+	return TEE_SUCCESS;
+}
+
+pseudo_ta_register(.uuid = PTA_CRYPTO_BENCH_UUID, .name = TA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .invoke_command_entry_point = invoke_command);
@@ -11,15 +11,31 @@
 #include <config.h>
 #include <kernel/early_ta.h>
 #include <kernel/linker.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/tee_ta_manager.h>
 #include <pta_device.h>
+#include <stdlib.h>
 #include <string.h>
 #include <tee/uuid.h>
 #include <user_ta_header.h>
 
 #define PTA_NAME "device.pta"
 
+/*
+ * The enumerated sets, pseudo TAs and early TAs, are fixed at build time
+ * so the serialized result is computed once per flavor on first request
+ * and never invalidated. Repeat enumerations are served with a copy.
+ */
+struct dev_enum_cache {
+	uint8_t *buf;
+	uint32_t len;
+	bool valid;
+};
+
+static struct dev_enum_cache dev_cache[2];
+static struct mutex dev_cache_mutex = MUTEX_INITIALIZER;
+
 static void add_ta(uint32_t flags, const TEE_UUID *uuid, uint8_t *buf,
 		   uint32_t blen, uint32_t *pos, uint32_t rflags)
 {
@@ -37,12 +53,54 @@ static void add_ta(uint32_t flags, const TEE_UUID *uuid, uint8_t *buf,
 	}
 }
 
+static void enum_tas(uint8_t *buf, uint32_t blen, uint32_t *pos,
+		     uint32_t rflags)
+{
+	const struct pseudo_ta_head *ta = NULL;
+	const struct early_ta *eta = NULL;
+
+	SCATTERED_ARRAY_FOREACH(ta, pseudo_tas, struct pseudo_ta_head)
+		add_ta(ta->flags, &ta->uuid, buf, blen, pos, rflags);
+
+	if (IS_ENABLED(CFG_EARLY_TA))
+		for_each_early_ta(eta)
+			add_ta(eta->flags, &eta->uuid, buf, blen, pos,
+			       rflags);
+}
+
+static struct dev_enum_cache *get_cached_devices(uint32_t rflags)
+{
+	struct dev_enum_cache *cache = NULL;
+	uint32_t pos = 0;
+	uint8_t *buf = NULL;
+
+	cache = dev_cache + !!(rflags & TA_FLAG_DEVICE_ENUM_SUPP);
+	if (cache->valid)
+		return cache;
+
+	enum_tas(NULL, 0, &pos, rflags);
+
+	if (pos) {
+		buf = malloc(pos);
+		if (!buf)
+			return NULL;
+		pos = 0;
+		enum_tas(buf, UINT32_MAX, &pos, rflags);
+	}
+
+	cache->buf = buf;
+	cache->len = pos;
+	cache->valid = true;
+
+	return cache;
+}
+
 static TEE_Result get_devices(uint32_t types,
 			      TEE_Param params[TEE_NUM_PARAMS],
 			      uint32_t rflags)
 {
-	const struct pseudo_ta_head *ta = NULL;
-	const struct early_ta *eta = NULL;
+	struct dev_enum_cache *cache = NULL;
+	TEE_Result res = TEE_SUCCESS;
 	void *buf = NULL;
 	uint32_t blen = 0;
 	uint32_t pos = 0;
@@ -59,19 +117,24 @@ static TEE_Result get_devices(uint32_t types,
 	buf =  params[0].memref.buffer;
 	blen = params[0].memref.size;
 
-	SCATTERED_ARRAY_FOREACH(ta, pseudo_tas, struct pseudo_ta_head)
-		add_ta(ta->flags, &ta->uuid, buf, blen, &pos, rflags);
-
-	if (IS_ENABLED(CFG_EARLY_TA))
-		for_each_early_ta(eta)
-			add_ta(eta->flags, &eta->uuid, buf, blen, &pos,
-			       rflags);
-
-	params[0].memref.size = pos;
-	if (pos > blen)
-		return TEE_ERROR_SHORT_BUFFER;
+	mutex_lock(&dev_cache_mutex);
+	cache = get_cached_devices(rflags);
+	if (cache) {
+		if (cache->len <= blen)
+			memcpy(buf, cache->buf, cache->len);
+		else
+			res = TEE_ERROR_SHORT_BUFFER;
+		params[0].memref.size = cache->len;
+	} else {
+		/* Allocation failed, enumerate directly as before */
+		enum_tas(buf, blen, &pos, rflags);
+		params[0].memref.size = pos;
+		if (pos > blen)
+			res = TEE_ERROR_SHORT_BUFFER;
+	}
+	mutex_unlock(&dev_cache_mutex);
 
-	return TEE_SUCCESS;
+	return res;
 }
 
 static TEE_Result invoke_command(void *pSessionContext __unused,
@@ -10,6 +10,7 @@
 #include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <mm/mobj.h>
+#include <mm/vm.h>
 #include <optee_rpc_cmd.h>
 #include <pta_gprof.h>
 #include <string.h>
@@ -71,7 +72,9 @@ static TEE_Result gprof_start_pc_sampling(struct ts_session *s,
 					  TEE_PARAM_TYPE_VALUE_INPUT,
 					  TEE_PARAM_TYPE_NONE,
 					  TEE_PARAM_TYPE_NONE);
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
 	struct sample_buf *sbuf = NULL;
+	TEE_Result res = TEE_SUCCESS;
 	uint32_t offset = 0;
 	uint32_t scale = 0;
 	uint32_t len = 0;
@@ -90,12 +93,31 @@ static TEE_Result gprof_start_pc_sampling(struct ts_session *s,
 	offset = params[1].value.a;
 	scale = params[1].value.b;
 
+	/*
+	 * The user buffer is validated once here and the samples are
+	 * accumulated in a core private histogram. Writing user memory
+	 * directly would cost an access rights check for every sample in
+	 * the native interrupt path.
+	 */
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_WRITE |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     buf, len);
+	if (res != TEE_SUCCESS)
+		return TEE_ERROR_ACCESS_DENIED;
+
 	sbuf = calloc(1, sizeof(*sbuf));
 	if (!sbuf)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	sbuf->samples = (uint16_t *)buf;
 	sbuf->nsamples = len / sizeof(*sbuf->samples);
+	sbuf->samples = calloc(sbuf->nsamples, sizeof(*sbuf->samples));
+	if (!sbuf->samples) {
+		free(sbuf);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	sbuf->usamples = (uint16_t *)buf;
 	sbuf->offset = offset;
 	sbuf->scale = scale;
 	sbuf->freq = read_cntfrq();
@@ -113,7 +135,9 @@ static TEE_Result gprof_stop_pc_sampling(struct ts_session *s,
 					  TEE_PARAM_TYPE_NONE,
 					  TEE_PARAM_TYPE_NONE,
 					  TEE_PARAM_TYPE_NONE);
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
 	struct sample_buf *sbuf = NULL;
+	TEE_Result res = TEE_SUCCESS;
 	uint32_t rate = 0;
 
 	if (exp_pt != param_types)
@@ -128,6 +152,22 @@ static TEE_Result gprof_stop_pc_sampling(struct ts_session *s,
 	if (sbuf->enabled)
 		sbuf->enabled = false;
 
+	/*
+	 * Copy the histogram to the buffer registered at start, the
+	 * mapping is revalidated since it may have changed since then.
+	 */
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_WRITE |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)sbuf->usamples,
+				     sbuf->nsamples * sizeof(*sbuf->usamples));
+	if (res == TEE_SUCCESS)
+		memcpy(sbuf->usamples, sbuf->samples,
+		       sbuf->nsamples * sizeof(*sbuf->samples));
+	else
+		res = TEE_ERROR_ACCESS_DENIED;
+
 	rate = ((uint64_t)sbuf->count * sbuf->freq) / sbuf->usr;
 	params[0].value.a = rate;
 
@@ -135,10 +175,11 @@ static TEE_Result gprof_stop_pc_sampling(struct ts_session *s,
 	     " cntfrq=%" PRIu32 " rate=%" PRIu32, sbuf->count, sbuf->usr,
 	     sbuf->freq, rate);
 
+	free(sbuf->samples);
 	free(sbuf);
 	s->sbuf = NULL;
 
-	return TEE_SUCCESS;
+	return res;
 }
 
 /*
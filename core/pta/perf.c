@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <assert.h>
+#include <kernel/pmu.h>
+#include <kernel/pseudo_ta.h>
+#include <pta_perf.h>
+#include <string.h>
+#include <util.h>
+
+#define TA_NAME		"perf.ta"
+
+static TEE_Result cmd_start(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	uint32_t events[PMU_NUM_COUNTERS] = { };
+
+	COMPILE_TIME_ASSERT(PTA_PERF_NUM_COUNTERS == PMU_NUM_COUNTERS);
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	events[0] = p[0].value.a;
+	events[1] = p[0].value.b;
+	events[2] = p[1].value.a;
+	events[3] = p[1].value.b;
+
+	return pmu_start(events);
+}
+
+static TEE_Result cmd_read(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pmu_counts counts = { };
+	struct pta_perf_counts *out = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(*out)) {
+		p[1].memref.size = sizeof(*out);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = sizeof(*out);
+
+	res = pmu_read_counts(&counts, p[0].value.a);
+	if (res)
+		return res;
+
+	out = p[1].memref.buffer;
+	out->cycles = counts.cycles;
+	for (n = 0; n < PMU_NUM_COUNTERS; n++)
+		out->events[n] = counts.events[n];
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result cmd_stop(uint32_t type,
+			   TEE_Param p[TEE_NUM_PARAMS] __unused)
+{
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE, TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE, TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pmu_stop();
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result invoke_command(void *psess __unused, uint32_t cmd,
+				 uint32_t ptypes,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd) {
+	case PTA_PERF_CMD_START:
+		return cmd_start(ptypes, params);
+	case PTA_PERF_CMD_READ:
+		return cmd_read(ptypes, params);
+	case PTA_PERF_CMD_STOP:
+		return cmd_stop(ptypes, params);
+	default:
+		break;
+	}
+	return TEE_ERROR_BAD_PARAMETERS;
+}
+
+pseudo_ta_register(.uuid = PTA_PERF_UUID, .name = TA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .invoke_command_entry_point = invoke_command);
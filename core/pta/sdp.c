@@ -8,26 +8,36 @@
 #include <mm/core_memprot.h>
 #include <mm/vm.h>
 #include <sdp_pta.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define PTA_NAME "sdp.pta"
 
-static TEE_Result sdp_pa_cmd_virt_to_phys(uint32_t types,
-					  TEE_Param params[TEE_NUM_PARAMS])
+/* Number of SDP buffers that can be registered per session */
+#define SDP_PTA_NUM_BUFS	16
+
+/*
+ * Buffers registered with the session. A registered buffer has been
+ * validated once so later address translations against the handle skip
+ * the access rights and secure attribute checks. A slot with len == 0 is
+ * free.
+ */
+struct sdp_buf {
+	vaddr_t va;
+	size_t len;
+	paddr_t pa;
+};
+
+struct sdp_session {
+	struct sdp_buf bufs[SDP_PTA_NUM_BUFS];
+};
+
+static TEE_Result sdp_check_memref(char *va, size_t len)
 {
-	char *va = params[0].memref.buffer;
-	size_t len = params[0].memref.size;
 	struct tee_ta_session *s;
 	struct user_ta_ctx *utc;
 	TEE_Result res;
 
-	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
-				     TEE_PARAM_TYPE_VALUE_OUTPUT,
-				     TEE_PARAM_TYPE_NONE,
-				     TEE_PARAM_TYPE_NONE)) {
-		EMSG("bad parameters types: 0x%" PRIx32, types);
-		return TEE_ERROR_BAD_PARAMETERS;
-	}
-
 	s = tee_ta_get_calling_session();
 	if (!s)
 		return TEE_ERROR_ACCESS_DENIED;
@@ -46,23 +56,135 @@ static TEE_Result sdp_pa_cmd_virt_to_phys(uint32_t types,
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sdp_pa_cmd_virt_to_phys(uint32_t types,
+					  TEE_Param params[TEE_NUM_PARAMS])
+{
+	char *va = params[0].memref.buffer;
+	size_t len = params[0].memref.size;
+	TEE_Result res;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE)) {
+		EMSG("bad parameters types: 0x%" PRIx32, types);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	res = sdp_check_memref(va, len);
+	if (res != TEE_SUCCESS)
+		return res;
+
 	reg_pair_from_64(virt_to_phys(va), &params[1].value.a,
 			 &params[1].value.b);
 
 	return TEE_SUCCESS;
 }
 
+static TEE_Result sdp_pa_cmd_register_buf(struct sdp_session *sess,
+					  uint32_t types,
+					  TEE_Param params[TEE_NUM_PARAMS])
+{
+	char *va = params[0].memref.buffer;
+	size_t len = params[0].memref.size;
+	TEE_Result res;
+	size_t n;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE)) {
+		EMSG("bad parameters types: 0x%" PRIx32, types);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < SDP_PTA_NUM_BUFS; n++)
+		if (!sess->bufs[n].len)
+			break;
+	if (n == SDP_PTA_NUM_BUFS)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = sdp_check_memref(va, len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	sess->bufs[n].va = (vaddr_t)va;
+	sess->bufs[n].len = len;
+	sess->bufs[n].pa = virt_to_phys(va);
+
+	params[1].value.a = n;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sdp_pa_cmd_unregister_buf(struct sdp_session *sess,
+					    uint32_t types,
+					    TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t handle = params[0].value.a;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE)) {
+		EMSG("bad parameters types: 0x%" PRIx32, types);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (handle >= SDP_PTA_NUM_BUFS || !sess->bufs[handle].len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memset(&sess->bufs[handle], 0, sizeof(sess->bufs[handle]));
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sdp_pa_cmd_get_phys(struct sdp_session *sess, uint32_t types,
+				      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t handle = params[0].value.a;
+	uint32_t offs = params[0].value.b;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE)) {
+		EMSG("bad parameters types: 0x%" PRIx32, types);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (handle >= SDP_PTA_NUM_BUFS || !sess->bufs[handle].len ||
+	    offs >= sess->bufs[handle].len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	reg_pair_from_64(sess->bufs[handle].pa + offs, &params[1].value.a,
+			 &params[1].value.b);
+
+	return TEE_SUCCESS;
+}
+
 /*
  * Trusted Application Entry Points
  */
 static TEE_Result open_session(uint32_t nParamTypes __unused,
 			       TEE_Param pParams[TEE_NUM_PARAMS] __unused,
-			       void **ppSessionContext __unused)
+			       void **ppSessionContext)
 {
 	struct tee_ta_session *s = tee_ta_get_calling_session();
+	struct sdp_session *sess;
 
 	if (s && (s->ctx->flags & TA_FLAG_SECURE_DATA_PATH)) {
 		DMSG("open entry point for pseudo-TA \"%s\"", PTA_NAME);
+		sess = calloc(1, sizeof(*sess));
+		if (!sess)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		*ppSessionContext = sess;
 		return TEE_SUCCESS;
 	}
 
@@ -72,15 +194,28 @@ static TEE_Result open_session(uint32_t nParamTypes __unused,
 	return TEE_ERROR_ACCESS_DENIED;
 }
 
-static TEE_Result invoke_command(void *pSessionContext __unused,
+static void close_session(void *pSessionContext)
+{
+	free(pSessionContext);
+}
+
+static TEE_Result invoke_command(void *pSessionContext,
 				 uint32_t nCommandID, uint32_t nParamTypes,
 				 TEE_Param pParams[TEE_NUM_PARAMS])
 {
+	struct sdp_session *sess = pSessionContext;
+
 	FMSG("command entry point for pseudo-TA \"%s\"", PTA_NAME);
 
 	switch (nCommandID) {
 	case PTA_CMD_SDP_VIRT_TO_PHYS:
 		return sdp_pa_cmd_virt_to_phys(nParamTypes, pParams);
+	case PTA_CMD_SDP_REGISTER_BUF:
+		return sdp_pa_cmd_register_buf(sess, nParamTypes, pParams);
+	case PTA_CMD_SDP_UNREGISTER_BUF:
+		return sdp_pa_cmd_unregister_buf(sess, nParamTypes, pParams);
+	case PTA_CMD_SDP_GET_PHYS:
+		return sdp_pa_cmd_get_phys(sess, nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -91,4 +226,5 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 pseudo_ta_register(.uuid = PTA_SDP_PTA_UUID, .name = PTA_NAME,
 		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_SECURE_DATA_PATH,
 		   .open_session_entry_point = open_session,
+		   .close_session_entry_point = close_session,
 		   .invoke_command_entry_point = invoke_command);
@@ -37,6 +37,209 @@ static TEE_Result check_install_conflict(const struct shdr_bootstrap_ta *bs_ta)
 	return res;
 }
 
+/*
+ * State of a chunked bootstrap install, one per session. An install
+ * spans several commands so the hash context, the signed header and the
+ * write handle stay around until the install is committed or aborted.
+ */
+struct install_state {
+	struct shdr *shdr;
+	struct tee_tadb_ta_write *ta;
+	void *hash_ctx;
+	size_t remain_bytes;
+};
+
+static void install_abort(struct install_state *state)
+{
+	if (state->ta)
+		tee_tadb_ta_close_and_delete(state->ta);
+	crypto_hash_free_ctx(state->hash_ctx);
+	shdr_free(state->shdr);
+	memset(state, 0, sizeof(*state));
+}
+
+static TEE_Result install_begin(struct install_state *state,
+				uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	struct tee_tadb_property property;
+	struct shdr_bootstrap_ta bs_ta;
+	struct tee_tadb_ta_write *ta;
+	struct shdr *shdr = NULL;
+	void *hash_ctx = NULL;
+	TEE_Result res;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (state->ta)
+		return TEE_ERROR_BAD_STATE;
+
+	shdr = shdr_alloc_and_copy(params->memref.buffer,
+				   params->memref.size);
+	if (!shdr)
+		return TEE_ERROR_SECURITY;
+
+	res = shdr_verify_signature(shdr);
+	if (res)
+		goto err;
+
+	if (shdr->img_type != SHDR_BOOTSTRAP_TA ||
+	    shdr->hash_size > TEE_MAX_HASH_SIZE ||
+	    params->memref.size < SHDR_GET_SIZE(shdr) + sizeof(bs_ta)) {
+		res = TEE_ERROR_SECURITY;
+		goto err;
+	}
+
+	res = crypto_hash_alloc_ctx(&hash_ctx,
+				    TEE_DIGEST_HASH_TO_ALGO(shdr->algo));
+	if (res)
+		goto err;
+	res = crypto_hash_init(hash_ctx);
+	if (res)
+		goto err;
+	res = crypto_hash_update(hash_ctx, (uint8_t *)shdr, sizeof(*shdr));
+	if (res)
+		goto err;
+
+	memcpy(&bs_ta, (const uint8_t *)params->memref.buffer +
+		       SHDR_GET_SIZE(shdr), sizeof(bs_ta));
+
+	/* Check that we're not downgrading a TA */
+	res = check_install_conflict(&bs_ta);
+	if (res)
+		goto err;
+
+	res = crypto_hash_update(hash_ctx, (uint8_t *)&bs_ta, sizeof(bs_ta));
+	if (res)
+		goto err;
+
+	memset(&property, 0, sizeof(property));
+	COMPILE_TIME_ASSERT(sizeof(property.uuid) == sizeof(bs_ta.uuid));
+	tee_uuid_from_octets(&property.uuid, bs_ta.uuid);
+	property.version = bs_ta.ta_version;
+	property.custom_size = 0;
+	property.bin_size = params[1].value.a;
+	DMSG("Installing %pUl", (void *)&property.uuid);
+
+	res = tee_tadb_ta_create(&property, &ta);
+	if (res)
+		goto err;
+
+	state->shdr = shdr;
+	state->ta = ta;
+	state->hash_ctx = hash_ctx;
+	state->remain_bytes = params[1].value.a;
+
+	return TEE_SUCCESS;
+err:
+	crypto_hash_free_ctx(hash_ctx);
+	shdr_free(shdr);
+	return res;
+}
+
+static TEE_Result install_write(struct install_state *state,
+				uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	const uint8_t *nw = NULL;
+	const size_t buf_size = 2 * 4096;
+	size_t offs = 0;
+	void *buf = NULL;
+	TEE_Result res;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!state->ta)
+		return TEE_ERROR_BAD_STATE;
+
+	if (params->memref.size > state->remain_bytes) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto err;
+	}
+
+	buf = malloc(buf_size);
+	if (!buf) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err;
+	}
+
+	/*
+	 * Hash and write via a bounce buffer so normal world can't change
+	 * the data between the hash update and the write.
+	 */
+	nw = params->memref.buffer;
+	while (offs < params->memref.size) {
+		size_t l = MIN(buf_size, params->memref.size - offs);
+
+		memcpy(buf, nw + offs, l);
+		res = crypto_hash_update(state->hash_ctx, buf, l);
+		if (res)
+			goto err_free;
+		res = tee_tadb_ta_write(state->ta, buf, l);
+		if (res)
+			goto err_free;
+		offs += l;
+	}
+	state->remain_bytes -= params->memref.size;
+
+	free(buf);
+	return TEE_SUCCESS;
+err_free:
+	free(buf);
+err:
+	install_abort(state);
+	return res;
+}
+
+static TEE_Result install_commit(struct install_state *state,
+				 uint32_t param_types)
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	uint8_t digest[TEE_MAX_HASH_SIZE];
+	TEE_Result res;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!state->ta)
+		return TEE_ERROR_BAD_STATE;
+
+	if (state->remain_bytes) {
+		res = TEE_ERROR_BAD_STATE;
+		goto err;
+	}
+
+	res = crypto_hash_final(state->hash_ctx, digest, state->shdr->hash_size);
+	if (res)
+		goto err;
+	if (consttime_memcmp(digest, SHDR_GET_HASH(state->shdr),
+			     state->shdr->hash_size)) {
+		res = TEE_ERROR_SECURITY;
+		goto err;
+	}
+
+	res = tee_tadb_ta_close_and_commit(state->ta);
+	state->ta = NULL;
+	install_abort(state);
+	return res;
+err:
+	install_abort(state);
+	return res;
+}
+
 static TEE_Result install_ta(struct shdr *shdr, const uint8_t *nw,
 			     size_t nw_size)
 {
@@ -163,13 +366,40 @@ out:
 	return res;
 }
 
-static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
+static TEE_Result open_session(uint32_t param_types __unused,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused,
+			       void **sess_ctx)
+{
+	struct install_state *state = calloc(1, sizeof(*state));
+
+	if (!state)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	*sess_ctx = state;
+	return TEE_SUCCESS;
+}
+
+static void close_session(void *sess_ctx)
+{
+	struct install_state *state = sess_ctx;
+
+	install_abort(state);
+	free(state);
+}
+
+static TEE_Result invoke_command(void *sess_ctx, uint32_t cmd_id,
 				 uint32_t param_types,
 				 TEE_Param params[TEE_NUM_PARAMS])
 {
 	switch (cmd_id) {
 	case PTA_SECSTOR_TA_MGMT_BOOTSTRAP:
 		return bootstrap(param_types, params);
+	case PTA_SECSTOR_TA_MGMT_BOOTSTRAP_BEGIN:
+		return install_begin(sess_ctx, param_types, params);
+	case PTA_SECSTOR_TA_MGMT_BOOTSTRAP_WRITE:
+		return install_write(sess_ctx, param_types, params);
+	case PTA_SECSTOR_TA_MGMT_BOOTSTRAP_COMMIT:
+		return install_commit(sess_ctx, param_types);
 	default:
 		break;
 	}
@@ -185,4 +415,6 @@ pseudo_ta_register(.uuid = PTA_SECSTOR_TA_MGMT_UUID, .name = "secstor_ta_mgmt",
 		    */
 		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_SINGLE_INSTANCE |
 			    TA_FLAG_MULTI_SESSION,
+		   .open_session_entry_point = open_session,
+		   .close_session_entry_point = close_session,
 		   .invoke_command_entry_point = invoke_command);
@@ -5,12 +5,24 @@
 #include <compiler.h>
 #include <stdio.h>
 #include <trace.h>
+#include <kernel/evtrace.h>
+#include <kernel/interrupt.h>
+#include <kernel/lockprof.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/thread.h>
+#include <kernel/ts_manager.h>
+#include <kernel/user_ta.h>
+#include <kernel/wait_queue.h>
 #include <mm/tee_pager.h>
 #include <mm/tee_mm.h>
 #include <string.h>
 #include <string_ext.h>
 #include <malloc.h>
+#include <mempool.h>
+#include <tee/tee_fs.h>
+#include <util.h>
 
 #define TA_NAME		"stats.ta"
 
@@ -21,8 +33,17 @@
 #define STATS_CMD_PAGER_STATS		0
 #define STATS_CMD_ALLOC_STATS		1
 #define STATS_CMD_MEMLEAK_STATS		2
+#define STATS_CMD_THREAD_WQ_STATS	3
+#define STATS_CMD_RPMB_STATS		4
+#define STATS_CMD_HEAP_CHECK_INTERVAL	5
+#define STATS_CMD_EVENT_TRACE		6
+#define STATS_CMD_LOCK_STATS		7
+#define STATS_CMD_PAGER_FAULT_TRACE	8
+#define STATS_CMD_ITR_STATS		9
+#define STATS_CMD_STACK_USAGE		10
+#define STATS_CMD_TS_LATENCY		11
 
-#define STATS_NB_POOLS			4
+#define STATS_NB_POOLS			6
 
 static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
@@ -90,6 +111,29 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 				nex_malloc_reset_stats();
 			break;
 #endif
+		case 5:
+			memset(stats, 0, sizeof(*stats));
+			if (mempool_default)
+				mempool_get_stats(mempool_default, stats,
+						  !!p[0].value.b);
+			strlcpy(stats->desc, "Mempool", sizeof(stats->desc));
+			break;
+
+		case 6:
+			/*
+			 * Contended acquisitions of the default mempool,
+			 * reported in the allocated field.
+			 */
+			memset(stats, 0, sizeof(*stats));
+			if (mempool_default)
+				stats->allocated =
+					mempool_get_contention_count(
+						mempool_default,
+						!!p[0].value.b);
+			strlcpy(stats->desc, "Mempool lock",
+				sizeof(stats->desc));
+			break;
+
 		default:
 			EMSG("Wrong pool id");
 			break;
@@ -101,14 +145,77 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	return TEE_SUCCESS;
 }
 
+/* Per TA pager fault statistics returned by STATS_CMD_PAGER_STATS */
+struct pager_ta_stats {
+	TEE_UUID uuid;
+	uint32_t faults;
+	uint32_t read_faults;
+	uint32_t write_faults;
+	uint32_t exec_faults;
+	uint32_t pages_loaded;
+	uint32_t evictions;
+};
+
+#if defined(CFG_PAGED_USER_TA) && defined(CFG_WITH_STATS)
+static TEE_Result get_pager_ta_stats(TEE_Param *p)
+{
+	struct pager_ta_stats *out = p->memref.buffer;
+	size_t max_out = p->memref.size / sizeof(*out);
+	struct tee_ta_ctx *ctx = NULL;
+	struct tee_pager_um_stats *um = NULL;
+	size_t n = 0;
+
+	mutex_lock(&tee_ta_mutex);
+
+	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+		if (!is_user_ta_ctx(&ctx->ts_ctx))
+			continue;
+		if (n == max_out) {
+			mutex_unlock(&tee_ta_mutex);
+			return TEE_ERROR_SHORT_BUFFER;
+		}
+		um = &to_user_ta_ctx(&ctx->ts_ctx)->uctx.pager_stats;
+		out[n].uuid = ctx->ts_ctx.uuid;
+		out[n].faults = um->faults;
+		out[n].read_faults = um->read_faults;
+		out[n].write_faults = um->write_faults;
+		out[n].exec_faults = um->exec_faults;
+		out[n].pages_loaded = um->pages_loaded;
+		out[n].evictions = um->evictions;
+		n++;
+	}
+
+	mutex_unlock(&tee_ta_mutex);
+	p->memref.size = n * sizeof(*out);
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result get_pager_ta_stats(TEE_Param *p __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
 	struct tee_pager_stats stats;
+	bool with_ta_stats = false;
 
+	/*
+	 * An optional memref in params[3] also retrieves per TA fault
+	 * statistics as an array of struct pager_ta_stats, one entry per
+	 * loaded user TA.
+	 */
 	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_NONE) != type) {
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT) == type) {
+		with_ta_stats = true;
+	} else if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_NONE) != type) {
 		EMSG("expect 3 output values as argument");
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
@@ -121,8 +228,301 @@ static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	p[2].value.a = stats.hidden_hits;
 	p[2].value.b = stats.zi_released;
 
+	if (with_ta_stats)
+		return get_pager_ta_stats(p + 3);
+
+	return TEE_SUCCESS;
+}
+
+#if defined(CFG_PAGER_FAULT_TRACE) && defined(CFG_WITH_PAGER)
+static TEE_Result get_pager_fault_trace(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t num_recs = 0;
+
+	/*
+	 * p[0].value.a = returns the total fault count, the oldest record
+	 *		  in the ring is found at index
+	 *		  count % TEE_PAGER_FAULT_TRACE_SIZE
+	 * p[1].memref.buffer = output buffer to struct tee_pager_fault_rec[]
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(struct tee_pager_fault_rec) *
+			       TEE_PAGER_FAULT_TRACE_SIZE) {
+		p[1].memref.size = sizeof(struct tee_pager_fault_rec) *
+				   TEE_PAGER_FAULT_TRACE_SIZE;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	num_recs = p[1].memref.size / sizeof(struct tee_pager_fault_rec);
+	p[0].value.a = tee_pager_get_fault_trace(p[1].memref.buffer, num_recs);
+	p[1].memref.size = MIN(num_recs,
+			       (size_t)TEE_PAGER_FAULT_TRACE_SIZE) *
+			   sizeof(struct tee_pager_fault_rec);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+static TEE_Result get_thread_wq_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	uint32_t *vals = NULL;
+	size_t n = 0;
+
+	/*
+	 * p[0].value.a = number of threads (out)
+	 * p[1].memref.buffer = output buffer receiving two uint32_t per
+	 * thread: the number of wait-queue sleep RPCs followed by the
+	 * number of wakeup RPCs issued on behalf of the thread
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	p[0].value.a = CFG_NUM_THREADS;
+
+	if (p[1].memref.size < 2 * sizeof(uint32_t) * CFG_NUM_THREADS) {
+		p[1].memref.size = 2 * sizeof(uint32_t) * CFG_NUM_THREADS;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = 2 * sizeof(uint32_t) * CFG_NUM_THREADS;
+	vals = p[1].memref.buffer;
+
+	for (n = 0; n < CFG_NUM_THREADS; n++)
+		wq_get_thread_stats(n, vals + 2 * n, vals + 2 * n + 1);
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_RPMB_FS
+static TEE_Result get_rpmb_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_rpmb_fs_stats stats;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the stats
+	 * p[1].memref.buffer = output buffer to struct tee_rpmb_fs_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(stats)) {
+		p[1].memref.size = sizeof(stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = sizeof(stats);
+
+	tee_rpmb_fs_get_stats(&stats, p[0].value.a);
+	memcpy(p[1].memref.buffer, &stats, sizeof(stats));
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef ENABLE_MDBG
+static TEE_Result set_heap_check_interval(uint32_t type,
+					  TEE_Param p[TEE_NUM_PARAMS])
+{
+	/*
+	 * p[0].value.a = validate the heap canaries on every Nth free,
+	 * 0 to disable the sampling
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT, TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE, TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mdbg_set_check_interval(p[0].value.a);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef CFG_CORE_EVENT_TRACE
+static TEE_Result get_event_trace(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t num_recs = 0;
+	uint32_t head = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	/*
+	 * p[0].value.a = core to snapshot
+	 * p[0].value.b = returns the total record count of that core, the
+	 *		  oldest record in the ring is found at index
+	 *		  count % EVTRACE_RING_SIZE
+	 * p[1].memref.buffer = output buffer to struct evtrace_rec[]
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(struct evtrace_rec) *
+			       EVTRACE_RING_SIZE) {
+		p[1].memref.size = sizeof(struct evtrace_rec) *
+				   EVTRACE_RING_SIZE;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	num_recs = p[1].memref.size / sizeof(struct evtrace_rec);
+	res = evtrace_snapshot(p[0].value.a, p[1].memref.buffer, &num_recs,
+			       &head);
+	if (res)
+		return res;
+
+	p[1].memref.size = num_recs * sizeof(struct evtrace_rec);
+	p[0].value.b = head;
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef CFG_LOCK_PROFILER
+static TEE_Result get_lock_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t num_stats = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	/*
+	 * p[0].value.a = 1 to reset the counters after reading
+	 * p[1].memref.buffer = output buffer to struct lockprof_stat[]
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	num_stats = p[1].memref.size / sizeof(struct lockprof_stat);
+	res = lockprof_get_stats(p[1].memref.buffer, &num_stats,
+				 p[0].value.a);
+	p[1].memref.size = num_stats * sizeof(struct lockprof_stat);
+
+	return res;
+}
+#endif
+
+static TEE_Result get_itr_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t num_stats = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	/*
+	 * p[0].value.a = 1 to reset the counters after reading
+	 * p[1].memref.buffer = output buffer to struct itr_stat[]
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	num_stats = p[1].memref.size / sizeof(struct itr_stat);
+	res = itr_get_stats(p[1].memref.buffer, &num_stats, p[0].value.a);
+	p[1].memref.size = num_stats * sizeof(struct itr_stat);
+
+	return res;
+}
+
+#ifdef CFG_CORE_STACK_USAGE
+/* Per stack high-water mark returned by STATS_CMD_STACK_USAGE */
+struct stack_usage_stats {
+	uint32_t stack_class;	/* THREAD_STACK_TMP/ABT/THREAD */
+	uint32_t index;		/* core or thread number */
+	uint32_t size;		/* usable stack size in bytes */
+	uint32_t max_usage;	/* high-water mark in bytes */
+};
+
+static TEE_Result get_stack_usage_stats(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stack_usage_stats *out = NULL;
+	size_t max_out = 0;
+	size_t max_usage = 0;
+	size_t size = 0;
+	unsigned int cls = 0;
+	size_t idx = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].value.a = number of entries written (out)
+	 * p[1].memref.buffer = output buffer to struct stack_usage_stats[]
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	out = p[1].memref.buffer;
+	max_out = p[1].memref.size / sizeof(*out);
+
+	for (cls = THREAD_STACK_TMP; cls <= THREAD_STACK_THREAD; cls++) {
+		for (idx = 0;
+		     thread_get_stack_usage(cls, idx, &size, &max_usage);
+		     idx++) {
+			if (n == max_out)
+				return TEE_ERROR_SHORT_BUFFER;
+			out[n].stack_class = cls;
+			out[n].index = idx;
+			out[n].size = size;
+			out[n].max_usage = max_usage;
+			n++;
+		}
+	}
+
+	p[0].value.a = n;
+	p[1].memref.size = n * sizeof(*out);
+
 	return TEE_SUCCESS;
 }
+#endif
+
+#ifdef CFG_TS_LATENCY_STATS
+static TEE_Result get_ts_latency_stats(uint32_t type,
+				       TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct ts_latency_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	/*
+	 * p[0].value.a = index of the TA slot to read (from 0 and up,
+	 *   TEE_ERROR_ITEM_NOT_FOUND past the last used slot)
+	 * p[0].value.b = 0 if no reset of the stats
+	 * p[1].memref.buffer = output buffer to struct ts_latency_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(stats)) {
+		p[1].memref.size = sizeof(stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	res = ts_latency_get_stats(p[0].value.a, &stats, p[0].value.b);
+	if (res)
+		return res;
+
+	memcpy(p[1].memref.buffer, &stats, sizeof(stats));
+	p[1].memref.size = sizeof(stats);
+
+	return TEE_SUCCESS;
+}
+#endif
 
 static TEE_Result get_memleak_stats(uint32_t type,
 				    TEE_Param p[TEE_NUM_PARAMS] __unused)
@@ -152,6 +552,38 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_alloc_stats(ptypes, params);
 	case STATS_CMD_MEMLEAK_STATS:
 		return get_memleak_stats(ptypes, params);
+	case STATS_CMD_THREAD_WQ_STATS:
+		return get_thread_wq_stats(ptypes, params);
+#ifdef CFG_RPMB_FS
+	case STATS_CMD_RPMB_STATS:
+		return get_rpmb_stats(ptypes, params);
+#endif
+#ifdef ENABLE_MDBG
+	case STATS_CMD_HEAP_CHECK_INTERVAL:
+		return set_heap_check_interval(ptypes, params);
+#endif
+#ifdef CFG_CORE_EVENT_TRACE
+	case STATS_CMD_EVENT_TRACE:
+		return get_event_trace(ptypes, params);
+#endif
+#ifdef CFG_LOCK_PROFILER
+	case STATS_CMD_LOCK_STATS:
+		return get_lock_stats(ptypes, params);
+#endif
+#if defined(CFG_PAGER_FAULT_TRACE) && defined(CFG_WITH_PAGER)
+	case STATS_CMD_PAGER_FAULT_TRACE:
+		return get_pager_fault_trace(ptypes, params);
+#endif
+	case STATS_CMD_ITR_STATS:
+		return get_itr_stats(ptypes, params);
+#ifdef CFG_CORE_STACK_USAGE
+	case STATS_CMD_STACK_USAGE:
+		return get_stack_usage_stats(ptypes, params);
+#endif
+#ifdef CFG_TS_LATENCY_STATS
+	case STATS_CMD_TS_LATENCY:
+		return get_ts_latency_stats(ptypes, params);
+#endif
 	default:
 		break;
 	}
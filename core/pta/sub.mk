@@ -1,7 +1,9 @@
 subdirs-$(CFG_TEE_CORE_EMBED_INTERNAL_TESTS) += tests
 
 srcs-$(CFG_TEE_BENCHMARK) += benchmark.c
+srcs-$(CFG_CRYPTO_BENCH_PTA) += crypto_bench.c
 srcs-$(CFG_DEVICE_ENUM_PTA) += device.c
+srcs-$(CFG_CORE_PMU_PROFILING) += perf.c
 srcs-$(CFG_TA_GPROF_SUPPORT) += gprof.c
 srcs-$(CFG_SDP_PTA) += sdp.c
 ifeq ($(CFG_WITH_USER_TA),y)
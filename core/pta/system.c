@@ -355,47 +355,34 @@ static TEE_Result binh_copy_to(struct bin_handle *binh, vaddr_t va,
 	return TEE_SUCCESS;
 }
 
-static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
-				       struct ts_session *s,
-				       uint32_t param_types,
-				       TEE_Param params[TEE_NUM_PARAMS])
+/*
+ * Maps a segment of an opened TA binary into the calling TA.
+ *
+ * Read-only segments are shared between all contexts mapping the same
+ * binary: the first mapping populates a fobj which is registered as a
+ * slice of the file identified by the binary's tag (hash), and later
+ * mappings of the same range resolve to that fobj through
+ * file_find_slice() without copying or hashing the data again. Writable
+ * segments always get a private copy.
+ */
+static TEE_Result map_ta_binary(struct bin_handle *binh, struct ts_session *s,
+				uint32_t flags, uint32_t offs_bytes,
+				uint32_t num_bytes, vaddr_t *va_req,
+				uint32_t pad_begin, uint32_t pad_end)
 {
 	const uint32_t accept_flags = PTA_SYSTEM_MAP_FLAG_SHAREABLE |
 				      PTA_SYSTEM_MAP_FLAG_WRITEABLE |
 				      PTA_SYSTEM_MAP_FLAG_EXECUTABLE;
-	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
-					  TEE_PARAM_TYPE_VALUE_INPUT,
-					  TEE_PARAM_TYPE_VALUE_INOUT,
-					  TEE_PARAM_TYPE_VALUE_INPUT);
 	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
-	struct bin_handle *binh = NULL;
 	uint32_t num_rounded_bytes = 0;
 	TEE_Result res = TEE_SUCCESS;
 	struct file_slice *fs = NULL;
 	bool file_is_locked = false;
 	struct mobj *mobj = NULL;
-	uint32_t offs_bytes = 0;
 	uint32_t offs_pages = 0;
-	uint32_t num_bytes = 0;
-	uint32_t pad_begin = 0;
-	uint32_t pad_end = 0;
 	size_t num_pages = 0;
-	uint32_t flags = 0;
 	uint32_t prot = 0;
-	vaddr_t va = 0;
-
-	if (exp_pt != param_types)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	binh = handle_lookup(&ctx->db, params[0].value.a);
-	if (!binh)
-		return TEE_ERROR_BAD_PARAMETERS;
-	flags = params[0].value.b;
-	offs_bytes = params[1].value.a;
-	num_bytes = params[1].value.b;
-	va = reg_pair_to_64(params[2].value.a, params[2].value.b);
-	pad_begin = params[3].value.a;
-	pad_end = params[3].value.b;
+	vaddr_t va = *va_req;
 
 	if ((flags & accept_flags) != flags)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -461,7 +448,16 @@ static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 		if (res)
 			goto err;
 	} else {
+#ifdef CFG_PAGED_USER_TA
 		struct fobj *f = fobj_ta_mem_alloc(num_pages);
+#else
+		/*
+		 * Every byte is written below: the binary is copied in and
+		 * the rounding tail is cleared before the pages are exposed,
+		 * so skip the allocator's clearing of the whole range.
+		 */
+		struct fobj *f = fobj_sec_mem_alloc_uninit(num_pages);
+#endif
 		struct file *file = NULL;
 		uint32_t vm_flags = 0;
 
@@ -489,6 +485,9 @@ static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 		res = binh_copy_to(binh, va, offs_bytes, num_bytes);
 		if (res)
 			goto err_unmap_va;
+		if (num_rounded_bytes > num_bytes)
+			memset((uint8_t *)va + num_bytes, 0,
+			       num_rounded_bytes - num_bytes);
 		res = vm_set_prot(&utc->uctx, va, num_rounded_bytes,
 				  prot);
 		if (res)
@@ -509,7 +508,7 @@ static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 
 	file_unlock(binh->f);
 
-	reg_pair_from_64(va, &params[2].value.a, &params[2].value.b);
+	*va_req = va;
 	return TEE_SUCCESS;
 
 err_unmap_va:
@@ -529,6 +528,150 @@ err:
 	return res;
 }
 
+static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
+				       struct ts_session *s,
+				       uint32_t param_types,
+				       TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INOUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT);
+	TEE_Result res = TEE_SUCCESS;
+	struct bin_handle *binh = NULL;
+	vaddr_t va = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	binh = handle_lookup(&ctx->db, params[0].value.a);
+	if (!binh)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	va = reg_pair_to_64(params[2].value.a, params[2].value.b);
+	res = map_ta_binary(binh, s, params[0].value.b, params[1].value.a,
+			    params[1].value.b, &va, params[3].value.a,
+			    params[3].value.b);
+	if (!res)
+		reg_pair_from_64(va, &params[2].value.a, &params[2].value.b);
+
+	return res;
+}
+
+/*
+ * Maps a zero initialized segment and fills the start of it from the TA
+ * binary, the equivalent of PTA_SYSTEM_MAP_ZI followed by
+ * PTA_SYSTEM_COPY_FROM_TA_BINARY without returning to user mode in
+ * between.
+ */
+static TEE_Result map_zi_from_binary(struct bin_handle *binh,
+				     struct ts_session *s, uint32_t offs_bytes,
+				     uint32_t filesz, uint32_t memsz,
+				     vaddr_t *va_req, uint32_t pad_end)
+{
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
+	uint32_t prot = TEE_MATTR_URW | TEE_MATTR_PRW;
+	uint32_t num_rounded_bytes = 0;
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	struct fobj *f = NULL;
+	vaddr_t va = *va_req;
+
+	if (ROUNDUP_OVERFLOW(memsz, SMALL_PAGE_SIZE, &num_rounded_bytes))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	f = fobj_ta_mem_alloc(num_rounded_bytes / SMALL_PAGE_SIZE);
+	if (!f)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	mobj = mobj_with_fobj_alloc(f, NULL);
+	fobj_put(f);
+	if (!mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	res = vm_map_pad(&utc->uctx, &va, memsz, prot, 0, mobj, 0, 0,
+			 pad_end, 0);
+	mobj_put(mobj);
+	if (res)
+		return res;
+
+	if (filesz) {
+		res = binh_copy_to(binh, va, offs_bytes, filesz);
+		if (res) {
+			if (vm_unmap(&utc->uctx, va, num_rounded_bytes))
+				panic();
+			return res;
+		}
+	}
+
+	*va_req = va;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result system_map_ta_segments(struct system_ctx *ctx,
+					 struct ts_session *s,
+					 uint32_t param_types,
+					 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INOUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	struct pta_system_seg_map *segs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct bin_handle *binh = NULL;
+	size_t nsegs = 0;
+	size_t n = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (params[0].value.b)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	binh = handle_lookup(&ctx->db, params[0].value.a);
+	if (!binh)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	segs = params[1].memref.buffer;
+	if (!segs || !params[1].memref.size ||
+	    params[1].memref.size % sizeof(*segs))
+		return TEE_ERROR_BAD_PARAMETERS;
+	nsegs = params[1].memref.size / sizeof(*segs);
+	if (nsegs > PTA_SYSTEM_MAX_SEG_MAPS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/*
+	 * Segments are mapped in array order. A failure leaves the already
+	 * mapped segments in place, ldelf aborts the load on any error so
+	 * there's nothing to be gained by rolling back here.
+	 */
+	for (n = 0; n < nsegs; n++) {
+		/* Work on a local copy of the descriptor */
+		struct pta_system_seg_map seg = segs[n];
+		vaddr_t va = seg.va;
+
+		if (!va || seg.reserved || seg.filesz > seg.memsz)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		if (seg.flags & PTA_SYSTEM_MAP_FLAG_WRITEABLE) {
+			if (seg.flags != PTA_SYSTEM_MAP_FLAG_WRITEABLE ||
+			    seg.offs & SMALL_PAGE_MASK)
+				return TEE_ERROR_BAD_PARAMETERS;
+			res = map_zi_from_binary(binh, s, seg.offs, seg.filesz,
+						 seg.memsz, &va, seg.pad_end);
+		} else {
+			if (seg.filesz != seg.memsz)
+				return TEE_ERROR_BAD_PARAMETERS;
+			res = map_ta_binary(binh, s, seg.flags, seg.offs,
+					    seg.filesz, &va, 0, seg.pad_end);
+		}
+		if (res)
+			return res;
+
+		segs[n].va = va;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result system_copy_from_ta_binary(struct system_ctx *ctx,
 					     uint32_t param_types,
 					     TEE_Param params[TEE_NUM_PARAMS])
@@ -892,6 +1035,9 @@ static TEE_Result invoke_command(void *sess_ctx, uint32_t cmd_id,
 		return system_close_ta_binary(sess_ctx, param_types, params);
 	case PTA_SYSTEM_MAP_TA_BINARY:
 		return system_map_ta_binary(sess_ctx, s, param_types, params);
+	case PTA_SYSTEM_MAP_TA_SEGMENTS:
+		return system_map_ta_segments(sess_ctx, s, param_types,
+					      params);
 	case PTA_SYSTEM_COPY_FROM_TA_BINARY:
 		return system_copy_from_ta_binary(sess_ctx, param_types,
 						  params);
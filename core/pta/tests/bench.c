@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/mutex.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
+#include <mm/tee_mm.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <util.h>
+
+#include "misc.h"
+
+/*
+ * Micro benchmarks of the core primitives the syscall and RPC paths
+ * depend on. Each iteration of the benched operation is timed separately
+ * with the generic timer so that the distribution (min/median/p99) is
+ * reported rather than a mean hiding tail latencies. The PTA_BENCH_NOP
+ * case measures the timing harness itself and is the baseline to
+ * subtract from the other results.
+ *
+ * A full null-syscall round trip cannot be timed from a pseudo TA as it
+ * needs a user TA context, xtest measures it from the normal world side.
+ */
+
+#define BENCH_MAX_BUF_SIZE	(1024 * 1024)
+
+static uint64_t __noprof bench_timestamp(void)
+{
+	/* Keep the counter read from drifting into the benched operation */
+	isb();
+	return read_cntpct();
+}
+
+static int cmp_sample(const void *a, const void *b)
+{
+	const uint32_t *ta = a;
+	const uint32_t *tb = b;
+
+	if (*ta < *tb)
+		return -1;
+	if (*ta > *tb)
+		return 1;
+	return 0;
+}
+
+static void report_samples(uint32_t *samples, size_t count,
+			   TEE_Param p[TEE_NUM_PARAMS])
+{
+	qsort(samples, count, sizeof(*samples), cmp_sample);
+
+	p[2].value.a = samples[0];
+	p[2].value.b = samples[count / 2];
+	p[3].value.a = samples[(count * 99) / 100];
+	p[3].value.b = read_cntfrq();
+}
+
+static void bench_nop(uint32_t *samples, size_t count)
+{
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		t0 = bench_timestamp();
+		samples[n] = bench_timestamp() - t0;
+	}
+}
+
+static TEE_Result bench_memcpy(uint32_t *samples, size_t count, size_t size)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *src = NULL;
+	uint8_t *dst = NULL;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	if (!size || size > BENCH_MAX_BUF_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	src = malloc(size);
+	dst = malloc(size);
+	if (!src || !dst) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	memset(src, 0x5c, size);
+
+	for (n = 0; n < count; n++) {
+		t0 = bench_timestamp();
+		memcpy(dst, src, size);
+		samples[n] = bench_timestamp() - t0;
+	}
+out:
+	free(src);
+	free(dst);
+	return res;
+}
+
+static void bench_mutex(uint32_t *samples, size_t count)
+{
+	struct mutex mu = MUTEX_INITIALIZER;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		t0 = bench_timestamp();
+		mutex_lock(&mu);
+		mutex_unlock(&mu);
+		samples[n] = bench_timestamp() - t0;
+	}
+
+	mutex_destroy(&mu);
+}
+
+static TEE_Result bench_malloc(uint32_t *samples, size_t count, size_t size)
+{
+	uint64_t t0 = 0;
+	void *buf = NULL;
+	size_t n = 0;
+
+	if (!size || size > BENCH_MAX_BUF_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < count; n++) {
+		t0 = bench_timestamp();
+		buf = malloc(size);
+		free(buf);
+		samples[n] = bench_timestamp() - t0;
+		if (!buf)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Maps and unmaps one non-secure shared memory page at a temporary
+ * virtual address, the same sequence mobj_reg_shm_inc_map()/_dec_map()
+ * performs when dynamic shared memory buffers are mapped on demand.
+ */
+static TEE_Result bench_map(uint32_t *samples, size_t count, paddr_t pa)
+{
+	TEE_Result res = TEE_SUCCESS;
+	tee_mm_entry_t *mm = NULL;
+	uint64_t t0 = 0;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		t0 = bench_timestamp();
+		mm = tee_mm_alloc(&tee_mm_shm, SMALL_PAGE_SIZE);
+		if (!mm)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		res = core_mmu_map_pages(tee_mm_get_smem(mm), &pa, 1,
+					 MEM_AREA_NSEC_SHM);
+		if (res) {
+			tee_mm_free(mm);
+			return res;
+		}
+		core_mmu_unmap_pages(tee_mm_get_smem(mm), 1);
+		tee_mm_free(mm);
+		samples[n] = bench_timestamp() - t0;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result bench_map_entry(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t *samples = NULL;
+	size_t count = p[0].value.b;
+	paddr_t pa = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!count || count > PTA_BENCH_MAX_ITERATIONS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!core_vbuf_is(CORE_MEM_NON_SEC, p[1].memref.buffer,
+			  p[1].memref.size))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pa = ROUNDDOWN(virt_to_phys(p[1].memref.buffer), SMALL_PAGE_SIZE);
+	if (!pa)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	samples = malloc(count * sizeof(*samples));
+	if (!samples)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = bench_map(samples, count, pa);
+	if (!res)
+		report_samples(samples, count, p);
+
+	free(samples);
+	return res;
+}
+
+TEE_Result core_bench_tests(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t *samples = NULL;
+	size_t count = 0;
+	size_t size = 0;
+
+	if (TEE_PARAM_TYPE_GET(type, 0) != TEE_PARAM_TYPE_VALUE_INPUT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[0].value.a == PTA_BENCH_MAP)
+		return bench_map_entry(type, p);
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	size = p[0].value.b;
+	count = p[1].value.a;
+	if (!count || count > PTA_BENCH_MAX_ITERATIONS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	samples = malloc(count * sizeof(*samples));
+	if (!samples)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	switch (p[0].value.a) {
+	case PTA_BENCH_NOP:
+		bench_nop(samples, count);
+		break;
+	case PTA_BENCH_MEMCPY:
+		res = bench_memcpy(samples, count, size);
+		break;
+	case PTA_BENCH_MUTEX:
+		bench_mutex(samples, count);
+		break;
+	case PTA_BENCH_MALLOC:
+		res = bench_malloc(samples, count, size);
+		break;
+	default:
+		res = TEE_ERROR_BAD_PARAMETERS;
+		break;
+	}
+
+	if (!res)
+		report_samples(samples, count, p);
+
+	free(samples);
+	return res;
+}
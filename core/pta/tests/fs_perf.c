@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2020, Linaro Limited
+ */
+
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_defines_extensions.h>
+#include <tee_api_types.h>
+#include <tee/tee_fs.h>
+#include <tee/tee_pobj.h>
+#include <tee/tee_svc_storage.h>
+#include <trace.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define FS_PERF_MAX_OBJ_SIZE	(8U * 1024 * 1024)
+#define FS_PERF_MAX_CHUNK_SIZE	(1U * 1024 * 1024)
+
+static const char fs_perf_obj_id[] = "fs_perf.test";
+
+static uint32_t get_ms(void)
+{
+	TEE_Time t = { };
+
+	if (tee_time_get_sys_time(&t))
+		return 0;
+
+	return t.seconds * 1000 + t.millis;
+}
+
+static size_t gcd(size_t a, size_t b)
+{
+	while (b) {
+		size_t t = b;
+
+		b = a % b;
+		a = t;
+	}
+
+	return a;
+}
+
+/*
+ * Returns a stride co-prime with nchunks so that
+ * (n * stride) % nchunks visits every chunk exactly once in a
+ * non-sequential order.
+ */
+static size_t random_stride(size_t nchunks)
+{
+	size_t stride = nchunks / 2 + 1;
+
+	while (gcd(stride, nchunks) != 1)
+		stride++;
+
+	return stride;
+}
+
+static TEE_Result do_chunks(const struct tee_file_operations *fops,
+			    struct tee_file_handle *fh, uint8_t *chunk,
+			    size_t chunk_size, size_t nchunks, size_t stride,
+			    bool write)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n;
+
+	for (n = 0; n < nchunks; n++) {
+		size_t pos = ((n * stride) % nchunks) * chunk_size;
+
+		if (write) {
+			res = fops->write(fh, pos, chunk, chunk_size);
+		} else {
+			size_t l = chunk_size;
+
+			res = fops->read(fh, pos, chunk, &l);
+			if (!res && l != chunk_size)
+				res = TEE_ERROR_CORRUPT_OBJECT;
+		}
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result core_fs_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT);
+	const struct tee_file_operations *fops = NULL;
+	struct tee_file_handle *fh = NULL;
+	struct tee_pobj po = {
+		.obj_id = (void *)fs_perf_obj_id,
+		.obj_id_len = sizeof(fs_perf_obj_id),
+	};
+	TEE_Result res = TEE_SUCCESS;
+	size_t obj_size = 0;
+	size_t chunk_size = 0;
+	size_t rep_count = 0;
+	size_t nchunks = 0;
+	size_t stride = 1;
+	uint8_t *chunk = NULL;
+	uint32_t t0 = 0;
+	uint32_t t1 = 0;
+	uint32_t t2 = 0;
+	uint32_t t3 = 0;
+	uint32_t t4 = 0;
+	size_t n = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	obj_size = params[0].value.a;
+	chunk_size = params[0].value.b;
+	rep_count = params[1].value.a;
+
+	if (!obj_size || obj_size > FS_PERF_MAX_OBJ_SIZE ||
+	    !chunk_size || chunk_size > FS_PERF_MAX_CHUNK_SIZE ||
+	    chunk_size > obj_size || obj_size % chunk_size || !rep_count)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	nchunks = obj_size / chunk_size;
+	if (params[1].value.b && nchunks > 1)
+		stride = random_stride(nchunks);
+
+	fops = tee_svc_storage_file_ops(TEE_STORAGE_PRIVATE);
+	if (!fops)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	chunk = malloc(chunk_size);
+	if (!chunk)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(chunk, 0x5a, chunk_size);
+
+	t0 = get_ms();
+
+	res = fops->create(&po, true, NULL, 0, NULL, 0, NULL, 0, &fh);
+	if (res)
+		goto out_free;
+
+	t1 = get_ms();
+
+	for (n = 0; n < rep_count; n++) {
+		res = do_chunks(fops, fh, chunk, chunk_size, nchunks, stride,
+				true /*write*/);
+		if (res)
+			goto out_close;
+	}
+
+	t2 = get_ms();
+
+	for (n = 0; n < rep_count; n++) {
+		res = do_chunks(fops, fh, chunk, chunk_size, nchunks, stride,
+				false /*read*/);
+		if (res)
+			goto out_close;
+	}
+
+	t3 = get_ms();
+
+out_close:
+	fops->close(&fh);
+	if (fops->remove(&po) && !res)
+		res = TEE_ERROR_GENERIC;
+
+	t4 = get_ms();
+
+	if (!res) {
+		params[2].value.a = t2 - t1;
+		params[2].value.b = t3 - t2;
+		params[3].value.a = t1 - t0;
+		params[3].value.b = t4 - t3;
+		IMSG("fs perf: obj %zu chunk %zu reps %zu stride %zu",
+		     obj_size, chunk_size, rep_count, stride);
+		IMSG("fs perf: create %" PRIu32 " ms write %" PRIu32
+		     " ms read %" PRIu32 " ms remove %" PRIu32 " ms",
+		     t1 - t0, t2 - t1, t3 - t2, t4 - t3);
+	}
+out_free:
+	free(chunk);
+
+	return res;
+}
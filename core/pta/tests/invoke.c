@@ -434,6 +434,10 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_lockdep_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TEST_CMD_AES_PERF:
 		return core_aes_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_FS_PERF:
+		return core_fs_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_BENCH:
+		return core_bench_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -34,4 +34,19 @@ static inline TEE_Result core_lockdep_tests(
 TEE_Result core_aes_perf_tests(uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS]);
 
+#ifdef CFG_REE_FS
+TEE_Result core_fs_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_fs_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+TEE_Result core_bench_tests(uint32_t param_types,
+			    TEE_Param params[TEE_NUM_PARAMS]);
+
 #endif /*CORE_PTA_TESTS_MISC_H*/
@@ -1,4 +1,5 @@
 srcs-$(CFG_WITH_USER_TA) += fs_htree.c
+srcs-$(CFG_REE_FS) += fs_perf.c
 srcs-y += interrupt.c
 srcs-y += invoke.c
 srcs-$(CFG_LOCKDEP) += lockdep.c
@@ -6,3 +7,4 @@ srcs-y += misc.c
 cflags-misc.c-y += -fno-builtin
 srcs-y += mutex.c
 srcs-y += aes_perf.c
+srcs-y += bench.c
@@ -17,6 +17,24 @@ struct tee_fs_dirfile_dirh {
 	int nbits;
 	bitstr_t *files;
 	size_t ndents;
+	/*
+	 * In-memory index over the dirfile, oid_hashes[n] holds a hash of
+	 * the (uuid, object id) pair stored in entry n, or 0 for a free
+	 * entry. Built lazily on the first lookup and kept coherent by
+	 * write_dent(). With the index a lookup reads one entry from
+	 * storage instead of scanning the whole dirfile.
+	 */
+	uint32_t *oid_hashes;
+	size_t nhashes;
+	bool hashes_valid;
+	/*
+	 * Mirror of the index: bit n is set when entry n holds an
+	 * object. Allocating a free entry finds the first clear bit
+	 * instead of scanning the entries. Valid when hashes_valid is
+	 * set.
+	 */
+	bitstr_t *used_ents;
+	int nent_bits;
 };
 
 struct dirfile_entry {
@@ -79,6 +97,81 @@ static bool test_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 	return false;
 }
 
+static uint32_t oid_hash(const TEE_UUID *uuid, const void *oid, size_t oidlen)
+{
+	const uint8_t *p = NULL;
+	uint32_t h = 2166136261;
+	size_t n = 0;
+
+	for (p = (const uint8_t *)uuid, n = 0; n < sizeof(*uuid); n++) {
+		h ^= p[n];
+		h *= 16777619;
+	}
+	for (p = oid, n = 0; n < oidlen; n++) {
+		h ^= p[n];
+		h *= 16777619;
+	}
+
+	/* 0 is reserved for free entries */
+	if (!h)
+		h = 1;
+
+	return h;
+}
+
+static TEE_Result maybe_grow_hashes(struct tee_fs_dirfile_dirh *dirh,
+				    size_t idx)
+{
+	void *p = NULL;
+
+	if (idx < dirh->nhashes)
+		return TEE_SUCCESS;
+
+	p = realloc(dirh->oid_hashes, (idx + 1) * sizeof(*dirh->oid_hashes));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	dirh->oid_hashes = p;
+
+	memset(dirh->oid_hashes + dirh->nhashes, 0,
+	       (idx + 1 - dirh->nhashes) * sizeof(*dirh->oid_hashes));
+	dirh->nhashes = idx + 1;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result maybe_grow_used_ents(struct tee_fs_dirfile_dirh *dirh,
+				       int idx)
+{
+	void *p = NULL;
+
+	if (idx < dirh->nent_bits)
+		return TEE_SUCCESS;
+
+	p = realloc(dirh->used_ents, bitstr_size(idx + 1));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	dirh->used_ents = p;
+
+	bit_nclear(dirh->used_ents, dirh->nent_bits, idx);
+	dirh->nent_bits = idx + 1;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Entries freed at the end of the dirfile are trimmed from the span the
+ * sweeps cover, so holes from deletions don't keep lengthening index
+ * rebuilds and enumeration over the lifetime of the device.
+ */
+static void trim_trailing_holes(struct tee_fs_dirfile_dirh *dirh)
+{
+	if (!dirh->hashes_valid)
+		return;
+
+	while (dirh->ndents && !dirh->oid_hashes[dirh->ndents - 1])
+		dirh->ndents--;
+}
+
 static TEE_Result read_dent(struct tee_fs_dirfile_dirh *dirh, int idx,
 			    struct dirfile_entry *dent)
 {
@@ -104,9 +197,51 @@ static TEE_Result write_dent(struct tee_fs_dirfile_dirh *dirh, size_t n,
 	if (!res && n >= dirh->ndents)
 		dirh->ndents = n + 1;
 
+	if (!res && dirh->hashes_valid) {
+		if (maybe_grow_hashes(dirh, n) ||
+		    maybe_grow_used_ents(dirh, n)) {
+			/* Drop the index, it's rebuilt on next lookup */
+			dirh->hashes_valid = false;
+		} else if (dent->oidlen) {
+			dirh->oid_hashes[n] = oid_hash(&dent->uuid, dent->oid,
+						       dent->oidlen);
+			bit_set(dirh->used_ents, n);
+		} else {
+			dirh->oid_hashes[n] = 0;
+			bit_clear(dirh->used_ents, n);
+			trim_trailing_holes(dirh);
+		}
+	}
+
 	return res;
 }
 
+static void build_oid_hashes(struct tee_fs_dirfile_dirh *dirh)
+{
+	struct dirfile_entry dent;
+	size_t n = 0;
+
+	if (dirh->ndents && (maybe_grow_hashes(dirh, dirh->ndents - 1) ||
+			     maybe_grow_used_ents(dirh, dirh->ndents - 1)))
+		return;
+
+	for (n = 0; n < dirh->ndents; n++) {
+		if (read_dent(dirh, n, &dent))
+			return;
+		if (dent.oidlen) {
+			dirh->oid_hashes[n] = oid_hash(&dent.uuid, dent.oid,
+						       dent.oidlen);
+			bit_set(dirh->used_ents, n);
+		} else {
+			dirh->oid_hashes[n] = 0;
+			bit_clear(dirh->used_ents, n);
+		}
+	}
+
+	dirh->hashes_valid = true;
+	trim_trailing_holes(dirh);
+}
+
 TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash,
 			       const struct tee_fs_dirfile_operations *fops,
 			       struct tee_fs_dirfile_dirh **dirh_ret)
@@ -165,6 +300,8 @@ void tee_fs_dirfile_close(struct tee_fs_dirfile_dirh *dirh)
 	if (dirh) {
 		dirh->fops->close(dirh->fh);
 		free(dirh->files);
+		free(dirh->oid_hashes);
+		free(dirh->used_ents);
 		free(dirh);
 	}
 }
@@ -203,6 +340,49 @@ TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 	int n;
 	int first_free = -1;
 
+	if (!dirh->hashes_valid)
+		build_oid_hashes(dirh);
+
+	if (dirh->hashes_valid) {
+		size_t m = 0;
+
+		if (oidlen) {
+			uint32_t h = oid_hash(uuid, oid, oidlen);
+
+			for (m = 0; m < dirh->nhashes; m++) {
+				if (dirh->oid_hashes[m] != h)
+					continue;
+				res = read_dent(dirh, m, &dent);
+				if (res)
+					return res;
+				if (dent.oidlen == oidlen &&
+				    !memcmp(&dent.uuid, uuid,
+					    sizeof(dent.uuid)) &&
+				    !memcmp(&dent.oid, oid, oidlen))
+					break;
+			}
+			if (m == dirh->nhashes)
+				return TEE_ERROR_ITEM_NOT_FOUND;
+		} else {
+			int i = 0;
+
+			bit_ffc(dirh->used_ents, dirh->nent_bits, &i);
+			if (i == -1 || (size_t)i >= dirh->nhashes)
+				m = dirh->nhashes;
+			else
+				m = i;
+			memset(&dent, 0, sizeof(dent));
+		}
+
+		if (dfh) {
+			dfh->idx = m;
+			dfh->file_number = dent.file_number;
+			memcpy(dfh->hash, dent.hash, sizeof(dent.hash));
+		}
+
+		return TEE_SUCCESS;
+	}
+
 	for (n = 0;; n++) {
 		res = read_dent(dirh, n, &dent);
 		if (res == TEE_ERROR_ITEM_NOT_FOUND && !oidlen) {
@@ -336,6 +516,70 @@ TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 	return write_dent(dirh, dfh->idx, &dent);
 }
 
+/* Number of entries transferred per read when sweeping the dirfile */
+#define SNAPSHOT_READ_DENTS	16
+
+TEE_Result tee_fs_dirfile_snapshot(struct tee_fs_dirfile_dirh *dirh,
+				   const TEE_UUID *uuid,
+				   struct tee_fs_dirent **ents, size_t *nents)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct dirfile_entry *dents = NULL;
+	struct tee_fs_dirent *e = NULL;
+	size_t nd = 0;
+	size_t pos = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	if (dirh->ndents) {
+		e = calloc(dirh->ndents, sizeof(*e));
+		dents = malloc(SNAPSHOT_READ_DENTS * sizeof(*dents));
+		if (!e || !dents) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+	}
+
+	for (pos = 0; pos < dirh->ndents; pos += n) {
+		size_t l = SNAPSHOT_READ_DENTS * sizeof(*dents);
+
+		res = dirh->fops->read(dirh->fh, pos * sizeof(*dents),
+				       dents, &l);
+		if (res)
+			goto out;
+
+		/* A trailing partial entry can't be valid, ignore it */
+		n = l / sizeof(*dents);
+		if (!n)
+			break;
+
+		for (m = 0; m < n && pos + m < dirh->ndents; m++) {
+			if (!dents[m].oidlen)
+				continue;
+			if (memcmp(&dents[m].uuid, uuid, sizeof(*uuid)))
+				continue;
+			memcpy(e[nd].oid, dents[m].oid, dents[m].oidlen);
+			e[nd].oidlen = dents[m].oidlen;
+			nd++;
+		}
+
+		if (n < SNAPSHOT_READ_DENTS)
+			break;
+	}
+
+	if (!nd) {
+		free(e);
+		e = NULL;
+	}
+	*ents = e;
+	*nents = nd;
+	e = NULL;
+out:
+	free(dents);
+	free(e);
+	return res;
+}
+
 TEE_Result tee_fs_dirfile_get_next(struct tee_fs_dirfile_dirh *dirh,
 				   const TEE_UUID *uuid, int *idx, void *oid,
 				   size_t *oidlen)
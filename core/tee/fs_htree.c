@@ -31,9 +31,30 @@
 #define NODE_ID_TO_BLOCK_NUM(id)	((id) - 1)
 
 /*
- * The hash tree is implemented as a binary tree with the purpose to ensure
- * integrity of the data in the nodes. The data in the nodes their turn
- * provides both integrity and confidentiality of the data blocks.
+ * Number of children per node. The default of 2 keeps the historical
+ * binary on-disk layout, a larger value gives a shallower tree so fewer
+ * ancestor nodes are rehashed and written back per block update. Note
+ * that changing the value changes the on-disk format incompatibly.
+ */
+#define HTREE_FANOUT			CFG_FS_HTREE_FANOUT
+
+/* Maximum node depth with the smallest fan-out and node ids < UINT_MAX */
+#define HTREE_MAX_LEVELS		32
+
+/*
+ * Nodes are numbered heap style starting with the root at 1, the
+ * children of node id are (id - 1) * HTREE_FANOUT + 2 + slot with slot
+ * in [0, HTREE_FANOUT). With a fan-out of 2 this reduces to the
+ * traditional 2 * id and 2 * id + 1 numbering.
+ */
+#define NODE_ID_PARENT(id)		(((id) - 2) / HTREE_FANOUT + 1)
+#define NODE_ID_CHILD_SLOT(id)		(((id) - 2) % HTREE_FANOUT)
+
+/*
+ * The hash tree is implemented as a tree with a configurable fan-out with
+ * the purpose to ensure integrity of the data in the nodes. The data in
+ * the nodes their turn provides both integrity and confidentiality of the
+ * data blocks.
  *
  * The hash tree is saved in a file as:
  * +----------------------------+
@@ -73,7 +94,7 @@
  */
 
 #define HTREE_NODE_COMMITTED_BLOCK	BIT32(0)
-/* n is 0 or 1 */
+/* n is in [0, HTREE_FANOUT) */
 #define HTREE_NODE_COMMITTED_CHILD(n)	BIT32(1 + (n))
 
 struct htree_node {
@@ -82,7 +103,7 @@ struct htree_node {
 	bool block_updated;
 	struct tee_fs_htree_node_image node;
 	struct htree_node *parent;
-	struct htree_node *child[2];
+	struct htree_node *child[HTREE_FANOUT];
 };
 
 struct tee_fs_htree {
@@ -94,6 +115,12 @@ struct tee_fs_htree {
 	const TEE_UUID *uuid;
 	const struct tee_fs_htree_storage *stor;
 	void *stor_aux;
+	/*
+	 * Authenc context kept for the lifetime of the tree. All
+	 * operations use the same FEK so reusing the context lets the
+	 * crypto layer keep the expanded key schedule across blocks.
+	 */
+	void *crypt_ctx;
 };
 
 struct traverse_arg;
@@ -178,6 +205,7 @@ static TEE_Result traverse_post_order(struct traverse_arg *targ,
 				      struct htree_node *node)
 {
 	TEE_Result res;
+	size_t n;
 
 	/*
 	 * This function is recursing but not very deep, only with Log(N)
@@ -187,13 +215,11 @@ static TEE_Result traverse_post_order(struct traverse_arg *targ,
 	if (!node)
 		return TEE_SUCCESS;
 
-	res = traverse_post_order(targ, node->child[0]);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	res = traverse_post_order(targ, node->child[1]);
-	if (res != TEE_SUCCESS)
-		return res;
+	for (n = 0; n < HTREE_FANOUT; n++) {
+		res = traverse_post_order(targ, node->child[n]);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
 
 	return targ->cb(targ, node);
 }
@@ -206,34 +232,29 @@ static TEE_Result htree_traverse_post_order(struct tee_fs_htree *ht,
 	return traverse_post_order(&targ, &ht->root);
 }
 
-static size_t node_id_to_level(size_t node_id)
-{
-	assert(node_id && node_id < UINT_MAX);
-	/* Calculate level of the node, root node (1) has level 1 */
-	return sizeof(unsigned int) * 8 - __builtin_clz(node_id);
-}
-
 static struct htree_node *find_closest_node(struct tee_fs_htree *ht,
 					    size_t node_id)
 {
 	struct htree_node *node = &ht->root;
-	size_t level = node_id_to_level(node_id);
+	size_t path[HTREE_MAX_LEVELS];
+	size_t level = 0;
+	size_t id = node_id;
 	size_t n;
 
-	/* n = 1 because root node is level 1 */
-	for (n = 1; n < level; n++) {
-		struct htree_node *child;
-		size_t bit_idx;
+	assert(node_id && node_id < UINT_MAX);
+
+	/* Record the child slots leading from node_id up to the root */
+	while (id > 1) {
+		assert(level < HTREE_MAX_LEVELS);
+		path[level] = NODE_ID_CHILD_SLOT(id);
+		id = NODE_ID_PARENT(id);
+		level++;
+	}
+
+	/* Follow the recorded slots from the root towards node_id */
+	for (n = level; n; n--) {
+		struct htree_node *child = node->child[path[n - 1]];
 
-		/*
-		 * The difference between levels of the current node and
-		 * the node we're looking for tells which bit decides
-		 * direction in the tree.
-		 *
-		 * As the first bit has index 0 we'll subtract 1
-		 */
-		bit_idx = level - n - 1;
-		child = node->child[((node_id >> bit_idx) & 1)];
 		if (!child)
 			return node;
 		node = child;
@@ -280,15 +301,15 @@ static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 		if (node->id == n)
 			continue;
 		/* Node id n should be a child of node */
-		assert((n >> 1) == node->id);
-		assert(!node->child[n & 1]);
+		assert(NODE_ID_PARENT(n) == node->id);
+		assert(!node->child[NODE_ID_CHILD_SLOT(n)]);
 
 		nc = calloc(1, sizeof(*nc));
 		if (!nc)
 			return TEE_ERROR_OUT_OF_MEMORY;
 		nc->id = n;
 		nc->parent = node;
-		node->child[n & 1] = nc;
+		node->child[NODE_ID_CHILD_SLOT(n)] = nc;
 		node = nc;
 	}
 
@@ -365,35 +386,109 @@ static TEE_Result init_head_from_data(struct tee_fs_htree *ht,
 	return TEE_SUCCESS;
 }
 
+static bool stor_has_node_blks(const struct tee_fs_htree_storage *stor)
+{
+	return stor->nodes_per_block && stor->rpc_node_blk_read_init &&
+	       stor->rpc_node_blk_write_init;
+}
+
+static TEE_Result read_node_blk(struct tee_fs_htree *ht, size_t bnum,
+				uint8_t *blk, size_t blen)
+{
+	struct tee_fs_rpc_operation op = { };
+	TEE_Result res;
+	size_t bytes = 0;
+	void *p = NULL;
+
+	res = ht->stor->rpc_node_blk_read_init(ht->stor_aux, &op, bnum, &p);
+	if (res != TEE_SUCCESS)
+		return res;
+	res = ht->stor->rpc_read_final(&op, &bytes);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/*
+	 * The block may be short if the last node slots never have been
+	 * written. Missing slots within max_node_id read as zero and are
+	 * caught by the hash verification.
+	 */
+	memcpy(blk, p, MIN(bytes, blen));
+	if (bytes < blen)
+		memset(blk + bytes, 0, blen - bytes);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
 {
+	const size_t node_size = sizeof(struct tee_fs_htree_node_image);
+	size_t npb = ht->stor->nodes_per_block;
 	TEE_Result res;
 	struct tee_fs_htree_node_image node_image;
 	struct htree_node *node;
 	struct htree_node *nc;
 	size_t committed_version;
 	size_t node_id = 2;
+	size_t blk_bnum = SIZE_MAX;
+	uint8_t *blk = NULL;
+
+	/*
+	 * Nodes are read a whole physical block at a time when the
+	 * storage supports it, turning the O(nodes) read RPCs of opening
+	 * a large object into O(node blocks). Failing that, or on any
+	 * block read error, the per-node reads are used.
+	 */
+	if (stor_has_node_blks(ht->stor))
+		blk = malloc(npb * 2 * node_size);
 
 	while (node_id <= ht->imeta.max_node_id) {
-		node = find_node(ht, node_id >> 1);
-		if (!node)
-			return TEE_ERROR_GENERIC;
+		node = find_node(ht, NODE_ID_PARENT(node_id));
+		if (!node) {
+			res = TEE_ERROR_GENERIC;
+			goto out;
+		}
 		committed_version = !!(node->node.flags &
-				    HTREE_NODE_COMMITTED_CHILD(node_id & 1));
+				    HTREE_NODE_COMMITTED_CHILD(
+						NODE_ID_CHILD_SLOT(node_id)));
+
+		if (blk) {
+			size_t bnum = (node_id - 1) / npb;
+
+			if (bnum != blk_bnum) {
+				res = read_node_blk(ht, bnum, blk,
+						    npb * 2 * node_size);
+				if (res != TEE_SUCCESS) {
+					free(blk);
+					blk = NULL;
+				} else {
+					blk_bnum = bnum;
+				}
+			}
+		}
 
-		res = rpc_read_node(ht, node_id, committed_version,
-				    &node_image);
-		if (res != TEE_SUCCESS)
-			return res;
+		if (blk) {
+			size_t offs = ((node_id - 1) % npb) * 2 * node_size +
+				      committed_version * node_size;
+
+			memcpy(&node_image, blk + offs, node_size);
+		} else {
+			res = rpc_read_node(ht, node_id, committed_version,
+					    &node_image);
+			if (res != TEE_SUCCESS)
+				goto out;
+		}
 
 		res = get_node(ht, true, node_id, &nc);
 		if (res != TEE_SUCCESS)
-			return res;
+			goto out;
 		nc->node = node_image;
 		node_id++;
 	}
 
-	return TEE_SUCCESS;
+	res = TEE_SUCCESS;
+out:
+	free(blk);
+	return res;
 }
 
 static TEE_Result calc_node_hash(struct htree_node *node,
@@ -403,6 +498,7 @@ static TEE_Result calc_node_hash(struct htree_node *node,
 	TEE_Result res;
 	uint8_t *ndata = (uint8_t *)&node->node + sizeof(node->node.hash);
 	size_t nsize = sizeof(node->node) - sizeof(node->node.hash);
+	size_t n;
 
 	res = crypto_hash_init(ctx);
 	if (res != TEE_SUCCESS)
@@ -418,16 +514,11 @@ static TEE_Result calc_node_hash(struct htree_node *node,
 			return res;
 	}
 
-	if (node->child[0]) {
-		res = crypto_hash_update(ctx, node->child[0]->node.hash,
-					 sizeof(node->child[0]->node.hash));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
-
-	if (node->child[1]) {
-		res = crypto_hash_update(ctx, node->child[1]->node.hash,
-					 sizeof(node->child[1]->node.hash));
+	for (n = 0; n < HTREE_FANOUT; n++) {
+		if (!node->child[n])
+			continue;
+		res = crypto_hash_update(ctx, node->child[n]->node.hash,
+					 sizeof(node->child[n]->node.hash));
 		if (res != TEE_SUCCESS)
 			return res;
 	}
@@ -459,15 +550,18 @@ static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 			return res;
 	}
 
-	res = crypto_authenc_alloc_ctx(&ctx, alg);
-	if (res != TEE_SUCCESS)
-		return res;
+	if (!ht->crypt_ctx) {
+		res = crypto_authenc_alloc_ctx(&ht->crypt_ctx, alg);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+	ctx = ht->crypt_ctx;
 
 	res = crypto_authenc_init(ctx, mode, ht->fek, TEE_FS_HTREE_FEK_SIZE, iv,
 				  TEE_FS_HTREE_IV_SIZE, TEE_FS_HTREE_TAG_SIZE,
 				  aad_len, payload_len);
 	if (res != TEE_SUCCESS)
-		goto err_free;
+		return res;
 
 	if (!ni) {
 		res = crypto_authenc_update_aad(ctx, mode, ht->root.node.hash,
@@ -496,8 +590,6 @@ static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 	return TEE_SUCCESS;
 err:
 	crypto_authenc_final(ctx);
-err_free:
-	crypto_authenc_free_ctx(ctx);
 	return res;
 }
 
@@ -511,7 +603,6 @@ static TEE_Result authenc_decrypt_final(void *ctx, const uint8_t *tag,
 	res = crypto_authenc_dec_final(ctx, crypt, len, plain, &out_size, tag,
 				       TEE_FS_HTREE_TAG_SIZE);
 	crypto_authenc_final(ctx);
-	crypto_authenc_free_ctx(ctx);
 
 	if (res == TEE_SUCCESS && out_size != len)
 		return TEE_ERROR_GENERIC;
@@ -532,7 +623,6 @@ static TEE_Result authenc_encrypt_final(void *ctx, uint8_t *tag,
 	res = crypto_authenc_enc_final(ctx, plain, len, crypt, &out_size, tag,
 				       &out_tag_size);
 	crypto_authenc_final(ctx);
-	crypto_authenc_free_ctx(ctx);
 
 	if (res == TEE_SUCCESS &&
 	    (out_size != len || out_tag_size != TEE_FS_HTREE_TAG_SIZE))
@@ -618,6 +708,9 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, const TEE_UUID *uuid,
 	TEE_Result res;
 	struct tee_fs_htree *ht = calloc(1, sizeof(*ht));
 
+	/* The committed child flags must fit in the node image flags field */
+	COMPILE_TIME_ASSERT(HTREE_FANOUT >= 2 && HTREE_FANOUT <= 8);
+
 	if (!ht)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -693,13 +786,157 @@ void tee_fs_htree_close(struct tee_fs_htree **ht)
 	if (!*ht)
 		return;
 	htree_traverse_post_order(*ht, free_node, NULL);
+	if ((*ht)->crypt_ctx)
+		crypto_authenc_free_ctx((*ht)->crypt_ctx);
 	free(*ht);
 	*ht = NULL;
 }
 
+/*
+ * Dirty nodes found while traversing the tree during sync are collected
+ * here and written out in batches of whole physical node blocks when the
+ * storage supports it, one read-modify-write RPC pair per block instead
+ * of one write RPC per node.
+ */
+struct htree_sync_ctx {
+	void *hash_ctx;
+	struct htree_node **nodes;
+	uint8_t *vers;
+	size_t num;
+	size_t alloced;
+};
+
+static TEE_Result sync_ctx_add(struct htree_sync_ctx *sctx,
+			       struct htree_node *node, uint8_t vers)
+{
+	if (sctx->num == sctx->alloced) {
+		size_t na = MAX(sctx->alloced * 2, (size_t)16);
+		struct htree_node **nn = NULL;
+		uint8_t *nv = NULL;
+
+		nn = realloc(sctx->nodes, na * sizeof(*nn));
+		if (!nn)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		sctx->nodes = nn;
+		nv = realloc(sctx->vers, na * sizeof(*nv));
+		if (!nv)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		sctx->vers = nv;
+		sctx->alloced = na;
+	}
+
+	sctx->nodes[sctx->num] = node;
+	sctx->vers[sctx->num] = vers;
+	sctx->num++;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sync_node_blk(struct tee_fs_htree *ht,
+				struct htree_sync_ctx *sctx,
+				size_t first, size_t last)
+{
+	const size_t node_size = sizeof(struct tee_fs_htree_node_image);
+	size_t npb = ht->stor->nodes_per_block;
+	size_t bnum = (sctx->nodes[first]->id - 1) / npb;
+	size_t blen = npb * 2 * node_size;
+	struct tee_fs_rpc_operation op = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *blk = NULL;
+	void *p = NULL;
+	size_t bytes = 0;
+	size_t n = 0;
+
+	/* A single node is written more cheaply with a direct write */
+	if (last - first == 1)
+		goto fallback;
+
+	blk = malloc(blen);
+	if (!blk)
+		goto fallback;
+
+	res = ht->stor->rpc_node_blk_read_init(ht->stor_aux, &op, bnum, &p);
+	if (res != TEE_SUCCESS)
+		goto fallback;
+	res = ht->stor->rpc_read_final(&op, &bytes);
+	if (res != TEE_SUCCESS)
+		goto fallback;
+	/* The block may not be fully populated in storage yet */
+	memcpy(blk, p, MIN(bytes, blen));
+	if (bytes < blen)
+		memset(blk + bytes, 0, blen - bytes);
+
+	for (n = first; n < last; n++) {
+		size_t offs = ((sctx->nodes[n]->id - 1) % npb) * 2 *
+			      node_size + sctx->vers[n] * node_size;
+
+		memcpy(blk + offs, &sctx->nodes[n]->node, node_size);
+	}
+
+	res = ht->stor->rpc_node_blk_write_init(ht->stor_aux, &op, bnum, &p);
+	if (res != TEE_SUCCESS)
+		goto fallback;
+	memcpy(p, blk, blen);
+	res = ht->stor->rpc_write_final(&op);
+	if (res != TEE_SUCCESS)
+		goto fallback;
+
+	free(blk);
+	return TEE_SUCCESS;
+
+fallback:
+	free(blk);
+	for (n = first; n < last; n++) {
+		res = rpc_write_node(ht, sctx->nodes[n]->id, sctx->vers[n],
+				     &sctx->nodes[n]->node);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result write_dirty_nodes(struct tee_fs_htree *ht,
+				    struct htree_sync_ctx *sctx)
+{
+	size_t npb = ht->stor->nodes_per_block;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+	size_t m = 0;
+
+	/* Sort by node id to group nodes stored in the same block */
+	for (n = 1; n < sctx->num; n++) {
+		struct htree_node *node = sctx->nodes[n];
+		uint8_t vers = sctx->vers[n];
+
+		for (m = n; m && sctx->nodes[m - 1]->id > node->id; m--) {
+			sctx->nodes[m] = sctx->nodes[m - 1];
+			sctx->vers[m] = sctx->vers[m - 1];
+		}
+		sctx->nodes[m] = node;
+		sctx->vers[m] = vers;
+	}
+
+	n = 0;
+	while (n < sctx->num) {
+		m = n + 1;
+		while (m < sctx->num &&
+		       (sctx->nodes[m]->id - 1) / npb ==
+		       (sctx->nodes[n]->id - 1) / npb)
+			m++;
+		res = sync_node_blk(ht, sctx, n, m);
+		if (res != TEE_SUCCESS)
+			return res;
+		n = m;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 					     struct htree_node *node)
 {
+	struct htree_sync_ctx *sctx = targ->arg;
 	TEE_Result res;
 	uint8_t vers;
 	struct tee_fs_htree_meta *meta = NULL;
@@ -715,7 +952,8 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 		return TEE_SUCCESS;
 
 	if (node->parent) {
-		uint32_t f = HTREE_NODE_COMMITTED_CHILD(node->id & 1);
+		uint32_t f = HTREE_NODE_COMMITTED_CHILD(
+					NODE_ID_CHILD_SLOT(node->id));
 
 		node->parent->dirty = true;
 		node->parent->node.flags ^= f;
@@ -729,13 +967,16 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 		meta = &targ->ht->imeta.meta;
 	}
 
-	res = calc_node_hash(node, meta, targ->arg, node->node.hash);
+	res = calc_node_hash(node, meta, sctx->hash_ctx, node->node.hash);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	node->dirty = false;
 	node->block_updated = false;
 
+	if (stor_has_node_blks(targ->ht->stor))
+		return sync_ctx_add(sctx, node, vers);
+
 	return rpc_write_node(targ->ht, node->id, vers, &node->node);
 }
 
@@ -759,7 +1000,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 {
 	TEE_Result res;
 	struct tee_fs_htree *ht = *ht_arg;
-	void *ctx;
+	struct htree_sync_ctx sctx = { };
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -767,14 +1008,20 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (!ht->dirty)
 		return TEE_SUCCESS;
 
-	res = crypto_hash_alloc_ctx(&ctx, TEE_FS_HTREE_HASH_ALG);
+	res = crypto_hash_alloc_ctx(&sctx.hash_ctx, TEE_FS_HTREE_HASH_ALG);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, ctx);
+	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, &sctx);
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	if (sctx.num) {
+		res = write_dirty_nodes(ht, &sctx);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
 	/* All the nodes are written to storage now. Time to update root. */
 	res = update_root(ht);
 	if (res != TEE_SUCCESS)
@@ -788,7 +1035,9 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (hash)
 		memcpy(hash, ht->root.node.hash, sizeof(ht->root.node.hash));
 out:
-	crypto_hash_free_ctx(ctx);
+	crypto_hash_free_ctx(sctx.hash_ctx);
+	free(sctx.nodes);
+	free(sctx.vers);
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
 	return res;
@@ -904,11 +1153,60 @@ out:
 	return res;
 }
 
+TEE_Result tee_fs_htree_get_block_vers(struct tee_fs_htree **ht_arg,
+				       size_t block_num, uint8_t *vers)
+{
+	struct tee_fs_htree *ht = *ht_arg;
+	TEE_Result res;
+	struct htree_node *node;
+
+	if (!ht)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	res = get_block_node(ht, false, block_num, &node);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	*vers = !!(node->node.flags & HTREE_NODE_COMMITTED_BLOCK);
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_fs_htree_dec_block(struct tee_fs_htree **ht_arg,
+				  size_t block_num, const void *enc_block,
+				  void *block)
+{
+	struct tee_fs_htree *ht = *ht_arg;
+	TEE_Result res;
+	struct htree_node *node;
+	void *ctx;
+
+	if (!ht)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	res = get_block_node(ht, false, block_num, &node);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, &node->node,
+			   ht->stor->block_size);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = authenc_decrypt_final(ctx, node->node.tag, enc_block,
+				    ht->stor->block_size, block);
+out:
+	if (res != TEE_SUCCESS)
+		tee_fs_htree_close(ht_arg);
+	return res;
+}
+
 TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 {
 	struct tee_fs_htree *ht = *ht_arg;
 	size_t node_id = BLOCK_NUM_TO_NODE_ID(block_num);
 	struct htree_node *node;
+	size_t n;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -916,10 +1214,12 @@ TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 	while (node_id < ht->imeta.max_node_id) {
 		node = find_closest_node(ht, ht->imeta.max_node_id);
 		assert(node && node->id == ht->imeta.max_node_id);
-		assert(!node->child[0] && !node->child[1]);
+		for (n = 0; n < HTREE_FANOUT; n++)
+			assert(!node->child[n]);
 		assert(node->parent);
-		assert(node->parent->child[node->id & 1] == node);
-		node->parent->child[node->id & 1] = NULL;
+		assert(node->parent->child[NODE_ID_CHILD_SLOT(node->id)] ==
+		       node);
+		node->parent->child[NODE_ID_CHILD_SLOT(node->id)] = NULL;
 		free(node);
 		ht->imeta.max_node_id--;
 		ht->dirty = true;
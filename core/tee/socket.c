@@ -10,6 +10,7 @@
 #include <pta_socket.h>
 #include <string.h>
 #include <tee/tee_fs_rpc.h>
+#include <util.h>
 
 static uint32_t get_instance_id(struct ts_session *sess)
 {
@@ -161,6 +162,103 @@ static TEE_Result socket_recv(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
+static TEE_Result socket_sendv(uint32_t instance_id, uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct mobj *mobj;
+	TEE_Result res;
+	size_t sz = 0;
+	uint8_t *va;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (ADD_OVERFLOW(params[1].memref.size, params[2].memref.size, &sz))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_SOCKET,
+					THREAD_SHM_TYPE_APPLICATION, sz, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	memcpy(va, params[1].memref.buffer, params[1].memref.size);
+	memcpy(va + params[1].memref.size, params[2].memref.buffer,
+	       params[2].memref.size);
+
+	struct thread_param tpm[3] = {
+		[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_SEND, instance_id,
+					 params[0].value.a /* handle */),
+		[1] = THREAD_PARAM_MEMREF(IN, mobj, 0, sz),
+		[2] = THREAD_PARAM_VALUE(INOUT, params[0].value.b, /* timeout */
+					 0, 0),
+	};
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 3, tpm);
+	params[3].value.a = tpm[2].u.value.b; /* transmitted bytes */
+
+	return res;
+}
+
+static TEE_Result socket_recvv(uint32_t instance_id, uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct mobj *mobj;
+	TEE_Result res;
+	size_t sz = 0;
+	size_t n = 0;
+	uint8_t *va;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (ADD_OVERFLOW(params[1].memref.size, params[2].memref.size, &sz))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_SOCKET,
+					THREAD_SHM_TYPE_APPLICATION, sz, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	struct thread_param tpm[3] = {
+		[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_RECV, instance_id,
+					 params[0].value.a /* handle */),
+		[1] = THREAD_PARAM_MEMREF(OUT, mobj, 0, sz),
+		[2] = THREAD_PARAM_VALUE(IN, params[0].value.b /* timeout */,
+					 0, 0),
+	};
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 3, tpm);
+
+	if (tpm[1].u.memref.size > sz)
+		return TEE_ERROR_GENERIC;
+
+	/* Scatter the received bytes over the two supplied buffers */
+	n = MIN(tpm[1].u.memref.size, (size_t)params[1].memref.size);
+	if (n)
+		memcpy(params[1].memref.buffer, va, n);
+	params[1].memref.size = n;
+	n = tpm[1].u.memref.size - n;
+	if (n)
+		memcpy(params[2].memref.buffer, va + params[1].memref.size, n);
+	params[2].memref.size = n;
+
+	return res;
+}
+
 static TEE_Result socket_ioctl(uint32_t instance_id, uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -215,6 +313,8 @@ static const ta_func ta_funcs[] = {
 	[PTA_SOCKET_SEND] = socket_send,
 	[PTA_SOCKET_RECV] = socket_recv,
 	[PTA_SOCKET_IOCTL] = socket_ioctl,
+	[PTA_SOCKET_SENDV] = socket_sendv,
+	[PTA_SOCKET_RECVV] = socket_recvv,
 };
 
 /*
@@ -7,6 +7,7 @@
 #include <bitstring.h>
 #include <crypto/crypto.h>
 #include <kernel/mutex.h>
+#include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <mm/mobj.h>
 #include <optee_rpc_cmd.h>
@@ -21,6 +22,7 @@
 #include <utee_defines.h>
 
 #define TADB_MAX_BUFFER_SIZE	(64U * 1024)
+#define TADB_DEDUP_BUFFER_SIZE	(4U * 1024)
 
 #define TADB_AUTH_ENC_ALG	TEE_ALG_AES_GCM
 #define TADB_IV_SIZE		TEE_AES_BLOCK_SIZE
@@ -61,6 +63,17 @@ struct tee_tadb_ta_write {
 	struct tadb_entry entry;
 	size_t pos;
 	void *ctx;
+	/*
+	 * When replacing a TA with one of identical size the incoming data
+	 * is first compared against the old image. If the content turns
+	 * out to be unchanged the old encrypted file and entry are kept
+	 * as is and nothing is written. While @dedup is true no new file
+	 * has been created yet and @fd is -1.
+	 */
+	bool dedup;
+	struct tadb_entry old_ent;
+	int old_fd;
+	void *old_ctx;
 };
 
 struct tee_tadb_ta_read {
@@ -78,6 +91,24 @@ static struct tee_tadb_dir *tadb_db;
 static unsigned int tadb_db_refc;
 static struct mutex tadb_mutex = MUTEX_INITIALIZER;
 
+/*
+ * Cache of recently looked up entries. TA opens tend to hit the same
+ * UUIDs repeatedly during session churn and a hit here saves scanning
+ * the database on storage. Slots are replaced round robin and
+ * invalidated by index when an entry is written. find_ent() is called
+ * with tadb_mutex held for reading only, so the cache has its own
+ * spinlock to let concurrent readers update it safely.
+ */
+#define TADB_ENT_CACHE_SIZE	4
+
+static struct tadb_ent_cache {
+	bool valid;
+	size_t idx;
+	struct tadb_entry entry;
+} tadb_ent_cache[TADB_ENT_CACHE_SIZE];
+static size_t tadb_ent_cache_next;
+static unsigned int tadb_ent_cache_lock = SPINLOCK_UNLOCK;
+
 static void file_num_to_str(char *buf, size_t blen, uint32_t file_number)
 {
 	snprintf(buf, blen, "%" PRIu32 ".ta", file_number);
@@ -193,14 +224,68 @@ static TEE_Result read_ent(struct tee_tadb_dir *db, size_t idx,
 	return res;
 }
 
+static bool ent_cache_find(const TEE_UUID *uuid, size_t *idx,
+			   struct tadb_entry *entry)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&tadb_ent_cache_lock);
+	bool found = false;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tadb_ent_cache); n++) {
+		if (tadb_ent_cache[n].valid &&
+		    !memcmp(&tadb_ent_cache[n].entry.prop.uuid, uuid,
+			    sizeof(*uuid))) {
+			*idx = tadb_ent_cache[n].idx;
+			if (entry)
+				*entry = tadb_ent_cache[n].entry;
+			found = true;
+			break;
+		}
+	}
+
+	cpu_spin_unlock_xrestore(&tadb_ent_cache_lock, exceptions);
+
+	return found;
+}
+
+static void ent_cache_insert(size_t idx, const struct tadb_entry *entry)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&tadb_ent_cache_lock);
+
+	tadb_ent_cache[tadb_ent_cache_next].valid = true;
+	tadb_ent_cache[tadb_ent_cache_next].idx = idx;
+	tadb_ent_cache[tadb_ent_cache_next].entry = *entry;
+	tadb_ent_cache_next = (tadb_ent_cache_next + 1) %
+			      ARRAY_SIZE(tadb_ent_cache);
+
+	cpu_spin_unlock_xrestore(&tadb_ent_cache_lock, exceptions);
+}
+
+static void ent_cache_invalidate(size_t idx)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&tadb_ent_cache_lock);
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tadb_ent_cache); n++)
+		if (tadb_ent_cache[n].idx == idx)
+			tadb_ent_cache[n].valid = false;
+
+	cpu_spin_unlock_xrestore(&tadb_ent_cache_lock, exceptions);
+}
+
 static TEE_Result write_ent(struct tee_tadb_dir *db, size_t idx,
 			    const struct tadb_entry *entry)
 {
 	const size_t l = sizeof(*entry);
 
+	ent_cache_invalidate(idx);
+
 	return db->ops->write(db->fh, idx * l, entry, l);
 }
 
+static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
+			   size_t *idx_ret, struct tadb_entry *entry_ret);
+
 static TEE_Result tadb_open(struct tee_tadb_dir **db_ret)
 {
 	TEE_Result res;
@@ -233,8 +318,8 @@ static TEE_Result tee_tadb_open(struct tee_tadb_dir **db)
 	TEE_Result res = TEE_SUCCESS;
 
 	mutex_lock(&tadb_mutex);
-	if (!tadb_db_refc) {
-		assert(!tadb_db);
+	if (!tadb_db) {
+		assert(!tadb_db_refc);
 		res = tadb_open(&tadb_db);
 		if (res)
 			goto err;
@@ -251,13 +336,12 @@ static void tadb_put(struct tee_tadb_dir *db)
 	assert(db == tadb_db);
 	mutex_lock(&tadb_mutex);
 	assert(tadb_db_refc);
+	/*
+	 * Keep the database open when the last reference is dropped. TA
+	 * lookups come in bursts during session churn and reopening means
+	 * re-reading and verifying the hash tree of the backing file.
+	 */
 	tadb_db_refc--;
-	if (!tadb_db_refc) {
-		db->ops->close(&db->fh);
-		free(db->files);
-		free(db);
-		tadb_db = NULL;
-	}
 	mutex_unlock(&tadb_mutex);
 }
 
@@ -360,6 +444,193 @@ err:
 	return res;
 }
 
+static size_t entry_enc_size(const struct tadb_entry *entry)
+{
+	return entry->prop.custom_size + entry->prop.bin_size;
+}
+
+/*
+ * If there's an old version of the TA with the same size, open it and
+ * prepare to compare it against the incoming data instead of writing a
+ * new file right away. Failure to set this up isn't an error, the TA is
+ * then simply written the regular way.
+ */
+static void tadb_dedup_init(struct tee_tadb_ta_write *ta)
+{
+	TEE_Result res;
+	size_t idx;
+
+	if (!entry_enc_size(&ta->entry))
+		return;
+
+	mutex_read_lock(&tadb_mutex);
+	res = find_ent(ta->db, &ta->entry.prop.uuid, &idx, &ta->old_ent);
+	mutex_read_unlock(&tadb_mutex);
+	if (res)
+		return;
+
+	if (entry_enc_size(&ta->old_ent) != entry_enc_size(&ta->entry))
+		return;
+
+	if (ta_operation_open(OPTEE_RPC_FS_OPEN, ta->old_ent.file_number,
+			      &ta->old_fd)) {
+		ta->old_fd = -1;
+		return;
+	}
+
+	if (tadb_authenc_init(TEE_MODE_DECRYPT, &ta->old_ent, &ta->old_ctx)) {
+		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->old_fd);
+		ta->old_fd = -1;
+		return;
+	}
+
+	ta->dedup = true;
+}
+
+static void tadb_dedup_release(struct tee_tadb_ta_write *ta)
+{
+	ta->dedup = false;
+	if (ta->old_fd != -1) {
+		crypto_authenc_free_ctx(ta->old_ctx);
+		ta->old_ctx = NULL;
+		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->old_fd);
+		ta->old_fd = -1;
+	}
+}
+
+/*
+ * Compare the incoming data against the old image at ta->pos. Returns
+ * via @matched how many leading bytes were equal, a partial match means
+ * the content differs. Errors from the compare itself aren't fatal, the
+ * caller falls back to writing the regular way.
+ */
+static TEE_Result tadb_dedup_compare(struct tee_tadb_ta_write *ta,
+				     const uint8_t *rb, size_t rl,
+				     size_t *matched)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_fs_rpc_operation op;
+	uint8_t *dec = malloc(TADB_DEDUP_BUFFER_SIZE);
+
+	*matched = 0;
+	if (!dec)
+		return TEE_SUCCESS;
+
+	while (*matched < rl) {
+		size_t l = MIN(rl - *matched, (size_t)TADB_DEDUP_BUFFER_SIZE);
+		size_t out = 0;
+		void *cb;
+
+		res = tee_fs_rpc_read_init(&op, OPTEE_RPC_CMD_FS, ta->old_fd,
+					   ta->pos + *matched, l, &cb);
+		if (res)
+			break;
+		res = tee_fs_rpc_read_final(&op, &out);
+		if (res || out != l)
+			break;
+
+		res = tadb_update_payload(ta->old_ctx, TEE_MODE_DECRYPT,
+					  cb, l, dec);
+		if (res)
+			break;
+
+		if (memcmp(dec, rb + *matched, l))
+			break;
+
+		*matched += l;
+	}
+
+	free(dec);
+	/* A failed compare only means the match stops here */
+	return TEE_SUCCESS;
+}
+
+/*
+ * The incoming data turned out to differ from the old image. Create the
+ * new file and replay the matched prefix [0, ta->pos) from the old file
+ * through the new encryption context. The old image is pulled through a
+ * fresh decryption context in its entirety and the tag verified, so
+ * normal world can't substitute the content between the compare above
+ * and this second read.
+ */
+static TEE_Result tadb_dedup_abandon(struct tee_tadb_ta_write *ta)
+{
+	TEE_Result res;
+	const size_t enc_size = entry_enc_size(&ta->old_ent);
+	struct tee_fs_rpc_operation op;
+	uint8_t *dec = NULL;
+	void *ctx = NULL;
+	size_t dl = 0;
+	size_t pos = 0;
+
+	res = ta_operation_open(OPTEE_RPC_FS_CREATE, ta->entry.file_number,
+				&ta->fd);
+	if (res)
+		goto out;
+
+	dec = malloc(TADB_DEDUP_BUFFER_SIZE);
+	if (!dec) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	res = tadb_authenc_init(TEE_MODE_DECRYPT, &ta->old_ent, &ctx);
+	if (res)
+		goto out;
+
+	while (pos < enc_size) {
+		size_t l = MIN(enc_size - pos, (size_t)TADB_DEDUP_BUFFER_SIZE);
+		size_t out = 0;
+		void *cb;
+		void *wb;
+
+		res = tee_fs_rpc_read_init(&op, OPTEE_RPC_CMD_FS, ta->old_fd,
+					   pos, l, &cb);
+		if (res)
+			goto out;
+		res = tee_fs_rpc_read_final(&op, &out);
+		if (res)
+			goto out;
+		if (out != l) {
+			res = TEE_ERROR_CORRUPT_OBJECT;
+			goto out;
+		}
+
+		res = tadb_update_payload(ctx, TEE_MODE_DECRYPT, cb, l, dec);
+		if (res)
+			goto out;
+
+		if (pos < ta->pos) {
+			size_t wl = MIN(l, ta->pos - pos);
+
+			res = tee_fs_rpc_write_init(&op, OPTEE_RPC_CMD_FS,
+						    ta->fd, pos, wl, &wb);
+			if (res)
+				goto out;
+			res = tadb_update_payload(ta->ctx, TEE_MODE_ENCRYPT,
+						  dec, wl, wb);
+			if (res)
+				goto out;
+			res = tee_fs_rpc_write_final(&op);
+			if (res)
+				goto out;
+		}
+
+		pos += l;
+	}
+
+	res = crypto_authenc_dec_final(ctx, NULL, 0, NULL, &dl,
+				       ta->old_ent.tag, TADB_TAG_SIZE);
+out:
+	if (ctx) {
+		crypto_authenc_final(ctx);
+		crypto_authenc_free_ctx(ctx);
+	}
+	free(dec);
+	tadb_dedup_release(ta);
+	return res;
+}
+
 TEE_Result tee_tadb_ta_create(const struct tee_tadb_property *property,
 			      struct tee_tadb_ta_write **ta_ret)
 {
@@ -373,6 +644,8 @@ TEE_Result tee_tadb_ta_create(const struct tee_tadb_property *property,
 	ta = calloc(1, sizeof(*ta));
 	if (!ta)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	ta->fd = -1;
+	ta->old_fd = -1;
 
 	res = tee_tadb_open(&ta->db);
 	if (res)
@@ -411,10 +684,14 @@ TEE_Result tee_tadb_ta_create(const struct tee_tadb_property *property,
 	if (res)
 		goto err_put;
 
-	res = ta_operation_open(OPTEE_RPC_FS_CREATE, ta->entry.file_number,
-				&ta->fd);
-	if (res)
-		goto err_put;
+	tadb_dedup_init(ta);
+
+	if (!ta->dedup) {
+		res = ta_operation_open(OPTEE_RPC_FS_CREATE,
+					ta->entry.file_number, &ta->fd);
+		if (res)
+			goto err_put;
+	}
 
 	res = tadb_authenc_init(TEE_MODE_ENCRYPT, &ta->entry, &ta->ctx);
 	if (res)
@@ -427,6 +704,7 @@ TEE_Result tee_tadb_ta_create(const struct tee_tadb_property *property,
 err_mutex:
 	mutex_unlock(&tadb_mutex);
 err_put:
+	tadb_dedup_release(ta);
 	tadb_put(ta->db);
 err_free:
 	free(ta);
@@ -442,6 +720,25 @@ TEE_Result tee_tadb_ta_write(struct tee_tadb_ta_write *ta, const void *buf,
 	size_t rl = len;
 	struct tee_fs_rpc_operation op;
 
+	if (ta->dedup) {
+		size_t matched = 0;
+
+		res = tadb_dedup_compare(ta, rb, rl, &matched);
+		if (res)
+			return res;
+
+		ta->pos += matched;
+		rb += matched;
+		rl -= matched;
+		if (!rl)
+			return TEE_SUCCESS;
+
+		/* Content differs, switch to writing a new file */
+		res = tadb_dedup_abandon(ta);
+		if (res)
+			return res;
+	}
+
 	while (rl) {
 		size_t wl = MIN(rl, TADB_MAX_BUFFER_SIZE);
 		void *wb;
@@ -472,8 +769,11 @@ void tee_tadb_ta_close_and_delete(struct tee_tadb_ta_write *ta)
 {
 	crypto_authenc_final(ta->ctx);
 	crypto_authenc_free_ctx(ta->ctx);
-	tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
-	ta_operation_remove(ta->entry.file_number);
+	tadb_dedup_release(ta);
+	if (ta->fd != -1) {
+		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
+		ta_operation_remove(ta->entry.file_number);
+	}
 
 	mutex_lock(&tadb_mutex);
 	clear_file(ta->db, ta->entry.file_number);
@@ -489,6 +789,9 @@ static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
 	TEE_Result res;
 	size_t idx;
 
+	if (!is_null_uuid(uuid) && ent_cache_find(uuid, idx_ret, entry_ret))
+		return TEE_SUCCESS;
+
 	/*
 	 * Search for the provided uuid, if it's found return the index it
 	 * has together with TEE_SUCCESS.
@@ -509,6 +812,8 @@ static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
 		if (!memcmp(&entry.prop.uuid, uuid, sizeof(*uuid))) {
 			if (entry_ret)
 				*entry_ret = entry;
+			if (!is_null_uuid(uuid))
+				ent_cache_insert(idx, &entry);
 			break;
 		}
 	}
@@ -540,6 +845,42 @@ TEE_Result tee_tadb_ta_close_and_commit(struct tee_tadb_ta_write *ta)
 	struct tadb_entry old_ent;
 	bool have_old_ent = false;
 
+	if (ta->dedup) {
+		if (ta->pos == entry_enc_size(&ta->old_ent)) {
+			size_t dl = 0;
+
+			/*
+			 * The whole image matched the old one. Verify the
+			 * old tag to make sure what was compared is the
+			 * authentic content, then keep the old entry and
+			 * file untouched.
+			 */
+			res = crypto_authenc_dec_final(ta->old_ctx, NULL, 0,
+						       NULL, &dl,
+						       ta->old_ent.tag,
+						       TADB_TAG_SIZE);
+			if (res)
+				goto err;
+
+			crypto_authenc_final(ta->ctx);
+			crypto_authenc_free_ctx(ta->ctx);
+			tadb_dedup_release(ta);
+
+			mutex_lock(&tadb_mutex);
+			clear_file(ta->db, ta->entry.file_number);
+			mutex_unlock(&tadb_mutex);
+
+			tadb_put(ta->db);
+			free(ta);
+			return TEE_SUCCESS;
+		}
+
+		/* Less data than the old image, write what we've got */
+		res = tadb_dedup_abandon(ta);
+		if (res)
+			goto err;
+	}
+
 	res = crypto_authenc_enc_final(ta->ctx, NULL, 0, NULL, &dsz,
 				       ta->entry.tag, &sz);
 	if (res)
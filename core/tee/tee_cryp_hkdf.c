@@ -5,14 +5,71 @@
 
 #include <crypto/crypto.h>
 #include <stdlib.h>
+#include <string_ext.h>
 #include <string.h>
 #include <tee/tee_cryp_hkdf.h>
 #include <tee/tee_cryp_utl.h>
 #include <utee_defines.h>
+#include <util.h>
 
+/* Largest IKM | salt input kept for cache comparison */
+#define HKDF_CACHE_MAX_IN_SIZE	1024
 
 static const uint8_t zero_salt[TEE_MAX_HASH_SIZE];
 
+static bool cache_hit(struct tee_cryp_hkdf_cache *cache, uint32_t hash_id,
+		      const uint8_t *ikm, size_t ikm_len, const uint8_t *salt,
+		      size_t salt_len)
+{
+	if (!cache || !cache->in || cache->hash_id != hash_id ||
+	    cache->ikm_len != ikm_len || cache->salt_len != salt_len)
+		return false;
+
+	if (memcmp(cache->in, ikm, ikm_len))
+		return false;
+	if (salt_len && memcmp(cache->in + ikm_len, salt, salt_len))
+		return false;
+
+	return true;
+}
+
+static void cache_store(struct tee_cryp_hkdf_cache *cache, uint32_t hash_id,
+			const uint8_t *ikm, size_t ikm_len,
+			const uint8_t *salt, size_t salt_len,
+			const uint8_t *prk, size_t prk_len)
+{
+	size_t l = 0;
+
+	if (!cache)
+		return;
+
+	if (ADD_OVERFLOW(ikm_len, salt_len, &l) || l > HKDF_CACHE_MAX_IN_SIZE)
+		return;
+
+	tee_cryp_hkdf_cache_clear(cache);
+
+	cache->in = malloc(l);
+	if (!cache->in)
+		return;
+	memcpy(cache->in, ikm, ikm_len);
+	if (salt_len)
+		memcpy(cache->in + ikm_len, salt, salt_len);
+	cache->ikm_len = ikm_len;
+	cache->salt_len = salt_len;
+	cache->hash_id = hash_id;
+	memcpy(cache->prk, prk, prk_len);
+	cache->prk_len = prk_len;
+}
+
+void tee_cryp_hkdf_cache_clear(struct tee_cryp_hkdf_cache *cache)
+{
+	if (cache->in) {
+		memzero_explicit(cache->in, cache->ikm_len + cache->salt_len);
+		free(cache->in);
+	}
+	memzero_explicit(cache, sizeof(*cache));
+}
+
 static TEE_Result hkdf_extract(uint32_t hash_id, const uint8_t *ikm,
 			       size_t ikm_len, const uint8_t *salt,
 			       size_t salt_len, uint8_t *prk, size_t *prk_len)
@@ -143,17 +200,26 @@ out:
 
 TEE_Result tee_cryp_hkdf(uint32_t hash_id, const uint8_t *ikm, size_t ikm_len,
 			 const uint8_t *salt, size_t salt_len,
-			 const uint8_t *info, size_t info_len, uint8_t *okm,
+			 const uint8_t *info, size_t info_len,
+			 struct tee_cryp_hkdf_cache *cache, uint8_t *okm,
 			 size_t okm_len)
 {
 	TEE_Result res;
 	uint8_t prk[TEE_MAX_HASH_SIZE];
 	size_t prk_len = sizeof(prk);
 
-	res = hkdf_extract(hash_id, ikm, ikm_len, salt, salt_len, prk,
-			   &prk_len);
-	if (res != TEE_SUCCESS)
-		return res;
+	if (cache_hit(cache, hash_id, ikm, ikm_len, salt, salt_len)) {
+		memcpy(prk, cache->prk, cache->prk_len);
+		prk_len = cache->prk_len;
+	} else {
+		res = hkdf_extract(hash_id, ikm, ikm_len, salt, salt_len, prk,
+				   &prk_len);
+		if (res != TEE_SUCCESS)
+			return res;
+		cache_store(cache, hash_id, ikm, ikm_len, salt, salt_len,
+			    prk, prk_len);
+	}
+
 	res = hkdf_expand(hash_id, prk, prk_len, info, info_len, okm,
 			  okm_len);
 
@@ -14,6 +14,11 @@ struct hmac_parms {
 	uint32_t algo;
 	size_t hash_len;
 	void *ctx;
+	/*
+	 * HMAC state with the password already processed, cloned into @ctx
+	 * for every iteration instead of redoing the key setup each time.
+	 */
+	void *base_ctx;
 };
 
 struct pbkdf2_parms {
@@ -34,9 +39,7 @@ static TEE_Result pbkdf2_f(uint8_t *out, size_t len, uint32_t idx,
 
 	memset(out, 0, len);
 	for (i = 1; i <= p->iteration_count; i++) {
-		res = crypto_mac_init(h->ctx, p->password, p->password_len);
-		if (res != TEE_SUCCESS)
-			return res;
+		crypto_mac_copy_state(h->ctx, h->base_ctx);
 
 		if (i == 1) {
 			if (p->salt && p->salt_len) {
@@ -89,6 +92,14 @@ TEE_Result tee_cryp_pbkdf2(uint32_t hash_id, const uint8_t *password,
 	if (res != TEE_SUCCESS)
 		return res;
 
+	res = crypto_mac_alloc_ctx(&hmac_parms.base_ctx, hmac_parms.algo);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = crypto_mac_init(hmac_parms.base_ctx, password, password_len);
+	if (res != TEE_SUCCESS)
+		goto out;
+
 	pbkdf2_parms.password = password;
 	pbkdf2_parms.password_len = password_len;
 	pbkdf2_parms.salt = salt;
@@ -109,6 +120,7 @@ TEE_Result tee_cryp_pbkdf2(uint32_t hash_id, const uint8_t *password,
 		res = pbkdf2_f(out, r, i, &hmac_parms, &pbkdf2_parms);
 
 out:
+	crypto_mac_free_ctx(hmac_parms.base_ctx);
 	crypto_mac_free_ctx(hmac_parms.ctx);
 	return res;
 }
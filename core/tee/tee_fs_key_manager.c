@@ -20,7 +20,9 @@
 #include <crypto/crypto.h>
 #include <initcall.h>
 #include <kernel/huk_subkey.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
+#include <kernel/pm.h>
 #include <kernel/tee_common_otp.h>
 #include <kernel/tee_ta_manager.h>
 #include <stdlib.h>
@@ -38,6 +40,150 @@ struct tee_fs_ssk {
 
 static struct tee_fs_ssk tee_fs_ssk;
 
+/*
+ * Cache of TSKs, one HMAC of the SSK per TA UUID. tee_fs_fek_crypt()
+ * otherwise re-derives the TSK on every FEK encryption or decryption
+ * even though it only depends on the SSK and the UUID, which shows up
+ * in storage open latency. A few entries cover the TAs with storage in
+ * active use. The cache is wiped on suspend in case memory content
+ * isn't preserved, the entries are re-derived on demand after resume.
+ */
+#define TSK_CACHE_NB_ENTRIES	4
+
+struct tsk_cache_entry {
+	bool valid;
+	bool has_uuid;
+	TEE_UUID uuid;
+	uint8_t tsk[TEE_FS_KM_TSK_SIZE];
+};
+
+static struct tsk_cache_entry tsk_cache[TSK_CACHE_NB_ENTRIES];
+static unsigned int tsk_cache_next;
+static struct mutex tsk_cache_mutex = MUTEX_INITIALIZER;
+
+static bool tsk_cache_find(const TEE_UUID *uuid,
+			   uint8_t tsk[TEE_FS_KM_TSK_SIZE])
+{
+	struct tsk_cache_entry *e = NULL;
+	size_t n = 0;
+	bool found = false;
+
+	mutex_lock(&tsk_cache_mutex);
+	for (n = 0; n < TSK_CACHE_NB_ENTRIES; n++) {
+		e = tsk_cache + n;
+		if (!e->valid || e->has_uuid != (bool)uuid)
+			continue;
+		if (uuid && memcmp(&e->uuid, uuid, sizeof(*uuid)))
+			continue;
+		memcpy(tsk, e->tsk, sizeof(e->tsk));
+		found = true;
+		break;
+	}
+	mutex_unlock(&tsk_cache_mutex);
+
+	return found;
+}
+
+static void tsk_cache_insert(const TEE_UUID *uuid,
+			     const uint8_t tsk[TEE_FS_KM_TSK_SIZE])
+{
+	struct tsk_cache_entry *e = NULL;
+
+	mutex_lock(&tsk_cache_mutex);
+	e = tsk_cache + tsk_cache_next;
+	tsk_cache_next = (tsk_cache_next + 1) % TSK_CACHE_NB_ENTRIES;
+	e->valid = true;
+	e->has_uuid = uuid;
+	if (uuid)
+		e->uuid = *uuid;
+	else
+		memset(&e->uuid, 0, sizeof(e->uuid));
+	memcpy(e->tsk, tsk, TEE_FS_KM_TSK_SIZE);
+	mutex_unlock(&tsk_cache_mutex);
+}
+
+/*
+ * Cache of unwrapped FEKs keyed by (UUID, encrypted FEK). Every storage
+ * open decrypts the FEK of the file with the TSK, while a TA typically
+ * works against the same few objects over and over. Only the decrypt
+ * direction is cached, FEKs are only encrypted when they are generated.
+ * Like the TSK cache it is wiped on suspend and refilled on demand.
+ */
+#define FEK_CACHE_NB_ENTRIES	8
+
+struct fek_cache_entry {
+	bool valid;
+	bool has_uuid;
+	TEE_UUID uuid;
+	uint8_t enc_fek[TEE_FS_KM_FEK_SIZE];
+	uint8_t fek[TEE_FS_KM_FEK_SIZE];
+};
+
+static struct fek_cache_entry fek_cache[FEK_CACHE_NB_ENTRIES];
+static unsigned int fek_cache_next;
+static struct mutex fek_cache_mutex = MUTEX_INITIALIZER;
+
+static bool fek_cache_find(const TEE_UUID *uuid, const uint8_t *enc_fek,
+			   uint8_t fek[TEE_FS_KM_FEK_SIZE])
+{
+	struct fek_cache_entry *e = NULL;
+	size_t n = 0;
+	bool found = false;
+
+	mutex_lock(&fek_cache_mutex);
+	for (n = 0; n < FEK_CACHE_NB_ENTRIES; n++) {
+		e = fek_cache + n;
+		if (!e->valid || e->has_uuid != (bool)uuid)
+			continue;
+		if (uuid && memcmp(&e->uuid, uuid, sizeof(*uuid)))
+			continue;
+		if (memcmp(e->enc_fek, enc_fek, sizeof(e->enc_fek)))
+			continue;
+		memcpy(fek, e->fek, sizeof(e->fek));
+		found = true;
+		break;
+	}
+	mutex_unlock(&fek_cache_mutex);
+
+	return found;
+}
+
+static void fek_cache_insert(const TEE_UUID *uuid, const uint8_t *enc_fek,
+			     const uint8_t fek[TEE_FS_KM_FEK_SIZE])
+{
+	struct fek_cache_entry *e = NULL;
+
+	mutex_lock(&fek_cache_mutex);
+	e = fek_cache + fek_cache_next;
+	fek_cache_next = (fek_cache_next + 1) % FEK_CACHE_NB_ENTRIES;
+	e->valid = true;
+	e->has_uuid = uuid;
+	if (uuid)
+		e->uuid = *uuid;
+	else
+		memset(&e->uuid, 0, sizeof(e->uuid));
+	memcpy(e->enc_fek, enc_fek, TEE_FS_KM_FEK_SIZE);
+	memcpy(e->fek, fek, TEE_FS_KM_FEK_SIZE);
+	mutex_unlock(&fek_cache_mutex);
+}
+
+static TEE_Result key_cache_pm(enum pm_op op, uint32_t pm_hint __unused,
+			       const struct pm_callback_handle *hdl __unused)
+{
+	/*
+	 * Other threads are parked when the suspend callbacks run so the
+	 * caches can be wiped without taking the mutexes.
+	 */
+	if (op == PM_OP_SUSPEND) {
+		memzero_explicit(tsk_cache, sizeof(tsk_cache));
+		tsk_cache_next = 0;
+		memzero_explicit(fek_cache, sizeof(fek_cache));
+		fek_cache_next = 0;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result do_hmac(void *out_key, size_t out_key_size,
 			  const void *in_key, size_t in_key_size,
 			  const void *message, size_t message_size)
@@ -89,22 +235,28 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 	if (tee_fs_ssk.is_init == 0)
 		return TEE_ERROR_GENERIC;
 
-	if (uuid) {
-		res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
-			      TEE_FS_KM_SSK_SIZE, uuid, sizeof(*uuid));
-		if (res != TEE_SUCCESS)
-			return res;
-	} else {
-		/*
-		 * Pick something of a different size than TEE_UUID to
-		 * guarantee that there's never a conflict.
-		 */
-		uint8_t dummy[1] = { 0 };
-
-		res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
-			      TEE_FS_KM_SSK_SIZE, dummy, sizeof(dummy));
-		if (res != TEE_SUCCESS)
-			return res;
+	if (mode == TEE_MODE_DECRYPT && fek_cache_find(uuid, in_key, out_key))
+		return TEE_SUCCESS;
+
+	if (!tsk_cache_find(uuid, tsk)) {
+		if (uuid) {
+			res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
+				      TEE_FS_KM_SSK_SIZE, uuid, sizeof(*uuid));
+			if (res != TEE_SUCCESS)
+				return res;
+		} else {
+			/*
+			 * Pick something of a different size than TEE_UUID to
+			 * guarantee that there's never a conflict.
+			 */
+			uint8_t dummy[1] = { 0 };
+
+			res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
+				      TEE_FS_KM_SSK_SIZE, dummy, sizeof(dummy));
+			if (res != TEE_SUCCESS)
+				return res;
+		}
+		tsk_cache_insert(uuid, tsk);
 	}
 
 	res = crypto_cipher_alloc_ctx(&ctx, TEE_FS_KM_ENC_FEK_ALG);
@@ -122,6 +274,8 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 	crypto_cipher_final(ctx);
 
 	memcpy(out_key, dst_key, sizeof(dst_key));
+	if (mode == TEE_MODE_DECRYPT)
+		fek_cache_insert(uuid, in_key, dst_key);
 
 exit:
 	crypto_cipher_free_ctx(ctx);
@@ -149,6 +303,8 @@ static TEE_Result tee_fs_init_key_manager(void)
 	else
 		memzero_explicit(&tee_fs_ssk, sizeof(tee_fs_ssk));
 
+	register_pm_core_service_cb(key_cache_pm, NULL);
+
 	return res;
 }
 
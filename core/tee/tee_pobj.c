@@ -3,15 +3,87 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <initcall.h>
 #include <kernel/mutex.h>
 #include <stdlib.h>
 #include <string.h>
 #include <tee/tee_pobj.h>
 #include <trace.h>
+#include <util.h>
 
-static TAILQ_HEAD(tee_pobjs, tee_pobj) tee_pobjs =
-		TAILQ_HEAD_INITIALIZER(tee_pobjs);
-static struct mutex pobjs_mutex = MUTEX_INITIALIZER;
+/*
+ * Every persistent object open resolves its struct tee_pobj here. Hash
+ * the object identity into buckets, each with its own mutex, so a lookup
+ * only scans and serializes against objects sharing a bucket.
+ */
+#define TEE_POBJ_NUM_BUCKETS	U(16)
+
+struct tee_pobj_bucket {
+	struct mutex mutex;
+	TAILQ_HEAD(, tee_pobj) pobjs;
+};
+
+static struct tee_pobj_bucket pobj_buckets[TEE_POBJ_NUM_BUCKETS];
+
+static uint32_t pobj_hash(const TEE_UUID *uuid, const void *obj_id,
+			  uint32_t obj_id_len)
+{
+	const uint8_t *b = (const uint8_t *)uuid;
+	uint32_t hash = 5381;
+	uint32_t n = 0;
+
+	for (n = 0; n < sizeof(*uuid); n++)
+		hash = hash * 33 + b[n];
+
+	b = obj_id;
+	for (n = 0; n < obj_id_len; n++)
+		hash = hash * 33 + b[n];
+
+	return hash;
+}
+
+static struct tee_pobj_bucket *pobj_bucket(const TEE_UUID *uuid,
+					   const void *obj_id,
+					   uint32_t obj_id_len)
+{
+	return pobj_buckets +
+	       pobj_hash(uuid, obj_id, obj_id_len) % TEE_POBJ_NUM_BUCKETS;
+}
+
+static void pobj_lock_2_buckets(struct tee_pobj_bucket *a,
+				struct tee_pobj_bucket *b)
+{
+	if (a == b) {
+		mutex_lock(&a->mutex);
+	} else if (a < b) {
+		mutex_lock(&a->mutex);
+		mutex_lock(&b->mutex);
+	} else {
+		mutex_lock(&b->mutex);
+		mutex_lock(&a->mutex);
+	}
+}
+
+static void pobj_unlock_2_buckets(struct tee_pobj_bucket *a,
+				  struct tee_pobj_bucket *b)
+{
+	mutex_unlock(&a->mutex);
+	if (a != b)
+		mutex_unlock(&b->mutex);
+}
+
+static TEE_Result tee_pobj_init(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < TEE_POBJ_NUM_BUCKETS; n++) {
+		mutex_init(&pobj_buckets[n].mutex);
+		TAILQ_INIT(&pobj_buckets[n].pobjs);
+	}
+
+	return TEE_SUCCESS;
+}
+service_init(tee_pobj_init);
 
 static TEE_Result tee_pobj_check_access(uint32_t oflags, uint32_t nflags)
 {
@@ -64,12 +136,13 @@ TEE_Result tee_pobj_get(TEE_UUID *uuid, void *obj_id, uint32_t obj_id_len,
 {
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_pobj *o = NULL;
+	struct tee_pobj_bucket *bkt = pobj_bucket(uuid, obj_id, obj_id_len);
 
 	*obj = NULL;
 
-	mutex_lock(&pobjs_mutex);
+	mutex_lock(&bkt->mutex);
 	/* Check if file is open */
-	TAILQ_FOREACH(o, &tee_pobjs, link) {
+	TAILQ_FOREACH(o, &bkt->pobjs, link) {
 		if ((obj_id_len == o->obj_id_len) &&
 		    (memcmp(obj_id, o->obj_id, obj_id_len) == 0) &&
 		    (memcmp(uuid, &o->uuid, sizeof(TEE_UUID)) == 0) &&
@@ -119,38 +192,45 @@ TEE_Result tee_pobj_get(TEE_UUID *uuid, void *obj_id, uint32_t obj_id_len,
 	memcpy(o->obj_id, obj_id, obj_id_len);
 	o->obj_id_len = obj_id_len;
 
-	TAILQ_INSERT_TAIL(&tee_pobjs, o, link);
+	TAILQ_INSERT_TAIL(&bkt->pobjs, o, link);
 	*obj = o;
 
 	res = TEE_SUCCESS;
 out:
 	if (res != TEE_SUCCESS)
 		*obj = NULL;
-	mutex_unlock(&pobjs_mutex);
+	mutex_unlock(&bkt->mutex);
 	return res;
 }
 
 void tee_pobj_create_final(struct tee_pobj *po)
 {
-	mutex_lock(&pobjs_mutex);
+	struct tee_pobj_bucket *bkt = pobj_bucket(&po->uuid, po->obj_id,
+						  po->obj_id_len);
+
+	mutex_lock(&bkt->mutex);
 	po->temporary = false;
 	po->creating = false;
-	mutex_unlock(&pobjs_mutex);
+	mutex_unlock(&bkt->mutex);
 }
 
 TEE_Result tee_pobj_release(struct tee_pobj *obj)
 {
+	struct tee_pobj_bucket *bkt = NULL;
+
 	if (obj == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	mutex_lock(&pobjs_mutex);
+	bkt = pobj_bucket(&obj->uuid, obj->obj_id, obj->obj_id_len);
+
+	mutex_lock(&bkt->mutex);
 	obj->refcnt--;
 	if (obj->refcnt == 0) {
-		TAILQ_REMOVE(&tee_pobjs, obj, link);
+		TAILQ_REMOVE(&bkt->pobjs, obj, link);
 		free(obj->obj_id);
 		free(obj);
 	}
-	mutex_unlock(&pobjs_mutex);
+	mutex_unlock(&bkt->mutex);
 
 	return TEE_SUCCESS;
 }
@@ -160,11 +240,20 @@ TEE_Result tee_pobj_rename(struct tee_pobj *obj, void *obj_id,
 {
 	TEE_Result res = TEE_SUCCESS;
 	void *new_obj_id = NULL;
+	struct tee_pobj_bucket *old_bkt = NULL;
+	struct tee_pobj_bucket *new_bkt = NULL;
 
 	if (obj == NULL || obj_id == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	mutex_lock(&pobjs_mutex);
+	/*
+	 * Only the sole reference holder may rename (checked below) so
+	 * obj->obj_id is stable enough to find the current bucket.
+	 */
+	old_bkt = pobj_bucket(&obj->uuid, obj->obj_id, obj->obj_id_len);
+	new_bkt = pobj_bucket(&obj->uuid, obj_id, obj_id_len);
+
+	pobj_lock_2_buckets(old_bkt, new_bkt);
 	if (obj->refcnt != 1) {
 		res = TEE_ERROR_BAD_STATE;
 		goto exit;
@@ -183,8 +272,14 @@ TEE_Result tee_pobj_rename(struct tee_pobj *obj, void *obj_id,
 	obj->obj_id_len = obj_id_len;
 	new_obj_id = NULL;
 
+	/* The new identity may hash to another bucket */
+	if (new_bkt != old_bkt) {
+		TAILQ_REMOVE(&old_bkt->pobjs, obj, link);
+		TAILQ_INSERT_TAIL(&new_bkt->pobjs, obj, link);
+	}
+
 exit:
-	mutex_unlock(&pobjs_mutex);
+	pobj_unlock_2_buckets(old_bkt, new_bkt);
 	free(new_obj_id);
 	return res;
 }
@@ -38,8 +38,9 @@ struct tee_fs_fd {
 
 struct tee_fs_dir {
 	struct tee_fs_dirfile_dirh *dirh;
-	int idx;
-	struct tee_fs_dirent d;
+	struct tee_fs_dirent *ents;
+	size_t nents;
+	size_t next_ent;
 	const TEE_UUID *uuid;
 };
 
@@ -50,6 +51,92 @@ static int pos_to_block_num(int position)
 
 static struct mutex ree_fs_mutex = MUTEX_INITIALIZER;
 
+/*
+ * Cache of recently accessed plaintext blocks, keyed by file handle and
+ * block number. A hit saves both the read RPC to normal world and the
+ * AES-GCM decrypt. Entries are allocated lazily, replaced LRU and
+ * updated write-through on block writes. All access is serialized by
+ * ree_fs_mutex.
+ */
+struct block_cache_entry {
+	struct tee_fs_fd *fdp;
+	int block_num;
+	uint64_t last_use;
+	uint8_t data[BLOCK_SIZE];
+};
+
+static struct block_cache_entry *block_cache[CFG_REE_FS_BLOCK_CACHE_NUM];
+static uint64_t block_cache_seq;
+
+static struct block_cache_entry *block_cache_find(struct tee_fs_fd *fdp,
+						  int block_num)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(block_cache); n++) {
+		struct block_cache_entry *bce = block_cache[n];
+
+		if (bce && bce->fdp == fdp && bce->block_num == block_num) {
+			block_cache_seq++;
+			bce->last_use = block_cache_seq;
+			return bce;
+		}
+	}
+
+	return NULL;
+}
+
+static void block_cache_store(struct tee_fs_fd *fdp, int block_num,
+			      const void *data)
+{
+	struct block_cache_entry *bce = block_cache_find(fdp, block_num);
+	size_t victim = 0;
+	size_t n = 0;
+
+	if (!bce) {
+		for (n = 0; n < ARRAY_SIZE(block_cache); n++) {
+			if (!block_cache[n]) {
+				block_cache[n] = calloc(1,
+							sizeof(*block_cache[n]));
+				if (!block_cache[n])
+					return; /* Not fatal, just no cache */
+				victim = n;
+				break;
+			}
+			if (block_cache[n]->last_use <
+			    block_cache[victim]->last_use)
+				victim = n;
+		}
+		bce = block_cache[victim];
+		bce->fdp = fdp;
+		bce->block_num = block_num;
+		block_cache_seq++;
+		bce->last_use = block_cache_seq;
+	}
+
+	memcpy(bce->data, data, BLOCK_SIZE);
+}
+
+static void block_cache_invalidate(struct tee_fs_fd *fdp)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(block_cache); n++)
+		if (block_cache[n] && block_cache[n]->fdp == fdp)
+			block_cache[n]->fdp = NULL;
+}
+
+static bool buf_is_zero(const uint8_t *b, size_t len)
+{
+	size_t n = 0;
+
+	for (n = 0; n < len; n++)
+		if (b[n])
+			return false;
+
+	return true;
+}
+
 static void *get_tmp_block(void)
 {
 	return mempool_alloc(mempool_default, BLOCK_SIZE);
@@ -60,13 +147,22 @@ static void put_tmp_block(void *tmp_block)
 	mempool_free(mempool_default, tmp_block);
 }
 
+/*
+ * Writes @head_zeros zero bytes at @pos followed by @len bytes from @buf.
+ * Folding the zero extension done when writing beyond the end of the
+ * file into the same pass means a block shared by the extension and the
+ * new data is encrypted and written once instead of twice, which is what
+ * every small append beyond a block boundary used to cost.
+ */
 static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
-				     const void *buf, size_t len)
+				     const void *buf, size_t len,
+				     size_t head_zeros)
 {
-	TEE_Result res;
+	TEE_Result res = TEE_SUCCESS;
+	size_t dstart = pos + head_zeros;
 	size_t start_block_num = pos_to_block_num(pos);
-	size_t end_block_num = pos_to_block_num(pos + len - 1);
-	size_t remain_bytes = len;
+	size_t end_block_num = pos_to_block_num(pos + head_zeros + len - 1);
+	size_t remain_bytes = head_zeros + len;
 	uint8_t *data_ptr = (uint8_t *)buf;
 	uint8_t *block;
 	struct tee_fs_htree_meta *meta = tee_fs_htree_get_meta(fdp->ht);
@@ -74,9 +170,9 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 	/*
 	 * It doesn't make sense to call this function if nothing is to be
 	 * written. This also guards against end_block_num getting an
-	 * unexpected value when pos == 0 and len == 0.
+	 * unexpected value when pos == 0 and the length is 0.
 	 */
-	if (!len)
+	if (!remain_bytes)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	block = get_tmp_block();
@@ -86,32 +182,78 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 	while (start_block_num <= end_block_num) {
 		size_t offset = pos % BLOCK_SIZE;
 		size_t size_to_write = MIN(remain_bytes, (size_t)BLOCK_SIZE);
+		bool have_old = false;
+		bool unchanged = false;
 
 		if (size_to_write + offset > BLOCK_SIZE)
 			size_to_write = BLOCK_SIZE - offset;
 
 		if (start_block_num * BLOCK_SIZE <
 		    ROUNDUP(meta->length, BLOCK_SIZE)) {
-			res = tee_fs_htree_read_block(&fdp->ht,
-						      start_block_num, block);
-			if (res != TEE_SUCCESS)
-				goto exit;
+			struct block_cache_entry *bce =
+				block_cache_find(fdp, start_block_num);
+
+			if (bce) {
+				memcpy(block, bce->data, BLOCK_SIZE);
+			} else {
+				res = tee_fs_htree_read_block(&fdp->ht,
+							      start_block_num,
+							      block);
+				if (res != TEE_SUCCESS)
+					goto exit;
+			}
+			have_old = true;
 		} else {
 			memset(block, 0, BLOCK_SIZE);
 		}
 
-		if (data_ptr)
-			memcpy(block + offset, data_ptr, size_to_write);
-		else
+		/*
+		 * Objects are often rewritten with identical content. When
+		 * the new bytes match what the block already holds the
+		 * encrypt, the write RPC and the ancestor node updates in
+		 * the hash tree can all be skipped.
+		 */
+		if (have_old) {
+			if (!data_ptr) {
+				unchanged = buf_is_zero(block + offset,
+							size_to_write);
+			} else if (pos >= dstart) {
+				unchanged = !memcmp(block + offset,
+						    data_ptr + (pos - dstart),
+						    size_to_write);
+			} else {
+				size_t z = MIN(dstart - pos, size_to_write);
+
+				unchanged = buf_is_zero(block + offset, z) &&
+					    (size_to_write == z ||
+					     !memcmp(block + offset + z,
+						     data_ptr,
+						     size_to_write - z));
+			}
+		}
+
+		if (!data_ptr) {
 			memset(block + offset, 0, size_to_write);
+		} else if (pos >= dstart) {
+			memcpy(block + offset, data_ptr + (pos - dstart),
+			       size_to_write);
+		} else {
+			size_t z = MIN(dstart - pos, size_to_write);
 
-		res = tee_fs_htree_write_block(&fdp->ht, start_block_num,
-					       block);
-		if (res != TEE_SUCCESS)
-			goto exit;
+			memset(block + offset, 0, z);
+			if (size_to_write > z)
+				memcpy(block + offset + z, data_ptr,
+				       size_to_write - z);
+		}
+
+		if (!unchanged) {
+			res = tee_fs_htree_write_block(&fdp->ht,
+						       start_block_num, block);
+			if (res != TEE_SUCCESS)
+				goto exit;
+		}
+		block_cache_store(fdp, start_block_num, block);
 
-		if (data_ptr)
-			data_ptr += size_to_write;
 		remain_bytes -= size_to_write;
 		start_block_num++;
 		pos += size_to_write;
@@ -247,12 +389,56 @@ static TEE_Result ree_fs_rpc_write_init(void *aux,
 				     offs, size, data);
 }
 
+static TEE_Result ree_fs_rpc_node_blk_init(void *aux,
+					    struct tee_fs_rpc_operation *op,
+					    size_t bnum, bool write,
+					    void **data)
+{
+	const size_t node_size = sizeof(struct tee_fs_htree_node_image);
+	const size_t block_nodes = BLOCK_SIZE / (node_size * 2);
+	struct tee_fs_fd *fdp = aux;
+	TEE_Result res;
+	size_t offs;
+	size_t size;
+
+	res = get_offs_size(TEE_FS_HTREE_TYPE_NODE, bnum * block_nodes, 0,
+			    &offs, &size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (write)
+		return tee_fs_rpc_write_init(op, OPTEE_RPC_CMD_FS, fdp->fd,
+					     offs, block_nodes * node_size * 2,
+					     data);
+
+	return tee_fs_rpc_read_init(op, OPTEE_RPC_CMD_FS, fdp->fd, offs,
+				    block_nodes * node_size * 2, data);
+}
+
+static TEE_Result ree_fs_rpc_node_blk_read_init(void *aux,
+						struct tee_fs_rpc_operation *op,
+						size_t bnum, void **data)
+{
+	return ree_fs_rpc_node_blk_init(aux, op, bnum, false, data);
+}
+
+static TEE_Result ree_fs_rpc_node_blk_write_init(void *aux,
+						 struct tee_fs_rpc_operation *op,
+						 size_t bnum, void **data)
+{
+	return ree_fs_rpc_node_blk_init(aux, op, bnum, true, data);
+}
+
 static const struct tee_fs_htree_storage ree_fs_storage_ops = {
 	.block_size = BLOCK_SIZE,
 	.rpc_read_init = ree_fs_rpc_read_init,
 	.rpc_read_final = tee_fs_rpc_read_final,
 	.rpc_write_init = ree_fs_rpc_write_init,
 	.rpc_write_final = tee_fs_rpc_write_final,
+	.nodes_per_block = BLOCK_SIZE /
+			   (sizeof(struct tee_fs_htree_node_image) * 2),
+	.rpc_node_blk_read_init = ree_fs_rpc_node_blk_read_init,
+	.rpc_node_blk_write_init = ree_fs_rpc_node_blk_write_init,
 };
 
 static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
@@ -264,7 +450,7 @@ static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
 	if ((size_t)new_file_len > meta->length) {
 		size_t ext_len = new_file_len - meta->length;
 
-		res = out_of_place_write(fdp, meta->length, NULL, ext_len);
+		res = out_of_place_write(fdp, meta->length, NULL, ext_len, 0);
 		if (res != TEE_SUCCESS)
 			return res;
 	} else {
@@ -289,8 +475,73 @@ static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
 
 		meta->length = new_file_len;
 		tee_fs_htree_meta_set_dirty(fdp->ht);
+		block_cache_invalidate(fdp);
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Read the committed versions of several consecutive data blocks with a
+ * single RPC. The FS RPC ABI only carries one (offset, length) pair per
+ * operation, so instead of a true scatter-gather list one read covering
+ * the span from the first to the last wanted physical block is issued
+ * and the blocks are picked out of the returned buffer. The two block
+ * versions are interleaved in the file so up to half of the span is
+ * transferred unused, but a single round trip still beats one RPC per
+ * block. The span buffer lives in the RPC shared memory and is only
+ * valid until the next RPC.
+ */
+#define READ_SPAN_MAX_BLOCKS	U(8)
+
+static TEE_Result read_block_span(struct tee_fs_fd *fdp, size_t first,
+				  size_t count, uint8_t **span,
+				  size_t boffs[READ_SPAN_MAX_BLOCKS])
+{
+	TEE_Result res;
+	struct tee_fs_rpc_operation op;
+	size_t offs_min = SIZE_MAX;
+	size_t offs_max = 0;
+	size_t offs;
+	size_t size;
+	size_t bytes;
+	uint8_t vers;
+	size_t n;
+	void *p;
+
+	assert(count >= 2 && count <= READ_SPAN_MAX_BLOCKS);
+
+	for (n = 0; n < count; n++) {
+		res = tee_fs_htree_get_block_vers(&fdp->ht, first + n, &vers);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		res = get_offs_size(TEE_FS_HTREE_TYPE_BLOCK, first + n, vers,
+				    &offs, &size);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		boffs[n] = offs;
+		offs_min = MIN(offs_min, offs);
+		offs_max = MAX(offs_max, offs + size);
 	}
 
+	res = tee_fs_rpc_read_init(&op, OPTEE_RPC_CMD_FS, fdp->fd, offs_min,
+				   offs_max - offs_min, &p);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_fs_rpc_read_final(&op, &bytes);
+	if (res != TEE_SUCCESS)
+		return res;
+	if (bytes != offs_max - offs_min)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	for (n = 0; n < count; n++)
+		boffs[n] -= offs_min;
+
+	*span = p;
+
 	return TEE_SUCCESS;
 }
 
@@ -303,6 +554,10 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 	size_t remain_bytes;
 	uint8_t *data_ptr = buf;
 	uint8_t *block = NULL;
+	uint8_t *span = NULL;
+	size_t span_first = 0;
+	size_t span_cnt = 0;
+	size_t span_boffs[READ_SPAN_MAX_BLOCKS];
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 	struct tee_fs_htree_meta *meta = tee_fs_htree_get_meta(fdp->ht);
 
@@ -335,9 +590,43 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 		if (size_to_read + offset > BLOCK_SIZE)
 			size_to_read = BLOCK_SIZE - offset;
 
-		res = tee_fs_htree_read_block(&fdp->ht, start_block_num, block);
-		if (res != TEE_SUCCESS)
-			goto exit;
+		struct block_cache_entry *bce =
+			block_cache_find(fdp, start_block_num);
+
+		if (bce) {
+			memcpy(block, bce->data, BLOCK_SIZE);
+		} else {
+			size_t bnum = start_block_num;
+
+			if (span_cnt && (bnum < span_first ||
+					 bnum >= span_first + span_cnt))
+				span_cnt = 0;
+
+			if (!span_cnt && bnum < (size_t)end_block_num) {
+				size_t cnt = MIN((size_t)end_block_num -
+						 bnum + 1,
+						 READ_SPAN_MAX_BLOCKS);
+
+				if (read_block_span(fdp, bnum, cnt, &span,
+						    span_boffs) ==
+				    TEE_SUCCESS) {
+					span_first = bnum;
+					span_cnt = cnt;
+				}
+			}
+
+			if (span_cnt)
+				res = tee_fs_htree_dec_block(&fdp->ht, bnum,
+						span + span_boffs[bnum -
+								  span_first],
+						block);
+			else
+				res = tee_fs_htree_read_block(&fdp->ht, bnum,
+							      block);
+			if (res != TEE_SUCCESS)
+				goto exit;
+			block_cache_store(fdp, start_block_num, block);
+		}
 
 		memcpy(data_ptr, block + offset, size_to_read);
 
@@ -381,13 +670,11 @@ static TEE_Result ree_fs_write_primitive(struct tee_file_handle *fh, size_t pos,
 	if ((pos + len) < len)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	if (file_size < pos) {
-		res = ree_fs_ftruncate_internal(fdp, pos);
-		if (res != TEE_SUCCESS)
-			return res;
-	}
+	if (file_size < pos)
+		return out_of_place_write(fdp, file_size, buf, len,
+					  pos - file_size);
 
-	return out_of_place_write(fdp, pos, buf, len);
+	return out_of_place_write(fdp, pos, buf, len, 0);
 }
 
 static TEE_Result ree_fs_open_primitive(bool create, uint8_t *hash,
@@ -440,6 +727,7 @@ static void ree_fs_close_primitive(struct tee_file_handle *fh)
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
 	if (fdp) {
+		block_cache_invalidate(fdp);
 		tee_fs_htree_close(&fdp->ht);
 		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
 		free(fdp);
@@ -470,6 +758,14 @@ static const struct tee_fs_dirfile_operations ree_dirf_ops = {
 
 static struct tee_fs_dirfile_dirh *ree_fs_dirh;
 static size_t ree_fs_dirh_refcount;
+/*
+ * Group commit state, protected by ree_fs_mutex. While a batch is open
+ * dirfile commits are deferred and flushed in one go when the batch
+ * ends. The batch holds a reference on ree_fs_dirh to keep the
+ * uncommitted dirfile state alive between operations.
+ */
+static bool ree_fs_batch_open;
+static bool ree_fs_batch_dirty;
 
 #ifdef CFG_RPMB_FS
 static struct tee_file_handle *ree_fs_rpmb_fh;
@@ -548,6 +844,16 @@ static void close_dirh(struct tee_fs_dirfile_dirh **dirh)
 }
 #endif /*!CFG_RPMB_FS*/
 
+static TEE_Result queue_dirh_commit(struct tee_fs_dirfile_dirh *dirh)
+{
+	if (ree_fs_batch_open) {
+		ree_fs_batch_dirty = true;
+		return TEE_SUCCESS;
+	}
+
+	return commit_dirh_writes(dirh);
+}
+
 static TEE_Result get_dirh(struct tee_fs_dirfile_dirh **dirh)
 {
 	if (!ree_fs_dirh) {
@@ -660,7 +966,7 @@ static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 	if (res)
 		return res;
 
-	res = commit_dirh_writes(dirh);
+	res = queue_dirh_commit(dirh);
 	if (res)
 		return res;
 
@@ -773,7 +1079,7 @@ static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
 	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
 	if (res)
 		goto out;
-	res = commit_dirh_writes(dirh);
+	res = queue_dirh_commit(dirh);
 out:
 	put_dirh(dirh, res);
 	mutex_unlock(&ree_fs_mutex);
@@ -820,7 +1126,7 @@ static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 			goto out;
 	}
 
-	res = commit_dirh_writes(dirh);
+	res = queue_dirh_commit(dirh);
 	if (res)
 		goto out;
 
@@ -855,7 +1161,7 @@ static TEE_Result ree_fs_remove(struct tee_pobj *po)
 	if (res)
 		goto out;
 
-	res = commit_dirh_writes(dirh);
+	res = queue_dirh_commit(dirh);
 	if (res)
 		goto out;
 
@@ -893,7 +1199,7 @@ static TEE_Result ree_fs_truncate(struct tee_file_handle *fh, size_t len)
 	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
 	if (res)
 		goto out;
-	res = commit_dirh_writes(dirh);
+	res = queue_dirh_commit(dirh);
 out:
 	put_dirh(dirh, res);
 	mutex_unlock(&ree_fs_mutex);
@@ -919,19 +1225,22 @@ static TEE_Result ree_fs_opendir_rpc(const TEE_UUID *uuid,
 	if (res)
 		goto out;
 
-	/* See that there's at least one file */
-	d->idx = -1;
-	d->d.oidlen = sizeof(d->d.oid);
-	res = tee_fs_dirfile_get_next(d->dirh, d->uuid, &d->idx, d->d.oid,
-				      &d->d.oidlen);
-	d->idx = -1;
+	/*
+	 * Snapshot the directory in one batched sweep, enumeration is
+	 * then served from memory without further storage reads.
+	 */
+	res = tee_fs_dirfile_snapshot(d->dirh, d->uuid, &d->ents, &d->nents);
+	if (!res && !d->nents)
+		res = TEE_ERROR_ITEM_NOT_FOUND;
 
 out:
 	if (!res) {
 		*dir = d;
 	} else {
-		if (d)
+		if (d) {
 			put_dirh(d->dirh, false);
+			free(d->ents);
+		}
 		free(d);
 	}
 	mutex_unlock(&ree_fs_mutex);
@@ -945,6 +1254,7 @@ static void ree_fs_closedir_rpc(struct tee_fs_dir *d)
 		mutex_lock(&ree_fs_mutex);
 
 		put_dirh(d->dirh, false);
+		free(d->ents);
 		free(d);
 
 		mutex_unlock(&ree_fs_mutex);
@@ -953,17 +1263,68 @@ static void ree_fs_closedir_rpc(struct tee_fs_dir *d)
 
 static TEE_Result ree_fs_readdir_rpc(struct tee_fs_dir *d,
 				     struct tee_fs_dirent **ent)
+{
+	TEE_Result res = TEE_ERROR_ITEM_NOT_FOUND;
+
+	mutex_lock(&ree_fs_mutex);
+
+	if (d->next_ent < d->nents) {
+		*ent = d->ents + d->next_ent;
+		d->next_ent++;
+		res = TEE_SUCCESS;
+	}
+
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+static TEE_Result ree_fs_begin_transaction(void)
 {
 	TEE_Result res;
+	struct tee_fs_dirfile_dirh *dirh = NULL;
 
 	mutex_lock(&ree_fs_mutex);
 
-	d->d.oidlen = sizeof(d->d.oid);
-	res = tee_fs_dirfile_get_next(d->dirh, d->uuid, &d->idx, d->d.oid,
-				      &d->d.oidlen);
-	if (res == TEE_SUCCESS)
-		*ent = &d->d;
+	if (ree_fs_batch_open) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
 
+	res = get_dirh(&dirh);
+	if (res)
+		goto out;
+
+	ree_fs_batch_open = true;
+	ree_fs_batch_dirty = false;
+out:
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+static TEE_Result ree_fs_end_transaction(void)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_mutex);
+
+	if (!ree_fs_batch_open) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
+
+	ree_fs_batch_open = false;
+	/*
+	 * If an operation failed during the batch the dirfile has been
+	 * closed and the deferred updates already rolled back, in which
+	 * case ree_fs_dirh is NULL and there's nothing to flush.
+	 */
+	if (ree_fs_batch_dirty && ree_fs_dirh)
+		res = commit_dirh_writes(ree_fs_dirh);
+	ree_fs_batch_dirty = false;
+	put_dirh_primitive(res);
+out:
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
@@ -981,4 +1342,6 @@ const struct tee_file_operations ree_fs_ops = {
 	.opendir = ree_fs_opendir_rpc,
 	.closedir = ree_fs_closedir_rpc,
 	.readdir = ree_fs_readdir_rpc,
+	.begin_transaction = ree_fs_begin_transaction,
+	.end_transaction = ree_fs_end_transaction,
 };
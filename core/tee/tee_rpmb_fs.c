@@ -13,6 +13,7 @@
 #include <kernel/tee_common.h>
 #include <kernel/tee_common_otp.h>
 #include <kernel/tee_misc.h>
+#include <kernel/tee_time.h>
 #include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <mm/mobj.h>
@@ -43,14 +44,6 @@
 
 #define TEE_RPMB_FS_FILENAME_LENGTH 224
 
-/**
- * Utilized when caching is enabled, i.e., when CFG_RPMB_FS_CACHE_ENTRIES > 0.
- * Cache size + the number of entries that are repeatedly read in and buffered
- * once the cache is full.
- */
-#define RPMB_BUF_MAX_ENTRIES (CFG_RPMB_FS_CACHE_ENTRIES + \
-			      CFG_RPMB_FS_RD_ENTRIES)
-
 /**
  * FS parameters: Information often used by internal functions.
  * fat_start_address will be set by rpmb_fs_setup().
@@ -79,10 +72,11 @@ struct rpmb_fat_entry {
  */
 struct rpmb_fat_entry_dir {
 	/*
-	 * Buffer storing the FAT FS entries read in from RPMB storage. It
-	 * includes the optional cache entries (CFG_RPMB_FS_CACHE_ENTRIES)
-	 * and entries temporary read for current FAT FS traversal
-	 * (CFG_RPMB_FS_RD_ENTRIES) when not found from cached entries.
+	 * Buffer storing the FAT FS entries read in from RPMB storage. When
+	 * caching is enabled (CFG_RPMB_FS_CACHE_ENTRIES > 0) it grows on
+	 * demand until it mirrors all FAT FS entries up to the last one and
+	 * is kept across traversals. Without caching it holds at most
+	 * CFG_RPMB_FS_RD_ENTRIES entries for the current traversal only.
 	 */
 	struct rpmb_fat_entry *rpmb_fat_entry_buf;
 	/* Current index of FAT FS entry to read from buffer. */
@@ -271,6 +265,142 @@ static struct tee_rpmb_ctx *rpmb_ctx;
  */
 static struct mutex rpmb_mutex = MUTEX_INITIALIZER;
 
+/*
+ * Small cache of MAC verified RPMB blocks read without a file encryption
+ * key, i.e., FS metadata such as the partition data and the FAT entries.
+ * Serving repeated reads of hot metadata blocks from secure memory saves
+ * both the device I/O and the HMAC verification. Entries are dropped as
+ * soon as the corresponding blocks are written. Like the rest of the
+ * driver state the cache is protected by rpmb_mutex.
+ */
+/*
+ * Health counters for the RPMB path, updated while holding rpmb_mutex
+ * and exported through the stats pseudo TA. The latency histograms make
+ * it possible to detect a degrading eMMC device before it fails.
+ */
+static struct tee_rpmb_fs_stats rpmb_stats;
+
+static uint32_t stats_get_ms(void)
+{
+	TEE_Time t = { };
+
+	if (tee_time_get_sys_time(&t))
+		return 0;
+
+	return t.seconds * 1000 + t.millis;
+}
+
+static void stats_record_lat(uint32_t *buckets, uint32_t ms)
+{
+	size_t n;
+
+	for (n = 0; n < TEE_RPMB_FS_STATS_LAT_BUCKETS - 1; n++)
+		if (ms < BIT32(n))
+			break;
+
+	buckets[n]++;
+}
+
+void tee_rpmb_fs_get_stats(struct tee_rpmb_fs_stats *stats, bool reset)
+{
+	mutex_lock(&rpmb_mutex);
+	*stats = rpmb_stats;
+	if (reset)
+		memset(&rpmb_stats, 0, sizeof(rpmb_stats));
+	mutex_unlock(&rpmb_mutex);
+}
+
+#define RPMB_BLK_CACHE_ENTRIES		8
+
+struct rpmb_blk_cache_entry {
+	bool valid;
+	uint16_t dev_id;
+	uint16_t blk_idx;
+	uint8_t data[RPMB_DATA_SIZE];
+};
+
+static struct rpmb_blk_cache_entry blk_cache[RPMB_BLK_CACHE_ENTRIES];
+static size_t blk_cache_next;
+
+static const uint8_t *blk_cache_find(uint16_t dev_id, uint16_t blk_idx)
+{
+	size_t n;
+
+	for (n = 0; n < RPMB_BLK_CACHE_ENTRIES; n++)
+		if (blk_cache[n].valid && blk_cache[n].dev_id == dev_id &&
+		    blk_cache[n].blk_idx == blk_idx)
+			return blk_cache[n].data;
+
+	return NULL;
+}
+
+static void blk_cache_store(uint16_t dev_id, uint16_t blk_idx,
+			    const uint8_t *data)
+{
+	struct rpmb_blk_cache_entry *ce = NULL;
+	size_t n;
+
+	for (n = 0; n < RPMB_BLK_CACHE_ENTRIES; n++) {
+		if (blk_cache[n].valid && blk_cache[n].dev_id == dev_id &&
+		    blk_cache[n].blk_idx == blk_idx) {
+			ce = blk_cache + n;
+			break;
+		}
+	}
+
+	if (!ce) {
+		/* Replace entries in round robin order. */
+		ce = blk_cache + blk_cache_next;
+		blk_cache_next = (blk_cache_next + 1) % RPMB_BLK_CACHE_ENTRIES;
+	}
+
+	ce->valid = true;
+	ce->dev_id = dev_id;
+	ce->blk_idx = blk_idx;
+	memcpy(ce->data, data, RPMB_DATA_SIZE);
+}
+
+static void blk_cache_invalidate(uint16_t dev_id, uint16_t blk_idx,
+				 uint16_t blkcnt)
+{
+	size_t n;
+
+	for (n = 0; n < RPMB_BLK_CACHE_ENTRIES; n++)
+		if (blk_cache[n].valid && blk_cache[n].dev_id == dev_id &&
+		    blk_cache[n].blk_idx >= blk_idx &&
+		    blk_cache[n].blk_idx < (uint32_t)blk_idx + blkcnt)
+			blk_cache[n].valid = false;
+}
+
+/*
+ * Serve a read covering blkcnt blocks at blk_idx entirely from the block
+ * cache if possible. Returns true and copies out the requested bytes when
+ * all covered blocks are cached, false otherwise.
+ */
+static bool blk_cache_read(uint16_t dev_id, uint16_t blk_idx, uint16_t blkcnt,
+			   uint8_t *data, uint32_t len, uint8_t byte_offset)
+{
+	uint8_t *dst = data;
+	uint32_t left = len;
+	uint16_t i;
+
+	for (i = 0; i < blkcnt; i++)
+		if (!blk_cache_find(dev_id, blk_idx + i))
+			return false;
+
+	for (i = 0; i < blkcnt; i++) {
+		const uint8_t *src = blk_cache_find(dev_id, blk_idx + i);
+		uint8_t offs = i ? 0 : byte_offset;
+		uint32_t sz = MIN(left, (uint32_t)RPMB_DATA_SIZE - offs);
+
+		memcpy(dst, src + offs, sz);
+		dst += sz;
+		left -= sz;
+	}
+
+	return true;
+}
+
 #ifdef CFG_RPMB_TESTKEY
 
 static const uint8_t rpmb_test_key[RPMB_KEY_MAC_SIZE] = {
@@ -396,70 +526,52 @@ func_exit:
 }
 
 struct tee_rpmb_mem {
-	struct mobj *phreq_mobj;
-	struct mobj *phresp_mobj;
+	struct mobj *mobj;
 	size_t req_size;
 	size_t resp_size;
 };
 
-static void tee_rpmb_free(struct tee_rpmb_mem *mem)
-{
-	if (!mem)
-		return;
-
-	if (mem->phreq_mobj) {
-		thread_rpc_free_payload(mem->phreq_mobj);
-		mem->phreq_mobj = NULL;
-	}
-	if (mem->phresp_mobj) {
-		thread_rpc_free_payload(mem->phresp_mobj);
-		mem->phresp_mobj = NULL;
-	}
-}
-
-
 static TEE_Result tee_rpmb_alloc(size_t req_size, size_t resp_size,
 		struct tee_rpmb_mem *mem, void **req, void **resp)
 {
-	TEE_Result res = TEE_SUCCESS;
 	size_t req_s = ROUNDUP(req_size, sizeof(uint32_t));
 	size_t resp_s = ROUNDUP(resp_size, sizeof(uint32_t));
+	void *va = NULL;
 
 	if (!mem)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	memset(mem, 0, sizeof(*mem));
 
-	mem->phreq_mobj = thread_rpc_alloc_payload(req_s);
-	mem->phresp_mobj = thread_rpc_alloc_payload(resp_s);
-
-	if (!mem->phreq_mobj || !mem->phresp_mobj) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
+	/*
+	 * Get shared memory from the per-thread cache instead of
+	 * allocating and freeing RPC payload memory around each request,
+	 * saving two blocking round trips to normal world per RPMB
+	 * operation. The request and response share one allocation at
+	 * different offsets.
+	 */
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_RPMB,
+					THREAD_SHM_TYPE_APPLICATION,
+					req_s + resp_s, &mem->mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
 
-	*req = mobj_get_va(mem->phreq_mobj, 0);
-	*resp = mobj_get_va(mem->phresp_mobj, 0);
-	if (!*req || !*resp) {
-		res = TEE_ERROR_GENERIC;
-		goto out;
-	}
+	*req = va;
+	*resp = (uint8_t *)va + req_s;
 
 	mem->req_size = req_size;
 	mem->resp_size = resp_size;
 
-out:
-	if (res != TEE_SUCCESS)
-		tee_rpmb_free(mem);
-	return res;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tee_rpmb_invoke(struct tee_rpmb_mem *mem)
 {
 	struct thread_param params[2] = {
-		[0] = THREAD_PARAM_MEMREF(IN, mem->phreq_mobj, 0,
-					  mem->req_size),
-		[1] = THREAD_PARAM_MEMREF(OUT, mem->phresp_mobj, 0,
+		[0] = THREAD_PARAM_MEMREF(IN, mem->mobj, 0, mem->req_size),
+		[1] = THREAD_PARAM_MEMREF(OUT, mem->mobj,
+					  ROUNDUP(mem->req_size,
+						  sizeof(uint32_t)),
 					  mem->resp_size),
 	};
 
@@ -920,7 +1032,6 @@ static TEE_Result tee_rpmb_get_dev_info(uint16_t dev_id,
 	res = TEE_SUCCESS;
 
 func_exit:
-	tee_rpmb_free(&mem);
 	return res;
 }
 
@@ -983,7 +1094,6 @@ static TEE_Result tee_rpmb_init_read_wr_cnt(uint16_t dev_id,
 	res = TEE_SUCCESS;
 
 func_exit:
-	tee_rpmb_free(&mem);
 	return res;
 }
 
@@ -1048,7 +1158,6 @@ static TEE_Result tee_rpmb_write_key(uint16_t dev_id)
 	res = TEE_SUCCESS;
 
 func_exit:
-	tee_rpmb_free(&mem);
 	return res;
 }
 
@@ -1194,6 +1303,7 @@ static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
 	uint16_t blk_idx;
 	uint16_t blkcnt;
 	uint8_t byte_offset;
+	uint32_t op_start;
 
 	if (!data || !len)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -1211,6 +1321,11 @@ static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
+	/* Only blocks not holding encrypted file data are cached. */
+	if (!fek && blk_cache_read(dev_id, blk_idx, blkcnt, data, len,
+				   byte_offset))
+		return TEE_SUCCESS;
+
 	req_size = sizeof(struct rpmb_req) + RPMB_DATA_FRAME_SIZE;
 	resp_size = RPMB_DATA_FRAME_SIZE * blkcnt;
 	res = tee_rpmb_alloc(req_size, resp_size, &mem,
@@ -1236,9 +1351,16 @@ static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
 	DMSG("Read %u block%s at index %u", blkcnt, ((blkcnt > 1) ? "s" : ""),
 	     blk_idx);
 
+	rpmb_stats.read_cnt++;
+	rpmb_stats.frames_sent++;
+
+	op_start = stats_get_ms();
 	res = tee_rpmb_invoke(&mem);
-	if (res != TEE_SUCCESS)
+	if (res != TEE_SUCCESS) {
+		rpmb_stats.op_errs++;
 		goto func_exit;
+	}
+	stats_record_lat(rpmb_stats.read_lat, stats_get_ms() - op_start);
 
 	msg_type = RPMB_MSG_TYPE_RESP_AUTH_DATA_READ;
 
@@ -1254,13 +1376,25 @@ static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
 	rawdata.byte_offset = byte_offset;
 
 	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, blkcnt, fek, uuid);
-	if (res != TEE_SUCCESS)
+	if (res != TEE_SUCCESS) {
+		if (res == TEE_ERROR_SECURITY)
+			rpmb_stats.hmac_errs++;
+		else
+			rpmb_stats.op_errs++;
 		goto func_exit;
+	}
+
+	/* The frames carry plain data and passed MAC verification. */
+	if (!fek) {
+		uint16_t i;
+
+		for (i = 0; i < blkcnt; i++)
+			blk_cache_store(dev_id, blk_idx + i, resp[i].data);
+	}
 
 	res = TEE_SUCCESS;
 
 func_exit:
-	tee_rpmb_free(&mem);
 	return res;
 }
 
@@ -1282,6 +1416,7 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 	uint16_t tmp_blkcnt;
 	uint16_t tmp_blk_idx;
 	uint16_t i;
+	uint32_t op_start;
 
 	DMSG("Write %u block%s at index %u", blkcnt, ((blkcnt > 1) ? "s" : ""),
 	     blk_idx);
@@ -1293,6 +1428,13 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 	if (res != TEE_SUCCESS)
 		return res;
 
+	/*
+	 * The covered blocks are about to change, drop any cached copies
+	 * before writing so a failed or partial write can't leave stale
+	 * data in the cache.
+	 */
+	blk_cache_invalidate(dev_id, blk_idx, blkcnt);
+
 	/*
 	 * We need to split data when block count
 	 * is bigger than reliable block write count.
@@ -1345,6 +1487,10 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 		if (res != TEE_SUCCESS)
 			goto out;
 
+		rpmb_stats.write_cnt++;
+		rpmb_stats.frames_sent += tmp_blkcnt;
+
+		op_start = stats_get_ms();
 		res = tee_rpmb_invoke(&mem);
 		if (res != TEE_SUCCESS) {
 			/*
@@ -1352,8 +1498,12 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 			 * out of sync due to inconsistent operation result!
 			 */
 			rpmb_ctx->wr_cnt_synced = false;
+			rpmb_stats.op_errs++;
+			rpmb_stats.wr_cnt_resyncs++;
 			goto out;
 		}
+		stats_record_lat(rpmb_stats.write_lat,
+				 stats_get_ms() - op_start);
 
 		msg_type = RPMB_MSG_TYPE_RESP_AUTH_DATA_WRITE;
 
@@ -1372,6 +1522,11 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 			 * out of sync due to inconsistent operation result!
 			 */
 			rpmb_ctx->wr_cnt_synced = false;
+			if (res == TEE_ERROR_SECURITY)
+				rpmb_stats.hmac_errs++;
+			else
+				rpmb_stats.op_errs++;
+			rpmb_stats.wr_cnt_resyncs++;
 			goto out;
 		}
 
@@ -1379,7 +1534,6 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 	}
 
 out:
-	tee_rpmb_free(&mem);
 	return res;
 }
 
@@ -1551,9 +1705,10 @@ static TEE_Result fat_entry_dir_init(void)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
 	/*
-	 * If caching is enabled, read in up to the maximum cache size, but
-	 * never more than the single read in size. Otherwise, read in as many
-	 * entries fit into the temporary buffer.
+	 * If caching is enabled, read in up to the configured initial cache
+	 * size, but never more than the single read in size. The cache grows
+	 * on demand in fat_entry_dir_get_next until it mirrors all entries.
+	 * Otherwise, read in as many entries fit into the temporary buffer.
 	 */
 	if (CFG_RPMB_FS_CACHE_ENTRIES)
 		num_elems_read = MIN(CFG_RPMB_FS_CACHE_ENTRIES,
@@ -1591,16 +1746,13 @@ out:
 }
 
 /**
- * fat_entry_dir_deinit: If caching is enabled, free the temporary buffer for
- * FAT FS entries in case the cache was too small. Keep the elements in the
- * cache. Reset the counter variables to start the next traversal from fresh
- * from the first cached entry. If caching is disabled, just free the
- * temporary buffer by calling fat_entry_dir_free and return.
+ * fat_entry_dir_deinit: If caching is enabled, keep all buffered FAT FS
+ * entries as the cache and reset the counter variables to start the next
+ * traversal fresh from the first cached entry. If caching is disabled, just
+ * free the temporary buffer by calling fat_entry_dir_free and return.
  */
 static void fat_entry_dir_deinit(void)
 {
-	struct rpmb_fat_entry *fe = NULL;
-
 	if (!fat_entry_dir)
 		return;
 
@@ -1609,26 +1761,9 @@ static void fat_entry_dir_deinit(void)
 		return;
 	}
 
-	fe = fat_entry_dir->rpmb_fat_entry_buf;
 	fat_entry_dir->idx_curr = 0;
 	fat_entry_dir->num_total_read = 0;
 	fat_entry_dir->last_reached = false;
-
-	if (fat_entry_dir->num_buffered > CFG_RPMB_FS_CACHE_ENTRIES) {
-		fat_entry_dir->num_buffered = CFG_RPMB_FS_CACHE_ENTRIES;
-
-		fe = realloc(fe, fat_entry_dir->num_buffered * sizeof(*fe));
-
-		/*
-		 * In case realloc fails, we are on the safe side if we destroy
-		 * the whole structure. Upon the next init, the cache has to be
-		 * re-established, but this case should not happen in practice.
-		 */
-		if (!fe)
-			fat_entry_dir_free();
-		else
-			fat_entry_dir->rpmb_fat_entry_buf = fe;
-	}
 }
 
 /**
@@ -1641,8 +1776,6 @@ static TEE_Result __maybe_unused fat_entry_dir_update
 					 uint32_t fat_address)
 {
 	uint32_t fat_entry_buf_idx = 0;
-	/* Use a temp var to avoid compiler warning if caching disabled. */
-	uint32_t max_cache_entries = CFG_RPMB_FS_CACHE_ENTRIES;
 
 	assert(!((fat_address - RPMB_FS_FAT_START_ADDRESS) %
 	       sizeof(struct rpmb_fat_entry)));
@@ -1655,8 +1788,7 @@ static TEE_Result __maybe_unused fat_entry_dir_update
 			     sizeof(struct rpmb_fat_entry);
 
 	/* Only need to write if index points to an entry in cache. */
-	if (fat_entry_buf_idx < fat_entry_dir->num_buffered &&
-	    fat_entry_buf_idx < max_cache_entries) {
+	if (fat_entry_buf_idx < fat_entry_dir->num_buffered) {
 		memcpy(fat_entry_dir->rpmb_fat_entry_buf + fat_entry_buf_idx,
 		       fat_entry, sizeof(struct rpmb_fat_entry));
 	}
@@ -1669,8 +1801,8 @@ static TEE_Result __maybe_unused fat_entry_dir_update
  * Read either from cache/buffer, or by reading from RPMB storage if the
  * elements in the buffer/cache are fully read. When reading in from RPMB
  * storage, the buffer is overwritten in case caching is disabled.
- * In case caching is enabled, the cache is either further filled, or a
- * temporary buffer populated if the cache is already full.
+ * In case caching is enabled, the cache keeps growing until it mirrors all
+ * FAT FS entries so that subsequent traversals are served from memory.
  * The FAT FS entry is written to fat_entry. The respective address in RPMB
  * storage is written to fat_address, if not NULL. When the last FAT FS entry
  * was previously read, the function indicates this case by writing a NULL
@@ -1725,66 +1857,37 @@ static TEE_Result fat_entry_dir_get_next(struct rpmb_fat_entry **fat_entry,
 		}
 
 		/*
-		 * We cache FAT FS entries, and the buffer is not completely
-		 * filled. Further keep on extending the buffer up to its max
-		 * size by reading in from RPMB.
+		 * We cache FAT FS entries. Keep on extending the buffer by
+		 * reading in from RPMB so that it eventually mirrors all
+		 * entries up to the last one. The mirrored entries are kept
+		 * across traversals by fat_entry_dir_deinit and updated
+		 * write-through by fat_entry_dir_update, so each entry only
+		 * has to be read in from RPMB once.
 		 */
-		if (fat_entry_dir->num_total_read < RPMB_BUF_MAX_ENTRIES) {
-			/*
-			 * Read at most as many elements as fit in the buffer
-			 * and no more than the defined number of entries to
-			 * read in at once.
-			 */
-			num_elems_read = MIN(RPMB_BUF_MAX_ENTRIES -
-					     fat_entry_dir->num_total_read,
-					     (uint32_t)CFG_RPMB_FS_RD_ENTRIES);
-
-			/*
-			 * Expand the buffer to fit in the additional entries.
-			 */
-			fe = realloc(fe,
-				     (fat_entry_dir->num_buffered +
-				      num_elems_read) * sizeof(*fe));
-			if (!fe)
-				return TEE_ERROR_OUT_OF_MEMORY;
+		num_elems_read = CFG_RPMB_FS_RD_ENTRIES;
 
-			fat_entry_dir->rpmb_fat_entry_buf = fe;
+		/*
+		 * Expand the buffer to fit in the additional entries.
+		 */
+		fe = realloc(fe,
+			     (fat_entry_dir->num_buffered +
+			      num_elems_read) * sizeof(*fe));
+		if (!fe)
+			return TEE_ERROR_OUT_OF_MEMORY;
 
-			/* Read in to the next free slot in the buffer/cache. */
-			res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID,
-					    fat_address_local,
-					    (uint8_t *)(fe +
-					    fat_entry_dir->num_total_read),
-					    num_elems_read * sizeof(*fe),
-					    NULL, NULL);
-			if (res)
-				return res;
+		fat_entry_dir->rpmb_fat_entry_buf = fe;
 
-			fat_entry_dir->num_buffered += num_elems_read;
-		} else {
-			/*
-			 * This happens when we have read as many elements as
-			 * can possibly fit into the buffer.
-			 * As the first part of the buffer serves as our cache,
-			 * we only overwrite the last part that serves as our
-			 * temporary buffer used to iteratively read in entries
-			 * when the cache is full. Read in the temporary buffer
-			 * maximum size.
-			 */
-			num_elems_read = CFG_RPMB_FS_RD_ENTRIES;
-			/* Reset index to beginning of the temporary buffer. */
-			fat_entry_dir->idx_curr = CFG_RPMB_FS_CACHE_ENTRIES;
+		/* Read in to the next free slot in the buffer/cache. */
+		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID,
+				    fat_address_local,
+				    (uint8_t *)(fe +
+				    fat_entry_dir->num_total_read),
+				    num_elems_read * sizeof(*fe),
+				    NULL, NULL);
+		if (res)
+			return res;
 
-			/* Read in elements after the end of the cache. */
-			res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID,
-					    fat_address_local,
-					    (uint8_t *)(fe +
-					    fat_entry_dir->idx_curr),
-					    num_elems_read * sizeof(*fe),
-					    NULL, NULL);
-			if (res)
-				return res;
-		}
+		fat_entry_dir->num_buffered += num_elems_read;
 	}
 
 post_read_in:
@@ -2782,32 +2885,57 @@ static TEE_Result rpmb_fs_create(struct tee_pobj *po, bool overwrite,
 {
 	TEE_Result res;
 	size_t pos = 0;
+	size_t size = 0;
+	uint8_t *buf = NULL;
 	struct rpmb_file_handle *fh = alloc_file_handle(po, po->temporary);
 
 	if (!fh)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
+	if (!head)
+		head_size = 0;
+	if (!attr)
+		attr_size = 0;
+	if (!data)
+		data_size = 0;
+
+	if (ADD_OVERFLOW(head_size, attr_size, &size) ||
+	    ADD_OVERFLOW(size, data_size, &size)) {
+		free(fh);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
 	mutex_lock(&rpmb_mutex);
 	res = rpmb_fs_open_internal(fh, &po->uuid, true);
 	if (res)
 		goto out;
 
-	if (head && head_size) {
-		res = rpmb_fs_write_primitive(fh, pos, head, head_size);
-		if (res)
+	/*
+	 * Combine head, attrs and data into a single write. Writing the
+	 * parts separately would grow the file with each write, reading
+	 * back and rewriting what's already written, and pay one FAT
+	 * entry update per part. One write means one allocation, one
+	 * multi-block data write and one FAT entry update.
+	 */
+	if (size) {
+		buf = malloc(size);
+		if (!buf) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
 			goto out;
-		pos += head_size;
-	}
+		}
 
-	if (attr && attr_size) {
-		res = rpmb_fs_write_primitive(fh, pos, attr, attr_size);
-		if (res)
-			goto out;
-		pos += attr_size;
-	}
+		if (head_size) {
+			memcpy(buf + pos, head, head_size);
+			pos += head_size;
+		}
+		if (attr_size) {
+			memcpy(buf + pos, attr, attr_size);
+			pos += attr_size;
+		}
+		if (data_size)
+			memcpy(buf + pos, data, data_size);
 
-	if (data && data_size) {
-		res = rpmb_fs_write_primitive(fh, pos, data, data_size);
+		res = rpmb_fs_write_primitive(fh, 0, buf, size);
 		if (res)
 			goto out;
 	}
@@ -2831,6 +2959,7 @@ static TEE_Result rpmb_fs_create(struct tee_pobj *po, bool overwrite,
 	}
 
 out:
+	free(buf);
 	if (res) {
 		rpmb_fs_remove_internal(fh);
 		free(fh);
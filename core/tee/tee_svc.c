@@ -5,7 +5,9 @@
  */
 
 #include <compiler.h>
+#include <initcall.h>
 #include <kernel/chip_services.h>
+#include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/tee_common.h>
 #include <kernel/tee_common_otp.h>
@@ -17,6 +19,7 @@
 #include <mm/mobj.h>
 #include <mm/tee_mm.h>
 #include <mm/vm.h>
+#include <stdlib.h>
 #include <stdlib_ext.h>
 #include <tee_api_types.h>
 #include <tee/tee_cryp_utl.h>
@@ -338,6 +341,102 @@ static void get_prop_set(unsigned long prop_set,
 	}
 }
 
+/*
+ * Sorted hash index over each property set, built once at boot, so that
+ * looking a property name up binary searches over precomputed hashes
+ * instead of strcmp()-walking the whole array on every query.
+ */
+struct prop_index {
+	uint32_t hash;
+	uint32_t idx;
+};
+
+static struct prop_index *prop_indexes[3];
+static size_t prop_index_counts[3];
+
+static int get_prop_set_slot(unsigned long prop_set)
+{
+	if ((TEE_PropSetHandle)prop_set == TEE_PROPSET_CURRENT_CLIENT)
+		return 0;
+	if ((TEE_PropSetHandle)prop_set == TEE_PROPSET_CURRENT_TA)
+		return 1;
+	if ((TEE_PropSetHandle)prop_set == TEE_PROPSET_TEE_IMPLEMENTATION)
+		return 2;
+
+	return -1;
+}
+
+static uint32_t prop_name_hash(const char *name)
+{
+	uint32_t hash = 5381;
+
+	while (*name)
+		hash = hash * 33 + *name++;
+
+	return hash;
+}
+
+static int prop_index_cmp(const void *a, const void *b)
+{
+	const struct prop_index *ia = a;
+	const struct prop_index *ib = b;
+
+	if (ia->hash < ib->hash)
+		return -1;
+	if (ia->hash > ib->hash)
+		return 1;
+	return 0;
+}
+
+static TEE_Result init_prop_indexes(void)
+{
+	const unsigned long sets[] = {
+		(unsigned long)TEE_PROPSET_CURRENT_CLIENT,
+		(unsigned long)TEE_PROPSET_CURRENT_TA,
+		(unsigned long)TEE_PROPSET_TEE_IMPLEMENTATION,
+	};
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(sets); n++) {
+		const struct tee_props *props = NULL;
+		const struct tee_props *vendor_props = NULL;
+		struct prop_index *idx = NULL;
+		size_t vendor_size = 0;
+		size_t size = 0;
+		size_t i = 0;
+
+		get_prop_set(sets[n], &props, &size, &vendor_props,
+			     &vendor_size);
+
+		if (!size && !vendor_size)
+			continue;
+
+		idx = malloc((size + vendor_size) * sizeof(*idx));
+		if (!idx)
+			panic();
+
+		for (i = 0; i < size + vendor_size; i++) {
+			const struct tee_props *p = NULL;
+
+			if (i < size)
+				p = props + i;
+			else
+				p = vendor_props + i - size;
+			idx[i].hash = prop_name_hash(p->name);
+			idx[i].idx = i;
+		}
+
+		qsort(idx, size + vendor_size, sizeof(*idx), prop_index_cmp);
+
+		prop_indexes[get_prop_set_slot(sets[n])] = idx;
+		prop_index_counts[get_prop_set_slot(sets[n])] = size +
+								vendor_size;
+	}
+
+	return TEE_SUCCESS;
+}
+service_init(init_prop_indexes);
+
 static const struct tee_props *get_prop_struct(unsigned long prop_set,
 					       unsigned long index)
 {
@@ -449,6 +548,11 @@ TEE_Result syscall_get_property_name_to_index(unsigned long prop_set,
 	size_t size = 0;
 	const struct tee_props *vendor_props = NULL;
 	size_t vendor_size = 0;
+	const struct prop_index *idx = NULL;
+	size_t count = 0;
+	uint32_t hash = 0;
+	size_t lo = 0;
+	size_t hi = 0;
 	char *kname = NULL;
 	uint32_t i = 0;
 
@@ -470,14 +574,32 @@ TEE_Result syscall_get_property_name_to_index(unsigned long prop_set,
 	kname[name_len - 1] = 0;
 
 	res = TEE_ERROR_ITEM_NOT_FOUND;
-	for (i = 0; i < size; i++) {
-		if (!strcmp(kname, props[i].name)) {
-			res = copy_to_user(index, &i, sizeof(*index));
-			goto out;
-		}
+
+	idx = prop_indexes[get_prop_set_slot(prop_set)];
+	count = prop_index_counts[get_prop_set_slot(prop_set)];
+	hash = prop_name_hash(kname);
+
+	hi = count;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (idx[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	for (i = size; i < size + vendor_size; i++) {
-		if (!strcmp(kname, vendor_props[i - size].name)) {
+
+	/* Hash collisions sort next to each other, strcmp() breaks the tie */
+	for (; lo < count && idx[lo].hash == hash; lo++) {
+		const char *pname = NULL;
+
+		i = idx[lo].idx;
+		if (i < size)
+			pname = props[i].name;
+		else
+			pname = vendor_props[i - size].name;
+
+		if (!strcmp(kname, pname)) {
 			res = copy_to_user(index, &i, sizeof(*index));
 			goto out;
 		}
@@ -554,11 +676,75 @@ static TEE_Result alloc_temp_sec_mem(size_t size, struct mobj **mobj,
 	return TEE_SUCCESS;
 }
 
+/*
+ * The bounce buffer for TA-to-TA parameters is kept on the called session
+ * and reused across invocations, a composition invoking the same service
+ * for each request then skips a secure memory allocation per hop. Only
+ * the allocation is kept, the content is still wiped when each call
+ * returns, and the buffer is released with the session. Oversized
+ * requests fall back to a one-shot allocation.
+ */
+#define TEMP_SEC_MEM_CACHE_MAX	SMALL_PAGE_SIZE
+
+static TEE_Result get_temp_sec_mem(struct ts_session *called_sess, size_t size,
+				   struct mobj **mobj, uint8_t **va)
+{
+	struct tee_ta_session *s = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (called_sess)
+		s = to_ta_session(called_sess);
+
+	if (s && s->param_mobj) {
+		if (size <= s->param_mobj_size) {
+			*mobj = mobj_get(s->param_mobj);
+			*va = mobj_get_va(*mobj, 0);
+			return TEE_SUCCESS;
+		}
+		mobj_put_wipe(s->param_mobj);
+		s->param_mobj = NULL;
+		s->param_mobj_size = 0;
+	}
+
+	res = alloc_temp_sec_mem(size, mobj, va);
+	if (res)
+		return res;
+
+	if (s && size <= TEMP_SEC_MEM_CACHE_MAX) {
+		s->param_mobj = mobj_get(*mobj);
+		s->param_mobj_size = size;
+	}
+
+	return TEE_SUCCESS;
+}
+
+#if defined(CFG_TA_PARAM_NOCOPY) && !defined(CFG_PAGED_USER_TA)
+/*
+ * A page-exact buffer can be shared with the called TA without exposing
+ * anything else: only the pages fully covered by the memory reference are
+ * mapped. Large such buffers skip the bounce copy below, the called TA
+ * then accesses the caller's pages directly for the duration of the call,
+ * just as it does for memory references in shared memory.
+ */
+static bool param_can_be_shared(vaddr_t va, size_t size)
+{
+	return size >= CFG_TA_PARAM_NOCOPY_THRESHOLD &&
+	       !(va & SMALL_PAGE_MASK) && !(size & SMALL_PAGE_MASK);
+}
+#else
+static bool param_can_be_shared(vaddr_t va __unused, size_t size __unused)
+{
+	return false;
+}
+#endif
+
 /*
  * TA invokes some TA with parameter.
  * If some parameters are memory references:
  * - either the memref is inside TA private RAM: TA is not allowed to expose
- *   its private RAM: use a temporary memory buffer and copy the data.
+ *   its private RAM: use a temporary memory buffer and copy the data. Page
+ *   exact memory references are exempt with CFG_TA_PARAM_NOCOPY and are
+ *   shared in place.
  * - or the memref is not in the TA private RAM:
  *   - if the memref was mapped to the TA, TA is allowed to expose it.
  *   - if so, converts memref virtual address into a physical address.
@@ -573,7 +759,9 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 {
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 	bool ta_private_memref[TEE_NUM_PARAMS] = { false, };
+	struct user_access_elem batch[TEE_NUM_PARAMS] = { };
 	TEE_Result res = TEE_SUCCESS;
+	size_t num_batch = 0;
 	size_t dst_offs = 0;
 	size_t req_mem = 0;
 	uint8_t *dst = 0;
@@ -623,6 +811,26 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 			}
 			/* uTA cannot expose its private memory */
 			if (vm_buf_is_inside_um_private(&utc->uctx, va, s)) {
+				struct mobj *m = NULL;
+				size_t o = 0;
+
+				/*
+				 * Except when the buffer is page exact: then
+				 * only pages fully covered by the buffer are
+				 * shared, nothing else leaks and the bounce
+				 * copy below can be skipped.
+				 */
+				if (param_can_be_shared((vaddr_t)va, s) &&
+				    !vm_buf_to_mboj_offs(&utc->uctx, va, s,
+							 &m, &o) &&
+				    !((o + mobj_get_phys_offs(m,
+						CORE_MMU_USER_PARAM_SIZE)) &
+				      SMALL_PAGE_MASK)) {
+					param->u[n].mem.mobj = m;
+					param->u[n].mem.offs = o;
+					break;
+				}
+
 				s = ROUNDUP(s, sizeof(uint32_t));
 				if (ADD_OVERFLOW(req_mem, s, &req_mem))
 					return TEE_ERROR_BAD_PARAMETERS;
@@ -644,7 +852,7 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 	if (req_mem == 0)
 		return TEE_SUCCESS;
 
-	res = alloc_temp_sec_mem(req_mem, mobj_tmp, &dst);
+	res = get_temp_sec_mem(called_sess, req_mem, mobj_tmp, &dst);
 	if (res != TEE_SUCCESS)
 		return res;
 	dst_offs = 0;
@@ -661,10 +869,12 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 		case TEE_PARAM_TYPE_MEMREF_INOUT:
 			va = (void *)param->u[n].mem.offs;
 			if (va) {
-				res = copy_from_user(dst, va,
-						     param->u[n].mem.size);
-				if (res != TEE_SUCCESS)
-					return res;
+				batch[num_batch] = (struct user_access_elem){
+					.kaddr = dst,
+					.uaddr = va,
+					.len = param->u[n].mem.size,
+				};
+				num_batch++;
 				param->u[n].mem.offs = dst_offs;
 				param->u[n].mem.mobj = *mobj_tmp;
 				tmp_buf_va[n] = dst;
@@ -691,7 +901,11 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 		}
 	}
 
-	return TEE_SUCCESS;
+	/*
+	 * All the bounce copies are done as one batch, validating and
+	 * copying the whole parameter block in one operation.
+	 */
+	return copy_from_user_batch(batch, num_batch);
 }
 
 /*
@@ -10,6 +10,7 @@
 #include <config.h>
 #include <crypto/crypto.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/thread.h>
 #include <kernel/user_access.h>
 #include <mm/vm.h>
 #include <stdlib_ext.h>
@@ -50,6 +51,9 @@ struct tee_cryp_state {
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
 	enum cryp_state state;
+#if defined(CFG_CRYPTO_HKDF)
+	struct tee_cryp_hkdf_cache hkdf_cache;
+#endif
 };
 
 struct tee_cryp_obj_secret {
@@ -1376,6 +1380,38 @@ TEE_Result syscall_cryp_obj_reset(unsigned long obj)
 	return TEE_SUCCESS;
 }
 
+/*
+ * Per-thread scratch array for marshalled attributes. The largest object,
+ * an RSA key pair, takes 8 attributes so the attribute syscalls normally
+ * need no heap allocation, only oversized counts fall back to malloc().
+ * A thread runs one syscall at a time and each syscall marshals at most
+ * one attribute array, so the slot cannot be in use when claimed.
+ */
+#define ATTR_SCRATCH_COUNT	8
+
+static TEE_Attribute attr_scratch[CFG_NUM_THREADS][ATTR_SCRATCH_COUNT];
+
+static TEE_Attribute *alloc_attrs(size_t attr_count)
+{
+	size_t alloc_size = 0;
+
+	if (attr_count <= ATTR_SCRATCH_COUNT)
+		return attr_scratch[thread_get_id()];
+
+	if (MUL_OVERFLOW(sizeof(TEE_Attribute), attr_count, &alloc_size))
+		return NULL;
+
+	return malloc(alloc_size);
+}
+
+static void free_attrs(TEE_Attribute *attrs)
+{
+	if (attrs == attr_scratch[thread_get_id()])
+		memset(attrs, 0, sizeof(attr_scratch[0]));
+	else
+		free_wipe(attrs);
+}
+
 static TEE_Result copy_in_attrs(struct user_ta_ctx *utc,
 			const struct utee_attribute *usr_attrs,
 			uint32_t attr_count, TEE_Attribute *attrs)
@@ -1661,12 +1697,7 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 	if (!type_props)
 		return TEE_ERROR_NOT_IMPLEMENTED;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), attr_count, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	attrs = malloc(alloc_size);
+	attrs = alloc_attrs(attr_count);
 	if (!attrs)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -1685,7 +1716,7 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 		o->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
 
 out:
-	free_wipe(attrs);
+	free_attrs(attrs);
 	return res;
 }
 
@@ -1903,12 +1934,7 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	if (res)
 		return res;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), param_count, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
+	params = alloc_attrs(param_count);
 	if (!params)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	res = copy_in_attrs(to_user_ta_ctx(sess->ctx), usr_params, param_count,
@@ -1995,7 +2021,7 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	}
 
 out:
-	free_wipe(params);
+	free_attrs(params);
 	if (res == TEE_SUCCESS) {
 		o->info.keySize = key_size;
 		o->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
@@ -2019,19 +2045,32 @@ static TEE_Result tee_svc_cryp_get_state(struct ts_session *sess,
 	return TEE_ERROR_BAD_PARAMETERS;
 }
 
-static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
+/*
+ * Max number of freed crypto states kept per TA context for reuse by
+ * syscall_cryp_state_alloc(). Reusing a state recycles the provider
+ * context of the same algorithm, keeping repeated
+ * TEE_AllocateOperation()/TEE_FreeOperation() cycles off the heap.
+ */
+#define CRYP_STATE_POOL_SIZE	8
+
+static struct tee_cryp_state *cryp_state_pool_get(struct user_ta_ctx *utc,
+						  uint32_t algo)
 {
-	struct tee_obj *o;
+	struct tee_cryp_state *cs = NULL;
 
-	if (tee_obj_get(utc, cs->key1, &o) == TEE_SUCCESS)
-		tee_obj_close(utc, o);
-	if (tee_obj_get(utc, cs->key2, &o) == TEE_SUCCESS)
-		tee_obj_close(utc, o);
+	TAILQ_FOREACH(cs, &utc->cryp_pool, link) {
+		if (cs->algo == algo) {
+			TAILQ_REMOVE(&utc->cryp_pool, cs, link);
+			utc->cryp_pool_count--;
+			return cs;
+		}
+	}
 
-	TAILQ_REMOVE(&utc->cryp_states, cs, link);
-	if (cs->ctx_finalize != NULL)
-		cs->ctx_finalize(cs->ctx);
+	return NULL;
+}
 
+static void cryp_state_destroy(struct tee_cryp_state *cs)
+{
 	switch (TEE_ALG_GET_CLASS(cs->algo)) {
 	case TEE_OPERATION_CIPHER:
 		crypto_cipher_free_ctx(cs->ctx);
@@ -2052,6 +2091,44 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 	free(cs);
 }
 
+static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
+{
+	struct tee_obj *o;
+
+	if (tee_obj_get(utc, cs->key1, &o) == TEE_SUCCESS)
+		tee_obj_close(utc, o);
+	if (tee_obj_get(utc, cs->key2, &o) == TEE_SUCCESS)
+		tee_obj_close(utc, o);
+
+	TAILQ_REMOVE(&utc->cryp_states, cs, link);
+#if defined(CFG_CRYPTO_HKDF)
+	tee_cryp_hkdf_cache_clear(&cs->hkdf_cache);
+#endif
+	if (cs->ctx_finalize != NULL) {
+		cs->ctx_finalize(cs->ctx);
+		cryp_state_destroy(cs);
+		return;
+	}
+
+	if (utc->cryp_pool_count < CRYP_STATE_POOL_SIZE) {
+		/*
+		 * Keep the state and its provider context for reuse by a
+		 * later allocation with the same algorithm. The context is
+		 * reinitialized before it can be used again and it never
+		 * leaves this TA context, so no state leaks between
+		 * trust boundaries.
+		 */
+		cs->key1 = 0;
+		cs->key2 = 0;
+		cs->state = CRYP_STATE_UNINITIALIZED;
+		TAILQ_INSERT_TAIL(&utc->cryp_pool, cs, link);
+		utc->cryp_pool_count++;
+		return;
+	}
+
+	cryp_state_destroy(cs);
+}
+
 static TEE_Result tee_svc_cryp_check_key_type(const struct tee_obj *o,
 					      uint32_t algo,
 					      TEE_OperationMode mode)
@@ -2189,9 +2266,12 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 			return res;
 	}
 
-	cs = calloc(1, sizeof(struct tee_cryp_state));
-	if (!cs)
-		return TEE_ERROR_OUT_OF_MEMORY;
+	cs = cryp_state_pool_get(utc, algo);
+	if (!cs) {
+		cs = calloc(1, sizeof(struct tee_cryp_state));
+		if (!cs)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
 	TAILQ_INSERT_TAIL(&utc->cryp_states, cs, link);
 	cs->algo = algo;
 	cs->mode = mode;
@@ -2202,37 +2282,29 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 		if ((algo == TEE_ALG_AES_XTS && (key1 == 0 || key2 == 0)) ||
 		    (algo != TEE_ALG_AES_XTS && (key1 == 0 || key2 != 0))) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_cipher_alloc_ctx(&cs->ctx, algo);
-			if (res != TEE_SUCCESS)
-				break;
 		}
 		break;
 	case TEE_OPERATION_AE:
 		if (key1 == 0 || key2 != 0) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_authenc_alloc_ctx(&cs->ctx, algo);
-			if (res != TEE_SUCCESS)
-				break;
 		}
 		break;
 	case TEE_OPERATION_MAC:
 		if (key1 == 0 || key2 != 0) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_mac_alloc_ctx(&cs->ctx, algo);
-			if (res != TEE_SUCCESS)
-				break;
 		}
 		break;
 	case TEE_OPERATION_DIGEST:
 		if (key1 != 0 || key2 != 0) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_hash_alloc_ctx(&cs->ctx, algo);
-			if (res != TEE_SUCCESS)
-				break;
 		}
 		break;
 	case TEE_OPERATION_ASYMMETRIC_CIPHER:
@@ -2323,9 +2395,17 @@ TEE_Result syscall_cryp_state_copy(unsigned long dst, unsigned long src)
 void tee_svc_cryp_free_states(struct user_ta_ctx *utc)
 {
 	struct tee_cryp_state_head *states = &utc->cryp_states;
+	struct tee_cryp_state *cs = NULL;
 
 	while (!TAILQ_EMPTY(states))
 		cryp_state_free(utc, TAILQ_FIRST(states));
+
+	while (!TAILQ_EMPTY(&utc->cryp_pool)) {
+		cs = TAILQ_FIRST(&utc->cryp_pool);
+		TAILQ_REMOVE(&utc->cryp_pool, cs, link);
+		cryp_state_destroy(cs);
+	}
+	utc->cryp_pool_count = 0;
 }
 
 TEE_Result syscall_cryp_state_free(unsigned long state)
@@ -2435,6 +2515,69 @@ TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 	return TEE_SUCCESS;
 }
 
+TEE_Result syscall_hash_update_iov(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_count)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t size = 0;
+	size_t n = 0;
+
+	if (!iov_count)
+		return TEE_SUCCESS;
+
+	if (MUL_OVERFLOW(sizeof(*iov), iov_count, &size))
+		return TEE_ERROR_OVERFLOW;
+
+	res = vm_check_access_rights(uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)iov, size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	for (n = 0; n < iov_count; n++) {
+		const void *chunk = (const void *)(uaddr_t)iov[n].base;
+		size_t chunk_size = iov[n].len;
+
+		/* Zero length fragments are valid, but nothing to do. */
+		if (!chunk_size)
+			continue;
+
+		res = vm_check_access_rights(uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)chunk, chunk_size);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		switch (TEE_ALG_GET_CLASS(cs->algo)) {
+		case TEE_OPERATION_DIGEST:
+			res = crypto_hash_update(cs->ctx, chunk, chunk_size);
+			break;
+		case TEE_OPERATION_MAC:
+			res = crypto_mac_update(cs->ctx, chunk, chunk_size);
+			break;
+		default:
+			res = TEE_ERROR_BAD_PARAMETERS;
+			break;
+		}
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
 			size_t chunk_size, void *hash, uint64_t *hash_len)
 {
@@ -2665,6 +2808,115 @@ TEE_Result syscall_cipher_final(unsigned long state, const void *src,
 					    src, src_len, dst, dst_len);
 }
 
+/*
+ * Each source fragment is fed to the cipher as if passed to a separate
+ * syscall_cipher_update() call, so fragment sizes must satisfy the same
+ * constraints the algorithm puts on update sizes (e.g. multiples of the
+ * block size for ECB and CBC). The iovec array is copied in before use
+ * to guard against it being modified while being processed.
+ */
+TEE_Result syscall_cipher_update_iov(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_count,
+			void *dst, uint64_t *dst_len)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct tee_cryp_state *cs = NULL;
+	struct utee_iovec *kiov = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t src_total = 0;
+	size_t offs = 0;
+	size_t size = 0;
+	size_t dlen = 0;
+	size_t n = 0;
+
+	if (MUL_OVERFLOW(sizeof(*iov), iov_count, &size))
+		return TEE_ERROR_OVERFLOW;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	if (iov_count) {
+		res = vm_check_access_rights(uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)iov, size);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		kiov = malloc(size);
+		if (!kiov)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		memcpy(kiov, iov, size);
+	}
+
+	for (n = 0; n < iov_count; n++) {
+		if (ADD_OVERFLOW(src_total, (size_t)kiov[n].len, &src_total)) {
+			res = TEE_ERROR_OVERFLOW;
+			goto out;
+		}
+
+		res = vm_check_access_rights(uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)kiov[n].base,
+					     kiov[n].len);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
+	if (dst_len) {
+		uint32_t flags = TEE_MEMORY_ACCESS_READ |
+				 TEE_MEMORY_ACCESS_WRITE |
+				 TEE_MEMORY_ACCESS_ANY_OWNER;
+
+		res = get_user_u64_as_size_t(&dlen, dst_len);
+		if (res != TEE_SUCCESS)
+			goto out;
+
+		res = vm_check_access_rights(uctx, flags, (uaddr_t)dst, dlen);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
+	if (dlen < src_total) {
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	for (n = 0; n < iov_count; n++) {
+		const void *src = (const void *)(uaddr_t)kiov[n].base;
+		size_t src_len = kiov[n].len;
+
+		/* Permit zero length fragments */
+		if (!src_len)
+			continue;
+
+		res = tee_do_cipher_update(cs->ctx, cs->algo, cs->mode,
+					   false /* last_block */, src,
+					   src_len, (uint8_t *)dst + offs);
+		if (res != TEE_SUCCESS)
+			goto out;
+		offs += src_len;
+	}
+
+out:
+	if ((res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) &&
+	    dst_len != NULL) {
+		TEE_Result res2 = put_user_u64(dst_len, src_total);
+
+		if (res2 != TEE_SUCCESS)
+			res = res2;
+	}
+	free(kiov);
+
+	return res;
+}
+
 #if defined(CFG_CRYPTO_HKDF)
 static TEE_Result get_hkdf_params(const TEE_Attribute *params,
 				  uint32_t param_count,
@@ -2926,10 +3178,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), param_count, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
+	params = alloc_attrs(param_count);
 	if (!params)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	res = copy_in_attrs(utc, usr_params, param_count, params);
@@ -3073,8 +3322,8 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 		}
 
 		res = tee_cryp_hkdf(hash_id, ikm, ik->key_size, salt, salt_len,
-				    info, info_len, (uint8_t *)(sk + 1),
-				    okm_len);
+				    info, info_len, &cs->hkdf_cache,
+				    (uint8_t *)(sk + 1), okm_len);
 		if (res == TEE_SUCCESS) {
 			sk->key_size = okm_len;
 			so->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
@@ -3180,7 +3429,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 		res = TEE_ERROR_NOT_SUPPORTED;
 
 out:
-	free_wipe(params);
+	free_attrs(params);
 	return res;
 }
 
@@ -3331,6 +3580,123 @@ out:
 	return res;
 }
 
+/*
+ * Vectored variant of syscall_authenc_update_payload(). A payload
+ * scattered over several buffers, as with media frames assembled from
+ * descriptor lists, is processed in a single syscall instead of one
+ * syscall per fragment. The fragments are written back to back into
+ * @dst_data; the iovec array is copied in before use so it cannot change
+ * while the source buffers are checked and processed.
+ */
+TEE_Result syscall_authenc_update_payload_iov(unsigned long state,
+					      const struct utee_iovec *iov,
+					      size_t iov_count, void *dst_data,
+					      uint64_t *dst_len)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct tee_cryp_state *cs = NULL;
+	struct utee_iovec *kiov = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t src_total = 0;
+	size_t acc_dlen = 0;
+	size_t size = 0;
+	size_t dlen = 0;
+	size_t n = 0;
+
+	if (MUL_OVERFLOW(sizeof(*iov), iov_count, &size))
+		return TEE_ERROR_OVERFLOW;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	if (TEE_ALG_GET_CLASS(cs->algo) != TEE_OPERATION_AE)
+		return TEE_ERROR_BAD_STATE;
+
+	if (iov_count) {
+		res = vm_check_access_rights(uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)iov, size);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		kiov = malloc(size);
+		if (!kiov)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		memcpy(kiov, iov, size);
+	}
+
+	for (n = 0; n < iov_count; n++) {
+		if (ADD_OVERFLOW(src_total, (size_t)kiov[n].len, &src_total)) {
+			res = TEE_ERROR_OVERFLOW;
+			goto out;
+		}
+
+		res = vm_check_access_rights(uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)kiov[n].base,
+					     kiov[n].len);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
+	res = get_user_u64_as_size_t(&dlen, dst_len);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = vm_check_access_rights(uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_WRITE |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)dst_data, dlen);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	if (dlen < src_total) {
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	for (n = 0; n < iov_count; n++) {
+		const void *src = (const void *)(uaddr_t)kiov[n].base;
+		size_t src_len = kiov[n].len;
+		size_t tmp_dlen = dlen - acc_dlen;
+
+		/* Permit zero length fragments */
+		if (!src_len)
+			continue;
+
+		res = crypto_authenc_update_payload(cs->ctx, cs->mode, src,
+						    src_len,
+						    (uint8_t *)dst_data +
+						    acc_dlen, &tmp_dlen);
+		if (res != TEE_SUCCESS)
+			goto out;
+		acc_dlen += tmp_dlen;
+	}
+
+out:
+	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
+		TEE_Result res2 = TEE_SUCCESS;
+
+		if (res == TEE_ERROR_SHORT_BUFFER)
+			res2 = put_user_u64(dst_len, src_total);
+		else
+			res2 = put_user_u64(dst_len, acc_dlen);
+		if (res2 != TEE_SUCCESS)
+			res = res2;
+	}
+	free(kiov);
+
+	return res;
+}
+
 TEE_Result syscall_authenc_enc_final(unsigned long state, const void *src_data,
 				     size_t src_len, void *dst_data,
 				     uint64_t *dst_len, void *tag,
@@ -3549,12 +3915,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
+	params = alloc_attrs(num_params);
 	if (!params)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	res = copy_in_attrs(utc, usr_params, num_params, params);
@@ -3679,7 +4040,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	}
 
 out:
-	free_wipe(params);
+	free_attrs(params);
 
 	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
 		TEE_Result res2 = put_user_u64(dst_len, dlen);
@@ -3691,62 +4052,16 @@ out:
 	return res;
 }
 
-TEE_Result syscall_asymm_verify(unsigned long state,
-			const struct utee_attribute *usr_params,
+static TEE_Result asymm_verify_digest(struct tee_cryp_state *cs,
+			struct tee_obj *o, const TEE_Attribute *params,
 			size_t num_params, const void *data, size_t data_len,
 			const void *sig, size_t sig_len)
 {
-	struct ts_session *sess = ts_get_current_session();
-	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
-	struct tee_cryp_state *cs = NULL;
 	TEE_Result res = TEE_SUCCESS;
-	TEE_Attribute *params = NULL;
-	struct tee_obj *o = NULL;
 	size_t hash_size = 0;
 	uint32_t hash_algo = 0;
 	int salt_len = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	if (cs->mode != TEE_MODE_VERIFY)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	res = vm_check_access_rights(&utc->uctx,
-				     TEE_MEMORY_ACCESS_READ |
-				     TEE_MEMORY_ACCESS_ANY_OWNER,
-				     (uaddr_t)data, data_len);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	res = vm_check_access_rights(&utc->uctx,
-				     TEE_MEMORY_ACCESS_READ |
-				     TEE_MEMORY_ACCESS_ANY_OWNER,
-				     (uaddr_t)sig, sig_len);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
-	if (!params)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = copy_in_attrs(utc, usr_params, num_params, params);
-	if (res != TEE_SUCCESS)
-		goto out;
-
-	res = tee_obj_get(utc, cs->key1, &o);
-	if (res != TEE_SUCCESS)
-		goto out;
-	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0) {
-		res = TEE_ERROR_BAD_PARAMETERS;
-		goto out;
-	}
-
 	switch (TEE_ALG_GET_MAIN_ALG(cs->algo)) {
 	case TEE_MAIN_ALGO_RSA:
 		if (cs->algo != TEE_ALG_RSASSA_PKCS1_V1_5) {
@@ -3822,7 +4137,176 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 		res = TEE_ERROR_NOT_SUPPORTED;
 	}
 
+	return res;
+}
+
+TEE_Result syscall_asymm_verify(unsigned long state,
+			const struct utee_attribute *usr_params,
+			size_t num_params, const void *data, size_t data_len,
+			const void *sig, size_t sig_len)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Attribute *params = NULL;
+	struct tee_obj *o = NULL;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->mode != TEE_MODE_VERIFY)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)data, data_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)sig, sig_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	params = alloc_attrs(num_params);
+	if (!params)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	res = copy_in_attrs(utc, usr_params, num_params, params);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = tee_obj_get(utc, cs->key1, &o);
+	if (res != TEE_SUCCESS)
+		goto out;
+	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = asymm_verify_digest(cs, o, params, num_params, data, data_len,
+				  sig, sig_len);
+
+out:
+	free_attrs(params);
+	return res;
+}
+
+/*
+ * Batch variant of syscall_asymm_verify(). Verifies @count
+ * (digest, signature) pairs, given as two arrays of struct utee_iovec,
+ * against the key of @state in one syscall, amortizing the state lookup,
+ * attribute copy-in and buffer checks over the whole batch. Processing
+ * stops at the first pair that fails to verify; its index is reported in
+ * *@failed_idx together with the verification error.
+ */
+TEE_Result syscall_asymm_verify_batch(unsigned long state,
+			const struct utee_attribute *usr_params,
+			size_t num_params, const struct utee_iovec *data_iov,
+			const struct utee_iovec *sig_iov, size_t count,
+			uint64_t *failed_idx)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Attribute *params = NULL;
+	struct utee_iovec *kdata = NULL;
+	struct utee_iovec *ksig = NULL;
+	struct tee_obj *o = NULL;
+	size_t size = 0;
+	size_t n = 0;
+
+	if (!count)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->mode != TEE_MODE_VERIFY)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (MUL_OVERFLOW(sizeof(*data_iov), count, &size))
+		return TEE_ERROR_OVERFLOW;
+
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)data_iov, size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)sig_iov, size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	kdata = malloc(size);
+	ksig = malloc(size);
+	params = alloc_attrs(num_params);
+	if (!kdata || !ksig || !params) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	/* Copy the iovec arrays in so they cannot change while processing */
+	memcpy(kdata, data_iov, size);
+	memcpy(ksig, sig_iov, size);
+
+	for (n = 0; n < count; n++) {
+		res = vm_check_access_rights(&utc->uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)kdata[n].base,
+					     kdata[n].len);
+		if (res != TEE_SUCCESS)
+			goto out;
+
+		res = vm_check_access_rights(&utc->uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     (uaddr_t)ksig[n].base,
+					     ksig[n].len);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
+	res = copy_in_attrs(utc, usr_params, num_params, params);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = tee_obj_get(utc, cs->key1, &o);
+	if (res != TEE_SUCCESS)
+		goto out;
+	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	for (n = 0; n < count; n++) {
+		res = asymm_verify_digest(cs, o, params, num_params,
+					  (const void *)(uaddr_t)kdata[n].base,
+					  kdata[n].len,
+					  (const void *)(uaddr_t)ksig[n].base,
+					  ksig[n].len);
+		if (res != TEE_SUCCESS) {
+			TEE_Result res2 = put_user_u64(failed_idx, n);
+
+			if (res2 != TEE_SUCCESS)
+				res = res2;
+			break;
+		}
+	}
+
 out:
-	free_wipe(params);
+	free_attrs(params);
+	free(kdata);
+	free(ksig);
 	return res;
 }
@@ -168,6 +168,23 @@ TEE_Result sys_map_ta_bin(vaddr_t *va, size_t num_bytes, uint32_t flags,
 	return res;
 }
 
+TEE_Result sys_map_ta_segs(uint32_t handle, struct pta_system_seg_map *segs,
+			   size_t num_segs)
+{
+	struct utee_params params = {
+		.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					 TEE_PARAM_TYPE_MEMREF_INOUT,
+					 TEE_PARAM_TYPE_NONE,
+					 TEE_PARAM_TYPE_NONE),
+	};
+
+	params.vals[0] = handle;
+	params.vals[2] = (vaddr_t)segs;
+	params.vals[3] = num_segs * sizeof(*segs);
+
+	return invoke_sys_ta(PTA_SYSTEM_MAP_TA_SEGMENTS, &params);
+}
+
 
 TEE_Result sys_copy_from_ta_bin(void *dst, size_t num_bytes, uint32_t handle,
 				size_t offs)
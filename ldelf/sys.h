@@ -7,6 +7,7 @@
 #define SYS_H
 
 #include <compiler.h>
+#include <pta_system.h>
 #include <stddef.h>
 #include <tee_api_types.h>
 #include <trace.h>
@@ -41,6 +42,8 @@ TEE_Result sys_close_ta_bin(uint32_t handle);
 TEE_Result sys_map_ta_bin(vaddr_t *va, size_t num_bytes, uint32_t flags,
 			  uint32_t handle, size_t offs, size_t pad_begin,
 			  size_t pad_end);
+TEE_Result sys_map_ta_segs(uint32_t handle, struct pta_system_seg_map *segs,
+			   size_t num_segs);
 TEE_Result sys_copy_from_ta_bin(void *dst, size_t num_bytes, uint32_t handle,
 				size_t offs);
 TEE_Result sys_set_prot(vaddr_t va, size_t num_bytes, uint32_t flags);
@@ -724,10 +724,45 @@ static size_t get_pad_begin(void)
 #endif /*!CFG_TA_ASLR*/
 }
 
+static void flush_seg_maps(struct ta_elf *elf,
+			   struct pta_system_seg_map *segs, size_t *num_segs)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!*num_segs)
+		return;
+
+	res = sys_map_ta_segs(elf->handle, segs, *num_segs);
+	if (res)
+		err(res, "sys_map_ta_segs");
+	*num_segs = 0;
+}
+
+static void queue_seg_map(struct ta_elf *elf, struct pta_system_seg_map *segs,
+			  size_t *num_segs, vaddr_t va, size_t offs,
+			  size_t filesz, size_t memsz, uint32_t flags,
+			  size_t pad_end)
+{
+	if (*num_segs == PTA_SYSTEM_MAX_SEG_MAPS)
+		flush_seg_maps(elf, segs, num_segs);
+
+	segs[*num_segs] = (struct pta_system_seg_map){
+		.va = va,
+		.offs = offs,
+		.filesz = filesz,
+		.memsz = memsz,
+		.flags = flags,
+		.pad_end = pad_end,
+	};
+	(*num_segs)++;
+}
+
 static void populate_segments(struct ta_elf *elf)
 {
+	struct pta_system_seg_map seg_maps[PTA_SYSTEM_MAX_SEG_MAPS] = { };
 	TEE_Result res = TEE_SUCCESS;
 	struct segment *seg = NULL;
+	size_t num_seg_maps = 0;
 	vaddr_t va = 0;
 	size_t pad_begin = 0;
 
@@ -741,6 +776,13 @@ static void populate_segments(struct ta_elf *elf)
 			size_t num_bytes = roundup(seg->vaddr + seg->memsz) -
 					   rounddown(seg->vaddr);
 
+			/*
+			 * copy_remapped_to() reads from the binary, make
+			 * sure queued segments with lower offsets have been
+			 * copied first.
+			 */
+			flush_seg_maps(elf, seg_maps, &num_seg_maps);
+
 			assert(elf->load_addr);
 			va = rounddown(elf->load_addr + seg->vaddr);
 			assert(va >= elf->max_addr);
@@ -783,10 +825,11 @@ static void populate_segments(struct ta_elf *elf)
 						    roundup(vaddr) -
 						    SMALL_PAGE_SIZE;
 					assert(num_bytes);
-					res = sys_map_zi(num_bytes, 0, &va, 0,
-							 0);
-					if (res)
-						err(res, "sys_map_zi");
+					queue_seg_map(elf, seg_maps,
+						      &num_seg_maps, va, 0, 0,
+						      num_bytes,
+						      PTA_SYSTEM_MAP_FLAG_WRITEABLE,
+						      0);
 					elf->max_addr = roundup(va + num_bytes);
 					continue;
 				}
@@ -798,19 +841,6 @@ static void populate_segments(struct ta_elf *elf)
 				offset += SMALL_PAGE_SIZE;
 			}
 
-			if (!elf->load_addr) {
-				va = 0;
-				pad_begin = get_pad_begin();
-				/*
-				 * If mapping with pad_begin fails we'll
-				 * retry without pad_begin, effectively
-				 * disabling ASLR for the current ELF file.
-				 */
-			} else {
-				va = vaddr + elf->load_addr;
-				pad_begin = 0;
-			}
-
 			if (seg->flags & PF_W)
 				flags |= PTA_SYSTEM_MAP_FLAG_WRITEABLE;
 			else
@@ -820,6 +850,38 @@ static void populate_segments(struct ta_elf *elf)
 			if (!(seg->flags & PF_R))
 				err(TEE_ERROR_NOT_SUPPORTED,
 				    "Segment must be readable");
+			if (!(flags & PTA_SYSTEM_MAP_FLAG_WRITEABLE) &&
+			    filesz != memsz)
+				err(TEE_ERROR_BAD_FORMAT,
+				    "Filesz and memsz mismatch");
+
+			if (elf->load_addr) {
+				/*
+				 * The load address is settled so the
+				 * address of this segment is known, queue
+				 * it and let the system PTA map and
+				 * populate the whole run in a single
+				 * invocation.
+				 */
+				queue_seg_map(elf, seg_maps, &num_seg_maps,
+					      vaddr + elf->load_addr, offset,
+					      filesz, memsz, flags, pad_end);
+				elf->max_addr = roundup(vaddr +
+							elf->load_addr +
+							memsz);
+				elf->max_offs += filesz;
+				continue;
+			}
+
+			/*
+			 * First load segment, map it individually to
+			 * settle the load address. If mapping with
+			 * pad_begin fails we'll retry without pad_begin,
+			 * effectively disabling ASLR for the current ELF
+			 * file.
+			 */
+			va = 0;
+			pad_begin = get_pad_begin();
 			if (flags & PTA_SYSTEM_MAP_FLAG_WRITEABLE) {
 				res = sys_map_zi(memsz, 0, &va, pad_begin,
 						 pad_end);
@@ -833,9 +895,6 @@ static void populate_segments(struct ta_elf *elf)
 				if (res)
 					err(res, "sys_copy_from_ta_bin");
 			} else {
-				if (filesz != memsz)
-					err(TEE_ERROR_BAD_FORMAT,
-					    "Filesz and memsz mismatch");
 				res = sys_map_ta_bin(&va, filesz, flags,
 						     elf->handle, offset,
 						     pad_begin, pad_end);
@@ -848,12 +907,13 @@ static void populate_segments(struct ta_elf *elf)
 					err(res, "sys_map_ta_bin");
 			}
 
-			if (!elf->load_addr)
-				elf->load_addr = va;
+			elf->load_addr = va;
 			elf->max_addr = roundup(va + memsz);
 			elf->max_offs += filesz;
 		}
 	}
+
+	flush_seg_maps(elf, seg_maps, &num_seg_maps);
 }
 
 static void map_segments(struct ta_elf *elf)
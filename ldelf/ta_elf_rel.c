@@ -9,6 +9,7 @@
 #include <elf32.h>
 #include <elf64.h>
 #include <elf_common.h>
+#include <stdlib.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <util.h>
@@ -142,20 +143,10 @@ static TEE_Result resolve_sym_helper(uint32_t hash, const char *name,
 	return TEE_ERROR_ITEM_NOT_FOUND;
 }
 
-/*
- * Look for named symbol in @elf, or all modules if @elf == NULL. Global symbols
- * are searched first, then weak ones. Last option, when at least one weak but
- * undefined symbol exists, resolve to zero. Otherwise return
- * TEE_ERROR_ITEM_NOT_FOUND.
- * @val (if != 0) receives the symbol value
- * @found_elf (if != 0) receives the module where the symbol is found
- */
-TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val,
-			      struct ta_elf **found_elf,
-			      struct ta_elf *elf)
+static TEE_Result resolve_sym_in_queue(uint32_t hash, const char *name,
+				       vaddr_t *val, struct ta_elf **found_elf,
+				       struct ta_elf *elf)
 {
-	uint32_t hash = elf_hash(name);
-
 	if (elf) {
 		/* Search global symbols */
 		if (!resolve_sym_helper(hash, name, val, elf,
@@ -184,6 +175,55 @@ success:
 	return TEE_SUCCESS;
 }
 
+/*
+ * Look for named symbol in @elf, or all modules if @elf == NULL. Global symbols
+ * are searched first, then weak ones. Last option, when at least one weak but
+ * undefined symbol exists, resolve to zero. Otherwise return
+ * TEE_ERROR_ITEM_NOT_FOUND.
+ * @val (if != 0) receives the symbol value
+ * @found_elf (if != 0) receives the module where the symbol is found
+ */
+TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val,
+			      struct ta_elf **found_elf,
+			      struct ta_elf *elf)
+{
+	return resolve_sym_in_queue(elf_hash(name), name, val, found_elf, elf);
+}
+
+/*
+ * Cache of symbol resolutions made while relocating. The same symbol is
+ * typically resolved several times: it can have both a GOT and a PLT
+ * entry, and the REL format used by 32-bit modules emits one relocation
+ * per reference. A resolution is only valid for a given set of loaded
+ * modules, so the cache is flushed whenever a module has been added to
+ * the queue (they are never removed).
+ */
+#define RESOLV_CACHE_SIZE	64	/* must be a power of two */
+
+struct resolv_cache_entry {
+	const char *name;
+	uint32_t hash;
+	vaddr_t val;
+	struct ta_elf *mod;
+};
+
+static struct resolv_cache_entry resolv_cache[RESOLV_CACHE_SIZE];
+static size_t resolv_cache_num_mods;
+
+static void resolv_cache_flush_if_stale(void)
+{
+	struct ta_elf *elf = NULL;
+	size_t num_mods = 0;
+
+	TAILQ_FOREACH(elf, &main_elf_queue, link)
+		num_mods++;
+
+	if (num_mods != resolv_cache_num_mods) {
+		memset(resolv_cache, 0, sizeof(resolv_cache));
+		resolv_cache_num_mods = num_mods;
+	}
+}
+
 static void e32_get_sym_name(const Elf32_Sym *sym_tab, size_t num_syms,
 			     const char *str_tab, size_t str_tab_size,
 			     Elf32_Rel *rel, const char **name)
@@ -204,10 +244,31 @@ static void e32_get_sym_name(const Elf32_Sym *sym_tab, size_t num_syms,
 
 static void resolve_sym(const char *name, vaddr_t *val, struct ta_elf **mod)
 {
-	TEE_Result res = ta_elf_resolve_sym(name, val, mod, NULL);
+	uint32_t hash = elf_hash(name);
+	struct resolv_cache_entry *e = NULL;
+	struct ta_elf *m = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t v = 0;
+
+	e = resolv_cache + (hash & (RESOLV_CACHE_SIZE - 1));
+	if (e->name && e->hash == hash && !strcmp(e->name, name)) {
+		v = e->val;
+		m = e->mod;
+	} else {
+		res = resolve_sym_in_queue(hash, name, &v, &m, NULL);
+		if (res)
+			err(res, "Symbol %s not found", name);
+		/* @name points into the mapped dynstr of a module */
+		e->name = name;
+		e->hash = hash;
+		e->val = v;
+		e->mod = m;
+	}
 
-	if (res)
-		err(res, "Symbol %s not found", name);
+	if (val)
+		*val = v;
+	if (mod)
+		*mod = m;
 }
 
 static void e32_process_dyn_rel(const Elf32_Sym *sym_tab, size_t num_syms,
@@ -610,6 +671,8 @@ void ta_elf_relocate(struct ta_elf *elf)
 {
 	size_t n = 0;
 
+	resolv_cache_flush_if_stale();
+
 	if (elf->is_32bit) {
 		Elf32_Shdr *shdr = elf->shdr;
 
@@ -624,4 +687,14 @@ void ta_elf_relocate(struct ta_elf *elf)
 				e64_relocate(elf, n);
 
 	}
+
+	/*
+	 * The section headers were only needed to locate the dynamic symbol
+	 * table and the relocation sections, all consumed by now. A module
+	 * is relocated once, so free the table instead of keeping it for
+	 * the lifetime of the TA.
+	 */
+	free(elf->shdr);
+	elf->shdr = NULL;
+	elf->e_shnum = 0;
 }
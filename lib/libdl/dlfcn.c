@@ -33,8 +33,12 @@ static TEE_Result invoke_system_pta(uint32_t cmd_id, uint32_t param_types,
 
 struct dl_handle {
 	TEE_UUID uuid;
+	unsigned int count;
+	struct dl_handle *next;
 };
 
+static struct dl_handle *dl_handles;
+
 void *dlopen(const char *filename, int flags)
 {
 	TEE_Param params[TEE_NUM_PARAMS] = { };
@@ -43,15 +47,31 @@ void *dlopen(const char *filename, int flags)
 	TEE_Result res = TEE_ERROR_GENERIC;
 	TEE_UUID uuid = { };
 
+	if (filename) {
+		res = tee_uuid_from_str(&uuid, filename);
+		if (res)
+			return NULL;
+	}
+
+	/*
+	 * Libraries stay loaded until the last handle is closed, so a
+	 * repeated dlopen() of the same UUID is resolved here without
+	 * re-entering ldelf. This also keeps the ELF init functions from
+	 * running a second time.
+	 */
+	for (h = dl_handles; h; h = h->next) {
+		if (!memcmp(&h->uuid, &uuid, sizeof(uuid))) {
+			h->count++;
+			hcount++;
+			return (void *)h;
+		}
+	}
+
 	h = malloc(sizeof(*h));
 	if (!h)
 		return NULL;
 
 	if (filename) {
-		res = tee_uuid_from_str(&uuid, filename);
-		if (res)
-			goto err;
-
 		param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
 					      TEE_PARAM_TYPE_VALUE_INPUT,
 					      TEE_PARAM_TYPE_NONE,
@@ -71,6 +91,9 @@ void *dlopen(const char *filename, int flags)
 
 	hcount++;
 	h->uuid = uuid;
+	h->count = 1;
+	h->next = dl_handles;
+	dl_handles = h;
 	return (void *)h;
 err:
 	free(h);
@@ -79,7 +102,21 @@ err:
 
 int dlclose(void *handle)
 {
-	free(handle);
+	struct dl_handle *h = handle;
+	struct dl_handle **prev = NULL;
+
+	if (h) {
+		h->count--;
+		if (!h->count) {
+			for (prev = &dl_handles; *prev; prev = &(*prev)->next) {
+				if (*prev == h) {
+					*prev = h->next;
+					break;
+				}
+			}
+			free(h);
+		}
+	}
 	hcount--;
 	if (!hcount && sess != TEE_HANDLE_NULL) {
 		TEE_CloseTASession(sess);
@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <crypto/crypto.h>
+#include <kernel/mutex.h>
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/pk.h>
@@ -90,6 +91,121 @@ static uint32_t tee_algo_to_mbedtls_hash_algo(uint32_t algo)
 	}
 }
 
+/*
+ * mbedtls_rsa_private() lazily computes the Montgomery constants RN, RP
+ * and RQ and a blinding pair Vi/Vf for the context it operates on. Since
+ * a fresh context is built around the key bignums for every operation,
+ * these helpers used to be recomputed on each call, which costs an extra
+ * exponentiation for the blinding pair alone. Keep the helpers of the
+ * most recently used private keys keyed by modulus and move them into
+ * the operation context on a match. The lock is only held while moving
+ * values in or out, never during the operation itself, so a concurrent
+ * operation on the same key simply starts cold.
+ */
+#define RSA_HELPER_CACHE_ENTRIES	2
+
+struct rsa_helper_cache_entry {
+	bool valid;
+	size_t use_count;
+	mbedtls_mpi N;	/* Modulus the helpers belong to */
+	mbedtls_mpi RN;
+	mbedtls_mpi RP;
+	mbedtls_mpi RQ;
+	mbedtls_mpi Vi;
+	mbedtls_mpi Vf;
+};
+
+static struct rsa_helper_cache_entry rsa_helper_cache[RSA_HELPER_CACHE_ENTRIES];
+static size_t rsa_helper_cache_ctr;
+static bool rsa_helper_cache_inited;
+static struct mutex rsa_helper_cache_lock = MUTEX_INITIALIZER;
+
+/* Move the value of @src to @dst, leaving @src empty */
+static void mpi_move(mbedtls_mpi *dst, mbedtls_mpi *src)
+{
+	mbedtls_mpi_free(dst);
+	*dst = *src;
+	mbedtls_mpi_init(src);
+}
+
+/* Must be called with rsa_helper_cache_lock held */
+static void rsa_helper_cache_init(void)
+{
+	struct rsa_helper_cache_entry *ce = NULL;
+	size_t n = 0;
+
+	if (rsa_helper_cache_inited)
+		return;
+
+	for (n = 0; n < RSA_HELPER_CACHE_ENTRIES; n++) {
+		ce = rsa_helper_cache + n;
+		mbedtls_mpi_init(&ce->N);
+		mbedtls_mpi_init(&ce->RN);
+		mbedtls_mpi_init(&ce->RP);
+		mbedtls_mpi_init(&ce->RQ);
+		mbedtls_mpi_init(&ce->Vi);
+		mbedtls_mpi_init(&ce->Vf);
+	}
+	rsa_helper_cache_inited = true;
+}
+
+static void rsa_helper_cache_take(mbedtls_rsa_context *rsa)
+{
+	struct rsa_helper_cache_entry *ce = NULL;
+	size_t n = 0;
+
+	mutex_lock(&rsa_helper_cache_lock);
+	rsa_helper_cache_init();
+	for (n = 0; n < RSA_HELPER_CACHE_ENTRIES; n++) {
+		ce = rsa_helper_cache + n;
+		if (ce->valid && !mbedtls_mpi_cmp_mpi(&ce->N, &rsa->N)) {
+			mpi_move(&rsa->RN, &ce->RN);
+			mpi_move(&rsa->RP, &ce->RP);
+			mpi_move(&rsa->RQ, &ce->RQ);
+			mpi_move(&rsa->Vi, &ce->Vi);
+			mpi_move(&rsa->Vf, &ce->Vf);
+			ce->valid = false;
+			break;
+		}
+	}
+	mutex_unlock(&rsa_helper_cache_lock);
+}
+
+static void rsa_helper_cache_put(mbedtls_rsa_context *rsa)
+{
+	struct rsa_helper_cache_entry *ce = NULL;
+	size_t n = 0;
+
+	mutex_lock(&rsa_helper_cache_lock);
+	rsa_helper_cache_init();
+	/* Prefer the slot already holding this modulus, else plain LRU */
+	for (n = 0; n < RSA_HELPER_CACHE_ENTRIES; n++) {
+		if (!mbedtls_mpi_cmp_mpi(&rsa_helper_cache[n].N, &rsa->N)) {
+			ce = rsa_helper_cache + n;
+			break;
+		}
+	}
+	if (!ce) {
+		ce = rsa_helper_cache;
+		for (n = 1; n < RSA_HELPER_CACHE_ENTRIES; n++)
+			if (rsa_helper_cache[n].use_count < ce->use_count)
+				ce = rsa_helper_cache + n;
+		ce->valid = false;
+		if (mbedtls_mpi_copy(&ce->N, &rsa->N))
+			goto out;
+	}
+	mpi_move(&ce->RN, &rsa->RN);
+	mpi_move(&ce->RP, &rsa->RP);
+	mpi_move(&ce->RQ, &rsa->RQ);
+	mpi_move(&ce->Vi, &rsa->Vi);
+	mpi_move(&ce->Vf, &rsa->Vf);
+	rsa_helper_cache_ctr++;
+	ce->use_count = rsa_helper_cache_ctr;
+	ce->valid = true;
+out:
+	mutex_unlock(&rsa_helper_cache_lock);
+}
+
 static void rsa_init_from_key_pair(mbedtls_rsa_context *rsa,
 				struct rsa_keypair *key)
 {
@@ -106,10 +222,19 @@ static void rsa_init_from_key_pair(mbedtls_rsa_context *rsa,
 		rsa->DQ = *(mbedtls_mpi *)key->dq;
 	}
 	rsa->len = mbedtls_mpi_size(&rsa->N);
+
+	rsa_helper_cache_take(rsa);
 }
 
 static void mbd_rsa_free(mbedtls_rsa_context *rsa)
 {
+	/*
+	 * Keep the computed Montgomery and blinding helpers for the next
+	 * operation with this key. Storing empty helpers is harmless, they
+	 * are recomputed on use.
+	 */
+	rsa_helper_cache_put(rsa);
+
 	/* Reset mpi to skip freeing here, those mpis will be freed with key */
 	mbedtls_mpi_init(&rsa->E);
 	mbedtls_mpi_init(&rsa->N);
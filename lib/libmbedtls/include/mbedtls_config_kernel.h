@@ -9,6 +9,8 @@
 #ifdef ARM64
 #define MBEDTLS_HAVE_INT64
 #endif
+/* Use the assembly bignum inner loops (umaal/umulh) from bn_mul.h */
+#define MBEDTLS_HAVE_ASM
 #define MBEDTLS_BIGNUM_C
 #define MBEDTLS_GENPRIME
 
@@ -31,7 +33,7 @@
 #if defined(CFG_CRYPTO_SHA224) || defined(CFG_CRYPTO_SHA256)
 #define MBEDTLS_SHA256_C
 #define MBEDTLS_MD_C
-#if defined(CFG_CRYPTO_SHA256_ACCEL)
+#if defined(CFG_CORE_CRYPTO_SHA256_ACCEL)
 #define MBEDTLS_SHA256_PROCESS_ALT
 #endif
 #endif
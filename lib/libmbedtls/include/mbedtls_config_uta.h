@@ -9,6 +9,15 @@
  */
 #define MBEDTLS_HAVE_INT32
 
+/*
+ * Use the assembly bignum inner loops (umaal) from bn_mul.h. The AArch64
+ * assembly assumes 64-bit limbs so it cannot be used together with
+ * MBEDTLS_HAVE_INT32, 64-bit TAs stick to the generic C loops.
+ */
+#ifdef ARM32
+#define MBEDTLS_HAVE_ASM
+#endif
+
 #define MBEDTLS_CIPHER_MODE_CBC
 #define MBEDTLS_PKCS1_V15
 
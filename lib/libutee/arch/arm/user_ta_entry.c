@@ -37,6 +37,33 @@ uint32_t ta_param_types;
 TEE_Param ta_params[TEE_NUM_PARAMS];
 struct __elf_phdr_info __elf_phdr_info;
 
+#ifdef CFG_TA_GROWABLE_HEAP
+/* Granularity when growing the heap with on-demand mappings */
+#define HEAP_GROW_SIZE	(32 * 1024)
+
+/*
+ * Grow the heap by mapping more zero initialized memory when an
+ * allocation doesn't fit in the pools registered so far. The new pool
+ * stays mapped for the rest of the life of the TA instance.
+ */
+bool __malloc_grow(size_t size)
+{
+	size_t sz = 0;
+	void *p = NULL;
+
+	if (ADD_OVERFLOW(size, HEAP_GROW_SIZE, &sz))
+		return false;
+	sz = ROUNDUP(sz, HEAP_GROW_SIZE);
+
+	p = tee_map_zi(sz, 0);
+	if (!p)
+		return false;
+
+	malloc_add_pool(p, sz);
+	return true;
+}
+#endif
+
 struct phdr_info {
 	struct dl_phdr_info info;
 	TAILQ_ENTRY(phdr_info) link;
@@ -382,6 +409,7 @@ TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 		break;
 	}
 	ta_header_save_params(0, NULL);
+	__utee_transient_arena_reset();
 
 	return res;
 }
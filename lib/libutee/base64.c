@@ -8,6 +8,26 @@
 static const char base64_table[] =
 	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/*
+ * Reverse lookup, the value is the 6-bit index plus one so that zero
+ * marks a character that isn't part of the base64 alphabet.
+ */
+static const uint8_t base64_rev[256] = {
+	['A'] = 1,  ['B'] = 2,  ['C'] = 3,  ['D'] = 4,  ['E'] = 5,
+	['F'] = 6,  ['G'] = 7,  ['H'] = 8,  ['I'] = 9,  ['J'] = 10,
+	['K'] = 11, ['L'] = 12, ['M'] = 13, ['N'] = 14, ['O'] = 15,
+	['P'] = 16, ['Q'] = 17, ['R'] = 18, ['S'] = 19, ['T'] = 20,
+	['U'] = 21, ['V'] = 22, ['W'] = 23, ['X'] = 24, ['Y'] = 25,
+	['Z'] = 26, ['a'] = 27, ['b'] = 28, ['c'] = 29, ['d'] = 30,
+	['e'] = 31, ['f'] = 32, ['g'] = 33, ['h'] = 34, ['i'] = 35,
+	['j'] = 36, ['k'] = 37, ['l'] = 38, ['m'] = 39, ['n'] = 40,
+	['o'] = 41, ['p'] = 42, ['q'] = 43, ['r'] = 44, ['s'] = 45,
+	['t'] = 46, ['u'] = 47, ['v'] = 48, ['w'] = 49, ['x'] = 50,
+	['y'] = 51, ['z'] = 52, ['0'] = 53, ['1'] = 54, ['2'] = 55,
+	['3'] = 56, ['4'] = 57, ['5'] = 58, ['6'] = 59, ['7'] = 60,
+	['8'] = 61, ['9'] = 62, ['+'] = 63, ['/'] = 64,
+};
+
 size_t _base64_enc_len(size_t size)
 {
 	return 4 * ((size + 2) / 3) + 1;
@@ -25,29 +45,32 @@ bool _base64_enc(const void *data, size_t dlen, char *buf, size_t *blen)
 		return false;
 	}
 
-	for (n = 0; n < dlen; n += 3) {
-		uint32_t igrp;
+	/* Full 3-byte groups, no tail conditions in the loop */
+	for (n = 0; n + 3 <= dlen; n += 3) {
+		uint32_t igrp = ((uint32_t)d[n] << 16) |
+				((uint32_t)d[n + 1] << 8) | d[n + 2];
 
-		igrp = d[n];
-		igrp <<= 8;
+		buf[boffs] = base64_table[(igrp >> 18) & 0x3f];
+		buf[boffs + 1] = base64_table[(igrp >> 12) & 0x3f];
+		buf[boffs + 2] = base64_table[(igrp >> 6) & 0x3f];
+		buf[boffs + 3] = base64_table[igrp & 0x3f];
 
-		if ((n + 1) < dlen)
-			igrp |= d[n + 1];
-		igrp <<= 8;
+		boffs += 4;
+	}
 
-		if ((n + 2) < dlen)
-			igrp |= d[n + 2];
+	if (n < dlen) {
+		uint32_t igrp = (uint32_t)d[n] << 16;
+
+		if (n + 1 < dlen)
+			igrp |= (uint32_t)d[n + 1] << 8;
 
 		buf[boffs] = base64_table[(igrp >> 18) & 0x3f];
 		buf[boffs + 1] = base64_table[(igrp >> 12) & 0x3f];
-		if ((n + 1) < dlen)
+		if (n + 1 < dlen)
 			buf[boffs + 2] = base64_table[(igrp >> 6) & 0x3f];
 		else
 			buf[boffs + 2] = '=';
-		if ((n + 2) < dlen)
-			buf[boffs + 3] = base64_table[igrp & 0x3f];
-		else
-			buf[boffs + 3] = '=';
+		buf[boffs + 3] = '=';
 
 		boffs += 4;
 	}
@@ -57,19 +80,6 @@ bool _base64_enc(const void *data, size_t dlen, char *buf, size_t *blen)
 	return true;
 }
 
-static bool get_idx(char ch, uint8_t *idx)
-{
-	size_t n = 0;
-
-	for (n = 0; base64_table[n] != '\0'; n++) {
-		if (ch == base64_table[n]) {
-			*idx = n;
-			return true;
-		}
-	}
-	return false;
-}
-
 bool _base64_dec(const char *data, size_t size, void *buf, size_t *blen)
 {
 	bool ret = false;
@@ -80,12 +90,47 @@ bool _base64_dec(const char *data, size_t size, void *buf, size_t *blen)
 	size_t s = 0;
 	uint8_t byte = 0;
 
-	for (n = 0; n < size && data[n] != '\0'; n++) {
+	while (n < size && data[n] != '\0') {
+		/*
+		 * Fast path: decode a whole quad of alphabet characters at
+		 * once. Pad, whitespace, NUL and other foreign characters
+		 * all have a zero reverse entry and divert to the
+		 * character-by-character path below.
+		 */
+		if (!s && n + 4 <= size) {
+			uint8_t i0 = base64_rev[(uint8_t)data[n]];
+			uint8_t i1 = base64_rev[(uint8_t)data[n + 1]];
+			uint8_t i2 = base64_rev[(uint8_t)data[n + 2]];
+			uint8_t i3 = base64_rev[(uint8_t)data[n + 3]];
+
+			if (i0 && i1 && i2 && i3) {
+				uint32_t igrp = ((uint32_t)(i0 - 1) << 18) |
+						((uint32_t)(i1 - 1) << 12) |
+						((uint32_t)(i2 - 1) << 6) |
+						(i3 - 1);
+
+				if (b && m < *blen)
+					b[m] = igrp >> 16;
+				m++;
+				if (b && m < *blen)
+					b[m] = (igrp >> 8) & 0xff;
+				m++;
+				if (b && m < *blen)
+					b[m] = igrp & 0xff;
+				m++;
+				n += 4;
+				continue;
+			}
+		}
+
 		if (data[n] == '=')
 			break;	/* Reached pad characters, we're done */
 
-		if (!get_idx(data[n], &idx))
+		idx = base64_rev[(uint8_t)data[n]];
+		n++;
+		if (!idx)
 			continue;
+		idx--;
 
 		switch (s) {
 		case 0:
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef ARM32_USER_SYSREG_H
+#define ARM32_USER_SYSREG_H
+
+#include <compiler.h>
+#include <stdint.h>
+#include <util.h>
+
+/*
+ * Templates for register read functions based on mrc/mrrc
+ */
+
+#define DEFINE_REG_READ_FUNC_(reg, opc1, crn, crm, opc2)	\
+static inline __noprof uint32_t read_##reg(void)		\
+{								\
+	uint32_t val = 0;					\
+								\
+	asm volatile("mrc p15, " #opc1 ", %0, " #crn ", "	\
+		     #crm ", " #opc2 : "=r" (val));		\
+	return val;						\
+}
+
+#define DEFINE_REG_READ_FUNC64_(reg, opc1, crm)			\
+static inline __noprof uint64_t read_##reg(void)		\
+{								\
+	uint32_t low = 0;					\
+	uint32_t high = 0;					\
+								\
+	asm volatile("mrrc p15, " #opc1 ", %0, %1, " #crm	\
+		     : "=r" (low), "=r" (high));		\
+	return SHIFT_U64(high, 32) | low;			\
+}
+
+/* ARM Generic timer functions */
+DEFINE_REG_READ_FUNC_(cntfrq, 0, c14, c0, 0)
+DEFINE_REG_READ_FUNC64_(cntpct, 0, c14)
+
+#endif /*ARM32_USER_SYSREG_H*/
@@ -23,4 +23,12 @@
 #define BENCHMARK_CMD_GET_MEMREF		BENCHMARK_CMD(2)
 #define BENCHMARK_CMD_UNREGISTER		BENCHMARK_CMD(3)
 
+/*
+ * Drain the per-CPU timestamp rings, merged by timestamp
+ *
+ * [out] value[0].a	number of timestamps returned
+ * [out] memref[1]	array of struct tee_time_st, consumed entries
+ */
+#define BENCHMARK_CMD_DRAIN			BENCHMARK_CMD(4)
+
 #endif /* __PTA_BENCHMARK_H */
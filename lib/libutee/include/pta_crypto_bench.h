@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2020, Linaro Limited
+ */
+
+#ifndef __PTA_CRYPTO_BENCH_H
+#define __PTA_CRYPTO_BENCH_H
+
+/*
+ * Interface to the crypto benchmark pseudo-TA, which times the core
+ * crypto primitives so that platform ports can compare their accelerated
+ * implementations against the generic ones across payload sizes.
+ *
+ * All commands use the same parameters:
+ *
+ * [in]  value[0].a	Algorithm (TEE_ALG_*), ignored by
+ *			PTA_CRYPTO_BENCH_CMD_RSA
+ * [in]  value[0].b	Payload size in bytes per iteration, or the RSA key
+ *			size in bits for PTA_CRYPTO_BENCH_CMD_RSA
+ * [in]  value[1].a	Number of iterations
+ * [in]  value[1].b	Symmetric key size in bytes, 0 selects 16
+ * [out] value[2].a	Elapsed counter (CNTPCT) ticks, low 32 bits
+ * [out] value[2].b	Elapsed counter ticks, high 32 bits
+ * [out] value[3].a	Counter frequency in Hz
+ * [out] value[3].b	Bytes processed per iteration
+ */
+
+#define PTA_CRYPTO_BENCH_UUID \
+		{ 0x61e48f42, 0x8f4e, 0x4e7a, \
+		{ 0x9b, 0x16, 0xd2, 0x41, 0x9b, 0x5a, 0x7c, 0x38 } }
+
+/* Time crypto_hash_init/update/final over the payload */
+#define PTA_CRYPTO_BENCH_CMD_HASH	0
+/* Time crypto_cipher_update of the payload */
+#define PTA_CRYPTO_BENCH_CMD_CIPHER	1
+/* Time crypto_authenc_update_payload of the payload */
+#define PTA_CRYPTO_BENCH_CMD_AUTHENC	2
+/* Time raw RSA private key decryption of one modulus sized block */
+#define PTA_CRYPTO_BENCH_CMD_RSA	3
+
+#endif /* __PTA_CRYPTO_BENCH_H */
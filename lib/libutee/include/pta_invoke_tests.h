@@ -103,5 +103,57 @@
  */
 #define PTA_INVOKE_TESTS_CMD_MEMREF_NULL	10
 
+/*
+ * Secure storage performance test
+ *
+ * [in]     value[0].a	object size in bytes
+ * [in]     value[0].b	chunk size per read/write call in bytes, must
+ *			divide the object size evenly
+ * [in]     value[1].a	repetition count
+ * [in]     value[1].b	access pattern, 0 sequential or 1 strided
+ *			pseudo-random
+ * [out]    value[2].a	write phase time in ms
+ * [out]    value[2].b	read phase time in ms
+ * [out]    value[3].a	create time in ms
+ * [out]    value[3].b	remove time in ms
+ */
+#define PTA_INVOKE_TESTS_CMD_FS_PERF		11
+
+/* Benched core primitives for PTA_INVOKE_TESTS_CMD_BENCH */
+#define PTA_BENCH_NOP				0
+#define PTA_BENCH_MEMCPY			1
+#define PTA_BENCH_MUTEX				2
+#define PTA_BENCH_MALLOC			3
+#define PTA_BENCH_MAP				4
+
+#define PTA_BENCH_MAX_ITERATIONS		4096
+
+/*
+ * Core primitive micro benchmark
+ *
+ * Times the selected primitive once per iteration with the generic timer
+ * and reports the distribution of the per iteration cost.
+ *
+ * [in]     value[0].a	benched primitive, one of PTA_BENCH_*
+ * [in]     value[0].b	buffer size in bytes for PTA_BENCH_MEMCPY and
+ *			PTA_BENCH_MALLOC, ignored otherwise
+ * [in]     value[1].a	iteration count, 1..PTA_BENCH_MAX_ITERATIONS
+ * [out]    value[2].a	minimum cost in timer ticks
+ * [out]    value[2].b	median cost in timer ticks
+ * [out]    value[3].a	99th percentile cost in timer ticks
+ * [out]    value[3].b	timer frequency in Hz
+ *
+ * PTA_BENCH_MAP instead expects a non-secure shared memory reference in
+ * params[1], the first page it covers is mapped and unmapped at a
+ * temporary virtual address each iteration:
+ *
+ * [in]     value[0].a	PTA_BENCH_MAP, value[0].b holds the iteration
+ *			count, 1..PTA_BENCH_MAX_ITERATIONS
+ * [in]     memref[1]	non-secure shared memory buffer
+ * [out]    value[2]	as above
+ * [out]    value[3]	as above
+ */
+#define PTA_INVOKE_TESTS_CMD_BENCH		12
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
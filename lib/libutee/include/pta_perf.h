@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef __PTA_PERF_H
+#define __PTA_PERF_H
+
+/*
+ * Interface to the perf pseudo-TA which drives PMU profiling of secure
+ * world execution, for instance to find cache miss hot spots in TA
+ * crypto loops. Profiling is started with a set of architectural PMU
+ * event numbers, the cycle counter is always counted. While running,
+ * only secure side execution is counted: the counters are stopped when a
+ * thread leaves for normal world and restarted on reentry.
+ *
+ * Note that counting in the secure state may have to be permitted by the
+ * EL3 firmware, if it isn't all counts read as zero.
+ */
+
+#define PTA_PERF_UUID \
+		{ 0x8f0b6893, 0x6d24, 0x4b15, \
+		{ 0x83, 0xd6, 0x24, 0x9c, 0x51, 0x47, 0x5f, 0xa0 } }
+
+/* Number of programmable event counters exposed */
+#define PTA_PERF_NUM_COUNTERS	4
+
+/* Accumulated counts returned by PTA_PERF_CMD_READ */
+struct pta_perf_counts {
+	uint64_t cycles;
+	uint64_t events[PTA_PERF_NUM_COUNTERS];
+};
+
+/*
+ * Start profiling, resetting the accumulated counts
+ *
+ * [in] value[0].a	PMU event number for counter 0
+ * [in] value[0].b	PMU event number for counter 1
+ * [in] value[1].a	PMU event number for counter 2
+ * [in] value[1].b	PMU event number for counter 3
+ */
+#define PTA_PERF_CMD_START	0
+
+/*
+ * Read the counts accumulated since start
+ *
+ * [in]  value[0].a	1 to restart accumulation from zero
+ * [out] memref[1]	struct pta_perf_counts
+ */
+#define PTA_PERF_CMD_READ	1
+
+/* Stop profiling, accumulated counts remain readable */
+#define PTA_PERF_CMD_STOP	2
+
+#endif /* __PTA_PERF_H */
@@ -14,6 +14,35 @@
  */
 #define PTA_SECSTOR_TA_MGMT_BOOTSTRAP	0
 
+/*
+ * Begin a chunked bootstrap install. The memref holds the signed header
+ * of the binary, that is, the shdr with hash and signature immediately
+ * followed by the bootstrap subheader. The value holds the number of
+ * payload bytes that will be supplied with
+ * PTA_SECSTOR_TA_MGMT_BOOTSTRAP_WRITE. The signature is verified here,
+ * the payload hash is checked incrementally as chunks arrive and the
+ * install only becomes visible at a successful
+ * PTA_SECSTOR_TA_MGMT_BOOTSTRAP_COMMIT.
+ *
+ * [in]		memref[0]: signed header of the binary
+ * [in]		value[1].a: payload size in bytes
+ */
+#define PTA_SECSTOR_TA_MGMT_BOOTSTRAP_BEGIN	1
+
+/*
+ * Supply the next chunk of payload of a chunked bootstrap install.
+ *
+ * [in]		memref[0]: next part of the payload
+ */
+#define PTA_SECSTOR_TA_MGMT_BOOTSTRAP_WRITE	2
+
+/*
+ * Finish a chunked bootstrap install, checking the payload hash against
+ * the signed header and committing the Trusted Application to secure
+ * storage. A failed check deletes the staged install.
+ */
+#define PTA_SECSTOR_TA_MGMT_BOOTSTRAP_COMMIT	3
+
 #define PTA_SECSTOR_TA_MGMT_UUID { 0x6e256cba, 0xfc4d, 0x4941, { \
 				   0xad, 0x09, 0x2c, 0xa1, 0x86, 0x03, 0x42, \
 				   0xdd } }
@@ -48,4 +48,26 @@
  */
 #define PTA_SOCKET_IOCTL	5
 
+/*
+ * Gathers two buffers into a single normal world send, saving one RPC
+ * round trip compared to two PTA_SOCKET_SEND commands.
+ * [in]		value[0].a	socket handle
+ * [in]		value[0].b	timeout ms or TEE_TIMEOUT_INFINITE
+ * [in]		memref[1]	first buffer to transmit
+ * [in]		memref[2]	second buffer to transmit
+ * [out]	value[3].a	number of transmitted bytes
+ */
+#define PTA_SOCKET_SENDV	6
+
+/*
+ * Fills the supplied buffers in order from a single normal world
+ * receive. The returned memref sizes tell how much of each buffer was
+ * filled.
+ * [in]		value[0].a	socket handle
+ * [in]		value[0].b	timeout ms or TEE_TIMEOUT_INFINITE
+ * [out]	memref[1]	first buffer
+ * [out]	memref[2]	second buffer
+ */
+#define PTA_SOCKET_RECVV	7
+
 #endif /*__PTA_SOCKET*/
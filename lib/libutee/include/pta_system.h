@@ -5,6 +5,7 @@
 #ifndef __PTA_SYSTEM_H
 #define __PTA_SYSTEM_H
 
+#include <stdint.h>
 #include <util.h>
 
 /*
@@ -189,4 +190,47 @@
  */
 #define PTA_SYSTEM_GET_TPM_EVENT_LOG	12
 
+/*
+ * Map an array of TA binary segments in one call
+ *
+ * Each element in the array is the equivalent of one
+ * PTA_SYSTEM_MAP_TA_BINARY (when @filesz equals @memsz) or one
+ * PTA_SYSTEM_MAP_ZI followed by one PTA_SYSTEM_COPY_FROM_TA_BINARY (when
+ * the segment is writeable), performed without returning to user mode in
+ * between. Segments are mapped in array order and each element must
+ * carry an explicit address. On error the already mapped elements remain
+ * mapped.
+ *
+ * [in]     value[0].a:	Handle to TA binary
+ * [in]     value[0].b:	Must be 0
+ * [in/out] memref[1]:	Array of struct pta_system_seg_map
+ */
+#define PTA_SYSTEM_MAP_TA_SEGMENTS	13
+
+/* Maximum number of elements in one PTA_SYSTEM_MAP_TA_SEGMENTS call */
+#define PTA_SYSTEM_MAX_SEG_MAPS		16
+
+/*
+ * One segment mapping for PTA_SYSTEM_MAP_TA_SEGMENTS
+ *
+ * @va:		Address to map at, must not be 0
+ * @offs:	Offset into the TA binary, must be page aligned
+ * @filesz:	Number of bytes initialized from the TA binary
+ * @memsz:	Total number of bytes, memory beyond @filesz is zero
+ *		initialized, must equal @filesz unless
+ *		PTA_SYSTEM_MAP_FLAG_WRITEABLE is set
+ * @flags:	Flags, PTA_SYSTEM_MAP_FLAG_*
+ * @pad_end:	Extra pad after the memory range
+ * @reserved:	Must be 0
+ */
+struct pta_system_seg_map {
+	uint64_t va;
+	uint32_t offs;
+	uint32_t filesz;
+	uint32_t memsz;
+	uint32_t flags;
+	uint32_t pad_end;
+	uint32_t reserved;
+};
+
 #endif /* __PTA_SYSTEM_H */
@@ -19,4 +19,39 @@
  */
 #define PTA_CMD_SDP_VIRT_TO_PHYS		0x0
 
+/*
+ * PTA_CMD_SDP_REGISTER_BUF - Register an SDP buffer with the session
+ *
+ * The buffer is validated once at registration. The returned handle can
+ * then be used with PTA_CMD_SDP_GET_PHYS to translate addresses within
+ * the buffer without revalidation, sparing the checks for buffers reused
+ * on every frame. Handles are only valid within the registering session.
+ *
+ * param[0] (in memref) - SDP buffer memory reference
+ * param[1] (out value) - Buffer handle (.a)
+ * param[2] unused
+ * param[3] unused
+ */
+#define PTA_CMD_SDP_REGISTER_BUF		0x1
+
+/*
+ * PTA_CMD_SDP_UNREGISTER_BUF - Release a registered SDP buffer handle
+ *
+ * param[0] (in value) - Buffer handle (.a)
+ * param[1] unused
+ * param[2] unused
+ * param[3] unused
+ */
+#define PTA_CMD_SDP_UNREGISTER_BUF		0x2
+
+/*
+ * PTA_CMD_SDP_GET_PHYS - Get physical address within a registered buffer
+ *
+ * param[0] (in value) - Buffer handle (.a), byte offset into buffer (.b)
+ * param[1] (out value) - Physical address (.a=32bit MSB, .b=32bit LSB)
+ * param[2] unused
+ * param[3] unused
+ */
+#define PTA_CMD_SDP_GET_PHYS			0x3
+
 #endif /* __SDP_PTA_H */
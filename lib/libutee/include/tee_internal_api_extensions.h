@@ -16,6 +16,14 @@ void tee_user_mem_mark_heap(void);
 size_t tee_user_mem_check_heap(void);
 /* Hint implementation defines */
 #define TEE_USER_MEM_HINT_NO_FILL_ZERO       0x80000000
+/*
+ * Allocate from a per-command transient arena instead of the heap. The
+ * buffer is zero filled and valid until the current entry point returns,
+ * at which point the whole arena is recycled at once. TEE_Free() is a
+ * no-op for such buffers. Intended for short-lived scratch buffers that
+ * would otherwise fragment the heap around long-lived session state.
+ */
+#define TEE_USER_MEM_HINT_TRANSIENT          0x80000001
 
 /*
  * Cache maintenance support (TA requires the CACHE_MAINTENANCE property)
@@ -79,8 +79,12 @@
 #define TEE_SCN_SE_CHANNEL_CLOSE__DEPRECATED		69
 /* End of deprecated Secure Element API syscalls */
 #define TEE_SCN_CACHE_OPERATION			70
+#define TEE_SCN_HASH_UPDATE_IOV			71
+#define TEE_SCN_CIPHER_UPDATE_IOV		72
+#define TEE_SCN_AUTHENC_UPDATE_PAYLOAD_IOV	73
+#define TEE_SCN_ASYMM_VERIFY_BATCH		74
 
-#define TEE_SCN_MAX				70
+#define TEE_SCN_MAX				74
 
 /* Maximum number of allowed arguments for a syscall */
 #define TEE_SVC_MAX_ARGS			8
@@ -31,8 +31,13 @@
 	 */
 #define TA_FLAG_DEVICE_ENUM		(1 << 9)  /* without tee-supplicant */
 #define TA_FLAG_DEVICE_ENUM_SUPP	(1 << 10) /* with tee-supplicant */
+	/*
+	 * Sessions of this TA are latency sensitive: threads blocked on a
+	 * core wait queue are woken ahead of waiters of ordinary TAs.
+	 */
+#define TA_FLAG_LATENCY_SENSITIVE	(1 << 11)
 
-#define TA_FLAGS_MASK			GENMASK_32(10, 0)
+#define TA_FLAGS_MASK			GENMASK_32(11, 0)
 
 struct ta_head {
 	TEE_UUID uuid;
@@ -91,6 +91,9 @@ TEE_Result _utee_cryp_state_free(unsigned long state);
 TEE_Result _utee_hash_init(unsigned long state, const void *iv, size_t iv_len);
 TEE_Result _utee_hash_update(unsigned long state, const void *chunk,
 			     size_t chunk_size);
+TEE_Result _utee_hash_update_iov(unsigned long state,
+				 const struct utee_iovec *iov,
+				 size_t iov_count);
 TEE_Result _utee_hash_final(unsigned long state, const void *chunk,
 			    size_t chunk_size, void *hash, uint64_t *hash_len);
 
@@ -98,6 +101,10 @@ TEE_Result _utee_cipher_init(unsigned long state, const void *iv,
 			     size_t iv_len);
 TEE_Result _utee_cipher_update(unsigned long state, const void *src,
 			       size_t src_len, void *dest, uint64_t *dest_len);
+TEE_Result _utee_cipher_update_iov(unsigned long state,
+				   const struct utee_iovec *iov,
+				   size_t iov_count, void *dest,
+				   uint64_t *dest_len);
 TEE_Result _utee_cipher_final(unsigned long state, const void *src,
 			      size_t src_len, void *dest, uint64_t *dest_len);
 
@@ -139,6 +146,10 @@ TEE_Result _utee_authenc_update_aad(unsigned long state, const void *aad_data,
 TEE_Result _utee_authenc_update_payload(unsigned long state,
 					const void *src_data, size_t src_len,
 					void *dest_data, uint64_t *dest_len);
+TEE_Result _utee_authenc_update_payload_iov(unsigned long state,
+					    const struct utee_iovec *iov,
+					    size_t iov_count, void *dest_data,
+					    uint64_t *dest_len);
 TEE_Result _utee_authenc_enc_final(unsigned long state, const void *src_data,
 				   size_t src_len, void *dest_data,
 				   uint64_t *dest_len, void *tag,
@@ -159,6 +170,13 @@ TEE_Result _utee_asymm_verify(unsigned long state,
 			      unsigned long num_params, const void *data,
 			      size_t data_len, const void *sig, size_t sig_len);
 
+TEE_Result _utee_asymm_verify_batch(unsigned long state,
+				    const struct utee_attribute *params,
+				    unsigned long num_params,
+				    const struct utee_iovec *data_iov,
+				    const struct utee_iovec *sig_iov,
+				    size_t count, uint64_t *failed_idx);
+
 /* Persistant Object Functions */
 /* obj is of type TEE_ObjectHandle */
 TEE_Result _utee_storage_obj_open(unsigned long storage_id,
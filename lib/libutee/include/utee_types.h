@@ -47,4 +47,13 @@ struct utee_attribute {
 	uint32_t attribute_id;
 };
 
+/*
+ * Scatter-gather element used by the vectored hash/cipher update
+ * syscalls
+ */
+struct utee_iovec {
+	uint64_t base;	/* serves as a pointer */
+	uint64_t len;
+};
+
 #endif /* UTEE_TYPES_H */
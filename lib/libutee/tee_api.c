@@ -2,6 +2,7 @@
 /*
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
+#include <arm_user_sysreg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string_ext.h>
@@ -9,6 +10,7 @@
 #include <tee_internal_api_extensions.h>
 #include <types_ext.h>
 #include <user_ta_header.h>
+#include <utee_defines.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
 
@@ -329,6 +331,21 @@ void *TEE_MemFill(void *buff, uint32_t x, uint32_t size)
 
 /* Date & Time API */
 
+#ifdef CFG_TA_CNTPCT_SYS_TIME
+void TEE_GetSystemTime(TEE_Time *time)
+{
+	uint64_t cntpct = read_cntpct();
+	uint32_t cntfrq = read_cntfrq();
+
+	/*
+	 * Core grants PL0 access to the physical counter and uses the same
+	 * counter as system time source (CFG_SECURE_TIME_SOURCE_CNTPCT), so
+	 * mirror the core computation here and skip the syscall.
+	 */
+	time->seconds = cntpct / cntfrq;
+	time->millis = (cntpct % cntfrq) / (cntfrq / TEE_TIME_MILLIS_BASE);
+}
+#else
 void TEE_GetSystemTime(TEE_Time *time)
 {
 	TEE_Result res = _utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
@@ -336,6 +353,7 @@ void TEE_GetSystemTime(TEE_Time *time)
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 }
+#endif
 
 TEE_Result TEE_Wait(uint32_t timeout)
 {
@@ -390,12 +408,71 @@ void TEE_GetREETime(TEE_Time *time)
 		TEE_Panic(res);
 }
 
+/*
+ * Backing store for TEE_USER_MEM_HINT_TRANSIENT. The arena is a single
+ * block carved from the heap on first use and bump allocated from,
+ * TEE_Free() on a transient buffer is a no-op and the whole arena is
+ * recycled in __utee_transient_arena_reset() when the entry point
+ * returns. Each allocation is preceded by a small header recording its
+ * size for TEE_Realloc(). Allocations which don't fit fall back to the
+ * heap and behave as ordinary allocations.
+ */
+#define TRANSIENT_ARENA_SIZE	4096
+
+struct transient_hdr {
+	uint32_t size;
+	uint32_t pad;
+};
+
+static uint8_t *transient_arena;
+static size_t transient_arena_offs;
+
+static bool is_transient_buf(void *buffer)
+{
+	vaddr_t va = (vaddr_t)buffer;
+
+	return transient_arena && va >= (vaddr_t)transient_arena &&
+	       va < (vaddr_t)transient_arena + TRANSIENT_ARENA_SIZE;
+}
+
+static void *transient_malloc(uint32_t len)
+{
+	struct transient_hdr *hdr = NULL;
+	size_t sz = 0;
+
+	if (!transient_arena)
+		transient_arena = malloc(TRANSIENT_ARENA_SIZE);
+
+	if (ADD_OVERFLOW(len, sizeof(*hdr), &sz) ||
+	    ROUNDUP_OVERFLOW(sz, sizeof(struct transient_hdr), &sz))
+		return NULL;
+
+	if (!transient_arena ||
+	    sz > TRANSIENT_ARENA_SIZE - transient_arena_offs)
+		return calloc(1, len);
+
+	hdr = (struct transient_hdr *)(transient_arena +
+				       transient_arena_offs);
+	transient_arena_offs += sz;
+	hdr->size = len;
+	memset(hdr + 1, 0, len);
+
+	return hdr + 1;
+}
+
+void __utee_transient_arena_reset(void)
+{
+	transient_arena_offs = 0;
+}
+
 void *TEE_Malloc(uint32_t len, uint32_t hint)
 {
 	if (hint == TEE_MALLOC_FILL_ZERO)
 		return calloc(1, len);
 	else if (hint == TEE_USER_MEM_HINT_NO_FILL_ZERO)
 		return malloc(len);
+	else if (hint == TEE_USER_MEM_HINT_TRANSIENT)
+		return transient_malloc(len);
 
 	EMSG("Invalid hint %#" PRIx32, hint);
 
@@ -404,11 +481,28 @@ void *TEE_Malloc(uint32_t len, uint32_t hint)
 
 void *TEE_Realloc(void *buffer, uint32_t newSize)
 {
+	if (is_transient_buf(buffer)) {
+		struct transient_hdr *hdr = (struct transient_hdr *)buffer - 1;
+		void *p = NULL;
+
+		if (newSize <= hdr->size)
+			return buffer;
+
+		p = transient_malloc(newSize);
+		if (p)
+			memcpy(p, buffer, hdr->size);
+
+		return p;
+	}
+
 	return realloc(buffer, newSize);
 }
 
 void TEE_Free(void *buffer)
 {
+	if (is_transient_buf(buffer))
+		return;
+
 	free(buffer);
 }
 
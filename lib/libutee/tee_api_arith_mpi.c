@@ -559,6 +559,76 @@ void TEE_BigIntInvMod(TEE_BigInt *dest, const TEE_BigInt *op,
 		mbedtls_mpi_free(&mpi_op);
 }
 
+/*
+ * A FMM context carries the Montgomery residue RR = 2^(2 * n * biL) mod N
+ * computed by TEE_BigIntInitFMMContext() so that repeated TEE_BigIntExpMod()
+ * calls against the same modulus skip recomputing it. The magic tells an
+ * initialized context from a zeroed buffer.
+ */
+#define FMM_CONTEXT_MAGIC	0x464d4d43
+
+struct fmm_context {
+	uint32_t magic;
+	uint32_t nblimbs;
+	mbedtls_mpi_uint rr[];
+};
+
+TEE_Result TEE_BigIntExpMod(TEE_BigInt *dest, TEE_BigInt *op1,
+			    const TEE_BigInt *op2, const TEE_BigInt *n,
+			    const TEE_BigIntFMMContext *context)
+{
+	const struct fmm_context *ctx = (const struct fmm_context *)context;
+	TEE_Result res = TEE_SUCCESS;
+	mbedtls_mpi mpi_dest;
+	mbedtls_mpi mpi_op1;
+	mbedtls_mpi mpi_op2;
+	mbedtls_mpi mpi_n;
+	mbedtls_mpi mpi_rr;
+	mbedtls_mpi *pop1 = &mpi_op1;
+	mbedtls_mpi *pop2 = &mpi_op2;
+
+	if (TEE_BigIntCmpS32(n, 2) < 0)
+		API_PANIC("Modulus is too short");
+
+	get_mpi(&mpi_dest, dest);
+	get_mpi(&mpi_n, n);
+
+	if (op1 == dest)
+		pop1 = &mpi_dest;
+	else
+		get_mpi(&mpi_op1, op1);
+
+	if (op2 == dest)
+		pop2 = &mpi_dest;
+	else if (op2 == op1)
+		pop2 = pop1;
+	else
+		get_mpi(&mpi_op2, op2);
+
+	get_mpi(&mpi_rr, NULL);
+	if (ctx && ctx->magic == FMM_CONTEXT_MAGIC) {
+		MPI_CHECK(mbedtls_mpi_grow(&mpi_rr, ctx->nblimbs));
+		memcpy(mpi_rr.p, ctx->rr,
+		       ctx->nblimbs * sizeof(mbedtls_mpi_uint));
+	}
+
+	/* When the residue is left empty mbed TLS computes it itself */
+	if (mbedtls_mpi_exp_mod(&mpi_dest, pop1, pop2, &mpi_n, &mpi_rr))
+		res = TEE_ERROR_NOT_SUPPORTED;	/* Even modulus */
+	else
+		MPI_CHECK(copy_mpi_to_bigint(&mpi_dest, dest));
+
+	mbedtls_mpi_free(&mpi_rr);
+	mbedtls_mpi_free(&mpi_n);
+	mbedtls_mpi_free(&mpi_dest);
+	if (pop1 == &mpi_op1)
+		mbedtls_mpi_free(&mpi_op1);
+	if (pop2 == &mpi_op2)
+		mbedtls_mpi_free(&mpi_op2);
+
+	return res;
+}
+
 bool TEE_BigIntRelativePrime(const TEE_BigInt *op1, const TEE_BigInt *op2)
 {
 	bool rc;
@@ -793,10 +863,42 @@ void TEE_BigIntInitFMM(TEE_BigIntFMM *bigIntFMM, uint32_t len)
 	TEE_BigIntInit(bigIntFMM, len);
 }
 
-void TEE_BigIntInitFMMContext(TEE_BigIntFMMContext *context __unused,
-			      uint32_t len __unused,
-			      const TEE_BigInt *modulus __unused)
+void TEE_BigIntInitFMMContext(TEE_BigIntFMMContext *context, uint32_t len,
+			      const TEE_BigInt *modulus)
 {
+	struct fmm_context *ctx = (struct fmm_context *)context;
+	size_t nblimbs = 0;
+	mbedtls_mpi mpi_n;
+	mbedtls_mpi mpi_rr;
+
+	if (TEE_BigIntCmpS32(modulus, 2) < 0)
+		API_PANIC("Modulus is too short");
+
+	get_mpi(&mpi_n, modulus);
+	get_mpi(&mpi_rr, NULL);
+
+	ctx->magic = 0;
+
+	/* RR = 2^(2 * n * biL) mod N, with n the limb count of N */
+	MPI_CHECK(mbedtls_mpi_lset(&mpi_rr, 1));
+	MPI_CHECK(mbedtls_mpi_shift_l(&mpi_rr, mpi_n.n * 2 *
+				      sizeof(mbedtls_mpi_uint) * 8));
+	MPI_CHECK(mbedtls_mpi_mod_mpi(&mpi_rr, &mpi_rr, &mpi_n));
+
+	/* Trim of eventual insignificant zeroes */
+	nblimbs = mpi_rr.n;
+	while (nblimbs && !mpi_rr.p[nblimbs - 1])
+		nblimbs--;
+
+	if (len < sizeof(*ctx) / sizeof(uint32_t) + nblimbs)
+		API_PANIC("Too small FMM context");
+
+	memcpy(ctx->rr, mpi_rr.p, nblimbs * sizeof(mbedtls_mpi_uint));
+	ctx->nblimbs = nblimbs;
+	ctx->magic = FMM_CONTEXT_MAGIC;
+
+	mbedtls_mpi_free(&mpi_rr);
+	mbedtls_mpi_free(&mpi_n);
 }
 
 uint32_t TEE_BigIntFMMSizeInU32(uint32_t modulusSizeInBits)
@@ -804,10 +906,10 @@ uint32_t TEE_BigIntFMMSizeInU32(uint32_t modulusSizeInBits)
 	return TEE_BigIntSizeInU32(modulusSizeInBits);
 }
 
-uint32_t TEE_BigIntFMMContextSizeInU32(uint32_t modulusSizeInBits __unused)
+uint32_t TEE_BigIntFMMContextSizeInU32(uint32_t modulusSizeInBits)
 {
-	/* Return something larger than 0 to keep malloc() and friends happy */
-	return 1;
+	return sizeof(struct fmm_context) / sizeof(uint32_t) +
+	       (modulusSizeInBits + 31) / 32;
 }
 
 void TEE_BigIntConvertToFMM(TEE_BigIntFMM *dest, const TEE_BigInt *src,
@@ -2,6 +2,7 @@
 /*
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
+#include <compiler.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,6 +12,205 @@
 
 #define TEE_USAGE_DEFAULT   0xffffffff
 
+/*
+ * With CFG_TA_OBJ_HANDLE_CACHE, TEE_CloseObject() defers the closing of
+ * the few lastly closed persistent objects and keeps their handles open
+ * kernel side. TEE_OpenPersistentObject() hands such a handle back, with
+ * the data position rewound, when storage, object ID and flags all match,
+ * saving the whole storage open path for TAs re-opening the same object
+ * over and over. A cached handle still holds its access and sharing
+ * rights, so a non-matching open or a create of the object, a rename or
+ * a deletion flushes cached handles with a real close first.
+ */
+#ifdef CFG_TA_OBJ_HANDLE_CACHE
+#define OBJ_HANDLE_CACHE_SIZE	4
+#define OBJ_HANDLE_TRACK_SIZE	16
+
+struct cached_obj_handle {
+	bool in_use;
+	uint32_t handle;
+	uint32_t storage_id;
+	uint32_t flags;
+	uint32_t obj_id_len;
+	uint8_t obj_id[TEE_OBJECT_ID_MAX_LEN];
+};
+
+/* Handles still open in the TA with the IDs they were opened with */
+static struct cached_obj_handle obj_handle_track[OBJ_HANDLE_TRACK_SIZE];
+/* Handles closed by the TA but kept open kernel side */
+static struct cached_obj_handle obj_handle_cache[OBJ_HANDLE_CACHE_SIZE];
+static size_t obj_handle_evict_idx;
+
+static void obj_handle_track_open(uint32_t handle, uint32_t storage_id,
+				  const void *obj_id, uint32_t obj_id_len,
+				  uint32_t flags)
+{
+	struct cached_obj_handle *e = NULL;
+	size_t n;
+
+	if (obj_id_len > TEE_OBJECT_ID_MAX_LEN)
+		return;
+
+	for (n = 0; n < OBJ_HANDLE_TRACK_SIZE; n++) {
+		if (!obj_handle_track[n].in_use) {
+			e = obj_handle_track + n;
+			break;
+		}
+	}
+	/* An untracked handle simply gets closed for real */
+	if (!e)
+		return;
+
+	e->in_use = true;
+	e->handle = handle;
+	e->storage_id = storage_id;
+	e->flags = flags;
+	e->obj_id_len = obj_id_len;
+	memcpy(e->obj_id, obj_id, obj_id_len);
+}
+
+static void obj_handle_forget(uint32_t handle)
+{
+	size_t n;
+
+	for (n = 0; n < OBJ_HANDLE_TRACK_SIZE; n++)
+		if (obj_handle_track[n].in_use &&
+		    obj_handle_track[n].handle == handle)
+			obj_handle_track[n].in_use = false;
+}
+
+static void obj_handle_drop(struct cached_obj_handle *e)
+{
+	TEE_Result res;
+
+	e->in_use = false;
+	res = _utee_cryp_obj_close(e->handle);
+	if (res != TEE_SUCCESS)
+		TEE_Panic(res);
+}
+
+static void obj_handle_cache_flush(void)
+{
+	size_t n;
+
+	for (n = 0; n < OBJ_HANDLE_CACHE_SIZE; n++)
+		if (obj_handle_cache[n].in_use)
+			obj_handle_drop(obj_handle_cache + n);
+}
+
+static void obj_handle_cache_flush_obj(uint32_t storage_id,
+				       const void *obj_id,
+				       uint32_t obj_id_len)
+{
+	size_t n;
+
+	for (n = 0; n < OBJ_HANDLE_CACHE_SIZE; n++) {
+		struct cached_obj_handle *e = obj_handle_cache + n;
+
+		if (e->in_use && e->storage_id == storage_id &&
+		    e->obj_id_len == obj_id_len &&
+		    !memcmp(e->obj_id, obj_id, obj_id_len))
+			obj_handle_drop(e);
+	}
+}
+
+static bool obj_handle_cache_take(uint32_t storage_id, const void *obj_id,
+				  uint32_t obj_id_len, uint32_t flags,
+				  uint32_t *handle)
+{
+	size_t n;
+
+	for (n = 0; n < OBJ_HANDLE_CACHE_SIZE; n++) {
+		struct cached_obj_handle *e = obj_handle_cache + n;
+
+		if (!e->in_use || e->storage_id != storage_id ||
+		    e->flags != flags || e->obj_id_len != obj_id_len ||
+		    memcmp(e->obj_id, obj_id, obj_id_len))
+			continue;
+
+		/* A re-opened object reads from the start of its data */
+		if (_utee_storage_obj_seek(e->handle, 0, TEE_DATA_SEEK_SET)) {
+			obj_handle_drop(e);
+			return false;
+		}
+
+		e->in_use = false;
+		*handle = e->handle;
+		obj_handle_track_open(e->handle, storage_id, obj_id,
+				      obj_id_len, flags);
+		return true;
+	}
+
+	return false;
+}
+
+static bool obj_handle_cache_put(uint32_t handle)
+{
+	struct cached_obj_handle *e = NULL;
+	size_t n;
+
+	for (n = 0; n < OBJ_HANDLE_TRACK_SIZE; n++) {
+		if (obj_handle_track[n].in_use &&
+		    obj_handle_track[n].handle == handle) {
+			e = obj_handle_track + n;
+			break;
+		}
+	}
+	if (!e)
+		return false;
+
+	for (n = 0; n < OBJ_HANDLE_CACHE_SIZE; n++)
+		if (!obj_handle_cache[n].in_use)
+			break;
+	if (n == OBJ_HANDLE_CACHE_SIZE) {
+		n = obj_handle_evict_idx;
+		obj_handle_evict_idx = (n + 1) % OBJ_HANDLE_CACHE_SIZE;
+		obj_handle_drop(obj_handle_cache + n);
+	}
+
+	obj_handle_cache[n] = *e;
+	e->in_use = false;
+
+	return true;
+}
+#else
+static void obj_handle_track_open(uint32_t handle __unused,
+				  uint32_t storage_id __unused,
+				  const void *obj_id __unused,
+				  uint32_t obj_id_len __unused,
+				  uint32_t flags __unused)
+{
+}
+
+static void obj_handle_forget(uint32_t handle __unused)
+{
+}
+
+static void obj_handle_cache_flush(void)
+{
+}
+
+static void obj_handle_cache_flush_obj(uint32_t storage_id __unused,
+				       const void *obj_id __unused,
+				       uint32_t obj_id_len __unused)
+{
+}
+
+static bool obj_handle_cache_take(uint32_t storage_id __unused,
+				  const void *obj_id __unused,
+				  uint32_t obj_id_len __unused,
+				  uint32_t flags __unused,
+				  uint32_t *handle __unused)
+{
+	return false;
+}
+
+static bool obj_handle_cache_put(uint32_t handle __unused)
+{
+	return false;
+}
+#endif /* CFG_TA_OBJ_HANDLE_CACHE */
+
 void __utee_from_attr(struct utee_attribute *ua, const TEE_Attribute *attrs,
 			uint32_t attr_count)
 {
@@ -194,6 +394,9 @@ void TEE_CloseObject(TEE_ObjectHandle object)
 	if (object == TEE_HANDLE_NULL)
 		return;
 
+	if (obj_handle_cache_put((unsigned long)object))
+		return;
+
 	res = _utee_cryp_obj_close((unsigned long)object);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
@@ -405,10 +608,22 @@ TEE_Result TEE_OpenPersistentObject(uint32_t storageID, const void *objectID,
 		goto exit;
 	}
 
+	if (obj_handle_cache_take(storageID, objectID, objectIDLen, flags,
+				  &obj)) {
+		*object = (TEE_ObjectHandle)(uintptr_t)obj;
+		return TEE_SUCCESS;
+	}
+
+	/* Cached handles of this object would conflict with this open */
+	obj_handle_cache_flush_obj(storageID, objectID, objectIDLen);
+
 	res = _utee_storage_obj_open(storageID, objectID, objectIDLen, flags,
 				     &obj);
-	if (res == TEE_SUCCESS)
+	if (res == TEE_SUCCESS) {
 		*object = (TEE_ObjectHandle)(uintptr_t)obj;
+		obj_handle_track_open(obj, storageID, objectID, objectIDLen,
+				      flags);
+	}
 
 exit:
 	if (res != TEE_SUCCESS &&
@@ -442,6 +657,9 @@ TEE_Result TEE_CreatePersistentObject(uint32_t storageID, const void *objectID,
 
 	__utee_check_out_annotation(object, sizeof(*object));
 
+	/* Cached handles of this object would conflict with this create */
+	obj_handle_cache_flush_obj(storageID, objectID, objectIDLen);
+
 	res = _utee_storage_obj_create(storageID, objectID, objectIDLen, flags,
 				       (unsigned long)attributes, initialData,
 				       initialDataLen, &obj);
@@ -491,6 +709,10 @@ TEE_Result TEE_CloseAndDeletePersistentObject1(TEE_ObjectHandle object)
 	if (object == TEE_HANDLE_NULL)
 		return TEE_SUCCESS;
 
+	/* Cached handles may refer to the object about to be deleted */
+	obj_handle_forget((unsigned long)object);
+	obj_handle_cache_flush();
+
 	res = _utee_storage_obj_del((unsigned long)object);
 
 	if (res != TEE_SUCCESS && res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
@@ -511,6 +733,10 @@ TEE_Result TEE_RenamePersistentObject(TEE_ObjectHandle object,
 		goto out;
 	}
 
+	/* The ID recorded for this handle is about to become stale */
+	obj_handle_forget((unsigned long)object);
+	obj_handle_cache_flush();
+
 	res = _utee_storage_obj_rename((unsigned long)object, newObjectID,
 				       newObjectIDLen);
 
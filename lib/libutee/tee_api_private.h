@@ -15,6 +15,12 @@ void __utee_from_attr(struct utee_attribute *ua, const TEE_Attribute *attrs,
 TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 			struct utee_params *up, unsigned long cmd_id);
 
+/*
+ * Recycles all TEE_USER_MEM_HINT_TRANSIENT allocations, called when an
+ * entry point returns.
+ */
+void __utee_transient_arena_reset(void);
+
 
 #if defined(CFG_TA_GPROF_SUPPORT)
 void __utee_gprof_init(void);
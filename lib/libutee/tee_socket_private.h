@@ -29,4 +29,31 @@ TEE_Result __tee_socket_pta_recv(uint32_t handle, void *buf, uint32_t *len,
 TEE_Result __tee_socket_pta_ioctl(uint32_t handle, uint32_t command, void *buf,
 				  uint32_t *len);
 
+/* A buffer of a vectored send or receive */
+struct __tee_socket_iov {
+	void *buf;
+	uint32_t len;
+};
+
+/*
+ * Sends the @count buffers of @iov in order, two buffers per socket PTA
+ * command so a batch costs fewer world switches than per-buffer
+ * __tee_socket_pta_send() calls. Stops early on a short send. @sent
+ * receives the total number of transmitted bytes.
+ */
+TEE_Result __tee_socket_pta_sendv(uint32_t handle,
+				  const struct __tee_socket_iov *iov,
+				  uint32_t count, uint32_t *sent,
+				  uint32_t timeout);
+
+/*
+ * Fills the @count buffers of @iov in order, two buffers per socket PTA
+ * command. Stops early when a command returns less than the requested
+ * capacity. @received receives the total number of received bytes.
+ */
+TEE_Result __tee_socket_pta_recvv(uint32_t handle,
+				  const struct __tee_socket_iov *iov,
+				  uint32_t count, uint32_t *received,
+				  uint32_t timeout);
+
 #endif /*__TEE_SOCKET_PRIVATE_H*/
@@ -138,6 +138,98 @@ TEE_Result __tee_socket_pta_recv(uint32_t handle, void *buf, uint32_t *len,
 	return res;
 }
 
+TEE_Result __tee_socket_pta_sendv(uint32_t handle,
+				  const struct __tee_socket_iov *iov,
+				  uint32_t count, uint32_t *sent,
+				  uint32_t timeout)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t param_types;
+	TEE_Param params[TEE_NUM_PARAMS];
+	uint32_t req = 0;
+	uint32_t n = 0;
+
+	param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_INPUT,
+				      TEE_PARAM_TYPE_VALUE_OUTPUT);
+	*sent = 0;
+
+	while (n < count) {
+		memset(params, 0, sizeof(params));
+		params[0].value.a = handle;
+		params[0].value.b = timeout;
+
+		params[1].memref.buffer = iov[n].buf;
+		params[1].memref.size = iov[n].len;
+		req = iov[n].len;
+		n++;
+		if (n < count) {
+			params[2].memref.buffer = iov[n].buf;
+			params[2].memref.size = iov[n].len;
+			req += iov[n].len;
+			n++;
+		}
+
+		res = invoke_socket_pta(PTA_SOCKET_SENDV, param_types, params);
+		if (res != TEE_SUCCESS)
+			break;
+		*sent += params[3].value.a;
+		/* A short send ends the batch */
+		if (params[3].value.a < req)
+			break;
+	}
+
+	return res;
+}
+
+TEE_Result __tee_socket_pta_recvv(uint32_t handle,
+				  const struct __tee_socket_iov *iov,
+				  uint32_t count, uint32_t *received,
+				  uint32_t timeout)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t param_types;
+	TEE_Param params[TEE_NUM_PARAMS];
+	uint32_t req = 0;
+	uint32_t got = 0;
+	uint32_t n = 0;
+
+	param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				      TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				      TEE_PARAM_TYPE_NONE);
+	*received = 0;
+
+	while (n < count) {
+		memset(params, 0, sizeof(params));
+		params[0].value.a = handle;
+		params[0].value.b = timeout;
+
+		params[1].memref.buffer = iov[n].buf;
+		params[1].memref.size = iov[n].len;
+		req = iov[n].len;
+		n++;
+		if (n < count) {
+			params[2].memref.buffer = iov[n].buf;
+			params[2].memref.size = iov[n].len;
+			req += iov[n].len;
+			n++;
+		}
+
+		res = invoke_socket_pta(PTA_SOCKET_RECVV, param_types, params);
+		if (res != TEE_SUCCESS)
+			break;
+		got = params[1].memref.size + params[2].memref.size;
+		*received += got;
+		/* Less data than capacity ends the batch */
+		if (got < req)
+			break;
+	}
+
+	return res;
+}
+
 TEE_Result __tee_socket_pta_ioctl(uint32_t handle, uint32_t command, void *buf,
 				  uint32_t *len)
 {
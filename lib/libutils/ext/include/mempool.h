@@ -6,6 +6,7 @@
 #ifndef __MEMPOOL_H
 #define __MEMPOOL_H
 
+#include <malloc.h>
 #include <types_ext.h>
 
 /*
@@ -30,6 +31,19 @@ struct mempool;
 
 #define MEMPOOL_ALIGN	__alignof__(long)
 
+/*
+ * With CFG_MEMPOOL_PER_THREAD a pool is split into one arena per thread,
+ * plus one for code running before the threads are initialized. Each arena
+ * is only ever used by its own thread so allocations are lock free, at the
+ * cost of a proportionally larger memory block supplied to
+ * mempool_alloc_pool().
+ */
+#if defined(__KERNEL__) && defined(CFG_MEMPOOL_PER_THREAD)
+#define MEMPOOL_NUM_ARENAS	(CFG_NUM_THREADS + 1)
+#else
+#define MEMPOOL_NUM_ARENAS	1
+#endif
+
 #if defined(__KERNEL__)
 /*
  * System wide memory pool for large temporary memory allocation.
@@ -41,9 +55,11 @@ extern struct mempool *mempool_default;
  * mempool_alloc_pool() - Allocate a new memory pool
  * @data:		a block of memory to carve out items from, must
  *			have an alignment of MEMPOOL_ALIGN.
- * @size:		size fo the block of memory
+ * @size:		size fo the block of memory, split evenly between
+ *			MEMPOOL_NUM_ARENAS arenas
  * @release_mem:	function to call when the pool has been emptied,
- *			ignored if NULL.
+ *			ignored if NULL or if CFG_MEMPOOL_PER_THREAD is
+ *			enabled (the arenas then keep their memory).
  * returns a pointer to a valid pool on success or NULL on failure.
  */
 struct mempool *mempool_alloc_pool(void *data, size_t size,
@@ -74,4 +90,27 @@ void *mempool_calloc(struct mempool *pool, size_t nmemb, size_t size);
  */
 void mempool_free(struct mempool *pool, void *ptr);
 
+#ifdef CFG_WITH_STATS
+/*
+ * mempool_get_stats() - Get allocation statistics for a memory pool
+ * @pool:		A memory pool created with mempool_alloc_pool()
+ * @stats:		Filled in with the statistics, @size is the size of
+ *			one arena and @allocated and @max_allocated report
+ *			the most loaded arena
+ * @reset:		True to restart the high water mark and failure
+ *			tracking
+ */
+void mempool_get_stats(struct mempool *pool, struct malloc_stats *stats,
+		       bool reset);
+
+/*
+ * mempool_get_contention_count() - Number of contended pool acquisitions
+ * @pool:		A memory pool created with mempool_alloc_pool()
+ * @reset:		True to restart the counting
+ * return the number of times a thread found the pool held by another
+ * thread, always 0 when CFG_MEMPOOL_PER_THREAD is enabled.
+ */
+uint32_t mempool_get_contention_count(struct mempool *pool, bool reset);
+#endif
+
 #endif /*__MEMPOOL_H*/
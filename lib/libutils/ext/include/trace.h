@@ -28,6 +28,11 @@ int trace_ext_get_thread_id(void);
 void trace_set_level(int level);
 int trace_get_level(void);
 void plat_trace_ext_puts(const char *str);
+/*
+ * Pushes buffered trace output to the console. A no-op unless the
+ * implementation of trace_ext_puts() defers its output.
+ */
+void trace_ext_drain(void);
 
 /* Internal functions used by the macros below */
 void trace_vprintf(const char *func, int line, int level, bool level_ok,
@@ -35,9 +40,16 @@ void trace_vprintf(const char *func, int line, int level, bool level_ok,
 void trace_printf(const char *func, int line, int level, bool level_ok,
 		  const char *fmt, ...) __printf(5, 6);
 
+/*
+ * The runtime level test is done at the call site so that a trace below
+ * the current level costs a load and a compare instead of a varargs
+ * call. trace_vprintf() repeats the test for callers reaching it
+ * directly.
+ */
 #define trace_printf_helper(level, level_ok, ...) \
-	trace_printf(__func__, __LINE__, (level), (level_ok), \
-		     __VA_ARGS__)
+	(((level_ok) && (level) > trace_level) ? (void)0 : \
+	 trace_printf(__func__, __LINE__, (level), (level_ok), \
+		      __VA_ARGS__))
 
 /* Formatted trace tagged with level independent */
 #if (TRACE_LEVEL <= 0)
@@ -91,15 +103,17 @@ void dhex_dump(const char *function, int line, int level,
 #if (TRACE_LEVEL < TRACE_DEBUG)
 #define DHEXDUMP(buf, len) (void)0
 #else
-#define DHEXDUMP(buf, len) dhex_dump(__func__, __LINE__, TRACE_DEBUG, \
-				     buf, len)
+#define DHEXDUMP(buf, len) \
+	((TRACE_DEBUG > trace_level) ? (void)0 : \
+	 dhex_dump(__func__, __LINE__, TRACE_DEBUG, buf, len))
 #endif
 
 
 /* Trace api without trace formatting */
 
 #define trace_printf_helper_raw(level, level_ok, ...) \
-	trace_printf(NULL, 0, (level), (level_ok), __VA_ARGS__)
+	(((level_ok) && (level) > trace_level) ? (void)0 : \
+	 trace_printf(NULL, 0, (level), (level_ok), __VA_ARGS__))
 
 /* No formatted trace tagged with level independent */
 #if (TRACE_LEVEL <= 0)
@@ -6,6 +6,7 @@
 
 
 #include <assert.h>
+#include <atomic.h>
 #include <compiler.h>
 #include <malloc.h>
 #include <mempool.h>
@@ -53,14 +54,23 @@
  */
 
 
+struct mempool_arena {
+	ssize_t last_offset;   /* offset to the last item, -1 if empty */
+#if defined(CFG_MEMPOOL_REPORT_LAST_OFFSET) || defined(CFG_WITH_STATS)
+	ssize_t max_last_offset;
+#endif
+};
+
 struct mempool {
-	size_t size;  /* size of the memory pool, in bytes */
-	ssize_t last_offset;   /* offset to the last one */
+	size_t size;  /* size of one arena, in bytes */
 	vaddr_t data;
-#ifdef CFG_MEMPOOL_REPORT_LAST_OFFSET
-	ssize_t max_last_offset;
+	struct mempool_arena arena[MEMPOOL_NUM_ARENAS];
+#ifdef CFG_WITH_STATS
+	uint32_t num_alloc_fail;
+	uint32_t biggest_alloc_fail;
+	uint32_t num_contentions;
 #endif
-#if defined(__KERNEL__)
+#if defined(__KERNEL__) && !defined(CFG_MEMPOOL_PER_THREAD)
 	void (*release_mem)(void *ptr, size_t size);
 	struct recursive_mutex mu;
 #endif
@@ -70,22 +80,51 @@ struct mempool {
 struct mempool *mempool_default;
 #endif
 
+static struct mempool_arena *get_arena(struct mempool *pool)
+{
+#if defined(__KERNEL__) && defined(CFG_MEMPOOL_PER_THREAD)
+	/*
+	 * Arena 0 is reserved for code running before the threads are
+	 * initialized, thread_get_id_may_fail() returns -1 then. An arena
+	 * is only ever touched by its own thread so no locking is needed.
+	 */
+	return pool->arena + thread_get_id_may_fail() + 1;
+#else
+	return pool->arena;
+#endif
+}
+
+static vaddr_t arena_data(struct mempool *pool, struct mempool_arena *arena)
+{
+	return pool->data + (arena - pool->arena) * pool->size;
+}
+
 static void get_pool(struct mempool *pool __maybe_unused)
 {
-#if defined(__KERNEL__)
+#if defined(__KERNEL__) && !defined(CFG_MEMPOOL_PER_THREAD)
+#ifdef CFG_WITH_STATS
+	short int owner = atomic_load_short(&pool->mu.owner);
+
+	/*
+	 * Racy by nature, only used to give an idea of how often threads
+	 * queue on the pool.
+	 */
+	if (owner != THREAD_ID_INVALID && owner != thread_get_id_may_fail())
+		atomic_inc32(&pool->num_contentions);
+#endif
 	mutex_lock_recursive(&pool->mu);
 #endif
 }
 
 static void put_pool(struct mempool *pool __maybe_unused)
 {
-#if defined(__KERNEL__)
+#if defined(__KERNEL__) && !defined(CFG_MEMPOOL_PER_THREAD)
 	if (mutex_get_recursive_lock_depth(&pool->mu) == 1) {
 		/*
 		 * As the refcount is about to become 0 there should be no items
 		 * left
 		 */
-		if (pool->last_offset >= 0)
+		if (pool->arena[0].last_offset >= 0)
 			panic();
 		if (pool->release_mem)
 			pool->release_mem((void *)pool->data, pool->size);
@@ -99,15 +138,22 @@ mempool_alloc_pool(void *data, size_t size,
 		   void (*release_mem)(void *ptr, size_t size) __maybe_unused)
 {
 	struct mempool *pool = calloc(1, sizeof(*pool));
+	size_t n;
 
 	COMPILE_TIME_ASSERT(MEMPOOL_ALIGN >= __alignof__(struct mempool_item));
 	assert(!((vaddr_t)data & (MEMPOOL_ALIGN - 1)));
 
 	if (pool) {
-		pool->size = size;
+		/*
+		 * Keeping each arena a multiple of MEMPOOL_ALIGN preserves
+		 * the alignment of @data for all of them.
+		 */
+		pool->size = ROUNDDOWN(size / MEMPOOL_NUM_ARENAS,
+				       MEMPOOL_ALIGN);
 		pool->data = (vaddr_t)data;
-		pool->last_offset = -1;
-#if defined(__KERNEL__)
+		for (n = 0; n < MEMPOOL_NUM_ARENAS; n++)
+			pool->arena[n].last_offset = -1;
+#if defined(__KERNEL__) && !defined(CFG_MEMPOOL_PER_THREAD)
 		pool->release_mem = release_mem;
 		mutex_init_recursive(&pool->mu);
 #endif
@@ -121,15 +167,19 @@ void *mempool_alloc(struct mempool *pool, size_t size)
 	size_t offset;
 	struct mempool_item *new_item;
 	struct mempool_item *last_item = NULL;
+	struct mempool_arena *arena = NULL;
+	vaddr_t data = 0;
 
 	get_pool(pool);
+	arena = get_arena(pool);
+	data = arena_data(pool, arena);
 
-	if (pool->last_offset < 0) {
+	if (arena->last_offset < 0) {
 		offset = 0;
 	} else {
-		last_item = (struct mempool_item *)(pool->data +
-						    pool->last_offset);
-		offset = pool->last_offset + last_item->size;
+		last_item = (struct mempool_item *)(data +
+						    arena->last_offset);
+		offset = arena->last_offset + last_item->size;
 
 		offset = ROUNDUP(offset, MEMPOOL_ALIGN);
 		if (offset > pool->size)
@@ -141,18 +191,20 @@ void *mempool_alloc(struct mempool *pool, size_t size)
 	if (offset + size > pool->size)
 		goto error;
 
-	new_item = (struct mempool_item *)(pool->data + offset);
+	new_item = (struct mempool_item *)(data + offset);
 	new_item->size = size;
-	new_item->prev_item_offset = pool->last_offset;
+	new_item->prev_item_offset = arena->last_offset;
 	if (last_item)
 		last_item->next_item_offset = offset;
 	new_item->next_item_offset = -1;
-	pool->last_offset = offset;
+	arena->last_offset = offset;
+#if defined(CFG_MEMPOOL_REPORT_LAST_OFFSET) || defined(CFG_WITH_STATS)
+	if (arena->last_offset > arena->max_last_offset) {
+		arena->max_last_offset = arena->last_offset;
 #ifdef CFG_MEMPOOL_REPORT_LAST_OFFSET
-	if (pool->last_offset > pool->max_last_offset) {
-		pool->max_last_offset = pool->last_offset;
 		DMSG("Max memory usage increased to %zu",
-		     (size_t)pool->max_last_offset);
+		     (size_t)arena->max_last_offset);
+#endif
 	}
 #endif
 
@@ -160,6 +212,11 @@ void *mempool_alloc(struct mempool *pool, size_t size)
 
 error:
 	EMSG("Failed to allocate %zu bytes, please tune the pool size", size);
+#ifdef CFG_WITH_STATS
+	atomic_inc32(&pool->num_alloc_fail);
+	if (size > pool->biggest_alloc_fail)
+		pool->biggest_alloc_fail = size;
+#endif
 	put_pool(pool);
 	return NULL;
 }
@@ -184,27 +241,78 @@ void mempool_free(struct mempool *pool, void *ptr)
 	struct mempool_item *item;
 	struct mempool_item *prev_item;
 	struct mempool_item *next_item;
+	struct mempool_arena *arena;
+	vaddr_t data;
 	ssize_t last_offset = -1;
 
 	if (!ptr)
 		return;
 
+	arena = get_arena(pool);
+	data = arena_data(pool, arena);
+
 	item = (struct mempool_item *)((vaddr_t)ptr -
 				       sizeof(struct mempool_item));
 	if (item->prev_item_offset >= 0) {
-		prev_item = (struct mempool_item *)(pool->data +
+		prev_item = (struct mempool_item *)(data +
 						    item->prev_item_offset);
 		prev_item->next_item_offset = item->next_item_offset;
 		last_offset = item->prev_item_offset;
 	}
 
 	if (item->next_item_offset >= 0) {
-		next_item = (struct mempool_item *)(pool->data +
+		next_item = (struct mempool_item *)(data +
 						    item->next_item_offset);
 		next_item->prev_item_offset = item->prev_item_offset;
-		last_offset = pool->last_offset;
+		last_offset = arena->last_offset;
 	}
 
-	pool->last_offset = last_offset;
+	arena->last_offset = last_offset;
 	put_pool(pool);
 }
+
+#ifdef CFG_WITH_STATS
+void mempool_get_stats(struct mempool *pool, struct malloc_stats *stats,
+		       bool reset)
+{
+	struct mempool_arena *arena = NULL;
+	size_t n = 0;
+
+	/*
+	 * The arenas of other threads are read without holding any lock,
+	 * the reported values are only indicative. Each arena is sized
+	 * @size so the max last offset is what to compare against it when
+	 * tuning the pool size.
+	 */
+	memset(stats, 0, sizeof(*stats));
+	stats->size = pool->size;
+
+	for (n = 0; n < MEMPOOL_NUM_ARENAS; n++) {
+		arena = pool->arena + n;
+
+		if (arena->last_offset > (ssize_t)stats->allocated)
+			stats->allocated = arena->last_offset;
+		if (arena->max_last_offset > (ssize_t)stats->max_allocated)
+			stats->max_allocated = arena->max_last_offset;
+		if (reset)
+			arena->max_last_offset = arena->last_offset;
+	}
+
+	stats->num_alloc_fail = pool->num_alloc_fail;
+	stats->biggest_alloc_fail = pool->biggest_alloc_fail;
+	if (reset) {
+		pool->num_alloc_fail = 0;
+		pool->biggest_alloc_fail = 0;
+	}
+}
+
+uint32_t mempool_get_contention_count(struct mempool *pool, bool reset)
+{
+	uint32_t count = pool->num_contentions;
+
+	if (reset)
+		pool->num_contentions = 0;
+
+	return count;
+}
+#endif
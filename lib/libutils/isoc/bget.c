@@ -799,10 +799,88 @@ void *bgetz(size, poolset)
     return ((void *) buf);
 }
 
-/*  BGETR  --  Reallocate a buffer.  This is a minimal implementation,
-	       simply in terms of brel()  and  bget().	 It  could  be
-	       enhanced to allow the buffer to grow into adjacent free
-	       blocks and to avoid moving data unnecessarily.  */
+/*  BEXTEND  --  Try to resize an allocated buffer in place, claiming
+		 space from the following buffer in memory when that one
+		 is free.  Returns 1 on success with the buffer holding
+		 at least <size> payload bytes, 0 when the buffer  must
+		 be moved instead.  */
+
+static int bextend(buf, size, poolset)
+  void *buf;
+  bufsize size;
+  struct bpoolset *poolset;
+{
+    struct bhead *b, *ba;
+    struct bfhead *bn;
+    bufsize osize, need, avail, excess;
+
+    b = BH(((char *) buf) - sizeof(struct bhead));
+    osize = -b->bsize;
+    if (osize <= 0) {		      /* Directly-acquired buffer */
+	return 0;
+    }
+
+    /* Compute the needed total buffer size the same way bget() does. */
+
+    if (size < SizeQ) {
+	size = SizeQ;
+    }
+#ifdef SizeQuant
+#if SizeQuant > 1
+    if (ADD_OVERFLOW(size, SizeQuant - 1, &size))
+	return 0;
+
+    size = ROUNDDOWN(size, SizeQuant);
+#endif
+#endif
+    if (ADD_OVERFLOW(size, sizeof(struct bhead), &need))
+	return 0;
+
+    avail = osize;
+    if (avail < need) {
+
+	/* Claim the next buffer in memory if it is free and both together
+	   cover the request. */
+
+	bn = BFH(((char *) b) + osize);
+	if (bn->bh.bsize <= 0 || avail + bn->bh.bsize < need) {
+	    return 0;
+	}
+	assert(bn->ql.blink->ql.flink == bn);
+	assert(bn->ql.flink->ql.blink == bn);
+	bn->ql.blink->ql.flink = bn->ql.flink;
+	bn->ql.flink->ql.blink = bn->ql.blink;
+	avail += bn->bh.bsize;
+	b->bsize = -avail;
+
+	/* The buffer following the claimed one is allocated.  Mark it as
+	   no longer preceded by a free buffer. */
+
+	BH(((char *) b) + avail)->prevfree = 0;
+
+#ifdef BufStats
+	poolset->totalloc += avail - osize;
+#endif
+	tag_asan_alloced(buf, avail - sizeof(struct bhead));
+    }
+
+    /* Release the tail of the buffer again if it is large enough to stand
+       alone as a free buffer.	brel() restores the statistics. */
+
+    excess = avail - need;
+    if (excess > (bufsize) (SizeQ + sizeof(struct bhead))) {
+	ba = BH(((char *) b) + need);
+	ba->bsize = -excess;
+	ba->prevfree = 0;
+	b->bsize = -need;
+	brel((void *) (ba + 1), poolset, false /* !wipe */);
+    }
+    return 1;
+}
+
+/*  BGETR  --  Reallocate a buffer.  The buffer is grown or shrunk in
+	       place with bextend() when possible, otherwise a new
+	       buffer is acquired with bget() and the data is moved. */
 
 void *bgetr(buf, size, poolset)
   void *buf;
@@ -813,6 +891,20 @@ void *bgetr(buf, size, poolset)
     bufsize osize;		      /* Old size of buffer */
     struct bhead *b;
 
+    if (buf != NULL) {
+	b = BH(((char *) buf) - sizeof(struct bhead));
+	osize = -b->bsize;
+	if (osize > 0 && bextend(buf, size, poolset)) {
+	    osize -= sizeof(struct bhead);
+#ifndef __KERNEL__
+	    /* User space reallocations are always zeroed */
+	    if (size > osize)
+		 V memset((char *) buf + osize, 0, size - osize);
+#endif
+	    return buf;
+	}
+    }
+
     if ((nbuf = bget(size, poolset)) == NULL) { /* Acquire new buffer */
 	return NULL;
     }
@@ -90,6 +90,7 @@
 #if defined(__KERNEL__)
 /* Compiling for TEE Core */
 #include <kernel/asan.h>
+#include <kernel/panic.h>
 #include <kernel/thread.h>
 #include <kernel/spinlock.h>
 #include <kernel/unwind.h>
@@ -146,10 +147,36 @@ struct malloc_pool {
 	size_t len;
 };
 
+/*
+ * The debug allocator stores a header in each buffer which is checked when
+ * the buffer is released, something released buffers parked in a fast bin
+ * no longer have. So the fast bins are left out when ENABLE_MDBG is set.
+ */
+#if defined(CFG_BGET_FASTBIN) && !defined(ENABLE_MDBG)
+#define BGET_FASTBIN	1
+#endif
+
+#ifdef BGET_FASTBIN
+/* Largest buffer size served from the fast bins */
+#define FASTBIN_MAX_SIZE	512
+/* One bin per SizeQuant multiple */
+#define FASTBIN_NUM_BINS	(FASTBIN_MAX_SIZE / SizeQuant)
+/* Max number of released buffers parked in each bin */
+#define FASTBIN_MAX_COUNT	16
+
+struct fastbin {
+	void *head;
+	size_t count;
+};
+#endif
+
 struct malloc_ctx {
 	struct bpoolset poolset;
 	struct malloc_pool *pool;
 	size_t pool_len;
+#ifdef BGET_FASTBIN
+	struct fastbin fastbin[FASTBIN_NUM_BINS];
+#endif
 #ifdef BufStats
 	struct malloc_stats mstats;
 #endif
@@ -346,6 +373,138 @@ static bool bpool_foreach(struct malloc_ctx *ctx,
 	for (bpool_foreach_iterator_init((ctx),(iterator));   \
 	     bpool_foreach((ctx),(iterator), (bp));)
 
+/* Most of the stuff in this function is copied from bgetr() in bget.c */
+static __maybe_unused bufsize bget_buf_size(void *buf)
+{
+	bufsize osize;          /* Old size of buffer */
+	struct bhead *b;
+
+	b = BH(((char *)buf) - sizeof(struct bhead));
+	osize = -b->bsize;
+#ifdef BECtl
+	if (osize == 0) {
+		/*  Buffer acquired directly through acqfcn. */
+		struct bdhead *bd;
+
+		bd = BDH(((char *)buf) - sizeof(struct bdhead));
+		osize = bd->tsize - sizeof(struct bdhead);
+	} else
+#endif
+		osize -= sizeof(struct bhead);
+	assert(osize > 0);
+	return osize;
+}
+
+#ifdef BGET_FASTBIN
+
+/*
+ * Size-segregated LIFO bins of released buffers, in front of the bget
+ * free list. bget rounds each allocation up to a SizeQuant multiple so a
+ * released buffer is binned on its exact usable size and handed back
+ * unchanged to the next allocation rounding up to that same size, with
+ * O(1) cost for both operations. bget remains the fallback for larger
+ * buffers, empty bins and full bins.
+ *
+ * Parked buffers are still allocated as far as bget is concerned: they
+ * are counted in the allocated statistics and they satisfy
+ * malloc_buffer_is_within_alloced().
+ */
+
+static void fastbin_set_next(void *buf, void *next)
+{
+	memcpy_unchecked(buf, &next, sizeof(next));
+}
+
+static void *fastbin_get_next(void *buf)
+{
+	void *next = NULL;
+
+	memcpy_unchecked(&next, buf, sizeof(next));
+	return next;
+}
+
+static struct fastbin *fastbin_for_size(struct malloc_ctx *ctx, bufsize size)
+{
+	if (size <= 0 || size > FASTBIN_MAX_SIZE || size % SizeQuant)
+		return NULL;
+
+	return ctx->fastbin + size / SizeQuant - 1;
+}
+
+static void *fastbin_malloc(struct malloc_ctx *ctx, bufsize size)
+{
+	struct fastbin *bin = NULL;
+	void *ptr = NULL;
+
+	bin = fastbin_for_size(ctx, ROUNDUP(MAX(size, (bufsize)SizeQuant),
+					    SizeQuant));
+	if (!bin || !bin->head)
+		return NULL;
+
+	ptr = bin->head;
+	bin->head = fastbin_get_next(ptr);
+	bin->count--;
+	tag_asan_alloced(ptr, bget_buf_size(ptr));
+
+	return ptr;
+}
+
+static bool fastbin_free(struct malloc_ctx *ctx, void *ptr, bool wipe)
+{
+	bufsize size = bget_buf_size(ptr);
+	struct fastbin *bin = fastbin_for_size(ctx, size);
+
+	if (!bin || bin->count >= FASTBIN_MAX_COUNT)
+		return false;
+
+	if (wipe)
+		memset_unchecked(ptr, 0, size);
+	fastbin_set_next(ptr, bin->head);
+	bin->head = ptr;
+	bin->count++;
+	tag_asan_free(ptr, size);
+
+	return true;
+}
+
+#else  /* BGET_FASTBIN */
+
+static void *fastbin_malloc(struct malloc_ctx *ctx __unused,
+			    bufsize size __unused)
+{
+	return NULL;
+}
+
+static bool fastbin_free(struct malloc_ctx *ctx __unused, void *ptr __unused,
+			 bool wipe __unused)
+{
+	return false;
+}
+
+#endif /* BGET_FASTBIN */
+
+#ifndef __KERNEL__
+bool __weak __malloc_grow(size_t size __unused)
+{
+	return false;
+}
+#endif
+
+/*
+ * Gives an overridden __malloc_grow() a chance to register more pool
+ * space when the current pools are exhausted. Only available to user
+ * mode, the core sizes its heap at compile time.
+ */
+static bool maybe_grow(struct malloc_ctx *ctx __maybe_unused,
+		       bufsize s __maybe_unused)
+{
+#ifndef __KERNEL__
+	if (ctx == &malloc_ctx)
+		return __malloc_grow(s);
+#endif
+	return false;
+}
+
 static void *raw_malloc(size_t hdr_size, size_t ftr_size, size_t pl_size,
 			struct malloc_ctx *ctx)
 {
@@ -371,7 +530,11 @@ static void *raw_malloc(size_t hdr_size, size_t ftr_size, size_t pl_size,
 	if (!s)
 		s++;
 
-	ptr = bget(s, &ctx->poolset);
+	ptr = fastbin_malloc(ctx, s);
+	if (!ptr)
+		ptr = bget(s, &ctx->poolset);
+	if (!ptr && maybe_grow(ctx, s))
+		ptr = bget(s, &ctx->poolset);
 out:
 	raw_malloc_return_hook(ptr, pl_size, ctx);
 
@@ -382,7 +545,7 @@ static void raw_free(void *ptr, struct malloc_ctx *ctx, bool wipe)
 {
 	raw_malloc_validate_pools(ctx);
 
-	if (ptr)
+	if (ptr && !fastbin_free(ctx, ptr, wipe))
 		brel(ptr, &ctx->poolset, wipe);
 }
 
@@ -406,7 +569,13 @@ static void *raw_calloc(size_t hdr_size, size_t ftr_size, size_t pl_nmemb,
 	if (!s)
 		s++;
 
-	ptr = bgetz(s, &ctx->poolset);
+	ptr = fastbin_malloc(ctx, s);
+	if (ptr)
+		memset(ptr, 0, s);
+	else
+		ptr = bgetz(s, &ctx->poolset);
+	if (!ptr && maybe_grow(ctx, s))
+		ptr = bgetz(s, &ctx->poolset);
 out:
 	raw_malloc_return_hook(ptr, pl_nmemb * pl_size, ctx);
 
@@ -432,34 +601,113 @@ static void *raw_realloc(void *ptr, size_t hdr_size, size_t ftr_size,
 		s++;
 
 	p = bgetr(ptr, s, &ctx->poolset);
+	if (!p && maybe_grow(ctx, s))
+		p = bgetr(ptr, s, &ctx->poolset);
 out:
 	raw_malloc_return_hook(p, pl_size, ctx);
 
 	return p;
 }
 
-/* Most of the stuff in this function is copied from bgetr() in bget.c */
-static __maybe_unused bufsize bget_buf_size(void *buf)
-{
-	bufsize osize;          /* Old size of buffer */
-	struct bhead *b;
+/*
+ * With CFG_CORE_MALLOC_ARENAS each thread serves its small allocations
+ * from a private arena carved out of the shared heap, so the kernel hot
+ * paths don't contend on the shared heap spinlock. Large allocations, and
+ * allocations overflowing an arena, fall back to the shared heap. Since
+ * the arenas are allocated buffers of the shared heap they are covered by
+ * malloc_buffer_is_within_alloced() and malloc_buffer_overlaps_heap()
+ * without further ado, and malloc_get_stats() counts them as allocated.
+ *
+ * The debug allocator tracks buffers through the shared context only, so
+ * the arenas are left out when ENABLE_MDBG is set.
+ */
+#if defined(__KERNEL__) && defined(CFG_CORE_MALLOC_ARENAS) && \
+	!defined(ENABLE_MDBG)
+#define CORE_MALLOC_ARENAS	1
+#endif
 
-	b = BH(((char *)buf) - sizeof(struct bhead));
-	osize = -b->bsize;
-#ifdef BECtl
-	if (osize == 0) {
-		/*  Buffer acquired directly through acqfcn. */
-		struct bdhead *bd;
+#ifdef CORE_MALLOC_ARENAS
 
-		bd = BDH(((char *)buf) - sizeof(struct bdhead));
-		osize = bd->tsize - sizeof(struct bdhead);
-	} else
+/* Allocations above this size always go to the shared heap */
+#define ARENA_MAX_ALLOC		512
+
+struct thread_arena {
+	struct malloc_ctx ctx;
+	struct malloc_pool pool;
+};
+
+static struct thread_arena thread_arenas[CFG_NUM_THREADS];
+
+static struct malloc_ctx *init_thread_arena(struct thread_arena *ta)
+{
+	struct bfhead *freelist = &ta->ctx.poolset.freelist;
+	uint32_t exceptions = 0;
+	void *buf = NULL;
+
+	exceptions = malloc_lock(&malloc_ctx);
+	buf = raw_malloc(0, 0, CFG_CORE_MALLOC_ARENA_SIZE, &malloc_ctx);
+	malloc_unlock(&malloc_ctx, exceptions);
+	if (!buf)
+		return &malloc_ctx;
+
+	freelist->ql.flink = freelist;
+	freelist->ql.blink = freelist;
+	tag_asan_free(buf, CFG_CORE_MALLOC_ARENA_SIZE);
+	bpool(buf, CFG_CORE_MALLOC_ARENA_SIZE, &ta->ctx.poolset);
+	ta->pool.buf = buf;
+	ta->pool.len = CFG_CORE_MALLOC_ARENA_SIZE;
+	ta->ctx.pool = &ta->pool;
+#ifdef BufStats
+	ta->ctx.mstats.size = ta->pool.len;
 #endif
-		osize -= sizeof(struct bhead);
-	assert(osize > 0);
-	return osize;
+	/* Written last, ctx_owning_buf() tests it without holding the lock */
+	ta->ctx.pool_len = 1;
+
+	return &ta->ctx;
+}
+
+static struct malloc_ctx *ctx_for_alloc(size_t size)
+{
+	short int tid = thread_get_id_may_fail();
+
+	if (tid < 0 || size > ARENA_MAX_ALLOC)
+		return &malloc_ctx;
+	if (!thread_arenas[tid].ctx.pool_len)
+		return init_thread_arena(thread_arenas + tid);
+
+	return &thread_arenas[tid].ctx;
+}
+
+static struct malloc_ctx *ctx_owning_buf(void *ptr)
+{
+	uint8_t *va = ptr;
+	size_t n = 0;
+
+	for (n = 0; n < CFG_NUM_THREADS; n++) {
+		struct thread_arena *ta = thread_arenas + n;
+
+		if (ta->ctx.pool_len && va >= (uint8_t *)ta->pool.buf &&
+		    va < (uint8_t *)ta->pool.buf + ta->pool.len)
+			return &ta->ctx;
+	}
+
+	return &malloc_ctx;
+}
+
+#else  /* CORE_MALLOC_ARENAS */
+
+static __maybe_unused struct malloc_ctx *ctx_for_alloc(size_t size __unused)
+{
+	return &malloc_ctx;
 }
 
+static __maybe_unused struct malloc_ctx *ctx_owning_buf(void *ptr __unused)
+{
+	return &malloc_ctx;
+}
+
+#endif /* CORE_MALLOC_ARENAS */
+
 #ifdef ENABLE_MDBG
 
 struct mdbg_hdr {
@@ -538,6 +786,38 @@ static void assert_header(struct mdbg_hdr *hdr __maybe_unused)
 	assert(*mdbg_get_footer(hdr) == MDBG_FOOTER_MAGIC);
 }
 
+/*
+ * When nonzero, every mdbg_check_interval'th released buffer triggers a
+ * validation of the canaries of all allocated buffers. Unlike the
+ * assertions this also runs in release builds, trading detection latency
+ * for a bounded average cost. Tuned at runtime through the stats PTA.
+ */
+static uint32_t mdbg_check_interval;
+static uint32_t mdbg_free_count;
+
+static void gen_mdbg_validate_unlocked(struct malloc_ctx *ctx)
+{
+	struct bpool_iterator itr;
+	void *b = NULL;
+
+	BPOOL_FOREACH(ctx, &itr, &b) {
+		struct mdbg_hdr *hdr = (struct mdbg_hdr *)b;
+
+		if (hdr->magic != MDBG_HEADER_MAGIC ||
+		    *mdbg_get_footer(hdr) != MDBG_FOOTER_MAGIC) {
+			EMSG("Corrupted heap buffer %p", (void *)(hdr + 1));
+#ifdef __KERNEL__
+			panic();
+#endif
+		}
+	}
+}
+
+void mdbg_set_check_interval(uint32_t interval)
+{
+	mdbg_check_interval = interval;
+}
+
 static void gen_mdbg_free(struct malloc_ctx *ctx, void *ptr, bool wipe)
 {
 	struct mdbg_hdr *hdr = ptr;
@@ -545,6 +825,9 @@ static void gen_mdbg_free(struct malloc_ctx *ctx, void *ptr, bool wipe)
 	if (hdr) {
 		hdr--;
 		assert_header(hdr);
+		if (mdbg_check_interval &&
+		    !(++mdbg_free_count % mdbg_check_interval))
+			gen_mdbg_validate_unlocked(ctx);
 		hdr->magic = 0;
 		*mdbg_get_footer(hdr) = 0;
 		raw_free(hdr, ctx, wipe);
@@ -667,29 +950,46 @@ void mdbg_check(int bufdump)
 
 void *malloc(size_t size)
 {
+	struct malloc_ctx *ctx = ctx_for_alloc(size);
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = malloc_lock(ctx);
 
-	p = raw_malloc(0, 0, size, &malloc_ctx);
-	malloc_unlock(&malloc_ctx, exceptions);
+	p = raw_malloc(0, 0, size, ctx);
+	malloc_unlock(ctx, exceptions);
+
+	if (!p && ctx != &malloc_ctx) {
+		/* The arena is exhausted, fall back to the shared heap */
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_malloc(0, 0, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
 	return p;
 }
 
 static void free_helper(void *ptr, bool wipe)
 {
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	struct malloc_ctx *ctx = ctx_owning_buf(ptr);
+	uint32_t exceptions = malloc_lock(ctx);
 
-	raw_free(ptr, &malloc_ctx, wipe);
-	malloc_unlock(&malloc_ctx, exceptions);
+	raw_free(ptr, ctx, wipe);
+	malloc_unlock(ctx, exceptions);
 }
 
 void *calloc(size_t nmemb, size_t size)
 {
+	struct malloc_ctx *ctx = ctx_for_alloc(nmemb * size);
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = malloc_lock(ctx);
 
-	p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
-	malloc_unlock(&malloc_ctx, exceptions);
+	p = raw_calloc(0, 0, nmemb, size, ctx);
+	malloc_unlock(ctx, exceptions);
+
+	if (!p && ctx != &malloc_ctx) {
+		/* The arena is exhausted, fall back to the shared heap */
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
 	return p;
 }
 
@@ -701,11 +1001,36 @@ static void *realloc_unlocked(struct malloc_ctx *ctx, void *ptr,
 
 void *realloc(void *ptr, size_t size)
 {
+	struct malloc_ctx *ctx;
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions;
 
-	p = realloc_unlocked(&malloc_ctx, ptr, size);
-	malloc_unlock(&malloc_ctx, exceptions);
+	if (ptr)
+		ctx = ctx_owning_buf(ptr);
+	else
+		ctx = ctx_for_alloc(size);
+
+	exceptions = malloc_lock(ctx);
+	p = realloc_unlocked(ctx, ptr, size);
+	malloc_unlock(ctx, exceptions);
+
+	if (!p && ctx != &malloc_ctx) {
+		/*
+		 * The arena can't fit the new size, move the buffer to the
+		 * shared heap instead.
+		 */
+		size_t old_size = 0;
+
+		if (ptr)
+			old_size = bget_buf_size(ptr);
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_malloc(0, 0, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+		if (p && ptr) {
+			memcpy(p, ptr, MIN(old_size, size));
+			free_helper(ptr, false /* !wipe */);
+		}
+	}
 	return p;
 }
 
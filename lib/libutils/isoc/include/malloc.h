@@ -18,6 +18,13 @@ void *mdbg_realloc(const char *fname, int lineno, void *ptr, size_t size);
 
 void mdbg_check(int bufdump);
 
+/*
+ * Validate the canaries of all allocated buffers on every interval'th
+ * free() instead of relying on the per-free assertions, which are
+ * compiled out in release builds. 0 (the default) disables the sampling.
+ */
+void mdbg_set_check_interval(uint32_t interval);
+
 #define malloc(size)	mdbg_malloc(__FILE__, __LINE__, (size))
 #define calloc(nmemb, size) \
 		mdbg_calloc(__FILE__, __LINE__, (nmemb), (size))
@@ -56,6 +63,17 @@ bool malloc_buffer_overlaps_heap(void *buf, size_t len);
  */
 void malloc_add_pool(void *buf, size_t len);
 
+#ifndef __KERNEL__
+/*
+ * Called when an allocation of @size bytes can't be satisfied from the
+ * registered pools. The default implementation does nothing and returns
+ * false. It may be overridden to supply another pool with
+ * malloc_add_pool() and return true to have the failed allocation
+ * retried.
+ */
+bool __malloc_grow(size_t size);
+#endif
+
 #ifdef CFG_WITH_STATS
 /*
  * Get/reset allocation statistics
@@ -97,9 +97,23 @@ CFG_MSG_LONG_PREFIX_MASK ?= 0x1a
 # Otherwise, you need to implement hw_get_random_byte() for your platform
 CFG_WITH_SOFTWARE_PRNG ?= y
 
+# Size in bytes of a pool of pre-generated random bytes kept in front of
+# the hardware TRNG when CFG_WITH_SOFTWARE_PRNG is disabled. Requests are
+# then served with a memcpy and the caller draining the pool below a
+# quarter refills it in one bulk read, amortizing slow TRNG accesses over
+# many requests instead of stalling each one. Set to 0 to read the TRNG
+# directly on every request.
+CFG_HW_RNG_POOL_SIZE ?= 0
+
 # Number of threads
 CFG_NUM_THREADS ?= 2
 
+# Give each thread its own arena in the big number scratch memory pool
+# instead of serializing all threads on a single pool protected by a mutex.
+# This removes lock contention in concurrent asymmetric crypto operations
+# at the cost of one pool sized arena per thread, kept resident.
+CFG_MEMPOOL_PER_THREAD ?= n
+
 # API implementation version
 CFG_TEE_API_VERSION ?= GPD-1.1-dev
 
@@ -138,6 +152,16 @@ CFG_TEE_FW_MANUFACTURER ?= FW_MAN_UNDEF
 # This is the default FS when enabled (i.e., the one used when
 # TEE_STORAGE_PRIVATE is passed to the trusted storage API)
 CFG_REE_FS ?= y
+# Number of blocks in the REE FS plaintext block cache, sparing the read
+# RPC and decrypt for repeatedly read blocks. Each entry is one 4K block.
+CFG_REE_FS_BLOCK_CACHE_NUM ?= 4
+
+# Number of children per node in the secure storage hash tree. The default
+# of 2 keeps the historical binary on-disk format. A larger power of two
+# (4 or 8) gives a shallower tree for large objects, so each block update
+# rehashes and writes back fewer ancestor nodes. Note that changing the
+# value changes the on-disk format and makes existing objects unreadable.
+CFG_FS_HTREE_FANOUT ?= 2
 
 # RPMB file system support
 CFG_RPMB_FS ?= n
@@ -161,24 +185,22 @@ CFG_RPMB_FS_DEV_ID ?= 0
 CFG_RPMB_FS_RD_ENTRIES ?= 8
 
 # Enables caching of FAT FS entries when set to a value greater than zero.
-# When enabled, the cache stores the first 'CFG_RPMB_FS_CACHE_ENTRIES' FAT FS
-# entries. The cache is populated when FAT FS entries are initially read in.
-# When traversing the FAT FS entries, we read from the cache instead of reading
-# in the entries from RPMB storage. Consequently, when a FAT FS entry is
-# written, the cache is updated. In scenarios where an estimate of the number
-# of FAT FS entries can be made, the cache may be specifically tailored to
-# store all entries. The caching can improve RPMB I/O at the cost
-# of additional memory.
+# When enabled, an in-memory mirror of the FAT FS entries is kept across
+# operations. The value gives the initial mirror size in entries; the mirror
+# grows on demand (in steps of CFG_RPMB_FS_RD_ENTRIES) until it covers all
+# entries up to the last one. Each entry is read in (and MAC verified) from
+# RPMB storage only once; traversals are then served from memory and written
+# entries are updated write-through in the mirror. The caching can
+# significantly improve RPMB I/O at the cost of additional memory.
 # Without caching, we temporarily require
 # CFG_RPMB_FS_RD_ENTRIES*sizeof(struct rpmb_fat_entry) bytes of heap memory
 # while traversing the FAT FS (e.g. in read_fat).
 # For example 8*256 bytes = 2kB while in read_fat.
-# With caching, we constantly require up to
-# CFG_RPMB_FS_CACHE_ENTRIES*sizeof(struct rpmb_fat_entry) bytes of heap memory
-# depending on how many elements are in the cache, and additional temporary
-# CFG_RPMB_FS_RD_ENTRIES*sizeof(struct rpmb_fat_entry) bytes of heap memory
-# in case the cache is too small to hold all elements when traversing.
-CFG_RPMB_FS_CACHE_ENTRIES ?= 0
+# With caching, we constantly require
+# <number of FAT FS entries>*sizeof(struct rpmb_fat_entry) bytes of heap
+# memory. A single FAT entry currently has a size of 256 bytes.
+# Set to 0 to disable caching, for instance on memory constrained platforms.
+CFG_RPMB_FS_CACHE_ENTRIES ?= 32
 
 # Enables RPMB key programming by the TEE, in case the RPMB partition has not
 # been configured yet.
@@ -261,6 +283,33 @@ CFG_TA_ASLR ?= y
 CFG_TA_ASLR_MIN_OFFSET_PAGES ?= 0
 CFG_TA_ASLR_MAX_OFFSET_PAGES ?= 128
 
+# When enabled, a TA heap exhausted by an allocation grows by mapping
+# additional zero initialized memory instead of failing the allocation.
+# TA_DATA_SIZE then only sizes the initial heap, so TAs can be built
+# with a small heap and resident secure memory follows actual use
+# instead of the built-in worst case. Grown memory is only reclaimed
+# when the TA instance exits.
+CFG_TA_GROWABLE_HEAP ?= n
+
+# When enabled, core grants user TAs read access to the ARM generic timer
+# physical counter and frequency registers and libutee computes
+# TEE_GetSystemTime() directly from the counter instead of doing a syscall.
+# Requires CFG_SECURE_TIME_SOURCE_CNTPCT so the fast path agrees with the
+# time reported by core.
+CFG_TA_CNTPCT_SYS_TIME ?= n
+
+# Bounded staleness cache for TEE_GetREETime(). Each REE time reading
+# normally costs a full RPC round trip to the supplicant. With a non-zero
+# value core caches the last reading together with the generic timer
+# count it was taken at and serves subsequent readings by extrapolating
+# from the counter, refreshing over RPC only once the cached base is
+# older than this many milliseconds. REE time is non-secure and can be
+# set at will by the normal world, so trading a few milliseconds of
+# accuracy for the removal of a world switch per call does not weaken
+# any guarantee, but a refresh may still step the reported time
+# backwards if the REE clock was adjusted meanwhile. 0 disables caching.
+CFG_REE_TIME_CACHE_MS ?= 0
+
 # Address Space Layout Randomization for TEE Core
 #
 # When this flag is enabled, the early init code will introduce a random
@@ -281,6 +330,21 @@ CFG_REE_FS_TA ?= y
 CFG_REE_FS_TA_BUFFERED ?= n
 $(eval $(call cfg-depends-all,CFG_REE_FS_TA_BUFFERED,CFG_REE_FS_TA))
 
+# Cache the signed headers of recently verified REE FS TAs so that reopening
+# a TA whose header and hash are unchanged skips the signature verification.
+# The TA binary is still hashed and compared against the header on every load.
+CFG_REE_FS_TA_SHDR_CACHE ?= n
+$(eval $(call cfg-depends-all,CFG_REE_FS_TA_SHDR_CACHE,CFG_REE_FS_TA))
+
+# Keep verified TA binaries resident in the "Secure DDR" pool after the last
+# session has closed, so that reopening a TA skips both the load from
+# tee-supplicant and the authentication while the TA instance itself is
+# recreated with a clean state. Implies the buffered mode above. The cached
+# copies occupy TA RAM and an updated TA binary is not picked up until its
+# cache entry has been evicted.
+CFG_REE_FS_TA_RESIDENT ?= n
+$(eval $(call cfg-depends-all,CFG_REE_FS_TA_RESIDENT,CFG_REE_FS_TA))
+
 # Support for loading user TAs from a special section in the TEE binary.
 # Such TAs are available even before tee-supplicant is available (hence their
 # name), but note that many services exported to TAs may need tee-supplicant,
@@ -314,6 +378,14 @@ endif
 # Enable paging, requires SRAM, can't be enabled by default
 CFG_WITH_PAGER ?= n
 
+# With CFG_DRIVERS_LAZY_INIT drivers registered with driver_init_lazy()
+# are not initialized during boot but right before the first TA session
+# opens, the first point where their services can be requested. Products
+# that compile in more drivers than they use then don't stall boot on
+# initializing the unused ones. Drivers that must be ready before the
+# first session (console, RNG seeding the core) keep using driver_init().
+CFG_DRIVERS_LAZY_INIT ?= n
+
 # Runtime lock dependency checker: ensures that a proper locking hierarchy is
 # used in the TEE core when acquiring and releasing mutexes. Any violation will
 # cause a panic as soon as the invalid locking condition is detected. If
@@ -328,6 +400,127 @@ CFG_LOCKDEP_RECORD_STACK ?= y
 # with the pager enabled or lockdep
 CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
 
+# Keep released heap buffers of up to 512 bytes in size-segregated fast bins
+# instead of returning them to the bget free list immediately. Allocations
+# served from a bin avoid scanning the free list, which helps TAs with a high
+# allocation churn, at the price of some heap memory staying parked in the
+# bins.
+CFG_BGET_FASTBIN ?= n
+
+# Carve a per-thread arena out of the core heap for each thread and serve
+# small kernel allocations from it, so that hot paths don't contend on the
+# shared heap spinlock. Allocations above 512 bytes, and allocations
+# overflowing an arena, fall back to the shared heap.
+CFG_CORE_MALLOC_ARENAS ?= n
+# Size of each per-thread arena
+CFG_CORE_MALLOC_ARENA_SIZE ?= 8192
+
+# When a TA invokes another TA with a memory reference in its private
+# memory, the core normally copies the data through a bounce buffer so
+# that nothing else from the caller's address space is exposed. With
+# CFG_TA_PARAM_NOCOPY, page aligned references of a page multiple size of
+# at least CFG_TA_PARAM_NOCOPY_THRESHOLD bytes are instead mapped into the
+# called TA in place: the pages are fully covered by the reference so the
+# isolation argument for the copy doesn't apply. Has no effect together
+# with CFG_PAGED_USER_TA where private memory is backed by the pager.
+CFG_TA_PARAM_NOCOPY ?= n
+CFG_TA_PARAM_NOCOPY_THRESHOLD ?= 0x10000
+
+# Keep parameter mappings backed by registered shared memory in the TA
+# address space between invocations, so a client passing the same shared
+# memory on every invocation doesn't pay for a map/unmap cycle each time.
+# A cached mapping reserves its virtual address range but is unmapped and
+# holds no reference to the shared memory, it is revived when the same
+# cookie is passed again and dropped when any registration is released.
+# Requires CFG_CORE_DYN_SHM.
+CFG_TA_SHM_MAP_CACHE ?= n
+
+# With CFG_TA_OBJ_HANDLE_CACHE libutee defers the closing of the few
+# lastly closed persistent objects and hands the still open handle back
+# when the TA re-opens the same object with the same flags, saving the
+# full storage open path on each close-then-reopen cycle. A cached
+# handle keeps its access and sharing rights reserved until a
+# conflicting open or create, a rename or a deletion flushes it.
+CFG_TA_OBJ_HANDLE_CACHE ?= n
+
+# Keep the per-thread cache of RPC shared-memory payload buffers across
+# calls instead of releasing it when each call ends, so the first RPC of
+# a call (e.g. a single file system operation) costs one world switch
+# instead of an allocation and a free round trip on top. Only in effect
+# while normal world keeps the RPC argument cache enabled, disabling
+# that cache drops the payload buffers too. The cached buffers are owned
+# by tee-supplicant and stay allocated there for as long as caching is
+# enabled.
+CFG_RPC_PAYLOAD_CACHE ?= n
+
+# Use the NEON/SIMD register file for large memory copies and fills in the
+# core, for instance when marshalling large memref parameters or clearing
+# translation tables. Buffers below a threshold, and copies from contexts
+# where the VFP state can't be touched, keep using the plain string
+# routines. Requires CFG_WITH_VFP.
+CFG_CORE_NEON_MEMCPY ?= n
+
+# Record core events (std SMC entry/return, RPC round trips, pager faults)
+# with CNTPCT timestamps in small per-core ring buffers. Cheap enough to
+# stay enabled in production, the trace is retrieved with the stats
+# pseudo TA for tail latency analysis.
+CFG_CORE_EVENT_TRACE ?= n
+
+# When CFG_CORE_TRACE_DEFERRED is enabled trace output is buffered in
+# per-core rings instead of spinning on console FIFO space in the
+# caller, so a trace burst from a hot path doesn't stall the secure
+# thread at UART speed. The rings are drained to the console on fast
+# SMC entries and on panic; bytes that don't fit a full ring are dropped
+# and reported. CFG_CORE_TRACE_DEFERRED_BUF_SIZE sets the per-core ring
+# size in bytes and must be a power of two.
+CFG_CORE_TRACE_DEFERRED ?= n
+CFG_CORE_TRACE_DEFERRED_BUF_SIZE ?= 2048
+
+# Profile secure world execution with the ARM PMU through the perf pseudo
+# TA: cycles plus four event counters (cache misses, branch mispredicts,
+# ...) accumulated over secure side execution only, the counters are
+# stopped across world switches. Counting in the secure state may also
+# need to be permitted by the EL3 firmware (MDCR_EL3.SPME, or SDER on
+# Armv7).
+CFG_CORE_PMU_PROFILING ?= n
+
+# Profile mutex contention: per lock acquisition counts, how often the
+# acquirer had to wait and the longest hold time (in CNTPCT ticks), read
+# out through the stats pseudo TA. Unlike CFG_LOCKDEP this is meant for
+# production-like builds, it identifies the locks worth splitting.
+CFG_LOCK_PROFILER ?= n
+
+# Per TA latency histograms: each session entry/exit is CNTPCT-stamped
+# in the TS manager and accumulated into log2(microsecond) buckets per
+# TA UUID, with the time blocked on RPC separated from the secure side
+# compute time, read out through the stats pseudo TA
+# (STATS_CMD_TS_LATENCY). Attributes p99 regressions to the right TA
+# and tells world-switch overhead apart from TA code.
+CFG_TS_LATENCY_STATS ?= n
+
+# Log (PC, fault VA) of each pager fault in a small ring, read out
+# through the stats pseudo TA, so the code paths that thrash the pager
+# can be reconstructed offline. Requires CFG_WITH_PAGER.
+CFG_PAGER_FAULT_TRACE ?= n
+
+# With CFG_PAGER_LAZY_HASH_VERIFY the boot time hash check of the paged
+# area only covers the init part, whose pages are entered mapped and run
+# without a page-in. The remaining pages are verified against the same
+# hashes by the pager when they are first paged in, as they always are,
+# spreading the cost over runtime instead of stalling cold boot on
+# hashing the whole paged area serially. The trade-off is that a
+# corrupted page panics at first access instead of at boot.
+CFG_PAGER_LAZY_HASH_VERIFY ?= n
+
+# With CFG_PAGER_XTS the read/write pager backing store is encrypted
+# with AES-XTS instead of AES-GCM and page integrity is provided by a
+# truncated SHA-256 of the plaintext kept in the per page state in
+# unpaged memory, in place of the GCM tag. This roughly halves the
+# cryptographic cost of paging a dirty page on cores without AES/GHASH
+# instructions at the price of the weaker (birthday bounded) collision
+# resistance of a 128-bit hash compared to a keyed GCM tag.
+CFG_PAGER_XTS ?= n
+
 # Use the pager for user TAs
 CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 
@@ -348,6 +541,13 @@ CFG_WITH_STACK_CANARIES ?= y
 # stack limits on entry and panic immediately if it is out of range.
 CFG_CORE_DEBUG_CHECK_STACKS ?= n
 
+# Track the high-water mark of each core stack to help right-sizing the
+# static stack allocations. The stacks are filled with a pattern at boot
+# and lazily scanned for the deepest overwritten word when the usage is
+# queried through the stats pseudo TA (STATS_CMD_STACK_USAGE). The only
+# runtime cost outside the queries is the one-time fill.
+CFG_CORE_STACK_USAGE ?= n
+
 # Use when the default stack allocations are not sufficient.
 CFG_STACK_THREAD_EXTRA ?= 0
 CFG_STACK_TMP_EXTRA ?= 0
@@ -374,6 +574,14 @@ endif
 CFG_EMBED_DTB ?= n
 CFG_DT ?= n
 
+# When CFG_DT_CACHED_NODE_INDEX is enabled, dt_node_offset_by_compatible()
+# and dt_node_offset_by_phandle() build a one-pass index over the device
+# tree on first use (compatible string hash and phandle, each mapped to
+# their node offsets) instead of scanning the whole FDT structure block
+# on every query. This trades a small heap allocation for a faster boot
+# on platforms probing many devices from a large DTB.
+CFG_DT_CACHED_NODE_INDEX ?= n
+
 # Maximum size of the Device Tree Blob, has to be large enough to allow
 # editing of the supplied DTB.
 CFG_DTB_MAX_SIZE ?= 0x10000
@@ -438,6 +646,16 @@ $(call force,_CFG_FTRACE_BUF_WHEN_FULL_$(CFG_FTRACE_BUF_WHEN_FULL),y)
 #     display it in milliseconds
 CFG_FTRACE_US_MS ?= 10000
 
+# Incremental function tracing dump.
+# When this option is enabled the function tracing buffer of a user TA is
+# streamed to normal world in chunks: an entry point returning with the
+# buffer filled beyond a watermark dumps the buffer and restarts it,
+# instead of the buffer only being dumped once when the session ends.
+# Long-running sessions then deliver a continuous trace instead of
+# hitting the CFG_FTRACE_BUF_WHEN_FULL policy and losing data.
+CFG_FTRACE_INCREMENTAL_DUMP ?= n
+$(call cfg-depends-all,CFG_FTRACE_INCREMENTAL_DUMP,CFG_FTRACE_SUPPORT)
+
 # Core syscall function tracing.
 # When this option is enabled, OP-TEE core is instrumented with GCC's
 # -pg flag and will output syscall function graph in user TA ftrace
@@ -497,6 +715,11 @@ CFG_SYSTEM_PTA ?= y
 # world OS.
 CFG_DEVICE_ENUM_PTA ?= y
 
+# Enable the pseudo TA benchmarking the core crypto primitives, reporting
+# elapsed counter ticks per primitive so that platform ports can compare
+# their accelerated implementations against the generic ones.
+CFG_CRYPTO_BENCH_PTA ?= n
+
 # Define the number of cores per cluster used in calculating core position.
 # The cluster number is shifted by this value and added to the core ID,
 # so its value represents log2(cores/cluster).
@@ -5,6 +5,7 @@
 #include <tee_internal_api.h>
 #include <tee_internal_api_extensions.h>
 
+#include <stdbool.h>
 #include <string.h>
 #include <util.h>
 
@@ -14,6 +15,76 @@ static const uint32_t storageid = TEE_STORAGE_PRIVATE_RPMB;
 static const char rb_obj_name[] = "rb_state";
 static const char *named_value_prefix = "named_value_";
 
+/*
+ * The TA is single instance and the storage objects are only manipulated
+ * through this TA, so values read from storage stay valid for the
+ * lifetime of the instance. Boot verification reads the same rollback
+ * slots and named values repeatedly, cache them here and write through
+ * on update so repeated reads cost no storage I/O.
+ */
+static uint64_t rb_idx_cache[TA_AVB_MAX_ROLLBACK_LOCATIONS];
+static bool rb_idx_cached[TA_AVB_MAX_ROLLBACK_LOCATIONS];
+
+static uint32_t lock_state_cache;
+static bool lock_state_cached;
+
+struct named_value_cache {
+	struct named_value_cache *next;
+	uint32_t name_sz;
+	uint32_t value_sz;
+	char name[TEE_OBJECT_ID_MAX_LEN];
+	uint8_t value[];
+};
+
+static struct named_value_cache *nv_cache;
+
+static struct named_value_cache *find_named_value(const char *name,
+						  uint32_t name_sz)
+{
+	struct named_value_cache *nv;
+
+	for (nv = nv_cache; nv; nv = nv->next)
+		if (nv->name_sz == name_sz && !memcmp(nv->name, name, name_sz))
+			return nv;
+
+	return NULL;
+}
+
+static void drop_named_value(const char *name, uint32_t name_sz)
+{
+	struct named_value_cache **prev = &nv_cache;
+	struct named_value_cache *nv;
+
+	for (nv = nv_cache; nv; prev = &nv->next, nv = nv->next) {
+		if (nv->name_sz == name_sz &&
+		    !memcmp(nv->name, name, name_sz)) {
+			*prev = nv->next;
+			TEE_Free(nv);
+			return;
+		}
+	}
+}
+
+static void cache_named_value(const char *name, uint32_t name_sz,
+			      const void *value, uint32_t value_sz)
+{
+	struct named_value_cache *nv;
+
+	drop_named_value(name, name_sz);
+
+	/* The cache is best effort, skip the entry if allocation fails */
+	nv = TEE_Malloc(sizeof(*nv) + value_sz, TEE_MALLOC_FILL_ZERO);
+	if (!nv)
+		return;
+
+	nv->name_sz = name_sz;
+	nv->value_sz = value_sz;
+	TEE_MemMove(nv->name, name, name_sz);
+	TEE_MemMove(nv->value, value, value_sz);
+	nv->next = nv_cache;
+	nv_cache = nv;
+}
+
 static TEE_Result get_slot_offset(size_t slot, size_t *offset)
 {
 	if (slot >= TA_AVB_MAX_ROLLBACK_LOCATIONS)
@@ -76,6 +147,7 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_VALUE_OUTPUT,
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE);
+	size_t slot = 0;
 	size_t slot_offset;
 	uint64_t idx;
 	uint32_t count;
@@ -85,10 +157,17 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = get_slot_offset(params[0].value.a, &slot_offset);
+	slot = params[0].value.a;
+	res = get_slot_offset(slot, &slot_offset);
 	if (res)
 		return res;
 
+	if (rb_idx_cached[slot]) {
+		params[1].value.a = rb_idx_cache[slot] >> 32;
+		params[1].value.b = rb_idx_cache[slot];
+		return TEE_SUCCESS;
+	}
+
 	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
 	if (res)
 		return res;
@@ -120,6 +199,8 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 
 	params[1].value.a = idx >> 32;
 	params[1].value.b = idx;
+	rb_idx_cache[slot] = idx;
+	rb_idx_cached[slot] = true;
 out:
 	TEE_CloseObject(h);
 	return res;
@@ -131,6 +212,7 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_VALUE_INPUT,
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE);
+	size_t slot = 0;
 	size_t slot_offset;
 	uint64_t widx;
 	uint64_t idx;
@@ -141,7 +223,8 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = get_slot_offset(params[0].value.a, &slot_offset);
+	slot = params[0].value.a;
+	res = get_slot_offset(slot, &slot_offset);
 	if (res)
 		return res;
 	widx = ((uint64_t)params[1].value.a << 32) | params[1].value.b;
@@ -150,15 +233,19 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	if (res)
 		return res;
 
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
-
-	res =  TEE_ReadObjectData(h, &idx, sizeof(idx), &count);
-	if (res)
-		goto out;
-	if (count != sizeof(idx))
-		idx = 0; /* Not yet written slots are reported as 0 */
+	if (rb_idx_cached[slot]) {
+		idx = rb_idx_cache[slot];
+	} else {
+		res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
+		if (res)
+			goto out;
+
+		res =  TEE_ReadObjectData(h, &idx, sizeof(idx), &count);
+		if (res)
+			goto out;
+		if (count != sizeof(idx))
+			idx = 0; /* Not yet written slots are reported as 0 */
+	}
 
 	if (widx < idx) {
 		res = TEE_ERROR_SECURITY;
@@ -170,6 +257,10 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 		goto out;
 
 	res = TEE_WriteObjectData(h, &widx, sizeof(widx));
+	if (!res) {
+		rb_idx_cache[slot] = widx;
+		rb_idx_cached[slot] = true;
+	}
 out:
 	TEE_CloseObject(h);
 	return res;
@@ -189,6 +280,11 @@ static TEE_Result read_lock_state(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (lock_state_cached) {
+		params[0].value.a = lock_state_cache;
+		return TEE_SUCCESS;
+	}
+
 	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
 	if (res)
 		return res;
@@ -206,6 +302,8 @@ static TEE_Result read_lock_state(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	}
 
 	params[0].value.a = lock_state;
+	lock_state_cache = lock_state;
+	lock_state_cached = true;
 out:
 	TEE_CloseObject(h);
 	return res;
@@ -229,6 +327,9 @@ static TEE_Result write_lock_state(uint32_t pt,
 
 	wlock_state = params[0].value.a;
 
+	if (lock_state_cached && lock_state_cache == wlock_state)
+		return TEE_SUCCESS;
+
 	res = open_rb_state(wlock_state, &h);
 	if (res)
 		return res;
@@ -240,8 +341,16 @@ static TEE_Result write_lock_state(uint32_t pt,
 		goto out;
 
 	res = create_rb_state(wlock_state, &h);
+	/* Changing the lock state resets all rollback slots */
+	memset(rb_idx_cached, 0, sizeof(rb_idx_cached));
 out:
 	TEE_CloseObject(h);
+	if (!res) {
+		lock_state_cache = wlock_state;
+		lock_state_cached = true;
+	} else {
+		lock_state_cached = false;
+	}
 	return res;
 }
 
@@ -279,8 +388,12 @@ static TEE_Result write_persist_value(uint32_t pt,
 					 name_full_sz,
 					 flags, NULL, value,
 					 value_sz, &h);
-	if (res)
+	if (res) {
 		EMSG("Can't create named object value, res = 0x%x", res);
+		drop_named_value(name_full, name_full_sz);
+	} else {
+		cache_named_value(name_full, name_full_sz, value, value_sz);
+	}
 
 	TEE_CloseObject(h);
 
@@ -302,6 +415,8 @@ static TEE_Result read_persist_value(uint32_t pt,
 	char name_full[TEE_OBJECT_ID_MAX_LEN];
 	uint32_t name_full_sz;
 	uint32_t count;
+	struct named_value_cache *nv;
+	TEE_ObjectInfo info = { };
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -317,6 +432,14 @@ static TEE_Result read_persist_value(uint32_t pt,
 	if (res)
 		return res;
 
+	nv = find_named_value(name_full, name_full_sz);
+	if (nv) {
+		count = MIN(value_sz, nv->value_sz);
+		TEE_MemMove(value, nv->value, count);
+		params[1].memref.size = count;
+		return TEE_SUCCESS;
+	}
+
 	res = TEE_OpenPersistentObject(storageid, name_full,
 				       name_full_sz, flags, &h);
 	if (res) {
@@ -331,6 +454,10 @@ static TEE_Result read_persist_value(uint32_t pt,
 	}
 
 	params[1].memref.size = count;
+
+	/* Only cache complete values, a short buffer may truncate the read */
+	if (!TEE_GetObjectInfo1(h, &info) && count == info.dataSize)
+		cache_named_value(name_full, name_full_sz, value, count);
 out:
 	TEE_CloseObject(h);
 
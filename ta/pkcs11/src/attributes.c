@@ -32,30 +32,35 @@ enum pkcs11_rc add_attribute(struct obj_attrs **head, uint32_t attribute,
 			     void *data, size_t size)
 {
 	size_t buf_len = sizeof(struct obj_attrs) + (*head)->attrs_size;
-	char **bstart = (void *)head;
-	enum pkcs11_rc rc = PKCS11_CKR_OK;
-	uint32_t data32 = 0;
-
-	data32 = attribute;
-	rc = serialize(bstart, &buf_len, &data32, sizeof(uint32_t));
-	if (rc)
-		return rc;
-
-	data32 = size;
-	rc = serialize(bstart, &buf_len, &data32, sizeof(uint32_t));
-	if (rc)
-		return rc;
-
-	rc = serialize(bstart, &buf_len, data, size);
-	if (rc)
-		return rc;
+	struct pkcs11_attribute_head ref = {
+		.id = attribute,
+		.size = size,
+	};
+	size_t nlen = 0;
+	char *buf = NULL;
+
+	/*
+	 * Grow the serialized buffer and append header and data in one
+	 * pass rather than one serialize() round trip per field, templates
+	 * are rebuilt attribute by attribute so this path is hot.
+	 */
+	if (ADD_OVERFLOW(buf_len, sizeof(ref), &nlen) ||
+	    ADD_OVERFLOW(nlen, size, &nlen))
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	buf = TEE_Realloc(*head, nlen);
+	if (!buf)
+		return PKCS11_CKR_DEVICE_MEMORY;
 
 	/* Alloced buffer is always well aligned */
-	head = (void *)bstart;
-	(*head)->attrs_size += 2 * sizeof(uint32_t) + size;
+	*head = (void *)buf;
+	TEE_MemMove(buf + buf_len, &ref, sizeof(ref));
+	TEE_MemMove(buf + buf_len + sizeof(ref), data, size);
+
+	(*head)->attrs_size += sizeof(ref) + size;
 	(*head)->attrs_count++;
 
-	return rc;
+	return PKCS11_CKR_OK;
 }
 
 void get_attribute_ptrs(struct obj_attrs *head, uint32_t attribute,
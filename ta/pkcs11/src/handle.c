@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <tee_internal_api.h>
 #include <tee_internal_api_extensions.h>
+#include <util.h>
 
 #include "handle.h"
 
@@ -28,6 +29,7 @@ void handle_db_destroy(struct handle_db *db)
 		TEE_Free(db->ptrs);
 		db->ptrs = NULL;
 		db->max_ptrs = 0;
+		db->min_free = 0;
 	}
 }
 
@@ -40,10 +42,15 @@ uint32_t handle_get(struct handle_db *db, void *ptr)
 	if (!db || !ptr)
 		return 0;
 
-	/* Try to find an empty location (index 0 is reserved as invalid) */
-	for (n = 1; n < db->max_ptrs; n++) {
+	/*
+	 * Try to find an empty location (index 0 is reserved as invalid),
+	 * starting from the free slot hint so a mostly full database isn't
+	 * rescanned from the start on every allocation.
+	 */
+	for (n = MAX(db->min_free, 1); n < db->max_ptrs; n++) {
 		if (!db->ptrs[n]) {
 			db->ptrs[n] = ptr;
+			db->min_free = n + 1;
 			return n;
 		}
 	}
@@ -64,6 +71,7 @@ uint32_t handle_get(struct handle_db *db, void *ptr)
 
 	/* Since n stopped at db->max_ptrs there is an empty location there */
 	db->ptrs[n] = ptr;
+	db->min_free = n + 1;
 	return n;
 }
 
@@ -76,6 +84,8 @@ void *handle_put(struct handle_db *db, uint32_t handle)
 
 	p = db->ptrs[handle];
 	db->ptrs[handle] = NULL;
+	if (handle < db->min_free)
+		db->min_free = handle;
 	return p;
 }
 
@@ -11,6 +11,7 @@
 struct handle_db {
 	void **ptrs;
 	uint32_t max_ptrs;
+	uint32_t min_free;	/* No free slot below this index */
 };
 
 /*
@@ -47,12 +47,119 @@ static struct ck_token *get_session_token(void *session)
 	return pkcs11_session2token(ck_session);
 }
 
+/*
+ * Token objects found in the persistent database get their attributes
+ * deserialized on first reference only. The most recently referenced
+ * resident attributes are kept in an LRU list so a bounded set of hot
+ * objects is served from memory while a token holding thousands of
+ * objects does not keep them all resident.
+ */
+#define TOKEN_OBJ_ATTRIBUTES_RESIDENT_MAX	32
+
+static TAILQ_HEAD(obj_attrs_lru, pkcs11_object) attributes_lru =
+	TAILQ_HEAD_INITIALIZER(attributes_lru);
+static size_t attributes_lru_count;
+
+/*
+ * Objects are allocated zeroed so a NULL tqe_prev reliably tells an
+ * object is not in the LRU list. Same dependency on the TAILQ
+ * implementation as destroy_object() has on the LIST one.
+ */
+static bool obj_is_in_attributes_lru(struct pkcs11_object *obj)
+{
+	return obj->lru_link.tqe_prev;
+}
+
+void release_persistent_object_attributes(struct pkcs11_object *obj)
+{
+	if (!obj_is_in_attributes_lru(obj))
+		return;
+
+	TAILQ_REMOVE(&attributes_lru, obj, lru_link);
+	TEE_MemFill(&obj->lru_link, 0, sizeof(obj->lru_link));
+	attributes_lru_count--;
+
+	TEE_Free(obj->attributes);
+	obj->attributes = NULL;
+}
+
+enum pkcs11_rc load_persistent_object_attributes(struct pkcs11_object *obj)
+{
+	TEE_ObjectHandle hdl = TEE_HANDLE_NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct obj_attrs *head = NULL;
+	TEE_ObjectInfo info = { };
+	uint32_t size = 0;
+
+	if (obj->attributes) {
+		if (obj_is_in_attributes_lru(obj)) {
+			TAILQ_REMOVE(&attributes_lru, obj, lru_link);
+			TAILQ_INSERT_HEAD(&attributes_lru, obj, lru_link);
+		}
+		return PKCS11_CKR_OK;
+	}
+
+	assert(obj->uuid);
+
+	res = TEE_OpenPersistentObject(TEE_STORAGE_PRIVATE,
+				       obj->uuid, sizeof(TEE_UUID),
+				       TEE_DATA_FLAG_ACCESS_READ, &hdl);
+	if (res)
+		return tee2pkcs_error(res);
+
+	res = TEE_GetObjectInfo1(hdl, &info);
+	if (res)
+		goto out;
+
+	if (info.dataSize < sizeof(struct obj_attrs)) {
+		res = TEE_ERROR_CORRUPT_OBJECT;
+		goto out;
+	}
+
+	head = TEE_Malloc(info.dataSize, TEE_USER_MEM_HINT_NO_FILL_ZERO);
+	if (!head) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	res = TEE_ReadObjectData(hdl, head, info.dataSize, &size);
+	if (res)
+		goto out;
+
+	if (size != info.dataSize ||
+	    head->attrs_size != size - sizeof(struct obj_attrs)) {
+		res = TEE_ERROR_CORRUPT_OBJECT;
+		goto out;
+	}
+
+	obj->attributes = head;
+	head = NULL;
+
+	TAILQ_INSERT_HEAD(&attributes_lru, obj, lru_link);
+	attributes_lru_count++;
+
+	if (attributes_lru_count > TOKEN_OBJ_ATTRIBUTES_RESIDENT_MAX)
+		release_persistent_object_attributes(TAILQ_LAST(&attributes_lru,
+								obj_attrs_lru));
+
+out:
+	TEE_Free(head);
+	TEE_CloseObject(hdl);
+
+	return tee2pkcs_error(res);
+}
+
 /* Release resources of a non-persistent object */
 static void cleanup_volatile_obj_ref(struct pkcs11_object *obj)
 {
 	if (!obj)
 		return;
 
+	if (obj_is_in_attributes_lru(obj)) {
+		TAILQ_REMOVE(&attributes_lru, obj, lru_link);
+		attributes_lru_count--;
+	}
+
 	if (obj->key_handle != TEE_HANDLE_NULL)
 		TEE_FreeTransientObject(obj->key_handle);
 
@@ -130,6 +237,10 @@ void destroy_object(struct pkcs11_session *session, struct pkcs11_object *obj,
 		return;
 	}
 
+	/* Token objects from the database may not be deserialized yet */
+	if (obj->uuid)
+		load_persistent_object_attributes(obj);
+
 	/* Destroy target object (persistent or not) */
 	if (get_bool(obj->attributes, PKCS11_CKA_TOKEN)) {
 		assert(obj->uuid);
@@ -16,6 +16,7 @@ struct pkcs11_session;
 
 /*
  * link: objects are referenced in a double-linked list
+ * lru_link: position in the LRU list of lazily loaded token object attributes
  * attributes: pointer to the serialized object attributes
  * key_handle: GPD TEE object handle if used in an operation
  * key_type: GPD TEE key type (shortcut used for processing)
@@ -24,6 +25,7 @@ struct pkcs11_session;
  */
 struct pkcs11_object {
 	LIST_ENTRY(pkcs11_object) link;
+	TAILQ_ENTRY(pkcs11_object) lru_link;
 	struct obj_attrs *attributes;
 	TEE_ObjectHandle key_handle;
 	uint32_t key_type;
@@ -42,6 +44,24 @@ uint32_t pkcs11_object2handle(struct pkcs11_object *obj,
 struct pkcs11_object *create_token_object(struct obj_attrs *head,
 					  TEE_UUID *uuid);
 
+/*
+ * load_persistent_object_attributes() - Get attributes of a token object
+ * @obj:	Token object to load the serialized attributes of
+ *
+ * Token objects found in the persistent database at initialization are
+ * created without their attributes. This reads the serialized attributes
+ * from the object file in secure storage on first reference. Resident
+ * attributes of the least recently referenced objects are released when
+ * too many are loaded, hence callers shall not cache @obj->attributes
+ * across calls that may load other objects.
+ *
+ * Return PKCS11_CKR_OK on success or a PKCS11 return code.
+ */
+enum pkcs11_rc load_persistent_object_attributes(struct pkcs11_object *obj);
+
+/* Release resident attributes of a lazily loaded token object, if any */
+void release_persistent_object_attributes(struct pkcs11_object *obj);
+
 enum pkcs11_rc create_object(void *session, struct obj_attrs *attributes,
 			     uint32_t *handle);
 
@@ -135,17 +135,67 @@ void close_persistent_db(struct ck_token *token __unused)
 {
 }
 
+static struct uuid_idx_head *uuid_idx_bucket(struct ck_token *token,
+					     TEE_UUID *uuid)
+{
+	uint32_t hash = 0;
+
+	TEE_MemMove(&hash, uuid, sizeof(hash));
+
+	return token->uuid_idx + hash % TOKEN_UUID_IDX_BUCKETS;
+}
+
+static enum pkcs11_rc uuid_idx_add(struct ck_token *token, TEE_UUID *uuid,
+				   uint32_t idx)
+{
+	struct uuid_idx_entry *entry = TEE_Malloc(sizeof(*entry),
+						  TEE_MALLOC_FILL_ZERO);
+
+	if (!entry)
+		return PKCS11_CKR_DEVICE_MEMORY;
+
+	entry->idx = idx;
+	LIST_INSERT_HEAD(uuid_idx_bucket(token, uuid), entry, link);
+
+	return PKCS11_CKR_OK;
+}
+
+/*
+ * Removes the index entry for @idx and shifts down the indices above
+ * it, mirroring the compaction of the UUID array on unregister.
+ */
+static void uuid_idx_remove(struct ck_token *token, uint32_t idx)
+{
+	struct uuid_idx_entry *entry = NULL;
+	struct uuid_idx_entry *next = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < TOKEN_UUID_IDX_BUCKETS; n++) {
+		entry = LIST_FIRST(token->uuid_idx + n);
+		while (entry) {
+			next = LIST_NEXT(entry, link);
+			if (entry->idx == idx) {
+				LIST_REMOVE(entry, link);
+				TEE_Free(entry);
+			} else if (entry->idx > idx) {
+				entry->idx--;
+			}
+			entry = next;
+		}
+	}
+}
+
 static int get_persistent_obj_idx(struct ck_token *token, TEE_UUID *uuid)
 {
-	size_t i = 0;
+	struct uuid_idx_entry *entry = NULL;
 
 	if (!uuid)
 		return -1;
 
-	for (i = 0; i < token->db_objs->count; i++)
-		if (!TEE_MemCompare(token->db_objs->uuids + i,
+	LIST_FOREACH(entry, uuid_idx_bucket(token, uuid), link)
+		if (!TEE_MemCompare(token->db_objs->uuids + entry->idx,
 				    uuid, sizeof(TEE_UUID)))
-			return i;
+			return entry->idx;
 
 	return -1;
 }
@@ -247,6 +297,7 @@ enum pkcs11_rc unregister_persistent_object(struct ck_token *token,
 	TEE_Free(token->db_objs);
 	token->db_objs = ptr;
 	ptr = NULL;
+	uuid_idx_remove(token, idx);
 
 out:
 	TEE_CloseObject(db_hdl);
@@ -259,6 +310,7 @@ enum pkcs11_rc register_persistent_object(struct ck_token *token,
 					  TEE_UUID *uuid)
 {
 	TEE_ObjectHandle db_hdl = TEE_HANDLE_NULL;
+	struct uuid_idx_entry *entry = NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
 	void *ptr = NULL;
 	size_t size = 0;
@@ -267,12 +319,22 @@ enum pkcs11_rc register_persistent_object(struct ck_token *token,
 	if (get_persistent_obj_idx(token, uuid) >= 0)
 		TEE_Panic(0);
 
+	/*
+	 * Allocate the index entry up front so indexing the object can't
+	 * fail once the database has been updated.
+	 */
+	entry = TEE_Malloc(sizeof(*entry), TEE_MALLOC_FILL_ZERO);
+	if (!entry)
+		return PKCS11_CKR_DEVICE_MEMORY;
+
 	count = token->db_objs->count;
 	ptr = TEE_Realloc(token->db_objs,
 			  sizeof(struct token_persistent_objs) +
 			  ((count + 1) * sizeof(TEE_UUID)));
-	if (!ptr)
+	if (!ptr) {
+		TEE_Free(entry);
 		return PKCS11_CKR_DEVICE_MEMORY;
+	}
 
 	token->db_objs = ptr;
 	TEE_MemMove(token->db_objs->uuids + count, uuid, sizeof(TEE_UUID));
@@ -305,6 +367,15 @@ enum pkcs11_rc register_persistent_object(struct ck_token *token,
 out:
 	TEE_CloseObject(db_hdl);
 
+	if (res) {
+		TEE_Free(entry);
+	} else {
+		entry->idx = count;
+		LIST_INSERT_HEAD(uuid_idx_bucket(token,
+						 token->db_objs->uuids + count),
+				 entry, link);
+	}
+
 	return tee2pkcs_error(res);
 }
 
@@ -321,11 +392,14 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 	struct token_persistent_main *db_main = NULL;
 	struct token_persistent_objs *db_objs = NULL;
 	void *ptr = NULL;
+	size_t n = 0;
 
 	if (!token)
 		return NULL;
 
 	LIST_INIT(&token->object_list);
+	for (n = 0; n < TOKEN_UUID_IDX_BUCKETS; n++)
+		LIST_INIT(token->uuid_idx + n);
 
 	db_main = TEE_Malloc(sizeof(*db_main), TEE_MALLOC_FILL_ZERO);
 	db_objs = TEE_Malloc(sizeof(*db_objs), TEE_MALLOC_FILL_ZERO);
@@ -366,6 +440,9 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 			struct pkcs11_object *obj = NULL;
 			TEE_UUID *uuid = NULL;
 
+			if (uuid_idx_add(token, &db_objs->uuids[idx], idx))
+				goto error;
+
 			uuid = TEE_Malloc(sizeof(TEE_UUID),
 					  TEE_USER_MEM_HINT_NO_FILL_ZERO);
 			if (!uuid)
@@ -663,6 +663,9 @@ static void close_ck_session(struct pkcs11_session *session)
 	if (pkcs11_session_is_read_write(session))
 		session->token->rw_session_count--;
 
+	if (session->op_cache.op != TEE_HANDLE_NULL)
+		TEE_FreeOperation(session->op_cache.op);
+
 	TEE_Free(session);
 
 	DMSG("Close PKCS11 session %"PRIu32, session->handle);
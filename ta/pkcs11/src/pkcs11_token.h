@@ -80,6 +80,20 @@ struct token_persistent_objs {
 	TEE_UUID uuids[];
 };
 
+/*
+ * Hash index over the UUIDs in @db_objs so UUID lookups don't scan the
+ * whole array, entries reference UUIDs by their index in the array.
+ * Object UUIDs are random so their first bytes make a good hash key.
+ */
+struct uuid_idx_entry {
+	uint32_t idx;
+	LIST_ENTRY(uuid_idx_entry) link;
+};
+
+LIST_HEAD(uuid_idx_head, uuid_idx_entry);
+
+#define TOKEN_UUID_IDX_BUCKETS		64
+
 /*
  * Runtime state of the token, complies with pkcs11
  *
@@ -89,6 +103,7 @@ struct token_persistent_objs {
  * @object_list - List of the objects owned by the token
  * @db_main - Volatile copy of the persistent main database
  * @db_objs - Volatile copy of the persistent object database
+ * @uuid_idx - Hash index over the UUIDs in @db_objs
  */
 struct ck_token {
 	enum pkcs11_token_state state;
@@ -98,6 +113,7 @@ struct ck_token {
 	/* Copy in RAM of the persistent database */
 	struct token_persistent_main *db_main;
 	struct token_persistent_objs *db_objs;
+	struct uuid_idx_head uuid_idx[TOKEN_UUID_IDX_BUCKETS];
 };
 
 /*
@@ -130,6 +146,11 @@ enum pkcs11_proc_state {
  * @relogged - true once client logged since last operation update
  * @updated - true once an active operation is updated
  * @tee_op_handle - handle on active crypto operation or TEE_HANDLE_NULL
+ * @tee_algo - TEE algorithm @tee_op_handle was allocated for
+ * @tee_mode - TEE operation mode @tee_op_handle was allocated for
+ * @tee_key_size - maximum key bit size @tee_op_handle was allocated for
+ * @tee_op_reusable - true once the operation key is set, allowing the
+ *	operation to move to the session cache on release
  * @extra_ctx - context for the active processing
  */
 struct active_processing {
@@ -139,9 +160,31 @@ struct active_processing {
 	bool relogged;
 	bool updated;
 	TEE_OperationHandle tee_op_handle;
+	uint32_t tee_algo;
+	uint32_t tee_mode;
+	uint32_t tee_key_size;
+	bool tee_op_reusable;
 	void *extra_ctx;
 };
 
+/*
+ * Cache of the lastly released TEE crypto operation of a session so that
+ * back to back processings with the same algorithm, mode and key size
+ * reuse the allocated operation instead of re-allocating one on each
+ * initialization.
+ *
+ * @op - allocated TEE operation or TEE_HANDLE_NULL if cache is empty
+ * @algo - TEE algorithm @op was allocated for
+ * @mode - TEE operation mode @op was allocated for
+ * @key_size - maximum key bit size @op was allocated for
+ */
+struct tee_op_cache {
+	TEE_OperationHandle op;
+	uint32_t algo;
+	uint32_t mode;
+	uint32_t key_size;
+};
+
 /*
  * Structure tracking the PKCS#11 sessions
  *
@@ -153,6 +196,7 @@ struct active_processing {
  * @object_handle_db - Database for object handles published by the session
  * @state - R/W SO, R/W user, RO user, R/W public, RO public.
  * @processing - Reference to initialized processing context if any
+ * @op_cache - Cache of the lastly released TEE crypto operation
  */
 struct pkcs11_session {
 	TAILQ_ENTRY(pkcs11_session) link;
@@ -163,6 +207,7 @@ struct pkcs11_session {
 	struct handle_db object_handle_db;
 	enum pkcs11_session_state state;
 	struct active_processing *processing;
+	struct tee_op_cache op_cache;
 };
 
 /* Initialize static token instance(s) from default/persistent database */
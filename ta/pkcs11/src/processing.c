@@ -84,7 +84,23 @@ void release_active_processing(struct pkcs11_session *session)
 	}
 
 	if (session->processing->tee_op_handle != TEE_HANDLE_NULL) {
-		TEE_FreeOperation(session->processing->tee_op_handle);
+		/*
+		 * Keep the operation in the session cache for reuse by a
+		 * next initialization unless its key was never set, as
+		 * TEE_ResetOperation() requires a key.
+		 */
+		if (session->processing->tee_op_reusable) {
+			if (session->op_cache.op != TEE_HANDLE_NULL)
+				TEE_FreeOperation(session->op_cache.op);
+
+			session->op_cache.op = session->processing->tee_op_handle;
+			session->op_cache.algo = session->processing->tee_algo;
+			session->op_cache.mode = session->processing->tee_mode;
+			session->op_cache.key_size =
+				session->processing->tee_key_size;
+		} else {
+			TEE_FreeOperation(session->processing->tee_op_handle);
+		}
 		session->processing->tee_op_handle = TEE_HANDLE_NULL;
 	}
 
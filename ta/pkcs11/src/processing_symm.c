@@ -111,11 +111,31 @@ allocate_tee_operation(struct pkcs11_session *session,
 	/* Sign/Verify with AES or generic key relate to TEE MAC operation */
 	pkcs2tee_mode(&mode, function);
 
-	res = TEE_AllocateOperation(&session->processing->tee_op_handle,
-				    algo, mode, size);
-	if (res)
-		EMSG("TEE_AllocateOp. failed %#"PRIx32" %#"PRIx32" %#"PRIx32,
-		     algo, mode, size);
+	/*
+	 * Reuse the lastly released operation of the session when it was
+	 * allocated with the same parameters, saving an allocation per
+	 * initialization when a client repeats a processing.
+	 */
+	if (session->op_cache.op != TEE_HANDLE_NULL &&
+	    session->op_cache.algo == algo && session->op_cache.mode == mode &&
+	    session->op_cache.key_size == size) {
+		session->processing->tee_op_handle = session->op_cache.op;
+		session->op_cache.op = TEE_HANDLE_NULL;
+		TEE_ResetOperation(session->processing->tee_op_handle);
+		res = TEE_SUCCESS;
+	} else {
+		res = TEE_AllocateOperation(&session->processing->tee_op_handle,
+					    algo, mode, size);
+		if (res)
+			EMSG("TEE_AllocateOp. failed %#"PRIx32" %#"PRIx32" %#"PRIx32,
+			     algo, mode, size);
+	}
+
+	if (res == TEE_SUCCESS) {
+		session->processing->tee_algo = algo;
+		session->processing->tee_mode = mode;
+		session->processing->tee_key_size = size;
+	}
 
 	if (res == TEE_ERROR_NOT_SUPPORTED)
 		return PKCS11_CKR_MECHANISM_INVALID;
@@ -235,6 +255,9 @@ enum pkcs11_rc init_symm_operation(struct pkcs11_session *session,
 	if (rc)
 		return rc;
 
+	/* The operation key is set, the operation can be cached on release */
+	session->processing->tee_op_reusable = true;
+
 	return init_tee_operation(session, proc_params);
 }
 
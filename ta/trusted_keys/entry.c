@@ -130,16 +130,15 @@ static TEE_Result huk_ae_decrypt(TEE_OperationHandle crypto_op, uint8_t *in,
 	return res;
 }
 
-static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, uint32_t in_sz,
-			    uint8_t *out, uint32_t *out_sz)
+static TEE_Result huk_crypt_init(TEE_OperationMode mode,
+				 TEE_OperationHandle *crypto_op)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
-	TEE_OperationHandle crypto_op = TEE_HANDLE_NULL;
 	TEE_ObjectHandle hkey = TEE_HANDLE_NULL;
 	uint8_t huk_key[TA_DERIVED_KEY_MAX_SIZE] = { };
 	TEE_Attribute attr = { };
 
-	res = TEE_AllocateOperation(&crypto_op, TEE_ALG_AES_GCM, mode,
+	res = TEE_AllocateOperation(crypto_op, TEE_ALG_AES_GCM, mode,
 				    sizeof(huk_key) * 8);
 	if (res)
 		return res;
@@ -163,9 +162,28 @@ static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, uint32_t in_sz,
 	if (res)
 		goto out_key;
 
-	res = TEE_SetOperationKey(crypto_op, hkey);
+	res = TEE_SetOperationKey(*crypto_op, hkey);
+
+out_key:
+	TEE_FreeTransientObject(hkey);
+out_op:
+	if (res) {
+		TEE_FreeOperation(*crypto_op);
+		*crypto_op = TEE_HANDLE_NULL;
+	}
+	memzero_explicit(huk_key, sizeof(huk_key));
+	return res;
+}
+
+static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, uint32_t in_sz,
+			    uint8_t *out, uint32_t *out_sz)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	TEE_OperationHandle crypto_op = TEE_HANDLE_NULL;
+
+	res = huk_crypt_init(mode, &crypto_op);
 	if (res)
-		goto out_key;
+		return res;
 
 	if (mode == TEE_MODE_ENCRYPT) {
 		res = huk_ae_encrypt(crypto_op, in, in_sz, out, out_sz);
@@ -179,11 +197,7 @@ static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, uint32_t in_sz,
 		TEE_Panic(0);
 	}
 
-out_key:
-	TEE_FreeTransientObject(hkey);
-out_op:
 	TEE_FreeOperation(crypto_op);
-	memzero_explicit(huk_key, sizeof(huk_key));
 	return res;
 }
 
@@ -272,6 +286,158 @@ static TEE_Result unseal_trusted_key(uint32_t types,
 	return res;
 }
 
+/*
+ * Batch commands pack several keys or datablobs in a single memref: each
+ * element is a 32-bit byte size followed by the data, the next element
+ * starts at the following 4 byte aligned offset.
+ */
+static bool advance_elem_offs(uint32_t *offs, uint32_t data_sz)
+{
+	uint32_t o = 0;
+
+	if (ADD_OVERFLOW(*offs, sizeof(uint32_t) + data_sz, &o) ||
+	    ADD_OVERFLOW(o, sizeof(uint32_t) - 1, &o))
+		return false;
+
+	*offs = ROUNDDOWN(o, sizeof(uint32_t));
+	return true;
+}
+
+static TEE_Result batch_out_size(TEE_OperationMode mode, uint8_t *in,
+				 uint32_t in_sz, uint32_t *req_sz)
+{
+	uint32_t offs = 0;
+	uint32_t total = 0;
+	uint32_t n = 0;
+
+	while (offs < in_sz) {
+		if (in_sz - offs < sizeof(uint32_t))
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		memcpy(&n, in + offs, sizeof(n));
+		if (!n || n > MAX_BUF_SIZE ||
+		    n > in_sz - offs - sizeof(uint32_t))
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		if (mode == TEE_MODE_ENCRYPT) {
+			if (!advance_elem_offs(&total,
+					       n + sizeof(struct tk_blob_hdr)))
+				return TEE_ERROR_BAD_PARAMETERS;
+		} else {
+			if (n <= sizeof(struct tk_blob_hdr))
+				return TEE_ERROR_BAD_PARAMETERS;
+			if (!advance_elem_offs(&total,
+					       n - sizeof(struct tk_blob_hdr)))
+				return TEE_ERROR_BAD_PARAMETERS;
+		}
+
+		if (!advance_elem_offs(&offs, n))
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	*req_sz = total;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result batch_crypt(TEE_OperationMode mode, uint32_t types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	TEE_OperationHandle crypto_op = TEE_HANDLE_NULL;
+	uint8_t *in = NULL;
+	uint32_t in_sz = 0;
+	uint8_t *out = NULL;
+	uint32_t out_sz = 0;
+	uint32_t in_offs = 0;
+	uint32_t out_offs = 0;
+	uint32_t req_sz = 0;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				     TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	in = params[0].memref.buffer;
+	in_sz = params[0].memref.size;
+	out = params[1].memref.buffer;
+	out_sz = params[1].memref.size;
+
+	if (!in || !in_sz || !ALIGNMENT_IS_OK(in, uint32_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+	if ((!out && out_sz) || (out && !ALIGNMENT_IS_OK(out, uint32_t)))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = batch_out_size(mode, in, in_sz, &req_sz);
+	if (res)
+		return res;
+
+	if (req_sz > out_sz) {
+		params[1].memref.size = req_sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	/* Derive the key and set up the operation once for all elements */
+	res = huk_crypt_init(mode, &crypto_op);
+	if (res)
+		return res;
+
+	while (in_offs < in_sz) {
+		uint32_t n = 0;
+		uint32_t elem_sz = 0;
+
+		memcpy(&n, in + in_offs, sizeof(n));
+		elem_sz = out_sz - out_offs - sizeof(uint32_t);
+
+		if (mode == TEE_MODE_ENCRYPT)
+			res = huk_ae_encrypt(crypto_op,
+					     in + in_offs + sizeof(uint32_t), n,
+					     out + out_offs + sizeof(uint32_t),
+					     &elem_sz);
+		else
+			res = huk_ae_decrypt(crypto_op,
+					     in + in_offs + sizeof(uint32_t), n,
+					     out + out_offs + sizeof(uint32_t),
+					     &elem_sz);
+		if (res) {
+			EMSG("huk_AE_%scrypt failed: returned %#"PRIx32,
+			     mode == TEE_MODE_ENCRYPT ? "en" : "de", res);
+			break;
+		}
+
+		memcpy(out + out_offs, &elem_sz, sizeof(elem_sz));
+
+		if (!advance_elem_offs(&in_offs, n) ||
+		    !advance_elem_offs(&out_offs, elem_sz)) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			break;
+		}
+	}
+
+	TEE_FreeOperation(crypto_op);
+
+	if (!res)
+		params[1].memref.size = out_offs;
+
+	return res;
+}
+
+static TEE_Result seal_trusted_key_batch(uint32_t types,
+					 TEE_Param params[TEE_NUM_PARAMS])
+{
+	DMSG("Invoked TA_CMD_SEAL_BATCH");
+
+	return batch_crypt(TEE_MODE_ENCRYPT, types, params);
+}
+
+static TEE_Result unseal_trusted_key_batch(uint32_t types,
+					   TEE_Param params[TEE_NUM_PARAMS])
+{
+	DMSG("Invoked TA_CMD_UNSEAL_BATCH");
+
+	return batch_crypt(TEE_MODE_DECRYPT, types, params);
+}
+
 TEE_Result TA_CreateEntryPoint(void)
 {
 	return TEE_SUCCESS;
@@ -323,6 +489,10 @@ TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd,
 		return seal_trusted_key(pt, params);
 	case TA_CMD_UNSEAL:
 		return unseal_trusted_key(pt, params);
+	case TA_CMD_SEAL_BATCH:
+		return seal_trusted_key_batch(pt, params);
+	case TA_CMD_UNSEAL_BATCH:
+		return unseal_trusted_key_batch(pt, params);
 	default:
 		EMSG("Command ID %#"PRIx32" is not supported", cmd);
 		return TEE_ERROR_NOT_SUPPORTED;
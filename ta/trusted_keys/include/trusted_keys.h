@@ -32,4 +32,27 @@
  */
 #define TA_CMD_UNSEAL		0x2
 
+/*
+ * Seal an array of trusted keys using hardware unique key
+ *
+ * Each element in the packed arrays is a 32-bit byte size followed by
+ * the data, the next element starts at the following 4 byte aligned
+ * offset. The key schedule derived from the hardware unique key is
+ * reused across all elements.
+ *
+ * [in]      memref[0]        Packed array of plain keys
+ * [out]     memref[1]        Packed array of sealed key datablobs
+ */
+#define TA_CMD_SEAL_BATCH	0x3
+
+/*
+ * Unseal an array of trusted keys using hardware unique key
+ *
+ * The packed array format and key handling match TA_CMD_SEAL_BATCH.
+ *
+ * [in]      memref[0]        Packed array of sealed key datablobs
+ * [out]     memref[1]        Packed array of plain keys
+ */
+#define TA_CMD_UNSEAL_BATCH	0x4
+
 #endif /* TRUSTED_KEYS_H */